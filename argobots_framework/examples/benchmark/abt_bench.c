@@ -0,0 +1,491 @@
+#include "abt_bench.h"
+
+#include <abt.h>
+#include <dirent.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define BENCH_LINE_LEN 4096
+#define BENCH_MAX_COLUMNS 64
+
+static int env_int(const char *name, int default_value, int min_value) {
+    const char *value = getenv(name);
+    if (!value || value[0] == '\0') {
+        return default_value;
+    }
+    int result = atoi(value);
+    return result < min_value ? min_value : result;
+}
+
+void bench_init(bench_t *bench, const char *name) {
+    memset(bench, 0, sizeof(bench_t));
+    snprintf(bench->name, sizeof(bench->name), "%s", name);
+
+    bench->warmup = env_int("ABT_BENCH_WARMUP", 0, 0);
+    bench->repetitions = env_int("ABT_BENCH_REPS", 1, 1);
+    const char *format = getenv("ABT_BENCH_FORMAT");
+    if (format && strcmp(format, "csv") == 0) {
+        bench->format = BENCH_FORMAT_CSV;
+    } else if (format && strcmp(format, "json") == 0) {
+        bench->format = BENCH_FORMAT_JSON;
+    } else {
+        bench->format = BENCH_FORMAT_TEXT;
+    }
+    bench->output = getenv("ABT_BENCH_OUTPUT");
+    if (bench->output && bench->output[0] == '\0') {
+        bench->output = NULL;
+    }
+    bench->baseline = getenv("ABT_BENCH_BASELINE");
+    if (bench->baseline && bench->baseline[0] == '\0') {
+        bench->baseline = NULL;
+    }
+    const char *threshold = getenv("ABT_BENCH_THRESHOLD");
+    bench->threshold = (threshold && threshold[0] != '\0') ? atof(threshold)
+                                                           : 0.05;
+
+    bench->times = (double *)calloc(bench->repetitions, sizeof(double));
+    bench->phase_times = (double *)calloc(
+        (size_t)BENCH_MAX_PHASES * bench->repetitions, sizeof(double));
+}
+
+void bench_config(bench_t *bench, const char *key, const char *fmt, ...) {
+    if (bench->num_config >= BENCH_MAX_CONFIG) {
+        return;
+    }
+    int i = bench->num_config++;
+    snprintf(bench->config_keys[i], BENCH_NAME_LEN, "%s", key);
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(bench->config_values[i], BENCH_VALUE_LEN, fmt, args);
+    va_end(args);
+    // Values end up in csv cells.
+    for (char *c = bench->config_values[i]; *c; c++) {
+        if (*c == ',' || *c == '"' || *c == '\n') {
+            *c = ';';
+        }
+    }
+}
+
+int bench_num_runs(const bench_t *bench) {
+    return bench->warmup + bench->repetitions;
+}
+
+void bench_run_begin(bench_t *bench) {
+    bench->measuring = bench->run >= bench->warmup &&
+                       bench->num_times < bench->repetitions;
+    bench->run++;
+    bench->run_start = ABT_get_wtime();
+}
+
+void bench_run_end(bench_t *bench, int verified) {
+    double elapsed = ABT_get_wtime() - bench->run_start;
+    if (!bench->measuring) {
+        return;
+    }
+    bench->times[bench->num_times++] = elapsed;
+    if (!verified) {
+        bench->num_failed++;
+    }
+    bench->measuring = 0;
+}
+
+static int find_phase(bench_t *bench, const char *phase) {
+    for (int i = 0; i < bench->num_phases; i++) {
+        if (strcmp(bench->phase_names[i], phase) == 0) {
+            return i;
+        }
+    }
+    if (bench->num_phases >= BENCH_MAX_PHASES) {
+        return -1;
+    }
+    int i = bench->num_phases++;
+    snprintf(bench->phase_names[i], BENCH_NAME_LEN, "%s", phase);
+    return i;
+}
+
+void bench_phase_begin(bench_t *bench, const char *phase) {
+    if (!bench->measuring) {
+        return;
+    }
+    int i = find_phase(bench, phase);
+    if (i >= 0) {
+        bench->phase_start[i] = ABT_get_wtime();
+    }
+}
+
+void bench_phase_end(bench_t *bench, const char *phase) {
+    if (!bench->measuring) {
+        return;
+    }
+    int i = find_phase(bench, phase);
+    if (i >= 0) {
+        bench->phase_times[i * bench->repetitions + bench->num_times] +=
+            ABT_get_wtime() - bench->phase_start[i];
+    }
+}
+
+// =================== Statistics ===================
+
+static int compare_double(const void *lhs, const void *rhs) {
+    double l = *(const double *)lhs, r = *(const double *)rhs;
+    return (l > r) - (l < r);
+}
+
+// Two-sided 95% quantiles of Student's t distribution for 1..30 degrees of
+// freedom; the normal quantile is used beyond.
+static const double t95[] = {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+};
+
+void bench_compute_stats(const double *samples, int num_samples,
+                         bench_stats_t *stats) {
+    memset(stats, 0, sizeof(bench_stats_t));
+    stats->num_samples = num_samples;
+    if (num_samples <= 0) {
+        return;
+    }
+    double *sorted = (double *)malloc(sizeof(double) * num_samples);
+    memcpy(sorted, samples, sizeof(double) * num_samples);
+    qsort(sorted, num_samples, sizeof(double), compare_double);
+
+    int mid = num_samples / 2;
+    stats->median = (num_samples % 2) ? sorted[mid]
+                                      : (sorted[mid - 1] + sorted[mid]) / 2.0;
+    // Nearest-rank percentile.
+    int rank = (int)ceil(0.95 * num_samples);
+    stats->p95 = sorted[(rank > 0 ? rank : 1) - 1];
+    stats->min = sorted[0];
+    stats->max = sorted[num_samples - 1];
+
+    double sum = 0.0;
+    for (int i = 0; i < num_samples; i++) {
+        sum += sorted[i];
+    }
+    stats->mean = sum / num_samples;
+    if (num_samples > 1) {
+        double sq = 0.0;
+        for (int i = 0; i < num_samples; i++) {
+            sq += (sorted[i] - stats->mean) * (sorted[i] - stats->mean);
+        }
+        stats->stddev = sqrt(sq / (num_samples - 1));
+        int df = num_samples - 1;
+        double t = (df <= (int)(sizeof(t95) / sizeof(t95[0]))) ? t95[df - 1]
+                                                                : 1.960;
+        stats->ci95 = t * stats->stddev / sqrt((double)num_samples);
+    }
+    free(sorted);
+}
+
+// =================== Baseline ===================
+
+// Splits line in place at commas.  Returns the number of fields.
+static int split_csv(char *line, char **fields, int max_fields) {
+    int num_fields = 0;
+    line[strcspn(line, "\r\n")] = '\0';
+    char *field = line;
+    while (num_fields < max_fields) {
+        fields[num_fields++] = field;
+        char *comma = strchr(field, ',');
+        if (!comma) {
+            break;
+        }
+        *comma = '\0';
+        field = comma + 1;
+    }
+    return num_fields;
+}
+
+typedef struct {
+    double *values;
+    int num_values;
+    int capacity;
+} sample_list_t;
+
+static void sample_list_push(sample_list_t *list, double value) {
+    if (list->num_values == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 16;
+        list->values = (double *)realloc(list->values,
+                                         sizeof(double) * list->capacity);
+    }
+    list->values[list->num_values++] = value;
+}
+
+static void load_baseline_file(const bench_t *bench, const char *path,
+                               sample_list_t *samples) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        return;
+    }
+    char header_line[BENCH_LINE_LEN], line[BENCH_LINE_LEN];
+    char *header[BENCH_MAX_COLUMNS], *fields[BENCH_MAX_COLUMNS];
+    if (!fgets(header_line, sizeof(header_line), fp)) {
+        fclose(fp);
+        return;
+    }
+    int num_columns = split_csv(header_line, header, BENCH_MAX_COLUMNS);
+
+    // The time column, and the value each column must have (NULL: any).
+    static const char *time_columns[] = { "median_s", "real_time_nanos",
+                                          "time", "time_seconds" };
+    static const double time_scales[] = { 1.0, 1.0e-9, 1.0, 1.0 };
+    int time_column = -1;
+    double time_scale = 1.0;
+    for (int t = 0; t < 4 && time_column < 0; t++) {
+        for (int c = 0; c < num_columns; c++) {
+            if (strcmp(header[c], time_columns[t]) == 0) {
+                time_column = c;
+                time_scale = time_scales[t];
+                break;
+            }
+        }
+    }
+    const char *expected[BENCH_MAX_COLUMNS];
+    for (int c = 0; c < num_columns; c++) {
+        expected[c] = NULL;
+        if (strcmp(header[c], "benchmark") == 0) {
+            expected[c] = bench->name;
+        }
+        for (int k = 0; k < bench->num_config; k++) {
+            if (strcmp(header[c], bench->config_keys[k]) == 0) {
+                expected[c] = bench->config_values[k];
+            }
+        }
+    }
+
+    while (time_column >= 0 && fgets(line, sizeof(line), fp)) {
+        int num_fields = split_csv(line, fields, BENCH_MAX_COLUMNS);
+        if (num_fields <= time_column) {
+            continue;
+        }
+        int match = 1;
+        for (int c = 0; c < num_fields && c < num_columns && match; c++) {
+            if (expected[c] && strcmp(fields[c], expected[c]) != 0) {
+                match = 0;
+            }
+        }
+        char *end;
+        double value = strtod(fields[time_column], &end);
+        if (match && end != fields[time_column] && value > 0.0) {
+            sample_list_push(samples, value * time_scale);
+        }
+    }
+    fclose(fp);
+}
+
+int bench_load_baseline(const bench_t *bench, const char *path,
+                        double *baseline) {
+    sample_list_t samples = { NULL, 0, 0 };
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        return 0;
+    }
+    if (S_ISDIR(st.st_mode)) {
+        DIR *dir = opendir(path);
+        struct dirent *entry;
+        size_t name_len = strlen(bench->name);
+        while (dir && (entry = readdir(dir)) != NULL) {
+            size_t len = strlen(entry->d_name);
+            if (len > 4 && strcmp(entry->d_name + len - 4, ".csv") == 0 &&
+                strncmp(entry->d_name, bench->name, name_len) == 0) {
+                char file[BENCH_LINE_LEN];
+                snprintf(file, sizeof(file), "%s/%s", path, entry->d_name);
+                load_baseline_file(bench, file, &samples);
+            }
+        }
+        if (dir) {
+            closedir(dir);
+        }
+    } else {
+        load_baseline_file(bench, path, &samples);
+    }
+
+    int found = samples.num_values > 0;
+    if (found) {
+        bench_stats_t stats;
+        bench_compute_stats(samples.values, samples.num_values, &stats);
+        *baseline = stats.median;
+    }
+    free(samples.values);
+    return found;
+}
+
+// =================== Output ===================
+
+static void print_json_string(FILE *fp, const char *str) {
+    fputc('"', fp);
+    for (; *str; str++) {
+        if (*str == '"' || *str == '\\') {
+            fputc('\\', fp);
+        }
+        fputc(*str, fp);
+    }
+    fputc('"', fp);
+}
+
+static void write_csv(const bench_t *bench, FILE *fp, const bench_stats_t *stats,
+                      const bench_stats_t *phase_stats, int has_baseline,
+                      double baseline, int regression) {
+    int new_file = 1;
+    if (fp != stdout) {
+        fseek(fp, 0, SEEK_END);
+        new_file = ftell(fp) == 0;
+    }
+    if (new_file) {
+        fprintf(fp, "benchmark");
+        for (int k = 0; k < bench->num_config; k++) {
+            fprintf(fp, ",%s", bench->config_keys[k]);
+        }
+        fprintf(fp, ",warmup,repetitions,failed,median_s,p95_s,mean_s,"
+                    "stddev_s,ci95_s,min_s,max_s");
+        for (int p = 0; p < bench->num_phases; p++) {
+            fprintf(fp, ",%s_median_s", bench->phase_names[p]);
+        }
+        fprintf(fp, ",baseline_s,regression\n");
+    }
+    fprintf(fp, "%s", bench->name);
+    for (int k = 0; k < bench->num_config; k++) {
+        fprintf(fp, ",%s", bench->config_values[k]);
+    }
+    fprintf(fp, ",%d,%d,%d,%.9f,%.9f,%.9f,%.9f,%.9f,%.9f,%.9f", bench->warmup,
+            bench->num_times, bench->num_failed, stats->median, stats->p95,
+            stats->mean, stats->stddev, stats->ci95, stats->min, stats->max);
+    for (int p = 0; p < bench->num_phases; p++) {
+        fprintf(fp, ",%.9f", phase_stats[p].median);
+    }
+    if (has_baseline) {
+        fprintf(fp, ",%.9f,%d\n", baseline, regression);
+    } else {
+        fprintf(fp, ",NA,0\n");
+    }
+}
+
+static void write_json(const bench_t *bench, FILE *fp,
+                       const bench_stats_t *stats,
+                       const bench_stats_t *phase_stats, int has_baseline,
+                       double baseline, int regression) {
+    fprintf(fp, "{\"benchmark\":");
+    print_json_string(fp, bench->name);
+    fprintf(fp, ",\"config\":{");
+    for (int k = 0; k < bench->num_config; k++) {
+        if (k) {
+            fputc(',', fp);
+        }
+        print_json_string(fp, bench->config_keys[k]);
+        fputc(':', fp);
+        print_json_string(fp, bench->config_values[k]);
+    }
+    fprintf(fp, "},\"warmup\":%d,\"repetitions\":%d,\"failed\":%d,"
+                "\"times_s\":[",
+            bench->warmup, bench->num_times, bench->num_failed);
+    for (int i = 0; i < bench->num_times; i++) {
+        fprintf(fp, "%s%.9f", i ? "," : "", bench->times[i]);
+    }
+    fprintf(fp, "],\"stats\":{\"median_s\":%.9f,\"p95_s\":%.9f,"
+                "\"mean_s\":%.9f,\"stddev_s\":%.9f,\"ci95_s\":%.9f,"
+                "\"min_s\":%.9f,\"max_s\":%.9f},\"phases\":{",
+            stats->median, stats->p95, stats->mean, stats->stddev, stats->ci95,
+            stats->min, stats->max);
+    for (int p = 0; p < bench->num_phases; p++) {
+        if (p) {
+            fputc(',', fp);
+        }
+        print_json_string(fp, bench->phase_names[p]);
+        fprintf(fp, ":{\"median_s\":%.9f,\"p95_s\":%.9f,\"mean_s\":%.9f}",
+                phase_stats[p].median, phase_stats[p].p95,
+                phase_stats[p].mean);
+    }
+    fprintf(fp, "},\"baseline_s\":");
+    if (has_baseline) {
+        fprintf(fp, "%.9f", baseline);
+    } else {
+        fprintf(fp, "null");
+    }
+    fprintf(fp, ",\"regression\":%s}\n", regression ? "true" : "false");
+}
+
+static void write_text(const bench_t *bench, FILE *fp,
+                       const bench_stats_t *stats,
+                       const bench_stats_t *phase_stats, int has_baseline,
+                       double baseline, int regression) {
+    fprintf(fp, " Bench %s:", bench->name);
+    for (int k = 0; k < bench->num_config; k++) {
+        fprintf(fp, " %s=%s", bench->config_keys[k], bench->config_values[k]);
+    }
+    fprintf(fp, "\n Bench runs      = %d (+%d warmup, %d failed)\n",
+            bench->num_times, bench->warmup, bench->num_failed);
+    fprintf(fp, " Bench median    = %.6f s, p95 %.6f s\n", stats->median,
+            stats->p95);
+    fprintf(fp, " Bench mean      = %.6f s +- %.6f s (95%% CI), min %.6f s, "
+                "max %.6f s\n",
+            stats->mean, stats->ci95, stats->min, stats->max);
+    for (int p = 0; p < bench->num_phases; p++) {
+        fprintf(fp, " Bench phase %-12s median %.6f s, p95 %.6f s\n",
+                bench->phase_names[p], phase_stats[p].median,
+                phase_stats[p].p95);
+    }
+    if (has_baseline) {
+        fprintf(fp, " Bench baseline  = %.6f s, median %+.1f%% (%s)\n",
+                baseline, (stats->median / baseline - 1.0) * 100.0,
+                regression ? "REGRESSION" : "ok");
+    }
+}
+
+int bench_finish(bench_t *bench) {
+    bench_stats_t stats;
+    bench_stats_t phase_stats[BENCH_MAX_PHASES];
+    bench_compute_stats(bench->times, bench->num_times, &stats);
+    for (int p = 0; p < bench->num_phases; p++) {
+        bench_compute_stats(&bench->phase_times[p * bench->repetitions],
+                            bench->num_times, &phase_stats[p]);
+    }
+
+    double baseline = 0.0;
+    int has_baseline = bench->baseline && bench->num_times > 0 &&
+                       bench_load_baseline(bench, bench->baseline, &baseline);
+    int regression =
+        has_baseline && stats.median > baseline * (1.0 + bench->threshold);
+
+    FILE *fp = stdout;
+    if (bench->output) {
+        fp = fopen(bench->output, "a");
+        if (!fp) {
+            fprintf(stderr, "Cannot open %s, writing to stdout\n",
+                    bench->output);
+            fp = stdout;
+        }
+    }
+    switch (bench->format) {
+        case BENCH_FORMAT_CSV:
+            write_csv(bench, fp, &stats, phase_stats, has_baseline, baseline,
+                      regression);
+            break;
+        case BENCH_FORMAT_JSON:
+            write_json(bench, fp, &stats, phase_stats, has_baseline, baseline,
+                       regression);
+            break;
+        default:
+            write_text(bench, fp, &stats, phase_stats, has_baseline, baseline,
+                       regression);
+            break;
+    }
+    if (fp != stdout) {
+        fclose(fp);
+    }
+    if (regression && (bench->format != BENCH_FORMAT_TEXT || fp != stdout)) {
+        printf(" Bench %s: REGRESSION, median %.6f s vs baseline %.6f s\n",
+               bench->name, stats.median, baseline);
+    }
+
+    int failed = regression || bench->num_failed > 0;
+    free(bench->times);
+    free(bench->phase_times);
+    bench->times = NULL;
+    bench->phase_times = NULL;
+    return failed;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <stddef.h>
+
+/* A small benchmark runner shared by the CG and Jacobi-3D drivers, the
+ * reduction example and the scheduler comparison.
+ *
+ * A driver describes its configuration with bench_config(), then repeats its
+ * timed section bench_num_runs() times between bench_run_begin() and
+ * bench_run_end().  The first runs are warmups and are not measured.  Named
+ * phases inside a run are timed with bench_phase_begin()/bench_phase_end();
+ * a phase entered several times per run (e.g. once per iteration) adds up.
+ * bench_finish() prints median, p95, mean with a 95% confidence interval,
+ * min and max, and compares the median with a baseline.
+ *
+ * The runner is configured from the environment:
+ *   ABT_BENCH_WARMUP     warmup runs (default 0)
+ *   ABT_BENCH_REPS       measured runs (default 1)
+ *   ABT_BENCH_FORMAT     text (default), csv or json
+ *   ABT_BENCH_OUTPUT     file the csv/json record is appended to (default
+ *                        stdout); the csv header is written to a new file
+ *   ABT_BENCH_BASELINE   csv file, or directory of csv files whose names start
+ *                        with the benchmark name, to compare with
+ *   ABT_BENCH_THRESHOLD  relative slowdown of the median over the baseline
+ *                        that is reported as a regression (default 0.05)
+ *
+ * A baseline csv needs a header.  The time is read from the first of the
+ * columns median_s, real_time_nanos, time and time_seconds; every other
+ * column that names a configuration key (or "benchmark") must match.  This
+ * reads both the csv written by this runner and the *_summary.csv files of
+ * scripts/run_existing_benchmarks_scheduler_compare.sh. */
+
+#define BENCH_MAX_CONFIG 16
+#define BENCH_MAX_PHASES 16
+#define BENCH_NAME_LEN 32
+#define BENCH_VALUE_LEN 64
+
+typedef enum {
+    BENCH_FORMAT_TEXT = 0,
+    BENCH_FORMAT_CSV,
+    BENCH_FORMAT_JSON,
+} bench_format_t;
+
+typedef struct {
+    int num_samples;
+    double median;
+    double p95;
+    double mean;
+    double stddev;
+    double ci95;             /* half-width of the 95% interval of the mean */
+    double min;
+    double max;
+} bench_stats_t;
+
+typedef struct {
+    char name[BENCH_NAME_LEN];
+    char config_keys[BENCH_MAX_CONFIG][BENCH_NAME_LEN];
+    char config_values[BENCH_MAX_CONFIG][BENCH_VALUE_LEN];
+    int num_config;
+
+    int warmup;
+    int repetitions;
+    bench_format_t format;
+    const char *output;
+    const char *baseline;
+    double threshold;
+
+    int run;                 /* runs begun so far, warmups included */
+    int measuring;           /* inside a measured run */
+    double run_start;
+    double *times;           /* [repetitions] */
+    int num_times;
+    int num_failed;          /* runs that failed verification */
+
+    char phase_names[BENCH_MAX_PHASES][BENCH_NAME_LEN];
+    int num_phases;
+    double phase_start[BENCH_MAX_PHASES];
+    double *phase_times;     /* [BENCH_MAX_PHASES][repetitions] */
+} bench_t;
+
+void bench_init(bench_t *bench, const char *name);
+
+/* Adds a configuration key, printf-style.  Keys are written in every record
+ * and select the matching rows of the baseline. */
+void bench_config(bench_t *bench, const char *key, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+/* Total number of runs, warmups included. */
+int bench_num_runs(const bench_t *bench);
+
+void bench_run_begin(bench_t *bench);
+void bench_run_end(bench_t *bench, int verified);
+
+/* Phases are ignored outside measured runs. */
+void bench_phase_begin(bench_t *bench, const char *phase);
+void bench_phase_end(bench_t *bench, const char *phase);
+
+/* Reports the runs and frees the runner.  Returns 1 if the median regressed
+ * against the baseline or a run failed verification, 0 otherwise. */
+int bench_finish(bench_t *bench);
+
+/* Exposed for the test. */
+void bench_compute_stats(const double *samples, int num_samples,
+                         bench_stats_t *stats);
+/* Median of the matching baseline rows in seconds; returns 0 if none. */
+int bench_load_baseline(const bench_t *bench, const char *path,
+                        double *baseline);
@@ -0,0 +1,201 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/*
+ * Checks the statistics, the csv/json records and the baseline comparison of
+ * the benchmark runner.  The runs time a small loop of ULTs so that the phase
+ * timers are exercised, but the checks do not depend on the timings.
+ */
+
+#include "abt_bench.h"
+
+#include <abt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define NUM_XSTREAMS 2
+#define NUM_ULTS 8
+
+static int num_errors = 0;
+
+static void check(int cond, const char *what) {
+    if (!cond) {
+        printf("FAILED: %s\n", what);
+        num_errors++;
+    }
+}
+
+static int near(double a, double b) {
+    return fabs(a - b) <= 1e-9 * (fabs(a) + fabs(b) + 1.0);
+}
+
+static void test_stats(void) {
+    const double samples[] = { 5.0, 1.0, 4.0, 2.0, 3.0 };
+    bench_stats_t stats;
+    bench_compute_stats(samples, 5, &stats);
+    check(near(stats.median, 3.0), "median of an odd sample");
+    check(near(stats.p95, 5.0), "p95 of five samples");
+    check(near(stats.mean, 3.0), "mean");
+    check(near(stats.stddev, sqrt(2.5)), "sample standard deviation");
+    check(near(stats.ci95, 2.776 * sqrt(2.5) / sqrt(5.0)), "95% interval");
+    check(near(stats.min, 1.0) && near(stats.max, 5.0), "min and max");
+
+    bench_compute_stats(samples, 4, &stats);
+    check(near(stats.median, 3.0), "median of an even sample");
+    bench_compute_stats(samples, 1, &stats);
+    check(near(stats.ci95, 0.0), "no interval for one sample");
+}
+
+static void spin(void *arg) {
+    volatile double sum = 0.0;
+    for (int i = 0; i < 10000; i++) {
+        sum += i * (double)(size_t)arg;
+    }
+}
+
+static int run_bench(const char *scheduler, ABT_pool *pools) {
+    bench_t bench;
+    bench_init(&bench, "bench_test");
+    bench_config(&bench, "xstreams", "%d", NUM_XSTREAMS);
+    bench_config(&bench, "scheduler", "%s", scheduler);
+    for (int run = 0; run < bench_num_runs(&bench); run++) {
+        ABT_thread threads[NUM_ULTS];
+        bench_run_begin(&bench);
+        bench_phase_begin(&bench, "create");
+        for (int i = 0; i < NUM_ULTS; i++) {
+            ABT_thread_create(pools[i % NUM_XSTREAMS], spin, (void *)(size_t)i,
+                              ABT_THREAD_ATTR_NULL, &threads[i]);
+        }
+        bench_phase_end(&bench, "create");
+        bench_phase_begin(&bench, "join");
+        for (int i = 0; i < NUM_ULTS; i++) {
+            ABT_thread_free(&threads[i]);
+        }
+        bench_phase_end(&bench, "join");
+        bench_run_end(&bench, 1);
+    }
+    return bench_finish(&bench);
+}
+
+static int file_contains(const char *path, const char *str) {
+    char buf[8192];
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        return 0;
+    }
+    size_t len = fread(buf, 1, sizeof(buf) - 1, fp);
+    buf[len] = '\0';
+    fclose(fp);
+    return strstr(buf, str) != NULL;
+}
+
+static void test_records_and_baseline(ABT_pool *pools) {
+    char csv_path[] = "/tmp/abt_bench_test_XXXXXX";
+    int fd = mkstemp(csv_path);
+    check(fd >= 0, "temporary file");
+    close(fd);
+
+    setenv("ABT_BENCH_WARMUP", "1", 1);
+    setenv("ABT_BENCH_REPS", "5", 1);
+    setenv("ABT_BENCH_FORMAT", "csv", 1);
+    setenv("ABT_BENCH_OUTPUT", csv_path, 1);
+    check(run_bench("old", pools) == 0, "csv run");
+    check(run_bench("new", pools) == 0, "second csv run");
+    check(file_contains(csv_path, "benchmark,xstreams,scheduler,warmup,"),
+          "csv header");
+    check(file_contains(csv_path, "\nbench_test,2,old,1,5,0,"), "csv record");
+
+    // The csv just written is a baseline: a generous threshold passes, and a
+    // negative one (anything slower than 10% of the baseline) fails.
+    bench_t bench;
+    bench_init(&bench, "bench_test");
+    bench_config(&bench, "xstreams", "%d", NUM_XSTREAMS);
+    bench_config(&bench, "scheduler", "old");
+    double baseline = 0.0;
+    check(bench_load_baseline(&bench, csv_path, &baseline) && baseline > 0.0,
+          "baseline from the runner's csv");
+    bench_finish(&bench);
+
+    setenv("ABT_BENCH_FORMAT", "json", 1);
+    setenv("ABT_BENCH_OUTPUT", "/dev/null", 1);
+    setenv("ABT_BENCH_BASELINE", csv_path, 1);
+    setenv("ABT_BENCH_THRESHOLD", "100", 1);
+    check(run_bench("old", pools) == 0, "no regression");
+    setenv("ABT_BENCH_THRESHOLD", "-0.9", 1);
+    check(run_bench("old", pools) == 1, "regression is flagged");
+    unsetenv("ABT_BENCH_BASELINE");
+    unsetenv("ABT_BENCH_THRESHOLD");
+
+    // A summary of scripts/run_existing_benchmarks_scheduler_compare.sh.
+    FILE *fp = fopen(csv_path, "w");
+    fprintf(fp, "scheduler,xstreams,threads,run,time_seconds,real_time_nanos,"
+                "verification\n"
+                "old,2,4,1,8.48,4000000000,SUCCESSFUL\n"
+                "old,2,4,2,8.50,5000000000,SUCCESSFUL\n"
+                "old,2,4,3,8.50,NA,NA\n"
+                "new,2,4,1,8.90,9000000000,SUCCESSFUL\n"
+                "old,4,8,1,9.00,3000000000,SUCCESSFUL\n");
+    fclose(fp);
+    bench_init(&bench, "bench_test");
+    bench_config(&bench, "scheduler", "old");
+    bench_config(&bench, "xstreams", "2");
+    bench_config(&bench, "threads", "4");
+    check(bench_load_baseline(&bench, csv_path, &baseline) &&
+              near(baseline, 4.5),
+          "baseline from a scheduler-compare summary");
+    bench_finish(&bench);
+
+    // json records go to the output file one per line.
+    setenv("ABT_BENCH_OUTPUT", csv_path, 1);
+    remove(csv_path);
+    check(run_bench("old", pools) == 0, "json run");
+    check(file_contains(csv_path, "{\"benchmark\":\"bench_test\",\"config\":"
+                                  "{\"xstreams\":\"2\",\"scheduler\":\"old\"}"),
+          "json record");
+    check(file_contains(csv_path, "\"phases\":{\"create\":"), "json phases");
+
+    unsetenv("ABT_BENCH_WARMUP");
+    unsetenv("ABT_BENCH_REPS");
+    unsetenv("ABT_BENCH_FORMAT");
+    unsetenv("ABT_BENCH_OUTPUT");
+    remove(csv_path);
+}
+
+int main(int argc, char **argv)
+{
+    ABT_xstream xstreams[NUM_XSTREAMS];
+    ABT_pool pools[NUM_XSTREAMS];
+
+    ABT_init(argc, argv);
+    ABT_xstream_self(&xstreams[0]);
+    for (int i = 1; i < NUM_XSTREAMS; i++) {
+        ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+    }
+    for (int i = 0; i < NUM_XSTREAMS; i++) {
+        ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+    }
+
+    test_stats();
+    test_records_and_baseline(pools);
+
+    /* The default text report. */
+    check(run_bench("default", pools) == 0, "text run");
+
+    for (int i = 1; i < NUM_XSTREAMS; i++) {
+        ABT_xstream_join(xstreams[i]);
+        ABT_xstream_free(&xstreams[i]);
+    }
+    ABT_finalize();
+
+    if (num_errors > 0) {
+        printf("%d checks failed\n", num_errors);
+        return -1;
+    }
+    printf("No Error\n");
+    return 0;
+}
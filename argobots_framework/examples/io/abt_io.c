@@ -0,0 +1,608 @@
+#include "abt_io.h"
+
+#include <errno.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define ABT_IO_HAVE_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+#define ABT_IO_DEFAULT_ENTRIES 64
+#define ABT_IO_DEFAULT_POLL_FREQ 16
+#define ABT_IO_EVENT_FREQ 64
+#define ABT_IO_CACHELINE_SIZE 64
+
+/* A request of a suspended ULT.  It lives on the stack of that ULT. */
+typedef struct abt_io_op {
+    ABT_thread thread;
+    int res;
+    struct abt_io_op *next;  /* in abt_io_ring_t::completed */
+} abt_io_op_t;
+
+/* Only the scheduler of the ring and the ULTs on its execution stream touch
+ * the submission side; the completion side belongs to that scheduler, or to
+ * the completion execution stream if there is one. */
+typedef struct {
+#ifdef ABT_IO_HAVE_URING
+    int fd;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_array;
+    unsigned sq_mask;
+    unsigned sq_entries;
+    struct io_uring_sqe *sqes;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned cq_mask;
+    unsigned cq_entries;
+    struct io_uring_cqe *cqes;
+    void *sq_ptr;
+    void *cq_ptr;
+    size_t sq_size;
+    size_t cq_size;
+    size_t sqes_size;
+#endif
+    unsigned num_queued;     /* written but not submitted */
+    int num_inflight;        /* submitted but not reaped */
+    abt_io_op_t *completed;  /* reaped by the completion execution stream */
+} __attribute__((aligned(ABT_IO_CACHELINE_SIZE))) abt_io_ring_t;
+
+struct abt_io {
+    abt_io_config_t config;
+    int async;
+    abt_io_ring_t *rings;    /* [config.num_rings] */
+    int refs;                /* the schedulers and the user */
+    ABT_xstream completion_xstream;
+    ABT_sched completion_sched;
+};
+
+typedef struct {
+    abt_io_t *io;
+    int rank;
+} abt_io_sched_data_t;
+
+#ifdef ABT_IO_HAVE_URING
+
+static int ring_init(abt_io_ring_t *ring, unsigned entries)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0)
+        return -errno;
+
+    ring->fd = fd;
+    ring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_size =
+        params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if ((params.features & IORING_FEAT_SINGLE_MMAP) &&
+        ring->cq_size > ring->sq_size)
+        ring->sq_size = ring->cq_size;
+    ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ptr == MAP_FAILED)
+        goto fail_sq;
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_ptr = ring->sq_ptr;
+    } else {
+        ring->cq_ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ptr == MAP_FAILED)
+            goto fail_cq;
+    }
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = (struct io_uring_sqe *)mmap(NULL, ring->sqes_size,
+                                             PROT_READ | PROT_WRITE,
+                                             MAP_SHARED | MAP_POPULATE, fd,
+                                             IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED)
+        goto fail_sqes;
+
+    char *sq = (char *)ring->sq_ptr, *cq = (char *)ring->cq_ptr;
+    ring->sq_head = (unsigned *)(sq + params.sq_off.head);
+    ring->sq_tail = (unsigned *)(sq + params.sq_off.tail);
+    ring->sq_array = (unsigned *)(sq + params.sq_off.array);
+    ring->sq_mask = *(unsigned *)(sq + params.sq_off.ring_mask);
+    ring->sq_entries = params.sq_entries;
+    ring->cq_head = (unsigned *)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned *)(cq + params.cq_off.tail);
+    ring->cq_mask = *(unsigned *)(cq + params.cq_off.ring_mask);
+    ring->cq_entries = params.cq_entries;
+    ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+    return 0;
+
+fail_sqes:
+    if (ring->cq_ptr != ring->sq_ptr)
+        munmap(ring->cq_ptr, ring->cq_size);
+fail_cq:
+    munmap(ring->sq_ptr, ring->sq_size);
+fail_sq:
+    close(fd);
+    return -errno;
+}
+
+static void ring_free(abt_io_ring_t *ring)
+{
+    munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ptr != ring->sq_ptr)
+        munmap(ring->cq_ptr, ring->cq_size);
+    munmap(ring->sq_ptr, ring->sq_size);
+    close(ring->fd);
+}
+
+/* Submits all the queued entries with one system call. */
+static void ring_submit(abt_io_ring_t *ring)
+{
+    if (ring->num_queued == 0)
+        return;
+    int ret = (int)syscall(__NR_io_uring_enter, ring->fd, ring->num_queued, 0,
+                           0, NULL, 0);
+    if (ret > 0) {
+        ring->num_queued -= ret;
+        __atomic_add_fetch(&ring->num_inflight, ret, __ATOMIC_RELAXED);
+    }
+    /* On EAGAIN or EBUSY, the next poll tries again. */
+}
+
+/* Reaps all the available completions.  The ULTs are resumed, or handed back
+ * to the scheduler of the ring if hand_back is set. */
+static int ring_reap(abt_io_ring_t *ring, int hand_back)
+{
+    unsigned head = *ring->cq_head;
+    unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    abt_io_op_t *first = NULL, *last = NULL;
+    int num_reaped = 0;
+
+    while (head != tail) {
+        struct io_uring_cqe *cqe = &ring->cqes[head & ring->cq_mask];
+        abt_io_op_t *op = (abt_io_op_t *)(uintptr_t)cqe->user_data;
+        op->res = cqe->res;
+        if (hand_back) {
+            op->next = first;
+            first = op;
+            if (!last)
+                last = op;
+        } else {
+            ABT_thread_resume(op->thread);
+        }
+        head++;
+        num_reaped++;
+    }
+    if (num_reaped == 0)
+        return 0;
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    __atomic_sub_fetch(&ring->num_inflight, num_reaped, __ATOMIC_RELAXED);
+
+    if (first) {
+        abt_io_op_t *old = __atomic_load_n(&ring->completed, __ATOMIC_RELAXED);
+        do {
+            last->next = old;
+        } while (!__atomic_compare_exchange_n(&ring->completed, &old, first, 1,
+                                              __ATOMIC_RELEASE,
+                                              __ATOMIC_RELAXED));
+    }
+    return num_reaped;
+}
+
+static void ring_progress(abt_io_t *io, abt_io_ring_t *ring)
+{
+    ring_submit(ring);
+    if (!io->config.completion_xstream) {
+        ring_reap(ring, 0);
+        return;
+    }
+    abt_io_op_t *op = __atomic_exchange_n(&ring->completed, NULL,
+                                          __ATOMIC_ACQUIRE);
+    while (op) {
+        abt_io_op_t *next = op->next;
+        ABT_thread_resume(op->thread);
+        op = next;
+    }
+}
+
+/* Queues a request on the ring of the calling execution stream and suspends
+ * the caller until it completes.  Returns -1 without queuing it if the
+ * execution stream has no ring; a ring is not shared, since its scheduler
+ * could otherwise resume the caller before it is suspended. */
+static int ring_submit_and_wait(abt_io_t *io, uint8_t opcode, int fd,
+                                void *buf, unsigned len, off_t offset,
+                                int *p_res)
+{
+    abt_io_ring_t *ring;
+    unsigned tail;
+    abt_io_op_t op;
+
+    while (1) {
+        int rank;
+        ABT_self_get_xstream_rank(&rank);
+        if (rank >= io->config.num_rings)
+            return -1;
+        ring = &io->rings[rank];
+        tail = *ring->sq_tail;
+        unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+        int num_inflight =
+            __atomic_load_n(&ring->num_inflight, __ATOMIC_RELAXED);
+        if (tail - head < ring->sq_entries &&
+            ring->num_queued + num_inflight < ring->cq_entries)
+            break;
+        /* The ring is full until its scheduler submits and reaps. */
+        ABT_thread_yield();
+    }
+
+    struct io_uring_sqe *sqe = &ring->sqes[tail & ring->sq_mask];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->addr = (uint64_t)(uintptr_t)buf;
+    sqe->len = len;
+    sqe->off = (uint64_t)offset;
+    sqe->user_data = (uint64_t)(uintptr_t)&op;
+    ring->sq_array[tail & ring->sq_mask] = tail & ring->sq_mask;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->num_queued++;
+
+    /* Nothing else runs on this execution stream before the caller is
+     * suspended, so the scheduler cannot resume it too early. */
+    ABT_self_get_thread(&op.thread);
+    ABT_self_suspend();
+    *p_res = op.res;
+    return 0;
+}
+
+static int io_can_suspend(abt_io_t *io)
+{
+    ABT_unit_type type;
+    return io->async && ABT_self_get_type(&type) == ABT_SUCCESS &&
+           type == ABT_UNIT_TYPE_THREAD;
+}
+
+#else /* !ABT_IO_HAVE_URING */
+
+static void ring_progress(abt_io_t *io, abt_io_ring_t *ring)
+{
+    (void)io;
+    (void)ring;
+}
+
+static int io_can_suspend(abt_io_t *io)
+{
+    (void)io;
+    return 0;
+}
+
+#endif /* ABT_IO_HAVE_URING */
+
+static void io_release(abt_io_t *io)
+{
+    if (__atomic_sub_fetch(&io->refs, 1, __ATOMIC_ACQ_REL) != 0)
+        return;
+#ifdef ABT_IO_HAVE_URING
+    if (io->async) {
+        for (int i = 0; i < io->config.num_rings; i++) {
+            ring_free(&io->rings[i]);
+        }
+    }
+#endif
+    free(io->rings);
+    free(io);
+}
+
+/* Scheduler of a ring */
+
+static int sched_init(ABT_sched sched, ABT_sched_config config)
+{
+    abt_io_sched_data_t *p_data =
+        (abt_io_sched_data_t *)calloc(1, sizeof(abt_io_sched_data_t));
+
+    ABT_sched_config_read(config, 2, &p_data->io, &p_data->rank);
+    ABT_sched_set_data(sched, (void *)p_data);
+
+    return ABT_SUCCESS;
+}
+
+static void sched_run(ABT_sched sched)
+{
+    uint32_t work_count = 0, event_count = 0;
+    abt_io_sched_data_t *p_data;
+    abt_io_t *io;
+    abt_io_ring_t *ring;
+    int num_pools;
+    ABT_pool *pools;
+    int target;
+    ABT_bool stop;
+
+    ABT_sched_get_data(sched, (void **)&p_data);
+    io = p_data->io;
+    ring = &io->rings[p_data->rank];
+    ABT_sched_get_num_pools(sched, &num_pools);
+    pools = (ABT_pool *)malloc(num_pools * sizeof(ABT_pool));
+    ABT_sched_get_pools(sched, num_pools, 0, pools);
+
+    while (1) {
+        ABT_thread thread;
+        ABT_pool pool = ABT_POOL_NULL;
+
+        ABT_pool_pop_thread(pools[0], &thread);
+        if (thread == ABT_THREAD_NULL) {
+            /* Try to steal from other pools */
+            for (target = 1; target < num_pools; target++) {
+                ABT_pool_pop_thread(pools[target], &thread);
+                if (thread != ABT_THREAD_NULL) {
+                    pool = pools[target];
+                    break;
+                }
+            }
+        }
+        if (thread != ABT_THREAD_NULL) {
+            ABT_self_schedule(thread, pool);
+        }
+
+        /* Poll in batches while busy and at every iteration while idle. */
+        if (thread == ABT_THREAD_NULL ||
+            ++work_count >= (uint32_t)io->config.poll_freq) {
+            work_count = 0;
+            ring_progress(io, ring);
+            if (thread == ABT_THREAD_NULL && io->config.completion_xstream &&
+                __atomic_load_n(&ring->num_inflight, __ATOMIC_RELAXED) > 0) {
+                /* Let the completion execution stream run on a shared
+                 * core. */
+                sched_yield();
+            }
+        }
+
+        if (++event_count >= ABT_IO_EVENT_FREQ) {
+            event_count = 0;
+            /* Suspended ULTs are in no pool, so wait for their requests. */
+            if (ring->num_queued == 0 &&
+                __atomic_load_n(&ring->num_inflight, __ATOMIC_RELAXED) == 0 &&
+                __atomic_load_n(&ring->completed, __ATOMIC_RELAXED) == NULL) {
+                ABT_sched_has_to_stop(sched, &stop);
+                if (stop == ABT_TRUE)
+                    break;
+            }
+            ABT_xstream_check_events(sched);
+        }
+    }
+
+    free(pools);
+}
+
+static int sched_free(ABT_sched sched)
+{
+    abt_io_sched_data_t *p_data;
+
+    ABT_sched_get_data(sched, (void **)&p_data);
+    io_release(p_data->io);
+    free(p_data);
+
+    return ABT_SUCCESS;
+}
+
+/* Scheduler of the completion execution stream */
+
+static void completion_sched_run(ABT_sched sched)
+{
+    uint32_t event_count = 0;
+    abt_io_sched_data_t *p_data;
+    ABT_bool stop;
+
+    ABT_sched_get_data(sched, (void **)&p_data);
+
+    while (1) {
+        int num_reaped = 0;
+#ifdef ABT_IO_HAVE_URING
+        abt_io_t *io = p_data->io;
+        for (int i = 0; i < io->config.num_rings; i++) {
+            num_reaped += ring_reap(&io->rings[i], 1);
+        }
+#endif
+        if (num_reaped == 0) {
+            /* Let the other execution streams run on a shared core. */
+            sched_yield();
+        }
+
+        if (++event_count >= ABT_IO_EVENT_FREQ) {
+            event_count = 0;
+            ABT_sched_has_to_stop(sched, &stop);
+            if (stop == ABT_TRUE)
+                break;
+            ABT_xstream_check_events(sched);
+        }
+    }
+}
+
+static int completion_sched_free(ABT_sched sched)
+{
+    abt_io_sched_data_t *p_data;
+
+    ABT_sched_get_data(sched, (void **)&p_data);
+    free(p_data);
+
+    return ABT_SUCCESS;
+}
+
+static ABT_sched_config create_sched_config(abt_io_t *io, int rank)
+{
+    ABT_sched_config config;
+    ABT_sched_config_var cv_io = {
+        .idx = 0,
+        .type = ABT_SCHED_CONFIG_PTR,
+    };
+    ABT_sched_config_var cv_rank = {
+        .idx = 1,
+        .type = ABT_SCHED_CONFIG_INT,
+    };
+
+    ABT_sched_config_create(&config, cv_io, (void *)io, cv_rank, rank,
+                            ABT_sched_config_var_end);
+    return config;
+}
+
+void abt_io_config_init(abt_io_config_t *config, int num_xstreams)
+{
+    config->num_rings = num_xstreams;
+    config->entries = ABT_IO_DEFAULT_ENTRIES;
+    config->poll_freq = ABT_IO_DEFAULT_POLL_FREQ;
+    config->completion_xstream = 0;
+}
+
+abt_io_t *abt_io_init(const abt_io_config_t *config)
+{
+    abt_io_t *io = (abt_io_t *)calloc(1, sizeof(abt_io_t));
+    io->config = *config;
+    if (io->config.poll_freq < 1)
+        io->config.poll_freq = 1;
+    io->refs = 1;
+    if (posix_memalign((void **)&io->rings, ABT_IO_CACHELINE_SIZE,
+                       config->num_rings * sizeof(abt_io_ring_t)) != 0) {
+        free(io);
+        return NULL;
+    }
+    memset(io->rings, 0, config->num_rings * sizeof(abt_io_ring_t));
+
+#ifdef ABT_IO_HAVE_URING
+    int i, ret = 0;
+    for (i = 0; i < config->num_rings; i++) {
+        ret = ring_init(&io->rings[i], config->entries);
+        if (ret != 0)
+            break;
+    }
+    if (ret != 0) {
+        while (--i >= 0) {
+            ring_free(&io->rings[i]);
+        }
+        if (ret != -ENOSYS && ret != -EPERM) {
+            free(io->rings);
+            free(io);
+            return NULL;
+        }
+    } else {
+        io->async = 1;
+    }
+#endif
+    if (!io->async)
+        io->config.completion_xstream = 0;
+
+    if (io->config.completion_xstream) {
+        /* The rank after those of the rings keeps ranks and rings aligned. */
+        ABT_pool pool;
+        ABT_sched_config sched_config = create_sched_config(io, -1);
+        ABT_sched_def sched_def = {
+            .type = ABT_SCHED_TYPE_ULT,
+            .init = sched_init,
+            .run = completion_sched_run,
+            .free = completion_sched_free,
+            .get_migr_pool = NULL
+        };
+        ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_TRUE,
+                              &pool);
+        ABT_sched_create(&sched_def, 1, &pool, sched_config,
+                         &io->completion_sched);
+        ABT_sched_config_free(&sched_config);
+        int abt_errno =
+            ABT_xstream_create_with_rank(io->completion_sched,
+                                         config->num_rings,
+                                         &io->completion_xstream);
+        if (abt_errno != ABT_SUCCESS) {
+            /* The rank is taken, so the schedulers reap by themselves. */
+            ABT_sched_free(&io->completion_sched);
+            io->completion_xstream = ABT_XSTREAM_NULL;
+            io->config.completion_xstream = 0;
+        }
+    }
+    return io;
+}
+
+int abt_io_is_async(abt_io_t *io)
+{
+    return io->async;
+}
+
+void abt_io_create_scheds(abt_io_t *io, int num, ABT_pool *pools,
+                          ABT_sched *scheds)
+{
+    ABT_pool *sched_pools;
+    int i, k;
+
+    ABT_sched_def sched_def = {
+        .type = ABT_SCHED_TYPE_ULT,
+        .init = sched_init,
+        .run = sched_run,
+        .free = sched_free,
+        .get_migr_pool = NULL
+    };
+
+    __atomic_add_fetch(&io->refs, num, __ATOMIC_RELAXED);
+    sched_pools = (ABT_pool *)malloc(num * sizeof(ABT_pool));
+    for (i = 0; i < num; i++) {
+        for (k = 0; k < num; k++) {
+            sched_pools[k] = pools[(i + k) % num];
+        }
+
+        ABT_sched_config config = create_sched_config(io, i);
+        ABT_sched_create(&sched_def, num, sched_pools, config, &scheds[i]);
+        ABT_sched_config_free(&config);
+    }
+    free(sched_pools);
+}
+
+ssize_t abt_io_read(abt_io_t *io, int fd, void *buf, size_t count,
+                    off_t offset)
+{
+#ifdef ABT_IO_HAVE_URING
+    int res;
+    if (io_can_suspend(io) &&
+        ring_submit_and_wait(io, IORING_OP_READ, fd, buf, (unsigned)count,
+                             offset, &res) == 0)
+        return res;
+#endif
+    (void)io;
+    ssize_t ret = pread(fd, buf, count, offset);
+    return ret < 0 ? -errno : ret;
+}
+
+ssize_t abt_io_write(abt_io_t *io, int fd, const void *buf, size_t count,
+                     off_t offset)
+{
+#ifdef ABT_IO_HAVE_URING
+    int res;
+    if (io_can_suspend(io) &&
+        ring_submit_and_wait(io, IORING_OP_WRITE, fd, (void *)buf,
+                             (unsigned)count, offset, &res) == 0)
+        return res;
+#endif
+    (void)io;
+    ssize_t ret = pwrite(fd, buf, count, offset);
+    return ret < 0 ? -errno : ret;
+}
+
+int abt_io_fsync(abt_io_t *io, int fd)
+{
+#ifdef ABT_IO_HAVE_URING
+    int res;
+    if (io_can_suspend(io) &&
+        ring_submit_and_wait(io, IORING_OP_FSYNC, fd, NULL, 0, 0, &res) == 0)
+        return res;
+#endif
+    (void)io;
+    return fsync(fd) < 0 ? -errno : 0;
+}
+
+void abt_io_finalize(abt_io_t *io)
+{
+    if (io->completion_xstream != ABT_XSTREAM_NULL) {
+        ABT_xstream_join(io->completion_xstream);
+        ABT_xstream_free(&io->completion_xstream);
+        ABT_sched_free(&io->completion_sched);
+    }
+    io_release(io);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <abt.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+/* Asynchronous file I/O for ULTs on top of io_uring.
+ *
+ * Every execution stream has its own ring.  abt_io_read(), abt_io_write() and
+ * abt_io_fsync() write a submission entry to the ring of the calling
+ * execution stream and suspend the calling ULT with ABT_self_suspend(); the
+ * execution stream keeps running other ULTs meanwhile.  The schedulers
+ * created by abt_io_create_scheds() submit the queued entries of their ring
+ * with one io_uring_enter() call and reap the completions every poll_freq
+ * iterations (and whenever they are idle), resuming the ULTs whose requests
+ * completed.
+ *
+ * With completion_xstream, an additional execution stream of rank num_rings
+ * reaps the completion queues of all the rings and hands the completed
+ * requests back to the owning schedulers, which then only resume the ULTs.
+ * If that rank is taken, the schedulers reap their rings by themselves.
+ *
+ * The ring of a ULT is the one of its execution stream's rank, so execution
+ * stream i must run scheds[i].  A ULT on an execution stream whose rank is
+ * num_rings or higher has no ring, and neither has a tasklet or an external
+ * thread; their calls fall back to blocking pread(), pwrite() and fsync(), as
+ * all calls do if io_uring is not available.
+ *
+ * Usage: ABT_init(), abt_io_init(), abt_io_create_scheds(), create the
+ * execution streams, ..., join them, abt_io_finalize(), ABT_finalize(). */
+
+typedef struct {
+    int num_rings;           /* one per execution stream */
+    unsigned entries;        /* submission queue entries per ring */
+    int poll_freq;           /* scheduler iterations between two polls */
+    int completion_xstream;  /* reap completions on a dedicated xstream */
+} abt_io_config_t;
+
+typedef struct abt_io abt_io_t;
+
+void abt_io_config_init(abt_io_config_t *config, int num_xstreams);
+
+/* Returns NULL if the rings cannot be created for another reason than the
+ * lack of io_uring. */
+abt_io_t *abt_io_init(const abt_io_config_t *config);
+
+/* Returns 1 if the requests go through io_uring, 0 if they block. */
+int abt_io_is_async(abt_io_t *io);
+
+/* Associates each pool with a scheduler that steals from the other pools and
+ * drives the ring of its rank.  num - number of pools (MUST equal to
+ * config->num_rings). */
+void abt_io_create_scheds(abt_io_t *io, int num, ABT_pool *pools,
+                          ABT_sched *scheds);
+
+/* Same semantics as pread(), pwrite() and fsync(), except that errors are
+ * returned as negative errno values. */
+ssize_t abt_io_read(abt_io_t *io, int fd, void *buf, size_t count,
+                    off_t offset);
+ssize_t abt_io_write(abt_io_t *io, int fd, const void *buf, size_t count,
+                     off_t offset);
+int abt_io_fsync(abt_io_t *io, int fd);
+
+/* Stops the completion execution stream.  The rings are closed when the last
+ * scheduler is freed. */
+void abt_io_finalize(abt_io_t *io);
@@ -0,0 +1,311 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/*
+ * This example compares random block reads of ULTs that block their execution
+ * stream in pread() with reads through abt_io (see abt_io.h), which suspend
+ * only the calling ULT.  Every ULT first writes its share of the file and
+ * calls fsync(), then reads random blocks and checks their contents.
+ *
+ * -e [NUM_XSTREAMS] the number of execution streams
+ * -u [NUM_ULTS]     ULTs per execution stream
+ * -n [NUM_READS]    reads per ULT
+ * -b [BLOCK_SIZE]   bytes per read
+ * -s [FILE_SIZE]    file size in MiB
+ * -m [MODE]         0: blocking pread()
+ *                   1: abt_io, completions reaped by each scheduler
+ *                   2: abt_io, completions reaped by a dedicated xstream
+ * -d [DIRECT]       1: open the file with O_DIRECT to bypass the page cache
+ * -f [PATH]         the file (default: io_bench.dat)
+ *
+ * The read throughput and the p50/p99 latency of a read are printed.
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <abt.h>
+
+#include "abt_io.h"
+
+#define DEFAULT_NUM_XSTREAMS 2
+#define DEFAULT_NUM_ULTS 4
+#define DEFAULT_NUM_READS 256
+#define DEFAULT_BLOCK_SIZE 4096
+#define DEFAULT_FILE_SIZE 16 /* [MiB] */
+#define DEFAULT_MODE 1
+#define DEFAULT_PATH "io_bench.dat"
+#define ALIGNMENT 4096
+
+typedef struct {
+    abt_io_t *io;
+    int mode;
+    int fd;
+    int id;
+    int num_ults;
+    size_t block_size;
+    size_t num_blocks;
+    int num_reads;
+    double *latencies; /* [num_reads] */
+    int num_errors;
+} ult_arg_t;
+
+static ssize_t do_read(ult_arg_t *arg, void *buf, off_t offset)
+{
+    if (arg->mode == 0) {
+        return pread(arg->fd, buf, arg->block_size, offset);
+    }
+    return abt_io_read(arg->io, arg->fd, buf, arg->block_size, offset);
+}
+
+static void fill_block(uint64_t *buf, size_t block_size, size_t block)
+{
+    size_t i;
+    for (i = 0; i < block_size / sizeof(uint64_t); i++) {
+        buf[i] = block;
+    }
+}
+
+static void write_blocks(void *p_arg)
+{
+    ult_arg_t *arg = (ult_arg_t *)p_arg;
+    uint64_t *buf;
+    size_t block;
+
+    if (posix_memalign((void **)&buf, ALIGNMENT, arg->block_size) != 0) {
+        arg->num_errors++;
+        return;
+    }
+    for (block = arg->id; block < arg->num_blocks; block += arg->num_ults) {
+        off_t offset = (off_t)(block * arg->block_size);
+        ssize_t ret;
+        fill_block(buf, arg->block_size, block);
+        if (arg->mode == 0) {
+            ret = pwrite(arg->fd, buf, arg->block_size, offset);
+        } else {
+            ret = abt_io_write(arg->io, arg->fd, buf, arg->block_size, offset);
+        }
+        if (ret != (ssize_t)arg->block_size)
+            arg->num_errors++;
+    }
+    if (arg->id == 0) {
+        int ret = (arg->mode == 0) ? fsync(arg->fd)
+                                   : abt_io_fsync(arg->io, arg->fd);
+        if (ret != 0)
+            arg->num_errors++;
+    }
+    free(buf);
+}
+
+static void read_blocks(void *p_arg)
+{
+    ult_arg_t *arg = (ult_arg_t *)p_arg;
+    unsigned int seed = (unsigned int)arg->id * 7919 + 1;
+    uint64_t *buf;
+    int i;
+
+    if (posix_memalign((void **)&buf, ALIGNMENT, arg->block_size) != 0) {
+        arg->num_errors++;
+        return;
+    }
+    for (i = 0; i < arg->num_reads; i++) {
+        size_t block = (size_t)rand_r(&seed) % arg->num_blocks;
+        double start_time = ABT_get_wtime();
+        ssize_t ret = do_read(arg, buf, (off_t)(block * arg->block_size));
+        arg->latencies[i] = ABT_get_wtime() - start_time;
+        if (ret != (ssize_t)arg->block_size || buf[0] != block ||
+            buf[arg->block_size / sizeof(uint64_t) - 1] != block)
+            arg->num_errors++;
+    }
+    free(buf);
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double da = *(const double *)a, db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+static void run_ults(void (*func)(void *), ult_arg_t *args, int num_ults,
+                     ABT_pool *pools, int num_xstreams)
+{
+    int i;
+    ABT_thread *threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_ults);
+    for (i = 0; i < num_ults; i++) {
+        ABT_thread_create(pools[i % num_xstreams], func, &args[i],
+                          ABT_THREAD_ATTR_NULL, &threads[i]);
+    }
+    for (i = 0; i < num_ults; i++) {
+        ABT_thread_free(&threads[i]);
+    }
+    free(threads);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_ults_per_xstream = DEFAULT_NUM_ULTS;
+    int num_reads = DEFAULT_NUM_READS;
+    size_t block_size = DEFAULT_BLOCK_SIZE;
+    size_t file_size = DEFAULT_FILE_SIZE;
+    int mode = DEFAULT_MODE;
+    int direct = 0;
+    const char *path = DEFAULT_PATH;
+    int i;
+
+    while (1) {
+        int opt = getopt(argc, argv, "he:u:n:b:s:m:d:f:");
+        if (opt == -1)
+            break;
+        switch (opt) {
+            case 'e':
+                num_xstreams = atoi(optarg);
+                break;
+            case 'u':
+                num_ults_per_xstream = atoi(optarg);
+                break;
+            case 'n':
+                num_reads = atoi(optarg);
+                break;
+            case 'b':
+                block_size = (size_t)atol(optarg);
+                break;
+            case 's':
+                file_size = (size_t)atol(optarg);
+                break;
+            case 'm':
+                mode = atoi(optarg);
+                break;
+            case 'd':
+                direct = atoi(optarg);
+                break;
+            case 'f':
+                path = optarg;
+                break;
+            case 'h':
+            default:
+                printf("Usage: ./io_bench [-e NUM_XSTREAMS] [-u NUM_ULTS] "
+                       "[-n NUM_READS] [-b BLOCK_SIZE] [-s FILE_SIZE] "
+                       "[-m MODE] [-d DIRECT] [-f PATH]\n"
+                       "MODE = 0 : blocking pread()\n"
+                       "       1 : abt_io, polled by each scheduler\n"
+                       "       2 : abt_io, polled by a completion xstream\n");
+                return -1;
+        }
+    }
+    if (num_xstreams < 1 || num_ults_per_xstream < 1 || num_reads < 1 ||
+        block_size % ALIGNMENT != 0 || mode < 0 || mode > 2) {
+        printf("Invalid arguments.  BLOCK_SIZE must be a multiple of %d.\n",
+               ALIGNMENT);
+        return -1;
+    }
+    size_t num_blocks = file_size * 1024 * 1024 / block_size;
+    if (num_blocks == 0) {
+        printf("FILE_SIZE must hold at least one block.\n");
+        return -1;
+    }
+
+    int fd = open(path, O_CREAT | O_RDWR | O_TRUNC | (direct ? O_DIRECT : 0),
+                  0600);
+    if (fd < 0) {
+        perror("open");
+        return -1;
+    }
+
+    ABT_init(argc, argv);
+
+    /* Set up rings, pools and schedulers. */
+    abt_io_config_t config;
+    abt_io_config_init(&config, num_xstreams);
+    config.completion_xstream = (mode == 2);
+    abt_io_t *io = abt_io_init(&config);
+    if (!io) {
+        printf("abt_io_init() failed.\n");
+        return -1;
+    }
+    if (mode != 0 && !abt_io_is_async(io)) {
+        printf("io_uring is not available: abt_io blocks.\n");
+    }
+    ABT_xstream *xstreams =
+        (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    ABT_pool *pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    ABT_sched *scheds = (ABT_sched *)malloc(sizeof(ABT_sched) * num_xstreams);
+    for (i = 0; i < num_xstreams; i++) {
+        ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_TRUE,
+                              &pools[i]);
+    }
+    abt_io_create_scheds(io, num_xstreams, pools, scheds);
+    ABT_xstream_self(&xstreams[0]);
+    ABT_xstream_set_main_sched(xstreams[0], scheds[0]);
+    for (i = 1; i < num_xstreams; i++) {
+        ABT_xstream_create(scheds[i], &xstreams[i]);
+    }
+
+    int num_ults = num_xstreams * num_ults_per_xstream;
+    ult_arg_t *args = (ult_arg_t *)calloc(num_ults, sizeof(ult_arg_t));
+    double *latencies = (double *)malloc(sizeof(double) * num_ults * num_reads);
+    for (i = 0; i < num_ults; i++) {
+        args[i].io = io;
+        args[i].mode = mode;
+        args[i].fd = fd;
+        args[i].id = i;
+        args[i].num_ults = num_ults;
+        args[i].block_size = block_size;
+        args[i].num_blocks = num_blocks;
+        args[i].num_reads = num_reads;
+        args[i].latencies = &latencies[i * num_reads];
+    }
+
+    /* Write the file, then read random blocks. */
+    run_ults(write_blocks, args, num_ults, pools, num_xstreams);
+    double start_time = ABT_get_wtime();
+    run_ults(read_blocks, args, num_ults, pools, num_xstreams);
+    double elapsed = ABT_get_wtime() - start_time;
+
+    int num_errors = 0;
+    for (i = 0; i < num_ults; i++) {
+        num_errors += args[i].num_errors;
+    }
+    int num_total_reads = num_ults * num_reads;
+    qsort(latencies, num_total_reads, sizeof(double), compare_doubles);
+    printf("mode = %d (%s), %d xstreams, %d ULTs, %zu B blocks%s\n", mode,
+           mode == 0 ? "pread" : (abt_io_is_async(io) ? "io_uring" : "pread"),
+           num_xstreams, num_ults, block_size, direct ? ", O_DIRECT" : "");
+    printf("elapsed time = %f [s]\n", elapsed);
+    printf("throughput = %f [reads/s], %f [MiB/s]\n", num_total_reads / elapsed,
+           num_total_reads * (double)block_size / elapsed / (1024 * 1024));
+    printf("latency: p50 = %f [us], p99 = %f [us]\n",
+           latencies[(num_total_reads - 1) / 2] * 1.0e6,
+           latencies[(int)((num_total_reads - 1) * 0.99)] * 1.0e6);
+    if (num_errors) {
+        printf("%d operations failed or read wrong data\n", num_errors);
+    }
+
+    /* Join secondary execution streams. */
+    for (i = 1; i < num_xstreams; i++) {
+        ABT_xstream_join(xstreams[i]);
+        ABT_xstream_free(&xstreams[i]);
+    }
+    for (i = 1; i < num_xstreams; i++) {
+        ABT_sched_free(&scheds[i]);
+    }
+    abt_io_finalize(io);
+
+    ABT_finalize();
+
+    close(fd);
+    unlink(path);
+    free(args);
+    free(latencies);
+    free(xstreams);
+    free(pools);
+    free(scheds);
+
+    return num_errors ? -1 : 0;
+}
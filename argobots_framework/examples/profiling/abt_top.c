@@ -0,0 +1,291 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/*
+ * abt_top prints the rates of the live counters of a running Argobots program,
+ * like top.  The program must use Argobots configured with --enable-stats and
+ * run with ABT_STATS=1, which makes ABT_init() publish per-ES and per-pool
+ * counters in a shared-memory file (see abt_stats.h).  abt_top only maps the
+ * file read-only, so it does not stop or slow down the program.
+ *
+ * -p [PID]        read /dev/shm/abt_stats.<PID>
+ * -f [FILE]       read FILE (the value of ABT_STATS_FILE)
+ * -i [INTERVAL]   sampling interval in ms
+ * -n [NUM_ITERS]  the number of samples to print (0: until the program ends)
+ *
+ * Per ES, it prints pushes, pops, steals (pops from pools of other ESs), empty
+ * pops (scheduler iterations that found no work), ULTs and tasklets created
+ * and finished, and context switches per second, and the hit ratio of the
+ * local memory pool.  Per pool, it prints pushes, pops, steals, and empty pops
+ * per second.  Pools that did not get a slot of their own are shown as
+ * "other".
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "abt_stats.h"
+
+#define DEFAULT_INTERVAL 1000 /* [ms] */
+#define OPEN_TIMEOUT 5.0      /* [s] */
+
+typedef struct {
+    double time;
+    ABT_stats_xstream *xstreams;
+    ABT_stats_pool *pools;
+} snapshot_t;
+
+static double get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1.0e-9;
+}
+
+static void sleep_ms(int ms)
+{
+    struct timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (long)(ms % 1000) * 1000000;
+    nanosleep(&ts, NULL);
+}
+
+/* Maps the file and waits until the writer initializes it. */
+static const ABT_stats_header *map_stats(const char *filename, size_t *p_size)
+{
+    double start_time = get_time();
+    while (1) {
+        int fd = open(filename, O_RDONLY);
+        if (fd != -1) {
+            struct stat st;
+            if (fstat(fd, &st) == 0 &&
+                (size_t)st.st_size >= sizeof(ABT_stats_header)) {
+                void *p_page = mmap(NULL, (size_t)st.st_size, PROT_READ,
+                                    MAP_SHARED, fd, 0);
+                close(fd);
+                if (p_page == MAP_FAILED) {
+                    perror("mmap");
+                    return NULL;
+                }
+                const ABT_stats_header *p_hdr =
+                    (const ABT_stats_header *)p_page;
+                if (__atomic_load_n(&p_hdr->magic, __ATOMIC_ACQUIRE) ==
+                    ABT_STATS_MAGIC) {
+                    *p_size = (size_t)st.st_size;
+                    return p_hdr;
+                }
+                munmap(p_page, (size_t)st.st_size);
+            } else {
+                close(fd);
+            }
+        }
+        if (get_time() - start_time > OPEN_TIMEOUT) {
+            fprintf(stderr, "%s is not an Argobots statistics file.\n",
+                    filename);
+            return NULL;
+        }
+        sleep_ms(100);
+    }
+}
+
+static void take_snapshot(const ABT_stats_header *p_hdr, snapshot_t *p_snap)
+{
+    const char *p_base = (const char *)p_hdr;
+    /* Each word is updated atomically, so a plain copy does not tear a
+     * counter. */
+    memcpy(p_snap->xstreams, p_base + p_hdr->xstream_offset,
+           sizeof(ABT_stats_xstream) * p_hdr->max_xstreams);
+    memcpy(p_snap->pools, p_base + p_hdr->pool_offset,
+           sizeof(ABT_stats_pool) * p_hdr->max_pools);
+    p_snap->time = get_time();
+}
+
+static void format_rate(char *buf, uint64_t delta, double elapsed)
+{
+    double rate = delta / elapsed;
+    if (rate >= 1.0e9) {
+        sprintf(buf, "%.1fG", rate * 1.0e-9);
+    } else if (rate >= 1.0e6) {
+        sprintf(buf, "%.1fM", rate * 1.0e-6);
+    } else if (rate >= 1.0e4) {
+        sprintf(buf, "%.1fK", rate * 1.0e-3);
+    } else {
+        sprintf(buf, "%.0f", rate);
+    }
+}
+
+static void print_rates(const ABT_stats_header *p_hdr, const snapshot_t *p_prev,
+                        const snapshot_t *p_cur)
+{
+    static const char *xstream_labels[ABT_STATS_XSTREAM_NUM_COUNTERS - 2] = {
+        "push/s", "pop/s", "steal/s", "empty/s", "create/s", "finish/s",
+        "switch/s"
+    };
+    static const char *pool_labels[ABT_STATS_POOL_NUM_COUNTERS] = {
+        "push/s", "pop/s", "steal/s", "empty/s"
+    };
+    const double elapsed = p_cur->time - p_prev->time;
+    char buf[32];
+    uint32_t i;
+    int kind, num_xstreams = 0, num_pools = 0;
+
+    for (i = 0; i < p_hdr->max_xstreams; i++)
+        num_xstreams += p_cur->xstreams[i].in_use ? 1 : 0;
+    for (i = 1; i < p_hdr->max_pools; i++)
+        num_pools += p_cur->pools[i].in_use ? 1 : 0;
+    printf("abt_top - pid %u, %d ESs, %d pools, interval %.2f [s]\n\n",
+           p_hdr->pid, num_xstreams, num_pools, elapsed);
+
+    printf("%5s", "ES");
+    for (kind = 0; kind < ABT_STATS_XSTREAM_NUM_COUNTERS - 2; kind++)
+        printf(" %9s", xstream_labels[kind]);
+    printf(" %9s\n", "mem-hit%");
+    for (i = 0; i < p_hdr->max_xstreams; i++) {
+        const ABT_stats_xstream *p_c = &p_cur->xstreams[i];
+        const ABT_stats_xstream *p_p = &p_prev->xstreams[i];
+        if (!p_c->in_use && !p_p->in_use)
+            continue;
+        printf("%5u", i);
+        for (kind = 0; kind < ABT_STATS_XSTREAM_NUM_COUNTERS - 2; kind++) {
+            format_rate(buf, p_c->counters[kind] - p_p->counters[kind],
+                        elapsed);
+            printf(" %9s", buf);
+        }
+        uint64_t hits = p_c->counters[ABT_STATS_XSTREAM_MEM_POOL_HITS] -
+                        p_p->counters[ABT_STATS_XSTREAM_MEM_POOL_HITS];
+        uint64_t misses = p_c->counters[ABT_STATS_XSTREAM_MEM_POOL_MISSES] -
+                          p_p->counters[ABT_STATS_XSTREAM_MEM_POOL_MISSES];
+        if (hits + misses == 0) {
+            printf(" %9s\n", "-");
+        } else {
+            printf(" %8.1f%%\n", hits * 100.0 / (hits + misses));
+        }
+    }
+
+    printf("\n%5s", "pool");
+    for (kind = 0; kind < ABT_STATS_POOL_NUM_COUNTERS; kind++)
+        printf(" %9s", pool_labels[kind]);
+    printf("\n");
+    for (i = 0; i < p_hdr->max_pools; i++) {
+        const ABT_stats_pool *p_c = &p_cur->pools[i];
+        const ABT_stats_pool *p_p = &p_prev->pools[i];
+        if (!p_c->in_use)
+            continue;
+        /* A new pool took the slot, so its counters started from zero. */
+        const int is_new = (!p_p->in_use || p_p->id != p_c->id);
+        uint64_t sum = 0;
+        for (kind = 0; kind < ABT_STATS_POOL_NUM_COUNTERS; kind++)
+            sum += p_c->counters[kind];
+        if (i == 0 && sum == 0)
+            continue;
+        if (i == 0) {
+            printf("%5s", "other");
+        } else {
+            printf("%5llu", (unsigned long long)p_c->id);
+        }
+        for (kind = 0; kind < ABT_STATS_POOL_NUM_COUNTERS; kind++) {
+            uint64_t prev = is_new ? 0 : p_p->counters[kind];
+            format_rate(buf, p_c->counters[kind] - prev, elapsed);
+            printf(" %9s", buf);
+        }
+        printf("\n");
+    }
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *filename = NULL;
+    char filename_buf[64];
+    int interval = DEFAULT_INTERVAL;
+    int num_iters = 0;
+
+    while (1) {
+        int opt = getopt(argc, argv, "hp:f:i:n:");
+        if (opt == -1)
+            break;
+        switch (opt) {
+            case 'p':
+                sprintf(filename_buf, "/dev/shm/abt_stats.%d", atoi(optarg));
+                filename = filename_buf;
+                break;
+            case 'f':
+                filename = optarg;
+                break;
+            case 'i':
+                interval = atoi(optarg);
+                break;
+            case 'n':
+                num_iters = atoi(optarg);
+                break;
+            case 'h':
+            default:
+                printf("Usage: ./abt_top (-p PID | -f FILE) [-i INTERVAL] "
+                       "[-n NUM_ITERS]\n");
+                return -1;
+        }
+    }
+    if (!filename || interval <= 0 || num_iters < 0) {
+        printf("Usage: ./abt_top (-p PID | -f FILE) [-i INTERVAL] "
+               "[-n NUM_ITERS]\n");
+        return -1;
+    }
+
+    size_t size;
+    const ABT_stats_header *p_hdr = map_stats(filename, &size);
+    if (!p_hdr)
+        return -1;
+    if (p_hdr->version != ABT_STATS_VERSION ||
+        p_hdr->num_xstream_counters != ABT_STATS_XSTREAM_NUM_COUNTERS ||
+        p_hdr->num_pool_counters != ABT_STATS_POOL_NUM_COUNTERS ||
+        p_hdr->pool_offset + sizeof(ABT_stats_pool) * p_hdr->max_pools >
+            size) {
+        fprintf(stderr, "%s has an unsupported layout (version %u).\n",
+                filename, p_hdr->version);
+        munmap((void *)p_hdr, size);
+        return -1;
+    }
+
+    snapshot_t snaps[2];
+    int i;
+    for (i = 0; i < 2; i++) {
+        snaps[i].xstreams = (ABT_stats_xstream *)
+            malloc(sizeof(ABT_stats_xstream) * p_hdr->max_xstreams);
+        snaps[i].pools =
+            (ABT_stats_pool *)malloc(sizeof(ABT_stats_pool) * p_hdr->max_pools);
+    }
+    const int is_tty = isatty(STDOUT_FILENO);
+    int cur = 0, iter = 0;
+    take_snapshot(p_hdr, &snaps[cur]);
+    while (num_iters == 0 || iter < num_iters) {
+        sleep_ms(interval);
+        if (__atomic_load_n(&p_hdr->finalized, __ATOMIC_RELAXED)) {
+            printf("Process %u has finalized Argobots.\n", p_hdr->pid);
+            break;
+        }
+        cur = 1 - cur;
+        take_snapshot(p_hdr, &snaps[cur]);
+        if (is_tty) {
+            /* Redraw the screen like top. */
+            printf("\033[H\033[2J");
+        } else if (iter > 0) {
+            printf("\n");
+        }
+        print_rates(p_hdr, &snaps[1 - cur], &snaps[cur]);
+        iter++;
+    }
+
+    for (i = 0; i < 2; i++) {
+        free(snaps[i].xstreams);
+        free(snaps[i].pools);
+    }
+    munmap((void *)p_hdr, size);
+    return 0;
+}
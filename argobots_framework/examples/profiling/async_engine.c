@@ -15,7 +15,15 @@
  *                stream
  * -t [TIME]      total issuing time.  Throughput will be at most NUM_OPS / TIME
  * -s [SIZE]      computation size of each operation
- * -m [WAIT]      use ABT_POOL_FIFO_WAIT or not.
+ * -m [WAIT]      use ABT_POOL_FIFO_WAIT or not.  -w is accepted as well.
+ * -b [RATIO]     every RATIO-th operation is a background operation whose
+ *                size is BACKGROUND_SIZE_FACTOR * SIZE.  0 disables them.
+ * -d [EDF]       use per-ES ABT_POOL_EDF pools and ABT_SCHED_EDF.  Urgent
+ *                operations get a deadline of URGENT_SLACK after creation and
+ *                background ones BACKGROUND_SLACK.
+ * -x [ELASTIC]   use per-ES pools and the elastic work stealing schedulers,
+ *                which park idle secondary execution streams and revive them
+ *                when operations queue up (see abt_elastic_scheduler.h).
  * -p [PROF_MODE] 0: disabled, 1: basic, 2: detailed.
  *
  * The input parameters affect the following performance numbers.
@@ -54,6 +62,22 @@
  *   on completion.  WAIT=1 can increase this value since it may suspend
  *   underlying execution streams in ABT_pool_wait().
  *
+ * - Create latency
+ *   p50/p99 of the time that ABT_thread_create() takes on the primary
+ *   execution stream.  With WAIT=1, this includes waking up a sleeping
+ *   execution stream, which happens only if one is sleeping.
+ *
+ * - Completion latency per operation class
+ *   p50/p99 of the time between creating an operation and its completion,
+ *   separately for urgent and background operations.  With background
+ *   operations, a FIFO engine lets urgent ones wait behind long ones, which
+ *   inflates their p99; EDF=1 runs urgent operations first.
+ *
+ * - Elastic execution streams
+ *   With ELASTIC=1, the average number of running secondary execution streams
+ *   and the number of parks and revives.  If NUM_OPS / TIME is small, fewer
+ *   execution streams run, which leaves cores to other processes.
+ *
  * This example also shows when to use ABTX_PROF_ASSUME_SCHED_ALWAYS_ACTIVE.  If
  * developers want to know "real execution time" of backend execution streams,
  * please set zero.
@@ -70,12 +94,18 @@
  * sleep in ABT_pool_pop_timedwait(). */
 #define ABTX_PROF_ASSUME_SCHED_ALWAYS_ACTIVE 0
 #include "abtx_prof.h"
+#include "abt_elastic_scheduler.h"
 
 #define DEFAULT_SIZE 1024
 #define DEFAULT_NUM_XSTREAMS 3 /* Must be larger than 1. */
 #define DEFAULT_N 1024
 #define DEFAULT_WAIT 0
 #define DEFAULT_DURATION 5.0
+#define DEFAULT_BACKGROUND_RATIO 0
+
+#define BACKGROUND_SIZE_FACTOR 16
+#define URGENT_SLACK 1.0e-3     /* [s] */
+#define BACKGROUND_SLACK 1.0e-1 /* [s] */
 
 #define THREAD_POOL_SIZE 256  /* The maximum number of ops in the pool. */
 #define POOL_POP_WAIT_SEC 0.1 /* [s] */
@@ -98,12 +128,33 @@ void compute(int n)
 typedef struct {
     ABT_thread thread;
     int size;
+    int is_background;
+    double create_time;
+    double end_time;
 } operation_arg_t;
 
 void operation(void *arg)
 {
-    int size = ((operation_arg_t *)arg)->size;
-    compute(size);
+    operation_arg_t *op = (operation_arg_t *)arg;
+    compute(op->size);
+    op->end_time = ABT_get_wtime();
+}
+
+int compare_doubles(const void *a, const void *b)
+{
+    double da = *(const double *)a, db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+void print_latency(int step, const char *name, double *latencies, int num)
+{
+    if (num == 0)
+        return;
+    qsort(latencies, num, sizeof(double), compare_doubles);
+    printf("[%d] %s completion latency: p50 = %f [us], p99 = %f [us] "
+           "(%d ops)\n",
+           step, name, latencies[(num - 1) / 2] * 1.0e6,
+           latencies[(int)((num - 1) * 0.99)] * 1.0e6, num);
 }
 
 /* Scheduler */
@@ -156,9 +207,12 @@ int main(int argc, char *argv[])
     int n = DEFAULT_N;
     double duration = DEFAULT_DURATION;
     g_wait_mode = DEFAULT_WAIT;
+    int background_ratio = DEFAULT_BACKGROUND_RATIO;
+    int edf_mode = 0;
+    int elastic_mode = 0;
     int prof_mode = 1;
     while (1) {
-        int opt = getopt(argc, argv, "he:n:t:s:w:p:");
+        int opt = getopt(argc, argv, "he:n:t:s:m:w:b:d:x:p:");
         if (opt == -1)
             break;
         switch (opt) {
@@ -174,9 +228,19 @@ int main(int argc, char *argv[])
             case 's':
                 size = atoi(optarg);
                 break;
+            case 'm':
             case 'w':
                 g_wait_mode = atoi(optarg);
                 break;
+            case 'b':
+                background_ratio = atoi(optarg);
+                break;
+            case 'd':
+                edf_mode = atoi(optarg);
+                break;
+            case 'x':
+                elastic_mode = atoi(optarg);
+                break;
             case 'p':
                 prof_mode = atoi(optarg);
                 break;
@@ -184,7 +248,16 @@ int main(int argc, char *argv[])
             default:
                 printf(
                     "Usage: ./async_engine [-e NUM_XSTREAMS] [-n N] [-t TIME] "
-                    "[-s SIZE] [-w WAIT] [-p PROF_MODE]\n"
+                    "[-s SIZE] [-m WAIT] [-b RATIO] [-d EDF] "
+                    "[-x ELASTIC] [-p PROF_MODE]\n"
+                    "WAIT      = 0 : ABT_POOL_FIFO\n"
+                    "            1 : ABT_POOL_FIFO_WAIT\n"
+                    "RATIO     = N : every N-th operation is a background "
+                    "operation (0: none)\n"
+                    "EDF       = 0 : shared FIFO pool\n"
+                    "            1 : per-ES EDF pools and schedulers\n"
+                    "ELASTIC   = 0 : fixed number of execution streams\n"
+                    "            1 : park idle execution streams\n"
                     "PROF_MODE = 0 : disable ABTX profiler\n"
                     "            1 : enable ABTX profiler (basic)\n"
                     "            2 : enable ABTX profiler (advanced)\n");
@@ -195,6 +268,10 @@ int main(int argc, char *argv[])
         printf("NUM_XSTERAMS (=`%d`) must be larger than 1.\n", num_xstreams);
         return -1;
     }
+    if (edf_mode && elastic_mode) {
+        printf("EDF and ELASTIC cannot be used together.\n");
+        return -1;
+    }
     if (n <= 0) {
         printf("N (=`%d`) must be larger than 0.\n", n);
         return -1;
@@ -206,8 +283,13 @@ int main(int argc, char *argv[])
         (ABT_xstream *)malloc(sizeof(ABT_xstream) * (num_xstreams - 1));
     ABT_sched *engine_scheds =
         (ABT_sched *)malloc(sizeof(ABT_sched) * (num_xstreams - 1));
+    ABT_pool *engine_pools =
+        (ABT_pool *)malloc(sizeof(ABT_pool) * (num_xstreams - 1));
     operation_arg_t *ops =
         (operation_arg_t *)malloc(THREAD_POOL_SIZE * sizeof(operation_arg_t));
+    double *urgent_latencies = (double *)malloc(n * sizeof(double));
+    double *background_latencies = (double *)malloc(n * sizeof(double));
+    double *create_latencies = (double *)malloc(n * sizeof(double));
 
     /* Initialize Argobots. */
     ABT_init(argc, argv);
@@ -218,11 +300,28 @@ int main(int argc, char *argv[])
     prof_init = ABTX_prof_init(&prof_context);
 
     /* Set up pools */
-    ABT_pool primary_pool, engine_pool;
+    ABT_pool primary_pool;
     ABT_xstream_self(&primary_xstream);
     ABT_xstream_get_main_pools(primary_xstream, 1, &primary_pool);
-    ABT_pool_create_basic(g_wait_mode == 0 ? ABT_POOL_FIFO : ABT_POOL_FIFO_WAIT,
-                          ABT_POOL_ACCESS_MPMC, ABT_TRUE, &engine_pool);
+    if (elastic_mode) {
+        for (i = 0; i < num_xstreams - 1; i++) {
+            ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_TRUE,
+                                  &engine_pools[i]);
+        }
+    } else if (edf_mode == 0) {
+        /* All the engine execution streams share one pool. */
+        ABT_pool_create_basic(g_wait_mode == 0 ? ABT_POOL_FIFO
+                                               : ABT_POOL_FIFO_WAIT,
+                              ABT_POOL_ACCESS_MPMC, ABT_TRUE, &engine_pools[0]);
+        for (i = 1; i < num_xstreams - 1; i++) {
+            engine_pools[i] = engine_pools[0];
+        }
+    } else {
+        for (i = 0; i < num_xstreams - 1; i++) {
+            ABT_pool_create_basic(ABT_POOL_EDF, ABT_POOL_ACCESS_MPMC, ABT_TRUE,
+                                  &engine_pools[i]);
+        }
+    }
 
     /* Create schedulers. */
     ABT_sched_def engine_sched_def = { .type = ABT_SCHED_TYPE_ULT,
@@ -230,10 +329,32 @@ int main(int argc, char *argv[])
                                        .run = sched_run,
                                        .free = sched_free,
                                        .get_migr_pool = NULL };
-    for (i = 0; i < num_xstreams - 1; i++) {
-        ABT_sched_create(&engine_sched_def, 1, &engine_pool,
-                         ABT_SCHED_CONFIG_NULL, &engine_scheds[i]);
+    elastic_t *elastic = NULL;
+    if (elastic_mode) {
+        elastic_config_t elastic_config;
+        ABT_elastic_config_from_env(&elastic_config, num_xstreams - 1);
+        elastic = ABT_create_elastic_scheds(num_xstreams - 1, engine_pools,
+                                            engine_scheds, &elastic_config);
+    }
+    for (i = 0; i < num_xstreams - 1 && !elastic_mode; i++) {
+        if (edf_mode == 0) {
+            ABT_sched_create(&engine_sched_def, 1, &engine_pools[i],
+                             ABT_SCHED_CONFIG_NULL, &engine_scheds[i]);
+        } else {
+            /* The own pool comes first; the others are stolen from. */
+            int k;
+            ABT_pool *my_pools =
+                (ABT_pool *)malloc(sizeof(ABT_pool) * (num_xstreams - 1));
+            for (k = 0; k < num_xstreams - 1; k++) {
+                my_pools[k] = engine_pools[(i + k) % (num_xstreams - 1)];
+            }
+            ABT_sched_create_basic(ABT_SCHED_EDF, num_xstreams - 1, my_pools,
+                                   ABT_SCHED_CONFIG_NULL, &engine_scheds[i]);
+            free(my_pools);
+        }
     }
+    ABT_thread_attr deadline_attr;
+    ABT_thread_attr_create(&deadline_attr);
 
     /* Create execution streams */
     for (i = 0; i < num_xstreams - 1; i++) {
@@ -259,6 +380,7 @@ int main(int argc, char *argv[])
         /* Create total_ops threads in duration [s]. */
         int num_completed_ops = 0;
         int num_created_ops = 0;
+        int num_urgent_ops = 0, num_background_ops = 0;
         int num_total_ops = (step == 0) ? THREAD_POOL_SIZE : n;
         if (num_total_ops >= n)
             num_total_ops = n;
@@ -284,6 +406,13 @@ int main(int argc, char *argv[])
                     ABT_thread_get_state(ops[i].thread, &state);
                     if (state == ABT_THREAD_STATE_TERMINATED) {
                         ABT_thread_free(&ops[i].thread);
+                        double latency = ops[i].end_time - ops[i].create_time;
+                        if (ops[i].is_background) {
+                            background_latencies[num_background_ops++] =
+                                latency;
+                        } else {
+                            urgent_latencies[num_urgent_ops++] = latency;
+                        }
                         /* ABT_THREAD_NULL is set to ops[i].thread in
                          * ABT_thread_free(). */
                         num_completed_ops++;
@@ -291,9 +420,28 @@ int main(int argc, char *argv[])
                 }
                 if (create_flag && ops[i].thread == ABT_THREAD_NULL) {
                     /* Create a new thread. */
-                    ops[i].size = size;
-                    ABT_thread_create(engine_pool, operation, &ops[i],
-                                      ABT_THREAD_ATTR_NULL, &ops[i].thread);
+                    ops[i].is_background =
+                        background_ratio > 0 &&
+                        (num_created_ops + 1) % background_ratio == 0;
+                    ops[i].size = ops[i].is_background
+                                      ? size * BACKGROUND_SIZE_FACTOR
+                                      : size;
+                    ops[i].create_time = ABT_get_wtime();
+                    ABT_thread_attr attr = ABT_THREAD_ATTR_NULL;
+                    if (edf_mode != 0) {
+                        double slack = ops[i].is_background ? BACKGROUND_SLACK
+                                                            : URGENT_SLACK;
+                        ABT_thread_attr_set_deadline(deadline_attr,
+                                                     ops[i].create_time +
+                                                         slack);
+                        attr = deadline_attr;
+                    }
+                    ABT_pool pool =
+                        engine_pools[num_created_ops % (num_xstreams - 1)];
+                    ABT_thread_create(pool, operation, &ops[i], attr,
+                                      &ops[i].thread);
+                    create_latencies[num_created_ops] =
+                        ABT_get_wtime() - ops[i].create_time;
                     create_flag = 0;
                     num_created_ops++;
                     if (num_created_ops == num_total_ops)
@@ -324,6 +472,15 @@ int main(int argc, char *argv[])
             printf("[%d] approx. operation granularity = %f [us]\n", step,
                    (compute_end_time - compute_start_time) / num_computes *
                        1.0e6);
+            qsort(create_latencies, num_total_ops, sizeof(double),
+                  compare_doubles);
+            printf("[%d] create latency: p50 = %f [us], p99 = %f [us]\n",
+                   step, create_latencies[(num_total_ops - 1) / 2] * 1.0e6,
+                   create_latencies[(int)((num_total_ops - 1) * 0.99)] *
+                       1.0e6);
+            print_latency(step, "urgent", urgent_latencies, num_urgent_ops);
+            print_latency(step, "background", background_latencies,
+                          num_background_ops);
 
             if (prof_init == ABT_SUCCESS &&
                 (prof_mode == 1 || prof_mode == 2)) {
@@ -334,6 +491,19 @@ int main(int argc, char *argv[])
         }
     }
 
+    ABT_thread_attr_free(&deadline_attr);
+
+    /* A parked execution stream does not see the join request. */
+    if (elastic) {
+        elastic_stats_t stats;
+        ABT_elastic_stop(elastic, &stats);
+        printf("##############################\n");
+        printf("elastic: %f execution streams on average, %lu parks, "
+               "%lu revives\n",
+               stats.avg_xstreams, (unsigned long)stats.num_parks,
+               (unsigned long)stats.num_revives);
+    }
+
     /* Join secondary execution streams. */
     for (i = 0; i < num_xstreams - 1; i++) {
         ABT_xstream_join(engine_xstreams[i]);
@@ -357,7 +527,11 @@ int main(int argc, char *argv[])
 
     free(engine_xstreams);
     free(engine_scheds);
+    free(engine_pools);
     free(ops);
+    free(urgent_latencies);
+    free(background_latencies);
+    free(create_latencies);
 
     return 0;
 }
@@ -29,6 +29,15 @@
  *   ratio.  In general, users should to keep this number as high as possible
  *   (e.g., 95%).
  *
+ * - Adaptive cut-off
+ *   With -a ADAPTIVE (ADAPTIVE > 0), the pools are work-stealing deques and a
+ *   ULT is created only while the deque of another execution stream is empty
+ *   and fewer than ADAPTIVE units are waiting in the local deque (see
+ *   abt_spawn.h); otherwise the child runs inline.  CUTOFF
+ *   then only sets the grain of the serial loop, so a small CUTOFF no longer
+ *   multiplies the fork-join overheads.  The number of created ULTs is
+ *   printed after each run.
+ *
  * This example also shows that the overall execution time is affected by the
  * profiling mode (-p PROF_MODE).
  */
@@ -41,13 +50,17 @@
 #include <abt.h>
 
 #include "abtx_prof.h"
+#include "abt_spawn.h"
 
 #define DEFAULT_NUM_XSTREAMS 4
 #define DEFAULT_N (8 * 1024 * 1024)
 #define DEFAULT_CUTOFF 1024
+#define DEFAULT_ADAPTIVE 0
 #define NUM_REPEATS 4
 
 ABT_pool *pools;
+spawn_context_t spawn_context;
+int adaptive;
 
 typedef struct {
     int n;
@@ -74,10 +87,18 @@ void daxpy(void *arg)
         daxpy_arg_t child1_arg = { n / 2, a, x, y, cutoff };
         daxpy_arg_t child2_arg = { n - n / 2, a, x + n / 2, y + n / 2, cutoff };
 
+        ABT_thread child1;
+        if (adaptive) {
+            /* Calculate daxpy([0 : n/2]) in a ULT only if it helps. */
+            abt_spawn(&spawn_context, daxpy, &child1_arg, &child1);
+            daxpy(&child2_arg);
+            abt_sync(&spawn_context, &child1, 1);
+            return;
+        }
+
         int rank;
         ABT_xstream_self_rank(&rank);
         ABT_pool target_pool = pools[rank];
-        ABT_thread child1;
         /* Calculate daxpy([0 : n/2]). */
         ABT_thread_create(target_pool, daxpy, &child1_arg, ABT_THREAD_ATTR_NULL,
                           &child1);
@@ -94,10 +115,11 @@ int main(int argc, char **argv)
     int num_xstreams = DEFAULT_NUM_XSTREAMS;
     int n = DEFAULT_N;
     int cutoff = DEFAULT_CUTOFF;
+    adaptive = DEFAULT_ADAPTIVE;
     int i, j;
     int prof_mode = 1;
     while (1) {
-        int opt = getopt(argc, argv, "he:n:c:p:");
+        int opt = getopt(argc, argv, "he:n:c:a:p:");
         if (opt == -1)
             break;
         switch (opt) {
@@ -110,13 +132,20 @@ int main(int argc, char **argv)
             case 'c':
                 cutoff = atoi(optarg);
                 break;
+            case 'a':
+                adaptive = atoi(optarg);
+                break;
             case 'p':
                 prof_mode = atoi(optarg);
                 break;
             case 'h':
             default:
                 printf("Usage: ./daxpy [-e NUM_XSTREAMS] [-n N] [-c CUTOFF] "
-                       "[-p PROF_MODE]\n"
+                       "[-a ADAPTIVE] [-p PROF_MODE]\n"
+                       "ADAPTIVE  = 0 : create a ULT at every split\n"
+                       "            N : create a ULT only if another pool "
+                       "is empty and fewer than N\n"
+                       "                units wait in the local pool\n"
                        "PROF_MODE = 0 : disable ABTX profiler\n"
                        "            1 : enable ABTX profiler (basic)\n"
                        "            2 : enable ABTX profiler (advanced)\n");
@@ -133,14 +162,22 @@ int main(int argc, char **argv)
     /* Initialize Argobots. */
     ABT_init(argc, argv);
 
+    if (adaptive) {
+        /* Create work-stealing deques and their schedulers. */
+        spawn_create_scheds(num_xstreams, pools, scheds);
+        spawn_context_init(&spawn_context, pools, num_xstreams,
+                           SPAWN_MODE_HELP_FIRST);
+        spawn_context_set_adaptive(&spawn_context, adaptive);
+    }
+
     /* Create pools. */
-    for (i = 0; i < num_xstreams; i++) {
+    for (i = 0; i < num_xstreams && !adaptive; i++) {
         ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_TRUE,
                               &pools[i]);
     }
 
     /* Create schedulers. */
-    for (i = 0; i < num_xstreams; i++) {
+    for (i = 0; i < num_xstreams && !adaptive; i++) {
         ABT_pool *tmp = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
         for (j = 0; j < num_xstreams; j++) {
             tmp[j] = pools[(i + j) % num_xstreams];
@@ -178,6 +215,7 @@ int main(int argc, char **argv)
         } else if (prof_init == ABT_SUCCESS && prof_mode == 2) {
             ABTX_prof_start(prof_context, ABTX_PROF_MODE_DETAILED);
         }
+        size_t num_spawned = spawn_context.num_spawned;
         double start_time = ABT_get_wtime();
         daxpy_arg_t arg = { n, a, x, y, cutoff };
         daxpy(&arg);
@@ -189,6 +227,10 @@ int main(int argc, char **argv)
 
         printf("##############################\n");
         printf("[%d] elapsed time = %f [s]\n", i, end_time - start_time);
+        if (adaptive) {
+            printf("[%d] created ULTs = %zu\n", i,
+                   spawn_context.num_spawned - num_spawned);
+        }
         if (prof_init == ABT_SUCCESS && (prof_mode == 1 || prof_mode == 2)) {
             ABTX_prof_print(prof_context, stdout,
                             ABTX_PRINT_MODE_SUMMARY | ABTX_PRINT_MODE_FANCY);
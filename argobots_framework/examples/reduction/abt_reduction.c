@@ -1,9 +1,11 @@
 #include "abt_reduction.h"
 
 #include <limits.h>
+#include <stdio.h>
 #include <float.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 
 #if USE_TREE_REDUCTION
 
@@ -62,7 +64,7 @@ void reduction_thread(void *arg) {
     free(reduction_args->thread_results[thread_id]);
 }
 
-void reduce_common(
+static void reduce_common_ult(
     reduction_context_t *reduction_context,
     void *array,
     size_t num_elems,
@@ -146,7 +148,7 @@ void reduction_thread(void *arg) {
     free(local_result);
 }
 
-void reduce_common(
+static void reduce_common_ult(
     reduction_context_t *reduction_context,
     void *array,
     size_t num_elems,
@@ -197,6 +199,423 @@ void reduce_common(
 
 #endif
 
+// In tasklet mode, leaves cannot wait on a barrier.  Instead, they combine
+// partial results in the same binary-tree order as the ULT tree reduction:
+// at each level, the later of the two siblings to finish (decided by an
+// atomic counter) merges the right partial into the left one and climbs up,
+// while the earlier one simply returns.  The leaf that climbs out of the top
+// writes the result.
+
+typedef struct {
+    void **thread_results;               /* partial result of each leaf */
+    int *arrivals;                       /* arrival counter of each tree node */
+    int num_threads;                     /* total number of leaves */
+    size_t elem_size;                    /* size of a single element */
+    void (*reduce_func)(void *, void *); /* provided reduction function on 2 elements */
+    void *result;                        /* where to store the result of reduction */
+} reduction_tasklet_shared_t;
+
+typedef struct {
+    reduction_tasklet_shared_t *shared;
+    void *array;                         /* slice of the array for this leaf */
+    size_t num_elems;                    /* number of elements in the slice */
+    int thread_id;                       /* index of the current leaf */
+} reduction_tasklet_args_t;
+
+static void reduction_tasklet(void *arg) {
+    reduction_tasklet_args_t *tasklet_args = (reduction_tasklet_args_t *)arg;
+    reduction_tasklet_shared_t *shared = tasklet_args->shared;
+    size_t elem_size = shared->elem_size;
+    char *array = (char *)tasklet_args->array;
+    int id = tasklet_args->thread_id;
+    int num_threads = shared->num_threads;
+
+    // thread_results[id] is already initialized to the default value
+    void *local_result = shared->thread_results[id];
+    for (size_t i = 0; i < tasklet_args->num_elems; ++i) {
+        shared->reduce_func(local_result, array + i * elem_size);
+    }
+
+    for (int step = 1; step < num_threads; step *= 2) {
+        int left = id - id % (2 * step);
+        int right = left + step;
+        if (right >= num_threads) {
+            // No sibling on this level
+            continue;
+        }
+        // (left + step - 1) is unique for each node of the tree
+        if (__atomic_fetch_add(&shared->arrivals[left + step - 1], 1,
+                               __ATOMIC_ACQ_REL) == 0) {
+            // The sibling has not finished yet; it will combine our result
+            return;
+        }
+        shared->reduce_func(shared->thread_results[left],
+                            shared->thread_results[right]);
+        id = left;
+    }
+    memcpy(shared->result, shared->thread_results[0], elem_size);
+}
+
+static void reduce_common_tasklet(
+    reduction_context_t *reduction_context,
+    void *array,
+    size_t num_elems,
+    size_t elem_size,
+    void *default_reduction_value,
+    void (*reduce_func)(void *, void *),
+    void *result
+) {
+    int num_threads = reduction_context->num_threads;
+    size_t elems_per_thread = num_elems / num_threads;
+    reduction_tasklet_args_t *tasklet_args =
+        (reduction_tasklet_args_t *)malloc(sizeof(reduction_tasklet_args_t) * num_threads);
+    void **thread_results = (void **)malloc(num_threads * sizeof(void *));
+    char *results_buf = (char *)malloc(num_threads * elem_size);
+    int *arrivals = (int *)calloc(num_threads, sizeof(int));
+
+    reduction_tasklet_shared_t shared = {
+        .thread_results = thread_results,
+        .arrivals = arrivals,
+        .num_threads = num_threads,
+        .elem_size = elem_size,
+        .reduce_func = reduce_func,
+        .result = result,
+    };
+
+    for (int i = 0; i < num_threads; ++i) {
+        thread_results[i] = results_buf + i * elem_size;
+        memcpy(thread_results[i], default_reduction_value, elem_size);
+        tasklet_args[i].shared = &shared;
+        tasklet_args[i].array = (char *)array + i * elems_per_thread * elem_size;
+        tasklet_args[i].num_elems = (i == num_threads - 1) ? (num_elems - i * elems_per_thread) : elems_per_thread;
+        tasklet_args[i].thread_id = i;
+    }
+
+    for (int i = 0; i < num_threads; ++i) {
+        int pool_id = i % reduction_context->num_pools;
+        ABT_task_create(
+            reduction_context->pools[pool_id],
+            reduction_tasklet,
+            &tasklet_args[i],
+            &reduction_context->threads[i]
+        );
+    }
+
+    for (int i = 0; i < num_threads; ++i) {
+        ABT_thread_join(reduction_context->threads[i]);
+        ABT_thread_free(&reduction_context->threads[i]);
+    }
+
+    free(arrivals);
+    free(results_buf);
+    free(thread_results);
+    free(tasklet_args);
+}
+
+void reduce_common(
+    reduction_context_t *reduction_context,
+    void *array,
+    size_t num_elems,
+    size_t elem_size,
+    void *default_reduction_value,
+    void (*reduce_func)(void *, void *),
+    void *result
+) {
+    if (reduction_context->mode == REDUCTION_MODE_TASKLET) {
+        reduce_common_tasklet(reduction_context, array, num_elems, elem_size,
+                              default_reduction_value, reduce_func, result);
+    } else {
+        reduce_common_ult(reduction_context, array, num_elems, elem_size,
+                          default_reduction_value, reduce_func, result);
+    }
+}
+
+reduction_mode_t reduction_mode_from_env(void) {
+    const char *mode = getenv("ABT_REDUCTION_MODE");
+    if (mode && strcmp(mode, "tasklet") == 0) {
+        return REDUCTION_MODE_TASKLET;
+    }
+    return REDUCTION_MODE_ULT;
+}
+
+void reduction_create_leaf(
+    reduction_context_t *reduction_context,
+    int pool_id,
+    void (*leaf_func)(void *),
+    void *arg,
+    ABT_thread *leaf
+) {
+    if (reduction_context->mode == REDUCTION_MODE_TASKLET) {
+        ABT_task_create(reduction_context->pools[pool_id], leaf_func, arg, leaf);
+    } else {
+        ABT_thread_create(reduction_context->pools[pool_id], leaf_func, arg,
+                          ABT_THREAD_ATTR_NULL, leaf);
+    }
+}
+
+reduction_placement_t reduction_placement_from_env(void) {
+    const char *placement = getenv("ABT_PLACEMENT");
+    if (placement && strcmp(placement, "affinity") == 0) {
+        return REDUCTION_PLACEMENT_AFFINITY;
+    }
+    return REDUCTION_PLACEMENT_STATIC;
+}
+
+void reduction_placement_init(reduction_context_t *reduction_context,
+                              reduction_placement_t placement, int num_blocks) {
+    reduction_context->placement = placement;
+    reduction_context->num_blocks = num_blocks;
+    reduction_context->block_last_pool = (int *)malloc(sizeof(int) * num_blocks);
+    for (int i = 0; i < num_blocks; ++i) {
+        reduction_context->block_last_pool[i] = -1;
+    }
+    reduction_context->num_block_runs = 0;
+    reduction_context->num_block_moves = 0;
+}
+
+void reduction_placement_free(reduction_context_t *reduction_context) {
+    free(reduction_context->block_last_pool);
+    reduction_context->block_last_pool = NULL;
+}
+
+int reduction_block_pool(reduction_context_t *reduction_context, int block) {
+    int last_pool = reduction_context->block_last_pool[block];
+    if (reduction_context->placement == REDUCTION_PLACEMENT_AFFINITY &&
+        last_pool >= 0) {
+        return last_pool;
+    }
+    return block % reduction_context->num_pools;
+}
+
+void reduction_block_done(reduction_context_t *reduction_context, int block,
+                          ABT_thread leaf) {
+    ABT_xstream xstream;
+    if (ABT_thread_get_last_xstream(leaf, &xstream) != ABT_SUCCESS ||
+        xstream == ABT_XSTREAM_NULL) {
+        return;
+    }
+    int pool = -1;
+    for (int i = 0; i < reduction_context->num_xstreams; ++i) {
+        ABT_bool is_equal;
+        ABT_xstream_equal(xstream, reduction_context->xstreams[i], &is_equal);
+        if (is_equal == ABT_TRUE) {
+            pool = i % reduction_context->num_pools;
+            break;
+        }
+    }
+    // Called by the joining ULT only, so the counters need no atomics.
+    int last_pool = reduction_context->block_last_pool[block];
+    reduction_context->num_block_runs++;
+    if (last_pool >= 0 && pool != last_pool) {
+        reduction_context->num_block_moves++;
+    }
+    reduction_context->block_last_pool[block] = pool;
+}
+
+int reduction_tuner_from_env(void) {
+    const char *autotune = getenv("ABT_AUTOTUNE");
+    if (!autotune) {
+        return 0;
+    }
+    int trial_iters = atoi(autotune);
+    return trial_iters > 0 ? trial_iters : 0;
+}
+
+void reduction_tuner_init(reduction_tuner_t *tuner, int trial_iters,
+                          const reduction_tuning_t *initial, int num_xstreams,
+                          int max_threads, int tune_policy) {
+    memset(tuner, 0, sizeof(reduction_tuner_t));
+    tuner->stage = REDUCTION_TUNER_THREADS;
+    tuner->tune_policy = tune_policy;
+    tuner->trial_iters = trial_iters > 0 ? trial_iters : 1;
+    tuner->max_threads = initial->num_threads;
+    tuner->best = *initial;
+
+    tuner->options[tuner->num_options++] = *initial;
+    for (int factor = 1; factor <= 8; factor *= 2) {
+        int num_threads = factor * num_xstreams;
+        int is_new = (num_threads <= max_threads);
+        for (int i = 0; i < tuner->num_options && is_new; i++) {
+            is_new = (tuner->options[i].num_threads != num_threads);
+        }
+        if (is_new) {
+            reduction_tuning_t *option = &tuner->options[tuner->num_options++];
+            *option = *initial;
+            option->num_threads = num_threads;
+            if (num_threads > tuner->max_threads) {
+                tuner->max_threads = num_threads;
+            }
+        }
+    }
+}
+
+int reduction_tuner_max_threads(const reduction_tuner_t *tuner) {
+    return tuner->max_threads;
+}
+
+const reduction_tuning_t *reduction_tuner_current(const reduction_tuner_t *tuner) {
+    if (tuner->stage == REDUCTION_TUNER_LOCKED) {
+        return &tuner->best;
+    }
+    return &tuner->options[tuner->option];
+}
+
+// Moves to the steal policies with the best number of blocks.  The setting
+// that is already the best is not measured again.
+static int reduction_tuner_policy_options(reduction_tuner_t *tuner) {
+    static const int steal_thresholds[] = { 0, 1 };
+    static const reduction_placement_t placements[] = {
+        REDUCTION_PLACEMENT_STATIC, REDUCTION_PLACEMENT_AFFINITY
+    };
+    tuner->num_options = 0;
+    for (int s = 0; s < 2; s++) {
+        for (int p = 0; p < 2; p++) {
+            if (steal_thresholds[s] == tuner->best.steal_threshold &&
+                placements[p] == tuner->best.placement) {
+                continue;
+            }
+            reduction_tuning_t *option = &tuner->options[tuner->num_options++];
+            *option = tuner->best;
+            option->steal_threshold = steal_thresholds[s];
+            option->placement = placements[p];
+        }
+    }
+    return tuner->num_options;
+}
+
+int reduction_tuner_record(reduction_tuner_t *tuner, double seconds) {
+    if (tuner->stage == REDUCTION_TUNER_LOCKED) {
+        return 0;
+    }
+    double *time = &tuner->times[tuner->option];
+    if (tuner->iter == 0 || seconds < *time) {
+        *time = seconds;
+    }
+    if (++tuner->iter < tuner->trial_iters) {
+        return 0;
+    }
+    tuner->iter = 0;
+    tuner->tried[tuner->num_tried] = tuner->options[tuner->option];
+    tuner->tried_times[tuner->num_tried++] = *time;
+    if (++tuner->option < tuner->num_options) {
+        return 1;
+    }
+
+    // The stage is done: keep the fastest option.
+    for (int i = 0; i < tuner->num_options; i++) {
+        if ((tuner->stage == REDUCTION_TUNER_THREADS && i == 0) ||
+            tuner->times[i] < tuner->best_time) {
+            tuner->best = tuner->options[i];
+            tuner->best_time = tuner->times[i];
+        }
+    }
+    tuner->option = 0;
+    if (tuner->stage == REDUCTION_TUNER_THREADS && tuner->tune_policy &&
+        reduction_tuner_policy_options(tuner) > 0) {
+        tuner->stage = REDUCTION_TUNER_POLICY;
+    } else {
+        tuner->stage = REDUCTION_TUNER_LOCKED;
+    }
+    return 1;
+}
+
+void reduction_tuner_print(const reduction_tuner_t *tuner, int num_xstreams) {
+    printf(" Auto-tuning (%d iteration(s) per option):\n", tuner->trial_iters);
+    for (int i = 0; i < tuner->num_tried; i++) {
+        const reduction_tuning_t *option = &tuner->tried[i];
+        printf("   threads=%-4d steal_threshold=%d placement=%-8s %12.6f s\n",
+               option->num_threads, option->steal_threshold,
+               option->placement == REDUCTION_PLACEMENT_AFFINITY ? "affinity" : "static",
+               tuner->tried_times[i]);
+    }
+    if (tuner->stage != REDUCTION_TUNER_LOCKED) {
+        printf(" Auto-tuning did not finish; too few iterations\n");
+        return;
+    }
+    printf(" Auto-tuned: ");
+    if (tuner->tune_policy) {
+        printf("ABT_WS_STEAL_THRESHOLD=%d ", tuner->best.steal_threshold);
+    }
+    printf("ABT_PLACEMENT=%s, xstreams %d, threads %d\n",
+           tuner->best.placement == REDUCTION_PLACEMENT_AFFINITY ? "affinity" : "static",
+           num_xstreams, tuner->best.num_threads);
+}
+
+void reduction_apply_tuning(reduction_context_t *reduction_context,
+                            const reduction_tuning_t *tuning) {
+    long num_block_runs = reduction_context->num_block_runs;
+    long num_block_moves = reduction_context->num_block_moves;
+    if (reduction_context->num_blocks != tuning->num_threads ||
+        reduction_context->placement != tuning->placement) {
+        reduction_placement_free(reduction_context);
+        reduction_placement_init(reduction_context, tuning->placement,
+                                 tuning->num_threads);
+        reduction_context->num_block_runs = num_block_runs;
+        reduction_context->num_block_moves = num_block_moves;
+    }
+    reduction_context->num_threads = tuning->num_threads;
+}
+
+#define REDUCTION_HUGEPAGE_SIZE (2 * 1024 * 1024)
+
+static size_t roundup_hugepage(size_t size) {
+    return (size + REDUCTION_HUGEPAGE_SIZE - 1) &
+           ~((size_t)REDUCTION_HUGEPAGE_SIZE - 1);
+}
+
+static void *mmap_array(size_t size, int flags) {
+    void *ptr = mmap(NULL, roundup_hugepage(size), PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+    return ptr != MAP_FAILED ? ptr : NULL;
+}
+
+void *reduction_alloc_array(size_t size, reduction_alloc_type_t *p_type) {
+    const char *alloc = getenv("ABT_ARRAY_ALLOC");
+    int try_hugepage = alloc && strcmp(alloc, "hugepage") == 0;
+    int try_thp = try_hugepage || (alloc && strcmp(alloc, "thp") == 0);
+    void *ptr;
+
+#ifdef MAP_HUGETLB
+    if (try_hugepage && (ptr = mmap_array(size, MAP_HUGETLB))) {
+        *p_type = REDUCTION_ALLOC_MMAP_HUGEPAGE;
+        return ptr;
+    }
+#endif
+    if (try_thp && (ptr = mmap_array(size, 0))) {
+#ifdef MADV_HUGEPAGE
+        madvise(ptr, roundup_hugepage(size), MADV_HUGEPAGE);
+#endif
+        *p_type = REDUCTION_ALLOC_MMAP;
+        return ptr;
+    }
+    // calloc() of a large size gets fresh zero pages from mmap() and does not
+    // touch them.
+    *p_type = REDUCTION_ALLOC_MALLOC;
+    return calloc(1, size);
+}
+
+void reduction_free_array(void *ptr, size_t size, reduction_alloc_type_t type) {
+    if (!ptr) {
+        return;
+    }
+    if (type == REDUCTION_ALLOC_MALLOC) {
+        free(ptr);
+    } else {
+        munmap(ptr, roundup_hugepage(size));
+    }
+}
+
+const char *reduction_alloc_type_name(reduction_alloc_type_t type) {
+    switch (type) {
+        case REDUCTION_ALLOC_MMAP_HUGEPAGE:
+            return "hugepage";
+        case REDUCTION_ALLOC_MMAP:
+            return "thp";
+        default:
+            return "malloc";
+    }
+}
+
 // =================== Definitions for reduction funcs ===================
 
 #define BODY_sum(type) *((type *)a) += *((type *)b);
@@ -4,15 +4,155 @@
 
 #define USE_TREE_REDUCTION 1
 
+/* How leaf work units are created.  Tasklets have no stack and cannot yield,
+ * so only leaves that never block (no ABT_barrier_wait(), etc.) may use them. */
+typedef enum {
+    REDUCTION_MODE_ULT = 0,  /* ABT_thread_create() */
+    REDUCTION_MODE_TASKLET,  /* ABT_task_create() */
+} reduction_mode_t;
+
+/* Where the leaf of block t is created in each fork-join phase. */
+typedef enum {
+    REDUCTION_PLACEMENT_STATIC = 0, /* pools[t % num_pools] */
+    REDUCTION_PLACEMENT_AFFINITY,   /* pool of the xstream t last ran on */
+} reduction_placement_t;
+
 typedef struct {
     ABT_xstream *xstreams;
     int num_xstreams;
     ABT_pool *pools;
     int num_pools;
-    ABT_thread *threads;
+    ABT_thread *threads;     /* also holds tasklet handles in tasklet mode */
     int num_threads;
+    reduction_mode_t mode;
+    /* Set up by reduction_placement_init(). */
+    reduction_placement_t placement;
+    int num_blocks;
+    int *block_last_pool;    /* -1 until the block has run once */
+    long num_block_runs;
+    long num_block_moves;    /* runs on another xstream than the last one */
 } reduction_context_t;
 
+/* Returns REDUCTION_MODE_TASKLET if ABT_REDUCTION_MODE=tasklet is set. */
+reduction_mode_t reduction_mode_from_env(void);
+
+/* Creates a leaf work unit on the pool according to reduction_context->mode.
+ * The handle can be joined and freed by ABT_thread_join()/ABT_thread_free() in
+ * both modes. */
+void reduction_create_leaf(
+    reduction_context_t *reduction_context,
+    int pool_id,
+    void (*leaf_func)(void *),
+    void *arg,
+    ABT_thread *leaf
+);
+
+/* Returns REDUCTION_PLACEMENT_AFFINITY if ABT_PLACEMENT=affinity is set. */
+reduction_placement_t reduction_placement_from_env(void);
+
+/* Block placement for drivers that split every phase into the same num_blocks
+ * blocks.  In the affinity placement, a block goes back to the xstream that
+ * ran it in the previous phase, even if a work-stealing scheduler moved it
+ * there, so the slice of data it left in that xstream's caches is reused.
+ * pools[i] must be the main pool of xstreams[i]. */
+void reduction_placement_init(reduction_context_t *reduction_context,
+                              reduction_placement_t placement, int num_blocks);
+void reduction_placement_free(reduction_context_t *reduction_context);
+
+/* Returns the pool on which the leaf of the block should be created. */
+int reduction_block_pool(reduction_context_t *reduction_context, int block);
+
+/* Records the xstream the joined leaf of the block ran on.  Must be called
+ * before the leaf is freed. */
+void reduction_block_done(reduction_context_t *reduction_context, int block,
+                          ABT_thread leaf);
+
+/* Online auto-tuning of an iterative driver (ABT_AUTOTUNE=<n>).  The first
+ * iterations try candidate settings, n iterations each, and keep the fastest:
+ * first the number of blocks (leaves per phase) from num_xstreams to
+ * 8 * num_xstreams, then, if the scheduler steals, the steal threshold and
+ * the placement with that number of blocks.  The tuner then stays locked on
+ * the best setting for the rest of the run. */
+#define REDUCTION_TUNER_MAX_OPTIONS 8
+
+typedef struct {
+    int num_threads;         /* blocks per phase */
+    int steal_threshold;     /* for the work-stealing schedulers */
+    reduction_placement_t placement;
+} reduction_tuning_t;
+
+typedef enum {
+    REDUCTION_TUNER_THREADS = 0,
+    REDUCTION_TUNER_POLICY,
+    REDUCTION_TUNER_LOCKED,
+} reduction_tuner_stage_t;
+
+typedef struct {
+    reduction_tuner_stage_t stage;
+    int tune_policy;         /* the scheduler steals */
+    int trial_iters;         /* iterations measured per option */
+    int max_threads;
+    reduction_tuning_t options[REDUCTION_TUNER_MAX_OPTIONS];
+    double times[REDUCTION_TUNER_MAX_OPTIONS]; /* fastest iteration */
+    int num_options;
+    int option;              /* option being measured */
+    int iter;                /* iterations measured on the option */
+    reduction_tuning_t best;
+    double best_time;
+    /* Every option measured, for reduction_tuner_print(). */
+    reduction_tuning_t tried[2 * REDUCTION_TUNER_MAX_OPTIONS];
+    double tried_times[2 * REDUCTION_TUNER_MAX_OPTIONS];
+    int num_tried;
+} reduction_tuner_t;
+
+/* Returns the iterations per option set by ABT_AUTOTUNE, 0 if tuning is off. */
+int reduction_tuner_from_env(void);
+
+/* initial is the setting of the command line and environment; it is tried
+ * first.  No option uses more than max_threads blocks. */
+void reduction_tuner_init(reduction_tuner_t *tuner, int trial_iters,
+                          const reduction_tuning_t *initial, int num_xstreams,
+                          int max_threads, int tune_policy);
+
+/* Largest number of blocks among the options; the threads array of the
+ * context must hold that many leaves. */
+int reduction_tuner_max_threads(const reduction_tuner_t *tuner);
+
+/* Setting for the next iteration. */
+const reduction_tuning_t *reduction_tuner_current(const reduction_tuner_t *tuner);
+
+/* Records the time of an iteration run with reduction_tuner_current().
+ * Returns 1 if the driver must apply a new current setting. */
+int reduction_tuner_record(reduction_tuner_t *tuner, double seconds);
+
+/* Prints the measured options and the chosen setting as the environment and
+ * arguments that reproduce it. */
+void reduction_tuner_print(const reduction_tuner_t *tuner, int num_xstreams);
+
+/* Applies the number of blocks and the placement of a setting.  The block
+ * move counters are kept. */
+void reduction_apply_tuning(reduction_context_t *reduction_context,
+                            const reduction_tuning_t *tuning);
+
+/* How reduction_alloc_array() obtained an array.  The fallback order follows
+ * ABTU_alloc_largepage(), which libabt does not export. */
+typedef enum {
+    REDUCTION_ALLOC_MALLOC = 0,    /* calloc() */
+    REDUCTION_ALLOC_MMAP,          /* mmap() + madvise(MADV_HUGEPAGE) */
+    REDUCTION_ALLOC_MMAP_HUGEPAGE, /* mmap(MAP_HUGETLB) */
+} reduction_alloc_type_t;
+
+/* Allocates a zero-filled array for a driver.  Its pages are not touched, so
+ * each page is placed on the NUMA node of the ULT that first writes it;
+ * drivers should first-touch arrays with the partition of their compute
+ * phases.  ABT_ARRAY_ALLOC selects the pages:
+ *   malloc   (default) calloc()
+ *   thp      anonymous mmap() with transparent huge pages
+ *   hugepage mmap(MAP_HUGETLB), falling back to thp and malloc */
+void *reduction_alloc_array(size_t size, reduction_alloc_type_t *p_type);
+void reduction_free_array(void *ptr, size_t size, reduction_alloc_type_t type);
+const char *reduction_alloc_type_name(reduction_alloc_type_t type);
+
 void reduce_common(
     reduction_context_t *reduction_context,
     void *array,
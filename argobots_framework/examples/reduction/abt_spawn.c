@@ -0,0 +1,115 @@
+#include "abt_spawn.h"
+
+#include <stdlib.h>
+
+void spawn_create_scheds(int num_pools, ABT_pool *pools, ABT_sched *scheds) {
+    for (int i = 0; i < num_pools; ++i) {
+        ABT_pool_create_basic(ABT_POOL_RANDWS, ABT_POOL_ACCESS_MPMC, ABT_TRUE,
+                              &pools[i]);
+    }
+    ABT_pool *sched_pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_pools);
+    for (int i = 0; i < num_pools; ++i) {
+        // The first pool is the local one; the rest are stolen from.
+        for (int j = 0; j < num_pools; ++j) {
+            sched_pools[j] = pools[(i + j) % num_pools];
+        }
+        ABT_sched_create_basic(ABT_SCHED_RANDWS, num_pools, sched_pools,
+                               ABT_SCHED_CONFIG_NULL, &scheds[i]);
+    }
+    free(sched_pools);
+}
+
+void spawn_context_init(spawn_context_t *spawn_context, ABT_pool *pools,
+                        int num_pools, spawn_mode_t mode) {
+    spawn_context->pools = pools;
+    spawn_context->num_pools = num_pools;
+    spawn_context->mode = mode;
+    spawn_context->num_live = 0;
+    spawn_context->max_live = 0;
+    spawn_context->max_queued = 0;
+    spawn_context->num_spawned = 0;
+}
+
+void spawn_context_set_adaptive(spawn_context_t *spawn_context,
+                                size_t max_queued) {
+    spawn_context->max_queued = max_queued;
+}
+
+static void update_max_live(spawn_context_t *spawn_context) {
+    size_t num_live = __atomic_add_fetch(&spawn_context->num_live, 1,
+                                         __ATOMIC_RELAXED);
+    size_t max_live = __atomic_load_n(&spawn_context->max_live,
+                                      __ATOMIC_RELAXED);
+    while (num_live > max_live &&
+           !__atomic_compare_exchange_n(&spawn_context->max_live, &max_live,
+                                        num_live, 1, __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED))
+        ;
+}
+
+// Returns 1 if a spawned ULT is likely to be stolen: the local deque holds
+// fewer than max_queued units and the deque of some other execution stream
+// is empty, so that execution stream is, or soon will be, looking for work.
+static int has_idle_thief(spawn_context_t *spawn_context, int local) {
+    size_t size;
+    ABT_pool_get_size(spawn_context->pools[local], &size);
+    if (size >= spawn_context->max_queued)
+        return 0;
+    for (int i = 1; i < spawn_context->num_pools; ++i) {
+        int victim = (local + i) % spawn_context->num_pools;
+        ABT_pool_get_size(spawn_context->pools[victim], &size);
+        if (size == 0)
+            return 1;
+    }
+    return 0;
+}
+
+void abt_spawn(spawn_context_t *spawn_context, void (*func)(void *), void *arg,
+               ABT_thread *child) {
+    int rank;
+    ABT_self_get_xstream_rank(&rank);
+    ABT_pool pool = spawn_context->pools[rank % spawn_context->num_pools];
+
+    if (spawn_context->max_queued > 0 &&
+        !has_idle_thief(spawn_context, rank % spawn_context->num_pools)) {
+        // Nobody would steal a new ULT soon: it would only add fork-join
+        // overhead.
+        func(arg);
+        *child = ABT_THREAD_NULL;
+        return;
+    }
+    __atomic_add_fetch(&spawn_context->num_spawned, 1, __ATOMIC_RELAXED);
+    update_max_live(spawn_context);
+
+    if (spawn_context->mode == SPAWN_MODE_WORK_FIRST) {
+        // A stolen continuation is still associated with the victim's deque.
+        // Re-associate it with the local one so that ABT_thread_create_to()
+        // pushes it where the thieves of this execution stream look.
+        ABT_self_set_associated_pool(pool);
+        ABT_thread_create_to(pool, func, arg, ABT_THREAD_ATTR_NULL, child);
+        // Unless the continuation was stolen, the child has already finished
+        // when the parent resumes.  Free it now so that its stack is reused by
+        // the next spawn instead of being held until abt_sync().
+        ABT_thread_state state;
+        ABT_thread_get_state(*child, &state);
+        if (state == ABT_THREAD_STATE_TERMINATED) {
+            ABT_thread_free(child);
+            __atomic_sub_fetch(&spawn_context->num_live, 1, __ATOMIC_RELAXED);
+        }
+    } else {
+        ABT_thread_create(pool, func, arg, ABT_THREAD_ATTR_NULL, child);
+    }
+}
+
+void abt_sync(spawn_context_t *spawn_context, ABT_thread *children,
+              int num_children) {
+    size_t num_freed = 0;
+    for (int i = 0; i < num_children; ++i) {
+        // Children freed early by abt_spawn() are already ABT_THREAD_NULL.
+        if (children[i] != ABT_THREAD_NULL) {
+            ABT_thread_free(&children[i]);
+            num_freed++;
+        }
+    }
+    __atomic_sub_fetch(&spawn_context->num_live, num_freed, __ATOMIC_RELAXED);
+}
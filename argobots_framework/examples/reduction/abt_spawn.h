@@ -0,0 +1,68 @@
+#pragma once
+
+#include <abt.h>
+#include <stddef.h>
+
+/* A small fork-join layer for recursive divide-and-conquer drivers.
+ *
+ * The pools must be ABT_POOL_RANDWS pools, one per execution stream, scheduled
+ * by ABT_SCHED_RANDWS (see spawn_create_scheds()).  Such a pool is a deque:
+ * spawns are pushed to and popped from the head by the owner, while idle
+ * execution streams steal from the tail.
+ *
+ * help-first: abt_spawn() pushes the child to the local deque and returns; the
+ *             parent keeps running.  Children pile up in the deque until the
+ *             parent reaches abt_sync().
+ * work-first: abt_spawn() runs the child immediately with
+ *             ABT_thread_create_to() and pushes the parent continuation to the
+ *             local deque, from which other execution streams may steal it.
+ *             A child that has finished by the time the parent resumes is
+ *             freed at once, so only the spawn path being executed holds
+ *             stacks, which bounds their number by the recursion depth on each
+ *             execution stream.
+ *
+ * With an adaptive cut-off (spawn_context_set_adaptive()), abt_spawn() only
+ * creates a ULT while an idle thief exists, i.e. while the deque of another
+ * execution stream is empty and the local deque holds fewer than max_queued
+ * units for it to steal.  Otherwise it runs the child inline, so a recursion
+ * can split down to a small grain and still pay for a fork only when another
+ * execution stream can take it. */
+
+typedef enum {
+    SPAWN_MODE_HELP_FIRST = 0, /* ABT_thread_create() */
+    SPAWN_MODE_WORK_FIRST,     /* ABT_thread_create_to() */
+} spawn_mode_t;
+
+typedef struct {
+    ABT_pool *pools;     /* pools[rank] is the deque of execution stream rank */
+    int num_pools;
+    spawn_mode_t mode;
+    size_t num_live;     /* spawned ULTs that are not freed yet */
+    size_t max_live;     /* high-water mark of num_live */
+    size_t max_queued;   /* adaptive cut-off; 0 always spawns */
+    size_t num_spawned;  /* ULTs created by abt_spawn() */
+} spawn_context_t;
+
+/* Creates num_pools ABT_POOL_RANDWS pools and one ABT_SCHED_RANDWS scheduler
+ * per pool.  scheds[i] takes pools[i] first and steals from the others. */
+void spawn_create_scheds(int num_pools, ABT_pool *pools, ABT_sched *scheds);
+
+void spawn_context_init(spawn_context_t *spawn_context, ABT_pool *pools,
+                        int num_pools, spawn_mode_t mode);
+
+/* Makes abt_spawn() run the child inline while the local deque holds at least
+ * max_queued units or no other deque is empty.  0 restores spawning every
+ * child. */
+void spawn_context_set_adaptive(spawn_context_t *spawn_context,
+                                size_t max_queued);
+
+/* Spawns func(arg) as a child ULT of the caller, which must be a ULT running
+ * on one of spawn_context->pools.  The handle must be passed to abt_sync(); it
+ * may already be ABT_THREAD_NULL in work-first mode if the child finished, or
+ * with an adaptive cut-off if the child ran inline. */
+void abt_spawn(spawn_context_t *spawn_context, void (*func)(void *), void *arg,
+               ABT_thread *child);
+
+/* Waits for and frees num_children children spawned by the caller. */
+void abt_sync(spawn_context_t *spawn_context, ABT_thread *children,
+              int num_children);
@@ -0,0 +1,228 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/*
+ * Recursive (divide-and-conquer) sum reduction built on abt_spawn()/abt_sync().
+ * Each ULT splits its range into FANOUT parts and spawns a child for each part
+ * until a range has at most GRAIN elements, which is summed sequentially.
+ *
+ * The same reduction is run with help-first and work-first spawning, and the
+ * time, the maximum number of ULTs alive at once (each owns a stack) and the
+ * peak resident set size are reported for both.  ru_maxrss never decreases, so
+ * run a single mode per process (-m help or -m work) to compare it.
+ */
+
+#include "abt_spawn.h"
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+
+#define DEFAULT_NUM_XSTREAMS 4
+#define DEFAULT_NUM_ELEMS (1 << 20)
+#define DEFAULT_GRAIN 256
+#define DEFAULT_FANOUT 4
+#define DEFAULT_NUM_ITERS 5
+#define MAX_FANOUT 64
+
+size_t grain = DEFAULT_GRAIN;
+int fanout = DEFAULT_FANOUT;
+
+typedef struct {
+    spawn_context_t *spawn_context;
+    const long *array;
+    size_t num_elems;
+    long result;
+} node_args_t;
+
+static void reduce_node(void *arg) {
+    node_args_t *node_args = (node_args_t *)arg;
+    const long *array = node_args->array;
+    size_t num_elems = node_args->num_elems;
+
+    if (num_elems <= grain) {
+        long result = 0;
+        for (size_t i = 0; i < num_elems; ++i) {
+            result += array[i];
+        }
+        node_args->result = result;
+        return;
+    }
+
+    // Split the range into fanout parts and reduce them in parallel.
+    node_args_t child_args[MAX_FANOUT];
+    ABT_thread children[MAX_FANOUT];
+    size_t elems_per_child = (num_elems + fanout - 1) / fanout;
+    int num_children = 0;
+    for (size_t from = 0; from < num_elems; from += elems_per_child) {
+        node_args_t *child = &child_args[num_children];
+        child->spawn_context = node_args->spawn_context;
+        child->array = array + from;
+        child->num_elems = (num_elems - from < elems_per_child)
+                               ? (num_elems - from)
+                               : elems_per_child;
+        abt_spawn(node_args->spawn_context, reduce_node, child,
+                  &children[num_children]);
+        num_children++;
+    }
+    abt_sync(node_args->spawn_context, children, num_children);
+
+    long result = 0;
+    for (int i = 0; i < num_children; ++i) {
+        result += child_args[i].result;
+    }
+    node_args->result = result;
+}
+
+static long get_max_rss_kb(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+int main(int argc, char **argv)
+{
+    int i;
+    /* Read arguments. */
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    size_t num_elems = DEFAULT_NUM_ELEMS;
+    int num_iters = DEFAULT_NUM_ITERS;
+    int run_modes[2] = { 1, 1 };
+    while (1) {
+        int opt = getopt(argc, argv, "he:n:g:f:i:m:");
+        if (opt == -1)
+            break;
+        switch (opt) {
+            case 'e':
+                num_xstreams = atoi(optarg);
+                break;
+            case 'n':
+                num_elems = (size_t)atol(optarg);
+                break;
+            case 'g':
+                grain = (size_t)atol(optarg);
+                break;
+            case 'f':
+                fanout = atoi(optarg);
+                break;
+            case 'i':
+                num_iters = atoi(optarg);
+                break;
+            case 'm':
+                run_modes[SPAWN_MODE_HELP_FIRST] = strcmp(optarg, "work") != 0;
+                run_modes[SPAWN_MODE_WORK_FIRST] = strcmp(optarg, "help") != 0;
+                break;
+            case 'h':
+            default:
+                printf("Usage: ./recursive_reduction [-e NUM_XSTREAMS] "
+                       "[-n NUM_ELEMS] [-g GRAIN] [-f FANOUT] [-i NUM_ITERS] "
+                       "[-m help|work|both]\n");
+                return -1;
+        }
+    }
+    if (num_xstreams <= 0)
+        num_xstreams = 1;
+    if (num_elems == 0)
+        num_elems = 1;
+    if (grain == 0)
+        grain = 1;
+    if (fanout < 2)
+        fanout = 2;
+    if (fanout > MAX_FANOUT)
+        fanout = MAX_FANOUT;
+    if (num_iters <= 0)
+        num_iters = 1;
+
+    /* Allocate memory. */
+    ABT_xstream *xstreams =
+        (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    ABT_pool *pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    ABT_sched *scheds = (ABT_sched *)malloc(sizeof(ABT_sched) * num_xstreams);
+    long *array = (long *)malloc(sizeof(long) * num_elems);
+    for (size_t idx = 0; idx < num_elems; ++idx) {
+        array[idx] = (long)(idx % 1000);
+    }
+    long expected = 0;
+    for (size_t idx = 0; idx < num_elems; ++idx) {
+        expected += array[idx];
+    }
+
+    /* Initialize Argobots. */
+    ABT_init(argc, argv);
+
+    /* Create work-stealing deques and schedulers. */
+    spawn_create_scheds(num_xstreams, pools, scheds);
+
+    /* Set up a primary execution stream. */
+    ABT_xstream_self(&xstreams[0]);
+    ABT_xstream_set_main_sched(xstreams[0], scheds[0]);
+
+    /* Create secondary execution streams. */
+    for (i = 1; i < num_xstreams; i++) {
+        ABT_xstream_create(scheds[i], &xstreams[i]);
+    }
+
+    size_t stacksize = 0;
+    ABT_info_query_config(ABT_INFO_QUERY_KIND_DEFAULT_THREAD_STACKSIZE,
+                          &stacksize);
+
+    static const char *mode_names[] = { "help-first", "work-first" };
+    int failed = 0;
+    for (int mode = SPAWN_MODE_HELP_FIRST; mode <= SPAWN_MODE_WORK_FIRST;
+         mode++) {
+        if (!run_modes[mode])
+            continue;
+        spawn_context_t spawn_context;
+        spawn_context_init(&spawn_context, pools, num_xstreams,
+                           (spawn_mode_t)mode);
+        double min_time = 0.0, total_time = 0.0;
+        for (int iter = 0; iter < num_iters; iter++) {
+            node_args_t root = {
+                .spawn_context = &spawn_context,
+                .array = array,
+                .num_elems = num_elems,
+            };
+            double start_time = ABT_get_wtime();
+            reduce_node(&root);
+            double elapsed = ABT_get_wtime() - start_time;
+            if (root.result != expected) {
+                printf("%s: result=%ld, expected=%ld\n", mode_names[mode],
+                       root.result, expected);
+                failed = 1;
+            }
+            total_time += elapsed;
+            if (iter == 0 || elapsed < min_time)
+                min_time = elapsed;
+        }
+        printf("%-10s: min %.6f sec, avg %.6f sec, max live ULTs %zu "
+               "(%zu KB of stacks), max RSS %ld KB\n",
+               mode_names[mode], min_time, total_time / num_iters,
+               spawn_context.max_live,
+               spawn_context.max_live * stacksize / 1024, get_max_rss_kb());
+    }
+
+    /* Join secondary execution streams. */
+    for (i = 1; i < num_xstreams; i++) {
+        ABT_xstream_join(xstreams[i]);
+        ABT_xstream_free(&xstreams[i]);
+    }
+
+    /* Finalize Argobots. */
+    ABT_finalize();
+
+    /* Free allocated memory. */
+    free(xstreams);
+    free(pools);
+    free(scheds);
+    free(array);
+
+    if (failed) {
+        printf("Validation failed.\n");
+        return -1;
+    }
+    return 0;
+}
@@ -10,6 +10,7 @@
  */
 
 #include "abt_reduction.h"
+#include "abt_bench.h"
 
 #include <float.h>
 #include <getopt.h>
@@ -657,10 +658,28 @@ int main(int argc, char **argv)
         .num_threads = num_threads,
     };
 
-    int failed_tests = test_different_reductions(&reduction_context);
-    if (failed_tests > 0) {
-        printf("Failed %d tests\n", failed_tests);
-        return -1;
+    /* Run the same tests with ULT leaves and with tasklet leaves.  The runs
+     * are repeated and reported by the benchmark runner (ABT_BENCH_*). */
+    static const char *mode_names[] = { "ult", "tasklet" };
+    int regressed = 0;
+    for (int mode = REDUCTION_MODE_ULT; mode <= REDUCTION_MODE_TASKLET; mode++) {
+        reduction_context.mode = (reduction_mode_t)mode;
+        bench_t bench;
+        bench_init(&bench, "reduction");
+        bench_config(&bench, "xstreams", "%d", num_xstreams);
+        bench_config(&bench, "threads", "%d", num_threads);
+        bench_config(&bench, "mode", "%s", mode_names[mode]);
+        for (int run = 0; run < bench_num_runs(&bench); run++) {
+            bench_run_begin(&bench);
+            int failed_tests = test_different_reductions(&reduction_context);
+            bench_run_end(&bench, failed_tests == 0);
+            if (failed_tests > 0) {
+                printf("Failed %d tests (%s mode)\n", failed_tests,
+                       mode_names[mode]);
+                return -1;
+            }
+        }
+        regressed |= bench_finish(&bench);
     }
 
     /* Free ULTs. */
@@ -682,5 +701,5 @@ int main(int argc, char **argv)
     free(pools);
     free(threads);
 
-    return 0;
+    return regressed ? -1 : 0;
 }
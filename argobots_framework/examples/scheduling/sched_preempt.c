@@ -0,0 +1,282 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+/*
+ * This example runs a mixed workload on worker execution streams: long
+ * compute-bound ULTs that never yield and a stream of short ULTs that the
+ * primary ULT releases at a fixed interval.  Without preemption, a short ULT
+ * waits until every long ULT ahead of it in the pool completes.  With
+ * preemption (configure --enable-preemption), long ULTs are switched out after
+ * a quantum, so short ULTs start within a few quanta and long ULTs on the same
+ * execution stream share it fairly.
+ *
+ * -e [NUM_XSTREAMS] the number of worker execution streams
+ * -l [NUM_LONG]     long ULTs per worker execution stream
+ * -t [LONG_TIME]    work of a long ULT in ms
+ * -s [NUM_SHORT]    short ULTs in total (0 measures the overhead only)
+ * -w [SHORT_TIME]   work of a short ULT in us
+ * -i [INTERVAL]     release interval of short ULTs in us
+ * -p [MODE]         0: no preemption
+ *                   1: long ULTs are preemptible (ABT_thread_attr)
+ *                   2: all ULTs in worker pools are preemptible (ABT_pool)
+ * -q [QUANTUM]      preemption quantum in us (ABT_PREEMPTION_INTERVAL_USEC)
+ *
+ * The makespan of long ULTs, Jain's fairness index of their progress rates,
+ * and the p50/p99/max latency of short ULTs are printed.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <time.h>
+#include <abt.h>
+
+#define DEFAULT_NUM_XSTREAMS 2
+#define DEFAULT_NUM_LONG 2
+#define DEFAULT_LONG_TIME 50    /* [ms] */
+#define DEFAULT_NUM_SHORT 200
+#define DEFAULT_SHORT_TIME 10   /* [us] */
+#define DEFAULT_INTERVAL 1000   /* [us] */
+#define DEFAULT_MODE 1
+#define DEFAULT_QUANTUM "1000"  /* [us] */
+#define CALIBRATION_TIME 0.02   /* [s] */
+
+typedef struct {
+    unsigned long num_iters;
+    double release_time;
+    double end_time;
+} work_arg_t;
+
+static volatile double g_sink;
+
+static void compute(unsigned long num_iters)
+{
+    unsigned long i;
+    double x = 1.0;
+    for (i = 0; i < num_iters; i++) {
+        x = x * 1.0000001 + 1.0e-9;
+    }
+    g_sink = x;
+}
+
+static void work_func(void *p_arg)
+{
+    work_arg_t *arg = (work_arg_t *)p_arg;
+    compute(arg->num_iters);
+    arg->end_time = ABT_get_wtime();
+}
+
+/* Returns the number of iterations of compute() per second. */
+static double calibrate(void)
+{
+    unsigned long num_iters = 1024;
+    while (1) {
+        double start_time = ABT_get_wtime();
+        compute(num_iters);
+        double elapsed = ABT_get_wtime() - start_time;
+        if (elapsed > CALIBRATION_TIME)
+            return num_iters / elapsed;
+        num_iters *= 2;
+    }
+}
+
+static void sleep_until(double time)
+{
+    double delay = time - ABT_get_wtime();
+    if (delay > 0.0) {
+        struct timespec ts;
+        ts.tv_sec = (time_t)delay;
+        ts.tv_nsec = (long)((delay - (double)ts.tv_sec) * 1.0e9);
+        nanosleep(&ts, NULL);
+    }
+}
+
+static int compare_doubles(const void *p_a, const void *p_b)
+{
+    double a = *(const double *)p_a, b = *(const double *)p_b;
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_long_per_xstream = DEFAULT_NUM_LONG;
+    int long_time = DEFAULT_LONG_TIME;
+    int num_short = DEFAULT_NUM_SHORT;
+    int short_time = DEFAULT_SHORT_TIME;
+    int interval = DEFAULT_INTERVAL;
+    int mode = DEFAULT_MODE;
+    int i;
+
+    /* Use a short quantum unless the user specifies one. */
+    setenv("ABT_PREEMPTION_INTERVAL_USEC", DEFAULT_QUANTUM, 0);
+
+    while (1) {
+        int opt = getopt(argc, argv, "he:l:t:s:w:i:p:q:");
+        if (opt == -1)
+            break;
+        switch (opt) {
+            case 'e':
+                num_xstreams = atoi(optarg);
+                break;
+            case 'l':
+                num_long_per_xstream = atoi(optarg);
+                break;
+            case 't':
+                long_time = atoi(optarg);
+                break;
+            case 's':
+                num_short = atoi(optarg);
+                break;
+            case 'w':
+                short_time = atoi(optarg);
+                break;
+            case 'i':
+                interval = atoi(optarg);
+                break;
+            case 'p':
+                mode = atoi(optarg);
+                break;
+            case 'q':
+                setenv("ABT_PREEMPTION_INTERVAL_USEC", optarg, 1);
+                break;
+            case 'h':
+            default:
+                printf("Usage: ./sched_preempt [-e NUM_XSTREAMS] "
+                       "[-l NUM_LONG] [-t LONG_TIME] [-s NUM_SHORT] "
+                       "[-w SHORT_TIME] [-i INTERVAL] [-p MODE] "
+                       "[-q QUANTUM]\n"
+                       "MODE = 0 : no preemption\n"
+                       "       1 : preemptible long ULTs\n"
+                       "       2 : preemptible pools\n");
+                return -1;
+        }
+    }
+    if (num_xstreams < 1 || num_long_per_xstream < 0 || long_time < 0 ||
+        num_short < 0 || short_time < 0 || interval < 0 || mode < 0 ||
+        mode > 2) {
+        printf("Invalid arguments.\n");
+        return -1;
+    }
+
+    ABT_init(argc, argv);
+
+    ABT_bool preemption_enabled = ABT_FALSE;
+    ABT_info_query_config(ABT_INFO_QUERY_KIND_ENABLED_PREEMPTION,
+                          (void *)&preemption_enabled);
+    if (mode != 0 && !preemption_enabled) {
+        printf("Preemption is not available: long ULTs run to completion.\n");
+    }
+
+    /* Calibrate before idle worker execution streams take CPU time. */
+    double iters_per_sec = calibrate();
+
+    /* The primary execution stream only releases short ULTs. */
+    ABT_xstream *xstreams =
+        (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    ABT_pool *pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    for (i = 0; i < num_xstreams; i++) {
+        ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        if (mode == 2)
+            ABT_pool_set_preemptible(pools[i], ABT_TRUE);
+    }
+    ABT_thread_attr long_attr;
+    ABT_thread_attr_create(&long_attr);
+    if (mode == 1)
+        ABT_thread_attr_set_preemptible(long_attr, ABT_TRUE);
+
+    int num_long = num_xstreams * num_long_per_xstream;
+    int num_ults = num_long + num_short;
+    work_arg_t *args = (work_arg_t *)calloc(num_ults, sizeof(work_arg_t));
+    ABT_thread *threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_ults);
+
+    /* Long ULTs are pushed first, so short ULTs queue up behind them. */
+    double start_time = ABT_get_wtime();
+    for (i = 0; i < num_long; i++) {
+        args[i].num_iters = (unsigned long)(iters_per_sec * long_time * 1.0e-3);
+        args[i].release_time = start_time;
+        ABT_thread_create(pools[i % num_xstreams], work_func, &args[i],
+                          long_attr, &threads[i]);
+    }
+    for (i = num_long; i < num_ults; i++) {
+        double release_time =
+            start_time + (i - num_long + 1) * interval * 1.0e-6;
+        sleep_until(release_time);
+        args[i].num_iters =
+            (unsigned long)(iters_per_sec * short_time * 1.0e-6);
+        args[i].release_time = ABT_get_wtime();
+        ABT_thread_create(pools[i % num_xstreams], work_func, &args[i],
+                          ABT_THREAD_ATTR_NULL, &threads[i]);
+    }
+    /* Wait in nanosleep() so that the primary execution stream does not take
+     * CPU time from the workers while ULTs are running. */
+    for (i = 0; i < num_ults; i++) {
+        while (*(volatile double *)&args[i].end_time == 0.0) {
+            sleep_until(ABT_get_wtime() + interval * 1.0e-6);
+        }
+    }
+    for (i = 0; i < num_ults; i++) {
+        ABT_thread_free(&threads[i]);
+    }
+    double elapsed = ABT_get_wtime() - start_time;
+
+    /* Long ULTs: makespan and fairness of progress rates. */
+    double makespan = 0.0, sum_rate = 0.0, sum_rate2 = 0.0;
+    for (i = 0; i < num_long; i++) {
+        double completion = args[i].end_time - start_time;
+        double rate = 1.0 / completion;
+        makespan = completion > makespan ? completion : makespan;
+        sum_rate += rate;
+        sum_rate2 += rate * rate;
+    }
+    double ideal = num_long_per_xstream * long_time * 1.0e-3;
+    printf("mode = %d (%s), %d worker xstreams, %d long ULTs x %d [ms], "
+           "%d short ULTs x %d [us] every %d [us]\n",
+           mode,
+           (mode == 0 || !preemption_enabled)
+               ? "no preemption"
+               : (mode == 1 ? "preemptible ULTs" : "preemptible pools"),
+           num_xstreams, num_long, long_time, num_short, short_time, interval);
+    printf("quantum = %s [us]\n", getenv("ABT_PREEMPTION_INTERVAL_USEC"));
+    printf("elapsed time = %f [s]\n", elapsed);
+    if (num_long > 0) {
+        printf("long ULTs: makespan = %f [s] (ideal %f [s]), "
+               "fairness = %f\n",
+               makespan, ideal, sum_rate * sum_rate / (num_long * sum_rate2));
+    }
+
+    /* Short ULTs: latency from release to completion. */
+    if (num_short > 0) {
+        double *latencies = (double *)malloc(sizeof(double) * num_short);
+        for (i = 0; i < num_short; i++) {
+            work_arg_t *arg = &args[num_long + i];
+            latencies[i] = arg->end_time - arg->release_time;
+        }
+        qsort(latencies, num_short, sizeof(double), compare_doubles);
+        printf("short ULTs: latency p50 = %f [us], p99 = %f [us], "
+               "max = %f [us]\n",
+               latencies[(num_short - 1) / 2] * 1.0e6,
+               latencies[(int)((num_short - 1) * 0.99)] * 1.0e6,
+               latencies[num_short - 1] * 1.0e6);
+        free(latencies);
+    }
+
+    /* Join worker execution streams. */
+    for (i = 0; i < num_xstreams; i++) {
+        ABT_xstream_join(xstreams[i]);
+        ABT_xstream_free(&xstreams[i]);
+    }
+    ABT_thread_attr_free(&long_attr);
+
+    ABT_finalize();
+
+    free(args);
+    free(threads);
+    free(xstreams);
+    free(pools);
+
+    return 0;
+}
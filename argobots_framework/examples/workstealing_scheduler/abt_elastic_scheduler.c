@@ -0,0 +1,372 @@
+#include "abt_elastic_scheduler.h"
+
+#include <float.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define ELASTIC_EVENT_FREQ 10
+#define ELASTIC_CACHELINE_SIZE 64
+
+// The state of one scheduler.  Only its own scheduler writes busy_ns; the
+// controller writes parked.
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int parked;
+    uint64_t busy_ns;        // time spent running units
+    uint64_t last_busy_ns;   // busy_ns at the previous sample (controller)
+} __attribute__((aligned(ELASTIC_CACHELINE_SIZE))) elastic_slot_t;
+
+struct elastic {
+    elastic_config_t config;
+    int num;
+    ABT_pool *pools;         // [num]
+    elastic_slot_t *slots;   // [num]
+    ABT_pool ctl_pool;       // served by scheds[0] only
+    ABT_thread controller;
+    int stopping;
+    int refs;                // the schedulers and the user
+
+    // Owned by the controller.  Slots [0, num_running) run, the others are
+    // parked.
+    int num_running;
+    int idle_periods;
+    double start_time;
+    double last_time;
+    double running_time;     // integral of num_running over time
+    uint64_t num_parks;
+    uint64_t num_revives;
+};
+
+typedef struct {
+    uint32_t event_freq;
+    elastic_t *elastic;
+    int rank;
+} elastic_sched_data_t;
+
+static void elastic_release(elastic_t *elastic)
+{
+    if (__atomic_sub_fetch(&elastic->refs, 1, __ATOMIC_ACQ_REL) != 0)
+        return;
+    for (int i = 0; i < elastic->num; i++) {
+        pthread_mutex_destroy(&elastic->slots[i].lock);
+        pthread_cond_destroy(&elastic->slots[i].cond);
+    }
+    free(elastic->slots);
+    free(elastic->pools);
+    free(elastic);
+}
+
+static void elastic_set_parked(elastic_slot_t *slot, int parked)
+{
+    pthread_mutex_lock(&slot->lock);
+    __atomic_store_n(&slot->parked, parked, __ATOMIC_RELEASE);
+    if (!parked)
+        pthread_cond_signal(&slot->cond);
+    pthread_mutex_unlock(&slot->lock);
+}
+
+// Blocks while the scheduler is parked.  ULTs sleeping or waiting with a
+// timeout on this xstream are woken by ABT_xstream_check_events(), so the
+// wait ends at the next timer expiry to process the timers.  The woken ULTs
+// go back to their pools, where the running schedulers steal them.
+static void elastic_park(ABT_sched sched, elastic_slot_t *slot)
+{
+    pthread_mutex_lock(&slot->lock);
+    while (__atomic_load_n(&slot->parked, __ATOMIC_ACQUIRE)) {
+        double next_time;
+        ABT_xstream_get_next_timer_time(sched, &next_time);
+        if (next_time == DBL_MAX) {
+            pthread_cond_wait(&slot->cond, &slot->lock);
+            continue;
+        }
+        double delay = next_time - ABT_get_wtime();
+        if (delay > 0.0) {
+            // pthread_cond_timedwait() takes CLOCK_REALTIME.
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            uint64_t nsec = (uint64_t)ts.tv_nsec + (uint64_t)(delay * 1.0e9);
+            ts.tv_sec += (time_t)(nsec / 1000000000);
+            ts.tv_nsec = (long)(nsec % 1000000000);
+            pthread_cond_timedwait(&slot->cond, &slot->lock, &ts);
+            if (!__atomic_load_n(&slot->parked, __ATOMIC_ACQUIRE))
+                break;
+        }
+        pthread_mutex_unlock(&slot->lock);
+        ABT_xstream_check_events(sched);
+        pthread_mutex_lock(&slot->lock);
+    }
+    pthread_mutex_unlock(&slot->lock);
+}
+
+// Takes one sample and parks or revives at most one scheduler.
+static void elastic_adjust(elastic_t *elastic, double now)
+{
+    const elastic_config_t *config = &elastic->config;
+    double elapsed = now - elastic->last_time;
+    size_t queued = 0;
+    uint64_t busy_ns = 0;
+
+    for (int i = 0; i < elastic->num; i++) {
+        size_t size;
+        ABT_pool_get_size(elastic->pools[i], &size);
+        queued += size;
+
+        elastic_slot_t *slot = &elastic->slots[i];
+        uint64_t cur = __atomic_load_n(&slot->busy_ns, __ATOMIC_RELAXED);
+        busy_ns += cur - slot->last_busy_ns;
+        slot->last_busy_ns = cur;
+    }
+    elastic->running_time += elastic->num_running * elapsed;
+    elastic->last_time = now;
+
+    int num_running = elastic->num_running;
+    double idle_ratio = 1.0 - busy_ns * 1.0e-9 / (num_running * elapsed);
+
+    if (queued > config->grow_threshold * num_running &&
+        num_running < config->max_xstreams) {
+        elastic_set_parked(&elastic->slots[num_running], 0);
+        elastic->num_running++;
+        elastic->num_revives++;
+        elastic->idle_periods = 0;
+    } else if (idle_ratio > config->idle_threshold &&
+               queued <= (size_t)num_running &&
+               num_running > config->min_xstreams) {
+        if (++elastic->idle_periods >= config->hysteresis) {
+            elastic_set_parked(&elastic->slots[num_running - 1], 1);
+            elastic->num_running--;
+            elastic->num_parks++;
+            elastic->idle_periods = 0;
+        }
+    } else {
+        elastic->idle_periods = 0;
+    }
+}
+
+static void elastic_controller(void *arg)
+{
+    elastic_t *elastic = (elastic_t *)arg;
+    double next = ABT_get_wtime() + elastic->config.interval;
+
+    while (!__atomic_load_n(&elastic->stopping, __ATOMIC_ACQUIRE)) {
+        double now = ABT_get_wtime();
+        if (now >= next) {
+            elastic_adjust(elastic, now);
+            next = now + elastic->config.interval;
+        }
+        ABT_thread_yield();
+    }
+}
+
+static int sched_init(ABT_sched sched, ABT_sched_config config)
+{
+    elastic_sched_data_t *p_data =
+        (elastic_sched_data_t *)calloc(1, sizeof(elastic_sched_data_t));
+
+    ABT_sched_config_read(config, 3, &p_data->event_freq, &p_data->elastic,
+                          &p_data->rank);
+    ABT_sched_set_data(sched, (void *)p_data);
+
+    return ABT_SUCCESS;
+}
+
+static void sched_run(ABT_sched sched)
+{
+    uint32_t work_count = 0;
+    elastic_sched_data_t *p_data;
+    elastic_t *elastic;
+    elastic_slot_t *slot;
+    int num_pools;
+    ABT_pool *pools;
+    int target;
+    ABT_bool stop;
+
+    ABT_sched_get_data(sched, (void **)&p_data);
+    elastic = p_data->elastic;
+    slot = &elastic->slots[p_data->rank];
+    /* scheds[0] has the controller pool after the others. */
+    num_pools = elastic->num;
+    pools = (ABT_pool *)malloc(num_pools * sizeof(ABT_pool));
+    ABT_sched_get_pools(sched, num_pools, 0, pools);
+
+    while (1) {
+        ABT_thread thread;
+        ABT_pool pool = ABT_POOL_NULL;
+
+        if (__atomic_load_n(&slot->parked, __ATOMIC_ACQUIRE))
+            elastic_park(sched, slot);
+
+        ABT_pool_pop_thread(pools[0], &thread);
+        if (thread == ABT_THREAD_NULL) {
+            /* Try to steal from other pools, parked ones included */
+            for (target = 1; target < num_pools; target++) {
+                ABT_pool_pop_thread(pools[target], &thread);
+                if (thread != ABT_THREAD_NULL) {
+                    pool = pools[target];
+                    break;
+                }
+            }
+        }
+        if (thread != ABT_THREAD_NULL) {
+            double start = ABT_get_wtime();
+            ABT_self_schedule(thread, pool);
+            uint64_t busy_ns = (uint64_t)((ABT_get_wtime() - start) * 1.0e9);
+            __atomic_fetch_add(&slot->busy_ns, busy_ns, __ATOMIC_RELAXED);
+        }
+
+        if (++work_count >= p_data->event_freq) {
+            work_count = 0;
+            ABT_sched_has_to_stop(sched, &stop);
+            if (stop == ABT_TRUE) {
+                break;
+            }
+            ABT_xstream_check_events(sched);
+            if (p_data->rank == 0) {
+                ABT_pool_pop_thread(elastic->ctl_pool, &thread);
+                if (thread != ABT_THREAD_NULL)
+                    ABT_self_schedule(thread, ABT_POOL_NULL);
+            }
+        }
+    }
+
+    free(pools);
+}
+
+static int sched_free(ABT_sched sched)
+{
+    elastic_sched_data_t *p_data;
+
+    ABT_sched_get_data(sched, (void **)&p_data);
+    elastic_release(p_data->elastic);
+    free(p_data);
+
+    return ABT_SUCCESS;
+}
+
+static int env_int(const char *name, int value)
+{
+    const char *env = getenv(name);
+    return (env && env[0] != '\0') ? atoi(env) : value;
+}
+
+static double env_double(const char *name, double value)
+{
+    const char *env = getenv(name);
+    return (env && env[0] != '\0') ? atof(env) : value;
+}
+
+void ABT_elastic_config_from_env(elastic_config_t *config, int num)
+{
+    config->min_xstreams = env_int("ABT_ELASTIC_MIN", 1);
+    config->max_xstreams = env_int("ABT_ELASTIC_MAX", num);
+    config->interval = env_int("ABT_ELASTIC_INTERVAL_US", 1000) * 1.0e-6;
+    config->grow_threshold = env_double("ABT_ELASTIC_GROW", 2.0);
+    config->idle_threshold = env_double("ABT_ELASTIC_IDLE", 0.5);
+    config->hysteresis = env_int("ABT_ELASTIC_HYSTERESIS", 4);
+}
+
+elastic_t *ABT_create_elastic_scheds(int num, ABT_pool *pools, ABT_sched *scheds,
+                                     const elastic_config_t *config)
+{
+    ABT_sched_config sched_config;
+    ABT_pool *sched_pools;
+    elastic_t *elastic;
+    int i, k;
+
+    ABT_sched_config_var cv_event_freq = {
+        .idx = 0,
+        .type = ABT_SCHED_CONFIG_INT,
+    };
+    ABT_sched_config_var cv_elastic = {
+        .idx = 1,
+        .type = ABT_SCHED_CONFIG_PTR,
+    };
+    ABT_sched_config_var cv_rank = {
+        .idx = 2,
+        .type = ABT_SCHED_CONFIG_INT,
+    };
+
+    ABT_sched_def sched_def = {
+        .type = ABT_SCHED_TYPE_ULT,
+        .init = sched_init,
+        .run = sched_run,
+        .free = sched_free,
+        .get_migr_pool = NULL
+    };
+
+    elastic = (elastic_t *)calloc(1, sizeof(elastic_t));
+    elastic->config = *config;
+    if (elastic->config.max_xstreams > num || elastic->config.max_xstreams < 1)
+        elastic->config.max_xstreams = num;
+    if (elastic->config.min_xstreams < 1)
+        elastic->config.min_xstreams = 1;
+    if (elastic->config.min_xstreams > elastic->config.max_xstreams)
+        elastic->config.min_xstreams = elastic->config.max_xstreams;
+    if (elastic->config.hysteresis < 1)
+        elastic->config.hysteresis = 1;
+    elastic->num = num;
+    elastic->pools = (ABT_pool *)malloc(num * sizeof(ABT_pool));
+    memcpy(elastic->pools, pools, num * sizeof(ABT_pool));
+    if (posix_memalign((void **)&elastic->slots, ELASTIC_CACHELINE_SIZE,
+                       num * sizeof(elastic_slot_t)) != 0) {
+        fprintf(stderr, "ABT_create_elastic_scheds: out of memory\n");
+        abort();
+    }
+    memset(elastic->slots, 0, num * sizeof(elastic_slot_t));
+    elastic->num_running = elastic->config.max_xstreams;
+    for (i = 0; i < num; i++) {
+        pthread_mutex_init(&elastic->slots[i].lock, NULL);
+        pthread_cond_init(&elastic->slots[i].cond, NULL);
+        elastic->slots[i].parked = (i >= elastic->num_running);
+    }
+    elastic->refs = num + 1;
+    elastic->start_time = elastic->last_time = ABT_get_wtime();
+
+    ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_TRUE,
+                          &elastic->ctl_pool);
+
+    sched_pools = (ABT_pool *)malloc((num + 1) * sizeof(ABT_pool));
+    for (i = 0; i < num; i++) {
+        for (k = 0; k < num; k++) {
+            sched_pools[k] = pools[(i + k) % num];
+        }
+        sched_pools[num] = elastic->ctl_pool;
+
+        ABT_sched_config_create(&sched_config, cv_event_freq, ELASTIC_EVENT_FREQ,
+                                cv_elastic, (void *)elastic, cv_rank, i,
+                                ABT_sched_config_var_end);
+        ABT_sched_create(&sched_def, (i == 0) ? num + 1 : num, sched_pools,
+                         sched_config, &scheds[i]);
+        ABT_sched_config_free(&sched_config);
+    }
+    free(sched_pools);
+
+    ABT_thread_create(elastic->ctl_pool, elastic_controller, elastic,
+                      ABT_THREAD_ATTR_NULL, &elastic->controller);
+    return elastic;
+}
+
+void ABT_elastic_stop(elastic_t *elastic, elastic_stats_t *stats)
+{
+    __atomic_store_n(&elastic->stopping, 1, __ATOMIC_RELEASE);
+    ABT_thread_free(&elastic->controller);
+
+    double now = ABT_get_wtime();
+    elastic->running_time += elastic->num_running * (now - elastic->last_time);
+    if (stats) {
+        stats->num_parks = elastic->num_parks;
+        stats->num_revives = elastic->num_revives;
+        stats->avg_xstreams = (now > elastic->start_time)
+                                  ? elastic->running_time /
+                                        (now - elastic->start_time)
+                                  : elastic->num_running;
+    }
+
+    for (int i = 0; i < elastic->num; i++) {
+        elastic_set_parked(&elastic->slots[i], 0);
+    }
+    elastic_release(elastic);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <abt.h>
+#include <stdint.h>
+
+// Elastic work stealing schedulers.
+//
+// Each scheduler pops from its own pool and steals from all the others, like
+// the schedulers of ABT_create_ws_scheds().  A controller ULT, run by the
+// scheduler of pools[0], samples every `interval` seconds how many units are
+// queued in all the pools and how busy each running scheduler was.  It parks
+// the scheduler of the highest running rank when the running ones have been
+// idle for `hysteresis` periods in a row, and revives the lowest parked one
+// as soon as more than `grow_threshold` units per running scheduler are
+// queued.  A parked scheduler sleeps on a condition variable (a futex on
+// Linux) and its pool is drained by the running ones.  It still wakes up
+// when a ULT sleeping or waiting with a timeout on its xstream expires, so
+// that the ULT is pushed back to its pool.
+//
+// Rank 0 is never parked, and the number of running schedulers stays within
+// [min_xstreams, max_xstreams]; schedulers at and above max_xstreams stay
+// parked.  ABT_elastic_stop() has to be called before the xstreams are
+// joined, since a parked scheduler does not see the join request.
+
+typedef struct {
+    int min_xstreams;
+    int max_xstreams;
+    double interval;         // controller period [s]
+    double grow_threshold;   // queued units per running xstream to revive one
+    double idle_threshold;   // idle ratio above which one may be parked
+    int hysteresis;          // idle periods in a row before parking
+} elastic_config_t;
+
+typedef struct {
+    uint64_t num_parks;
+    uint64_t num_revives;
+    double avg_xstreams;     // running xstreams averaged over time
+} elastic_stats_t;
+
+typedef struct elastic elastic_t;
+
+// Fills config with the defaults for num xstreams, overridden by
+// ABT_ELASTIC_MIN, ABT_ELASTIC_MAX, ABT_ELASTIC_INTERVAL_US,
+// ABT_ELASTIC_GROW, ABT_ELASTIC_IDLE and ABT_ELASTIC_HYSTERESIS.
+void ABT_elastic_config_from_env(elastic_config_t *config, int num);
+
+// Associates each pool with an elastic scheduler; scheds[0] also runs the
+// controller.  num - number of pools (MUST equal to number of scheds).
+// Returns the controller, which is stopped by ABT_elastic_stop().
+elastic_t *ABT_create_elastic_scheds(int num, ABT_pool *pools, ABT_sched *scheds,
+                                     const elastic_config_t *config);
+
+// Stops the controller and revives all the parked schedulers.  If stats is
+// not NULL, the statistics of the run are stored there.  elastic must not be
+// used afterwards.
+void ABT_elastic_stop(elastic_t *elastic, elastic_stats_t *stats);
@@ -6,13 +6,15 @@
 
 typedef struct {
     uint32_t event_freq;
+    int steal_threshold;
 } ws_sched_data_t;
 
 static int sched_init(ABT_sched sched, ABT_sched_config config)
 {
     ws_sched_data_t *p_data = (ws_sched_data_t *)calloc(1, sizeof(ws_sched_data_t));
 
-    ABT_sched_config_read(config, 1, &p_data->event_freq);
+    ABT_sched_config_read(config, 2, &p_data->event_freq,
+                          &p_data->steal_threshold);
     ABT_sched_set_data(sched, (void *)p_data);
 
     return ABT_SUCCESS;
@@ -39,6 +41,12 @@ static void sched_run(ABT_sched sched)
         if (thread == ABT_THREAD_NULL) {
             /* Try to steal from other pools */
             for (target = 1; target < num_pools; target++) {
+                if (p_data->steal_threshold > 0) {
+                    size_t size;
+                    ABT_pool_get_size(pools[target], &size);
+                    if (size <= (size_t)p_data->steal_threshold)
+                        continue;
+                }
                 ABT_pool_pop_thread(pools[target], &thread);
                 if (thread != ABT_THREAD_NULL) {
                     ABT_self_schedule(thread, pools[target]);
@@ -72,7 +80,21 @@ static int sched_free(ABT_sched sched)
     return ABT_SUCCESS;
 }
 
+void ABT_ws_sched_set_steal_threshold(ABT_sched sched, int steal_threshold)
+{
+    ws_sched_data_t *p_data;
+
+    ABT_sched_get_data(sched, (void **)&p_data);
+    p_data->steal_threshold = steal_threshold;
+}
+
 void ABT_create_ws_scheds(int num, ABT_pool *pools, ABT_sched *scheds)
+{
+    ABT_create_ws_scheds_threshold(num, pools, scheds, 0);
+}
+
+void ABT_create_ws_scheds_threshold(int num, ABT_pool *pools, ABT_sched *scheds,
+                                    int steal_threshold)
 {
     ABT_sched_config config;
     ABT_pool *sched_pools;
@@ -82,6 +104,10 @@ void ABT_create_ws_scheds(int num, ABT_pool *pools, ABT_sched *scheds)
         .idx = 0,
         .type = ABT_SCHED_CONFIG_INT,
     };
+    ABT_sched_config_var cv_steal_threshold = {
+        .idx = 1,
+        .type = ABT_SCHED_CONFIG_INT,
+    };
 
     ABT_sched_def sched_def = {
         .type = ABT_SCHED_TYPE_ULT,
@@ -91,7 +117,8 @@ void ABT_create_ws_scheds(int num, ABT_pool *pools, ABT_sched *scheds)
         .get_migr_pool = NULL
     };
 
-    ABT_sched_config_create(&config, cv_event_freq, 10, ABT_sched_config_var_end);
+    ABT_sched_config_create(&config, cv_event_freq, 10, cv_steal_threshold,
+                            steal_threshold, ABT_sched_config_var_end);
 
     sched_pools = (ABT_pool *)malloc(num * sizeof(ABT_pool));
     for (i = 0; i < num; i++) {
@@ -7,3 +7,14 @@
 // pools - array of pool handles (MUST be initialized).
 // scheds - array of scheduler handles (WILL be initialized).
 void ABT_create_ws_scheds(int num, ABT_pool *pools, ABT_sched *scheds);
+
+// Same as ABT_create_ws_scheds(), but an idle scheduler steals from a pool
+// only if it holds more than steal_threshold units.  A threshold of 0 steals
+// whenever the victim is not empty; a larger one leaves the units of a
+// slightly busier xstream in place, where their data is cached.
+void ABT_create_ws_scheds_threshold(int num, ABT_pool *pools, ABT_sched *scheds,
+                                    int steal_threshold);
+
+// Changes the steal threshold of a scheduler created by one of the functions
+// above, e.g. while a driver tunes itself.  Takes effect at the next steal.
+void ABT_ws_sched_set_steal_threshold(ABT_sched sched, int steal_threshold);
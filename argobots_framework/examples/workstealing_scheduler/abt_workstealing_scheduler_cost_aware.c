@@ -31,6 +31,7 @@ static pool_meta_t *g_pool_meta = NULL;
 /* ===================== ДАННЫЕ ПЛАНИРОВЩИКА ===================== */
 typedef struct {
     uint32_t event_freq;
+    int steal_threshold;        // Порог дисбаланса для кражи
     int rank;                   // Идентификатор исполнительного потока
     double local_total_time;    // Локальное суммарное время (историческое)
     int local_task_count;       // Локальное количество выполненных задач (историческое)
@@ -170,7 +171,8 @@ static int sched_init(ABT_sched sched, ABT_sched_config config) {
     ws_sched_data_t *p_data = (ws_sched_data_t *)calloc(1, sizeof(ws_sched_data_t));
     
     /* Читаем конфигурацию */
-    ABT_sched_config_read(config, 1, &p_data->event_freq);
+    ABT_sched_config_read(config, 2, &p_data->event_freq,
+                          &p_data->steal_threshold);
     
     /* Получаем rank текущего исполнительного потока */
     ABT_xstream x;
@@ -206,6 +208,13 @@ static void sched_run(ABT_sched sched) {
             /* Локальная очередь пуста - ищем, у кого красть (по текущим оценкам) */
             int victim = ws_find_heaviest_pool(p_data->rank, num_pools);
             
+            /* Не крадём, пока дисбаланс не превысил порог */
+            if (victim >= 0 && p_data->steal_threshold > 0) {
+                size_t size;
+                ABT_pool_get_size(pools[victim], &size);
+                if (size <= (size_t)p_data->steal_threshold) victim = -1;
+            }
+
             if (victim >= 0) {
                 /* Пытаемся красть у выбранной жертвы */
                 ABT_pool_pop_thread(pools[victim], &thread);
@@ -246,7 +255,20 @@ static int sched_free(ABT_sched sched) {
 
 /* ===================== ПУБЛИЧНЫЙ ИНТЕРФЕЙС ===================== */
 
+void ABT_ws_sched_cost_aware_set_steal_threshold(ABT_sched sched,
+                                                 int steal_threshold) {
+    ws_sched_data_t *p_data;
+    ABT_sched_get_data(sched, (void **)&p_data);
+    p_data->steal_threshold = steal_threshold;
+}
+
 void ABT_create_ws_scheds_cost_aware(int num, ABT_pool *pools, ABT_sched *scheds) {
+    ABT_create_ws_scheds_cost_aware_threshold(num, pools, scheds, 0);
+}
+
+void ABT_create_ws_scheds_cost_aware_threshold(int num, ABT_pool *pools,
+                                               ABT_sched *scheds,
+                                               int steal_threshold) {
     int i, k;
     ABT_sched_config config;
     ABT_pool *sched_pools;
@@ -255,6 +277,10 @@ void ABT_create_ws_scheds_cost_aware(int num, ABT_pool *pools, ABT_sched *scheds
         .idx = 0, 
         .type = ABT_SCHED_CONFIG_INT 
     };
+    ABT_sched_config_var cv_steal_threshold = {
+        .idx = 1,
+        .type = ABT_SCHED_CONFIG_INT
+    };
 
     ABT_sched_def sched_def = {
         .type = ABT_SCHED_TYPE_ULT,
@@ -283,7 +309,8 @@ void ABT_create_ws_scheds_cost_aware(int num, ABT_pool *pools, ABT_sched *scheds
     }
 
     /* Создаем конфигурацию планировщика */
-    ABT_sched_config_create(&config, cv_event_freq, 10, ABT_sched_config_var_end);
+    ABT_sched_config_create(&config, cv_event_freq, 10, cv_steal_threshold,
+                            steal_threshold, ABT_sched_config_var_end);
 
     sched_pools = (ABT_pool *)malloc(num * sizeof(ABT_pool));
     for (i = 0; i < num; i++) {
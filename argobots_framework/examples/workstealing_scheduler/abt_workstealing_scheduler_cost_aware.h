@@ -3,6 +3,15 @@
 
 // Cost-aware work stealing scheduler
 void ABT_create_ws_scheds_cost_aware(int num, ABT_pool *pools, ABT_sched *scheds);
+/* Как ABT_create_ws_scheds_cost_aware(), но кража из пула разрешена, только если
+   в нём больше steal_threshold задач (0 - красть из любого непустого пула). */
+void ABT_create_ws_scheds_cost_aware_threshold(int num, ABT_pool *pools,
+                                               ABT_sched *scheds,
+                                               int steal_threshold);
+/* Меняет порог кражи планировщика, созданного функциями выше (например, при
+   автонастройке драйвера); действует со следующей попытки кражи. */
+void ABT_ws_sched_cost_aware_set_steal_threshold(ABT_sched sched,
+                                                 int steal_threshold);
 
 /* Метаданные задач для выбора жертвы по оценочной стоимости очередей. */
 void ws_push_task_estimate(int rank, double est);
@@ -8,6 +8,7 @@
 
 #include "abt_workstealing_scheduler.h"
 #include "abt_workstealing_scheduler_cost_aware.h"
+#include "abt_bench.h"
 
 /* ============================================================
  * Конфигурация
@@ -242,11 +243,29 @@ int main(void) {
     for (int i = 0; i < ntests; i++) {
         printf("\n=== Тест %d ===\n", i + 1);
 
-        create_tasks(&tests[i]);
-        benchmark_stats_t old = run_benchmark(SCHEDULER_OLD, tests[i]);
-
-        create_tasks(&tests[i]);
-        benchmark_stats_t nw  = run_benchmark(SCHEDULER_NEW, tests[i]);
+        /* Повторы и статистика - через ABT_BENCH_* (см. abt_bench.h) */
+        benchmark_stats_t stats[2];
+        for (int scheduler = SCHEDULER_OLD; scheduler <= SCHEDULER_NEW; scheduler++) {
+            bench_t bench;
+            bench_init(&bench, "ws_compare");
+            bench_config(&bench, "scheduler", "%s",
+                         scheduler == SCHEDULER_OLD ? "old" : "new");
+            bench_config(&bench, "xstreams", "%d", tests[i].num_xstreams);
+            bench_config(&bench, "tasks_per_stream", "%d", tests[i].tasks_per_stream);
+            bench_config(&bench, "complexity", "%d", tests[i].complexity_mode);
+            for (int run = 0; run < bench_num_runs(&bench); run++) {
+                create_tasks(&tests[i]);
+                bench_run_begin(&bench);
+                stats[scheduler] = run_benchmark(scheduler, tests[i]);
+                bench_run_end(&bench, 1);
+                for (int t = 0; t < g_task_count; t++)
+                    free(g_tasks[t]);
+                free(g_tasks);
+            }
+            bench_finish(&bench);
+        }
+        benchmark_stats_t old = stats[SCHEDULER_OLD];
+        benchmark_stats_t nw  = stats[SCHEDULER_NEW];
 
         printf("OLD: %.2f ms, steals=%d, imbalance=%d, eff=%.3f\n",
                old.total_time_ms, old.steals, old.imbalance, old.efficiency);
@@ -258,10 +277,6 @@ int main(void) {
                      / old.total_time_ms * 100.0;
 
         printf("Improvement: %.2f %%\n", imp);
-
-        for (int t = 0; t < g_task_count; t++)
-            free(g_tasks[t]);
-        free(g_tasks);
     }
 
     return 0;
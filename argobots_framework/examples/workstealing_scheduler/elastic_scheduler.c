@@ -0,0 +1,105 @@
+/*
+ * Elastic scheduler example.  Bursts of work are separated by idle phases;
+ * the controller parks the xstreams during the idle phases and revives them
+ * for the bursts.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "abt_elastic_scheduler.h"
+
+#define NUM_XSTREAMS 4
+#define NUM_BURSTS 3
+#define NUM_THREADS 64
+#define IDLE_TIME 0.2 /* [s] */
+
+static int g_counter = 0;
+
+static void compute(void *arg)
+{
+    (void)arg;
+    volatile double value = 1.0;
+    int i;
+    for (i = 0; i < 100000; i++) {
+        value = value * 0.5 + 1.0;
+    }
+    __atomic_fetch_add(&g_counter, 1, __ATOMIC_RELAXED);
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream xstreams[NUM_XSTREAMS];
+    ABT_sched scheds[NUM_XSTREAMS];
+    ABT_pool pools[NUM_XSTREAMS];
+    ABT_thread threads[NUM_THREADS];
+    elastic_config_t config;
+    elastic_stats_t stats;
+    elastic_t *elastic;
+    int i, burst;
+
+    ABT_init(argc, argv);
+
+    /* Create pools */
+    for (i = 0; i < NUM_XSTREAMS; i++) {
+        ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_TRUE, &pools[i]);
+    }
+
+    /* Create elastic schedulers */
+    ABT_elastic_config_from_env(&config, NUM_XSTREAMS);
+    elastic = ABT_create_elastic_scheds(NUM_XSTREAMS, pools, scheds, &config);
+
+    /* Create ESs */
+    ABT_xstream_self(&xstreams[0]);
+    ABT_xstream_set_main_sched(xstreams[0], scheds[0]);
+    for (i = 1; i < NUM_XSTREAMS; i++) {
+        ABT_xstream_create(scheds[i], &xstreams[i]);
+    }
+
+    for (burst = 0; burst < NUM_BURSTS; burst++) {
+        /* Idle phase */
+        double start = ABT_get_wtime();
+        while (ABT_get_wtime() - start < IDLE_TIME) {
+            ABT_thread_yield();
+        }
+
+        /* Burst */
+        for (i = 0; i < NUM_THREADS; i++) {
+            ABT_thread_create(pools[i % NUM_XSTREAMS], compute, NULL,
+                              ABT_THREAD_ATTR_NULL, &threads[i]);
+        }
+        for (i = 0; i < NUM_THREADS; i++) {
+            ABT_thread_free(&threads[i]);
+        }
+    }
+
+    ABT_elastic_stop(elastic, &stats);
+    printf("parks: %lu, revives: %lu, avg. xstreams: %.2f\n",
+           (unsigned long)stats.num_parks, (unsigned long)stats.num_revives,
+           stats.avg_xstreams);
+
+    /* Join & Free */
+    for (i = 1; i < NUM_XSTREAMS; i++) {
+        ABT_xstream_join(xstreams[i]);
+        ABT_xstream_free(&xstreams[i]);
+    }
+
+    /* Free schedulers */
+    for (i = 1; i < NUM_XSTREAMS; i++) {
+        ABT_sched_free(&scheds[i]);
+    }
+
+    /* Finalize */
+    ABT_finalize();
+
+    if (g_counter != NUM_BURSTS * NUM_THREADS) {
+        printf("expected=%d vs. g_counter=%d\n", NUM_BURSTS * NUM_THREADS,
+               g_counter);
+        return 1;
+    }
+    if (stats.num_parks == 0 || stats.num_revives == 0) {
+        printf("the xstreams were never parked and revived\n");
+        return 1;
+    }
+    return 0;
+}
@@ -11,6 +11,11 @@
 #define ABTD_SCHED_DEFAULT_STACKSIZE (4 * 1024 * 1024)
 #define ABTD_SCHED_EVENT_FREQ 50
 #define ABTD_SCHED_SLEEP_NSEC 100
+#define ABTD_BARRIER_SPIN_COUNT 128
+#define ABTD_BARRIER_YIELD_COUNT 16
+#define ABTD_TRACE_BUFFER_SIZE 65536
+#define ABTD_STATS_MAX_XSTREAMS 256
+#define ABTD_STATS_MAX_POOLS 64
 
 #define ABTD_SYS_PAGE_SIZE 4096
 #define ABTD_HUGE_PAGE_SIZE (2 * 1024 * 1024)
@@ -100,6 +105,18 @@ void ABTD_env_init(ABTI_global *p_global)
     p_global->mutex_max_wakeups =
         load_env_uint32("MUTEX_MAX_WAKEUPS", 1, 1, ABTD_ENV_UINT32_MAX);
 
+    /* ABT_BARRIER_SPIN_COUNT, ABT_ENV_BARRIER_SPIN_COUNT
+     * Number of busy-wait iterations before a barrier waiter yields */
+    p_global->barrier_spin_count =
+        load_env_uint32("BARRIER_SPIN_COUNT", ABTD_BARRIER_SPIN_COUNT, 0,
+                        ABTD_ENV_UINT32_MAX);
+
+    /* ABT_BARRIER_YIELD_COUNT, ABT_ENV_BARRIER_YIELD_COUNT
+     * Number of yields before a barrier waiter blocks */
+    p_global->barrier_yield_count =
+        load_env_uint32("BARRIER_YIELD_COUNT", ABTD_BARRIER_YIELD_COUNT, 0,
+                        ABTD_ENV_UINT32_MAX);
+
     /* ABT_PRINT_RAW_STACK, ABT_ENV_PRINT_RAW_STACK */
     ABT_bool default_print_raw_stack = ABT_TRUE;
 #ifdef ABT_CONFIG_DISABLE_STACK_UNWIND_DUMP_RAW_STACK
@@ -223,6 +240,77 @@ void ABTD_env_init(ABTI_global *p_global)
     /* Whether to print the configuration on ABT_init() */
     p_global->print_config = ABTD_env_get_print_config();
 
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+    /* ABT_PERF_COUNTERS, ABT_ENV_PERF_COUNTERS
+     * Whether to sample hardware counters per ULT and tasklet */
+    p_global->perf_enabled = load_env_bool("PERF_COUNTERS", ABT_FALSE);
+#endif
+
+#ifdef ABT_CONFIG_USE_PREEMPTION
+    /* ABT_PREEMPTION_INTERVAL_USEC, ABT_ENV_PREEMPTION_INTERVAL_USEC
+     * Quantum of preemptible ULTs in microseconds (0: no preemption) */
+    p_global->preemption_interval_usec =
+        load_env_uint64("PREEMPTION_INTERVAL_USEC", 0, 0, ABTD_ENV_UINT64_MAX);
+#endif
+
+#ifdef ABT_CONFIG_USE_TRACE
+    /* ABT_TRACE, ABT_ENV_TRACE
+     * Whether to record events in per-ES trace buffers */
+    p_global->trace_enabled = load_env_bool("TRACE", ABT_FALSE);
+
+    /* ABT_TRACE_BUFFER_SIZE, ABT_ENV_TRACE_BUFFER_SIZE
+     * Number of trace records kept by each ES (rounded up to a power of 2) */
+    p_global->trace_buffer_size = roundup_pow2_uint32(
+        load_env_uint32("TRACE_BUFFER_SIZE", ABTD_TRACE_BUFFER_SIZE, 64,
+                        ABTD_ENV_UINT32_MAX));
+
+    /* ABT_TRACE_FILE, ABT_ENV_TRACE_FILE
+     * Trace file written by ABT_finalize() */
+    p_global->trace_file = NULL;
+    env = get_abt_env("TRACE_FILE");
+    if (env != NULL) {
+        size_t len = strlen(env);
+        if (ABTU_malloc(len + 1, (void **)&p_global->trace_file) ==
+            ABT_SUCCESS) {
+            memcpy(p_global->trace_file, env, len + 1);
+        } else {
+            p_global->trace_file = NULL;
+        }
+    }
+#endif
+
+#ifdef ABT_CONFIG_USE_STATS
+    /* ABT_STATS, ABT_ENV_STATS
+     * Whether to publish live counters in a shared-memory file */
+    p_global->stats_enabled = load_env_bool("STATS", ABT_FALSE);
+
+    /* ABT_STATS_MAX_XSTREAMS, ABT_ENV_STATS_MAX_XSTREAMS
+     * Number of ES slots in the statistics file */
+    p_global->stats_max_xstreams =
+        load_env_uint32("STATS_MAX_XSTREAMS", ABTD_STATS_MAX_XSTREAMS, 1,
+                        ABTD_ENV_UINT32_MAX);
+
+    /* ABT_STATS_MAX_POOLS, ABT_ENV_STATS_MAX_POOLS
+     * Number of pool slots in the statistics file */
+    p_global->stats_max_pools =
+        load_env_uint32("STATS_MAX_POOLS", ABTD_STATS_MAX_POOLS, 1,
+                        ABTD_ENV_UINT32_MAX);
+
+    /* ABT_STATS_FILE, ABT_ENV_STATS_FILE
+     * Statistics file, which is removed by ABT_finalize() */
+    p_global->stats_file = NULL;
+    env = get_abt_env("STATS_FILE");
+    if (env != NULL) {
+        size_t len = strlen(env);
+        if (ABTU_malloc(len + 1, (void **)&p_global->stats_file) ==
+            ABT_SUCCESS) {
+            memcpy(p_global->stats_file, env, len + 1);
+        } else {
+            p_global->stats_file = NULL;
+        }
+    }
+#endif
+
     /* Init timer */
     ABTD_time_init();
 }
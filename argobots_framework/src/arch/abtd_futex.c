@@ -47,6 +47,18 @@ void ABTD_futex_broadcast(ABTD_futex_multiple *p_futex)
             NULL, 0);
 }
 
+void ABTD_futex_wake_and_unlock(ABTD_futex_multiple *p_futex,
+                                ABTD_spinlock *p_lock, int max_waiters)
+{
+    /* A waiter that reads val after this update does not sleep, so the system
+     * call can be issued after releasing p_lock. */
+    int current_val = ABTD_atomic_relaxed_load_int(&p_futex->val);
+    ABTD_atomic_relaxed_store_int(&p_futex->val, current_val + 1);
+    ABTD_spinlock_release(p_lock);
+    syscall(SYS_futex, &p_futex->val.val, FUTEX_WAKE_PRIVATE, max_waiters,
+            NULL, NULL, 0);
+}
+
 void ABTD_futex_suspend(ABTD_futex_single *p_futex)
 {
     /* Wake-up signal is 1. */
@@ -161,7 +173,8 @@ void ABTD_futex_timedwait_and_unlock(ABTD_futex_multiple *p_futex,
             } else {
                 ABTI_ASSERT(sync_obj.p_prev);
                 sync_obj.p_prev->p_next = sync_obj.p_next;
-                sync_obj.p_next->p_prev = sync_obj.p_prev;
+                if (sync_obj.p_next)
+                    sync_obj.p_next->p_prev = sync_obj.p_prev;
             }
         }
         ABTD_spinlock_release(p_lock);
@@ -188,6 +201,24 @@ void ABTD_futex_broadcast(ABTD_futex_multiple *p_futex)
     p_futex->p_next = NULL;
 }
 
+void ABTD_futex_wake_and_unlock(ABTD_futex_multiple *p_futex,
+                                ABTD_spinlock *p_lock, int max_waiters)
+{
+    /* p_lock protects the list of pthread_sync, so it is released last. */
+    pthread_sync *p_cur = (pthread_sync *)p_futex->p_next;
+    while (p_cur && max_waiters > 0) {
+        pthread_sync *p_next = p_cur->p_next;
+        pthread_mutex_lock(&p_cur->mutex);
+        ABTD_atomic_relaxed_store_int(&p_cur->val, 1);
+        pthread_cond_broadcast(&p_cur->cond);
+        pthread_mutex_unlock(&p_cur->mutex);
+        p_cur = p_next;
+        max_waiters--;
+    }
+    p_futex->p_next = (void *)p_cur;
+    ABTD_spinlock_release(p_lock);
+}
+
 void ABTD_futex_suspend(ABTD_futex_single *p_futex)
 {
     if (ABTD_atomic_acquire_load_ptr(&p_futex->p_sync_obj) != NULL) {
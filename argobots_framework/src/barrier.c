@@ -5,6 +5,16 @@
 
 #include "abti.h"
 
+#define ABTI_BARRIER_TREE_FANIN 4
+
+static void barrier_engine_release(ABTI_local *p_local,
+                                   ABTI_barrier_engine *p_engine,
+                                   uint64_t tag);
+static void barrier_engine_wait_release(ABTI_local **pp_local,
+                                        ABTI_barrier_engine *p_engine,
+                                        uint64_t tag, ABT_bool block_xstream,
+                                        void *p_sync);
+
 /** @defgroup BARRIER Barrier
  * This group is for Barrier.
  */
@@ -56,15 +66,15 @@ int ABT_barrier_create(uint32_t num_waiters, ABT_barrier *newbarrier)
     int abt_errno;
     ABTI_barrier *p_newbarrier;
     ABTI_CHECK_TRUE(num_waiters != 0, ABT_ERR_INV_ARG);
-    size_t arg_num_waiters = num_waiters;
 
     abt_errno = ABTU_malloc(sizeof(ABTI_barrier), (void **)&p_newbarrier);
     ABTI_CHECK_ERROR(abt_errno);
 
-    ABTD_spinlock_clear(&p_newbarrier->lock);
-    p_newbarrier->num_waiters = arg_num_waiters;
-    p_newbarrier->counter = 0;
-    ABTI_waitlist_init(&p_newbarrier->waitlist);
+    abt_errno = ABTI_barrier_engine_init(&p_newbarrier->engine, num_waiters);
+    if (ABTI_IS_ERROR_CHECK_ENABLED && abt_errno != ABT_SUCCESS) {
+        ABTU_free(p_newbarrier);
+        ABTI_HANDLE_ERROR(abt_errno);
+    }
     /* Return value */
     *newbarrier = ABTI_barrier_get_handle(p_newbarrier);
     return ABT_SUCCESS;
@@ -105,15 +115,20 @@ int ABT_barrier_reinit(ABT_barrier barrier, uint32_t num_waiters)
 
     ABTI_barrier *p_barrier = ABTI_barrier_get_ptr(barrier);
     ABTI_CHECK_NULL_BARRIER_PTR(p_barrier);
-    ABTI_UB_ASSERT(p_barrier->counter == 0);
+    ABTI_UB_ASSERT(ABTI_barrier_engine_is_idle(&p_barrier->engine));
     ABTI_CHECK_TRUE(num_waiters != 0, ABT_ERR_INV_ARG);
-    size_t arg_num_waiters = num_waiters;
 
-    /* Only when num_waiters is different from p_barrier->num_waiters, we
-     * change p_barrier. */
-    if (arg_num_waiters != p_barrier->num_waiters) {
-        /* We can reuse waiters and waiter_type arrays */
-        p_barrier->num_waiters = arg_num_waiters;
+    /* Only when num_waiters is different from the current one, we rebuild the
+     * combining tree. */
+    if (num_waiters != p_barrier->engine.num_waiters) {
+        int abt_errno;
+        ABTI_barrier_engine new_engine;
+        abt_errno = ABTI_barrier_engine_init(&new_engine, num_waiters);
+        ABTI_CHECK_ERROR(abt_errno);
+        new_engine.f_cb = p_barrier->engine.f_cb;
+        new_engine.p_cb_arg = p_barrier->engine.p_cb_arg;
+        ABTI_barrier_engine_destroy(&p_barrier->engine);
+        p_barrier->engine = new_engine;
     }
     return ABT_SUCCESS;
 }
@@ -150,14 +165,15 @@ int ABT_barrier_free(ABT_barrier *barrier)
     ABTI_barrier *p_barrier = ABTI_barrier_get_ptr(h_barrier);
     ABTI_CHECK_NULL_BARRIER_PTR(p_barrier);
 
-    /* The lock needs to be acquired to safely free the barrier structure.
-     * However, we do not have to unlock it because the entire structure is
-     * freed here. */
-    ABTD_spinlock_acquire(&p_barrier->lock);
+    /* The lock needs to be acquired to safely free the barrier structure since
+     * the last waiter might be still waking up the others.  However, we do not
+     * have to unlock it because the entire structure is freed here. */
+    ABTD_spinlock_acquire(&p_barrier->engine.lock);
 
-    /* p_barrier->counter must be checked after taking a lock. */
-    ABTI_UB_ASSERT(p_barrier->counter == 0);
+    /* The tree must be checked after taking a lock. */
+    ABTI_UB_ASSERT(ABTI_barrier_engine_is_idle(&p_barrier->engine));
 
+    ABTI_barrier_engine_destroy(&p_barrier->engine);
     ABTU_free(p_barrier);
 
     /* Return value */
@@ -212,23 +228,8 @@ int ABT_barrier_wait(ABT_barrier barrier)
     }
 #endif
 
-    ABTD_spinlock_acquire(&p_barrier->lock);
-
-    ABTI_ASSERT(p_barrier->counter < p_barrier->num_waiters);
-    p_barrier->counter++;
-
-    /* If we do not have all the waiters yet */
-    if (p_barrier->counter < p_barrier->num_waiters) {
-        ABTI_waitlist_wait_and_unlock(&p_local, &p_barrier->waitlist,
-                                      &p_barrier->lock,
-                                      ABT_SYNC_EVENT_TYPE_BARRIER,
-                                      (void *)p_barrier);
-    } else {
-        ABTI_waitlist_broadcast(p_local, &p_barrier->waitlist);
-        /* Reset counter */
-        p_barrier->counter = 0;
-        ABTD_spinlock_release(&p_barrier->lock);
-    }
+    ABTI_barrier_engine_wait(&p_local, &p_barrier->engine, ABT_FALSE,
+                             (void *)p_barrier);
     return ABT_SUCCESS;
 }
 
@@ -263,6 +264,261 @@ int ABT_barrier_get_num_waiters(ABT_barrier barrier, uint32_t *num_waiters)
     ABTI_barrier *p_barrier = ABTI_barrier_get_ptr(barrier);
     ABTI_CHECK_NULL_BARRIER_PTR(p_barrier);
 
-    *num_waiters = p_barrier->num_waiters;
+    *num_waiters = p_barrier->engine.num_waiters;
+    return ABT_SUCCESS;
+}
+
+/**
+ * @ingroup BARRIER
+ * @brief   Set a callback function of a barrier.
+ *
+ * \c ABT_barrier_set_callback() sets the callback function \c cb_func of the
+ * barrier \c barrier.  When all the waiters reach \c barrier, the last waiter
+ * calls \c cb_func() with \c cb_arg as its argument before any of the waiters
+ * returns from \c ABT_barrier_wait().  This can be used to combine partial
+ * results (e.g., a reduction) exactly once per barrier episode.  If \c cb_func
+ * is \c NULL, the callback is unset.
+ *
+ * \c cb_func() may not call \c ABT_barrier_wait() on \c barrier.
+ *
+ * @contexts
+ * \DOC_CONTEXT_INIT \DOC_CONTEXT_NOCTXSWITCH
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_INV_BARRIER_HANDLE{\c barrier}
+ *
+ * @undefined
+ * \DOC_UNDEFINED_UNINIT
+ * \DOC_UNDEFINED_WAITER{\c barrier}
+ * \DOC_UNDEFINED_THREAD_UNSAFE{\c barrier}
+ *
+ * @param[in] barrier  barrier handle
+ * @param[in] cb_func  callback function
+ * @param[in] cb_arg   argument passed to \c cb_func
+ * @return Error code
+ */
+int ABT_barrier_set_callback(ABT_barrier barrier, void (*cb_func)(void *),
+                             void *cb_arg)
+{
+    ABTI_UB_ASSERT(ABTI_initialized());
+
+    ABTI_barrier *p_barrier = ABTI_barrier_get_ptr(barrier);
+    ABTI_CHECK_NULL_BARRIER_PTR(p_barrier);
+    ABTI_UB_ASSERT(ABTI_barrier_engine_is_idle(&p_barrier->engine));
+
+    p_barrier->engine.f_cb = cb_func;
+    p_barrier->engine.p_cb_arg = cb_arg;
     return ABT_SUCCESS;
 }
+
+/*****************************************************************************/
+/* Private APIs                                                              */
+/*****************************************************************************/
+
+/* The barrier engine is a combining tree whose leaves accept at most
+ * ABTI_BARRIER_TREE_FANIN waiters and whose inner nodes combine at most
+ * ABTI_BARRIER_TREE_FANIN children.  Waiters are anonymous, so a waiter starts
+ * from the leaf chosen by its ES rank and moves to the next leaf if that one is
+ * already full.  The last arriver of each node climbs up the tree, and the one
+ * that completes the root resets the tree and releases the others by
+ * incrementing tag (sense reversal). */
+ABTU_ret_err int ABTI_barrier_engine_init(ABTI_barrier_engine *p_engine,
+                                          uint32_t num_waiters)
+{
+    const uint32_t fanin = ABTI_BARRIER_TREE_FANIN;
+    uint32_t num_leaves = (num_waiters + fanin - 1) / fanin;
+    uint32_t num_nodes = 0, width = num_leaves, offset = 0, i;
+    while (1) {
+        num_nodes += width;
+        if (width == 1)
+            break;
+        width = (width + fanin - 1) / fanin;
+    }
+
+    ABTI_barrier_node *p_nodes;
+    int abt_errno =
+        ABTU_memalign(ABT_CONFIG_STATIC_CACHELINE_SIZE,
+                      sizeof(ABTI_barrier_node) * num_nodes, (void **)&p_nodes);
+    ABTI_CHECK_ERROR(abt_errno);
+
+    for (i = 0; i < num_nodes; i++) {
+        ABTD_atomic_relaxed_store_uint32(&p_nodes[i].count, 0);
+        p_nodes[i].p_parent = NULL;
+    }
+    for (i = 0; i < num_leaves; i++) {
+        p_nodes[i].num_arrivals = ABTU_min_uint32(num_waiters - i * fanin, fanin);
+    }
+    width = num_leaves;
+    while (width > 1) {
+        uint32_t parent_width = (width + fanin - 1) / fanin;
+        for (i = 0; i < width; i++) {
+            p_nodes[offset + i].p_parent = &p_nodes[offset + width + i / fanin];
+        }
+        for (i = 0; i < parent_width; i++) {
+            p_nodes[offset + width + i].num_arrivals =
+                ABTU_min_uint32(width - i * fanin, fanin);
+        }
+        offset += width;
+        width = parent_width;
+    }
+
+    p_engine->num_waiters = num_waiters;
+    p_engine->num_leaves = num_leaves;
+    p_engine->num_nodes = num_nodes;
+    p_engine->p_nodes = p_nodes;
+    p_engine->f_cb = NULL;
+    p_engine->p_cb_arg = NULL;
+    ABTD_atomic_relaxed_store_uint64(&p_engine->tag, 0);
+    ABTD_spinlock_clear(&p_engine->lock);
+    ABTI_waitlist_init(&p_engine->waitlist);
+#ifndef ABT_CONFIG_ACTIVE_WAIT_POLICY
+    ABTD_futex_multiple_init(&p_engine->futex);
+    p_engine->num_blocked_xstreams = 0;
+#endif
+    return ABT_SUCCESS;
+}
+
+void ABTI_barrier_engine_destroy(ABTI_barrier_engine *p_engine)
+{
+    ABTU_free(p_engine->p_nodes);
+}
+
+ABT_bool ABTI_barrier_engine_is_idle(ABTI_barrier_engine *p_engine)
+{
+    uint32_t i;
+    for (i = 0; i < p_engine->num_nodes; i++) {
+        if (ABTD_atomic_relaxed_load_uint32(&p_engine->p_nodes[i].count) != 0)
+            return ABT_FALSE;
+    }
+    return ABT_TRUE;
+}
+
+/* If block_xstream is ABT_TRUE, the caller never yields and blocks the
+ * underlying ES (used by ABT_xstream_barrier).  Otherwise, a yieldable caller
+ * spins, yields, and finally suspends on the waitlist. */
+void ABTI_barrier_engine_wait(ABTI_local **pp_local,
+                              ABTI_barrier_engine *p_engine,
+                              ABT_bool block_xstream, void *p_sync)
+{
+    /* tag must be read before arriving; otherwise the episode might complete
+     * before tag is read. */
+    const uint64_t tag = ABTD_atomic_acquire_load_uint64(&p_engine->tag);
+
+    ABTI_xstream *p_local_xstream = ABTI_local_get_xstream_or_null(*pp_local);
+    uint32_t leaf = p_local_xstream
+                        ? ((uint32_t)p_local_xstream->rank) % p_engine->num_leaves
+                        : 0;
+    ABTI_barrier_node *p_node;
+    uint32_t count;
+    /* Claim a slot of a leaf. */
+    while (1) {
+        p_node = &p_engine->p_nodes[leaf];
+        count = ABTD_atomic_fetch_add_uint32(&p_node->count, 1);
+        if (count < p_node->num_arrivals)
+            break;
+        /* This leaf is full.  Try the next one. */
+        leaf = (leaf + 1 == p_engine->num_leaves) ? 0 : (leaf + 1);
+    }
+    /* The last arriver of a node proceeds to its parent. */
+    while (count + 1 == p_node->num_arrivals) {
+        if (!p_node->p_parent) {
+            /* This waiter completes the root. */
+            barrier_engine_release(*pp_local, p_engine, tag);
+            return;
+        }
+        p_node = p_node->p_parent;
+        count = ABTD_atomic_fetch_add_uint32(&p_node->count, 1);
+    }
+    barrier_engine_wait_release(pp_local, p_engine, tag, block_xstream, p_sync);
+}
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+static void barrier_engine_release(ABTI_local *p_local,
+                                   ABTI_barrier_engine *p_engine, uint64_t tag)
+{
+    uint32_t i;
+    if (p_engine->f_cb)
+        p_engine->f_cb(p_engine->p_cb_arg);
+    /* All the waiters have arrived, so nobody touches the tree now. */
+    for (i = 0; i < p_engine->num_nodes; i++) {
+        ABTD_atomic_relaxed_store_uint32(&p_engine->p_nodes[i].count, 0);
+    }
+    /* Release the waiters while holding the lock so that the barrier is not
+     * freed before blocked waiters are woken up. */
+    ABTD_spinlock_acquire(&p_engine->lock);
+    /* Note that this tag is sufficiently large, so it will not wrap around. */
+    ABTD_atomic_release_store_uint64(&p_engine->tag, tag + 1);
+    ABTI_waitlist_broadcast(p_local, &p_engine->waitlist);
+#ifndef ABT_CONFIG_ACTIVE_WAIT_POLICY
+    if (p_engine->num_blocked_xstreams) {
+        p_engine->num_blocked_xstreams = 0;
+        ABTD_futex_broadcast(&p_engine->futex);
+    }
+#endif
+    ABTD_spinlock_release(&p_engine->lock);
+}
+
+static void barrier_engine_wait_release(ABTI_local **pp_local,
+                                        ABTI_barrier_engine *p_engine,
+                                        uint64_t tag, ABT_bool block_xstream,
+                                        void *p_sync)
+{
+    ABTI_global *p_global = ABTI_global_get_global();
+    uint32_t i;
+
+    /* 1. Spin. */
+    for (i = 0; i < p_global->barrier_spin_count; i++) {
+        if (ABTD_atomic_acquire_load_uint64(&p_engine->tag) != tag)
+            return;
+        ABTD_atomic_pause();
+    }
+
+    if (block_xstream) {
+#ifdef ABT_CONFIG_ACTIVE_WAIT_POLICY
+        while (ABTD_atomic_acquire_load_uint64(&p_engine->tag) == tag)
+            ABTD_atomic_pause();
+#else
+        /* 2. Block the underlying ES. */
+        ABTD_spinlock_acquire(&p_engine->lock);
+        if (ABTD_atomic_relaxed_load_uint64(&p_engine->tag) == tag) {
+            p_engine->num_blocked_xstreams++;
+            /* Spurious wakeup does not happen, so tag has been updated. */
+            ABTD_futex_wait_and_unlock(&p_engine->futex, &p_engine->lock);
+        } else {
+            ABTD_spinlock_release(&p_engine->lock);
+        }
+#endif
+        return;
+    }
+
+    /* 2. Yield if the caller is yieldable. */
+    ABTI_xstream *p_local_xstream = ABTI_local_get_xstream_or_null(*pp_local);
+    if (!ABTI_IS_EXT_THREAD_ENABLED || p_local_xstream) {
+        ABTI_ythread *p_ythread =
+            ABTI_thread_get_ythread_or_null(p_local_xstream->p_thread);
+        if (p_ythread) {
+            for (i = 0; i < p_global->barrier_yield_count; i++) {
+                if (ABTD_atomic_acquire_load_uint64(&p_engine->tag) != tag)
+                    return;
+                ABTI_ythread_yield(&p_local_xstream, p_ythread,
+                                   ABTI_YTHREAD_YIELD_KIND_YIELD_LOOP,
+                                   ABT_SYNC_EVENT_TYPE_BARRIER, p_sync);
+                *pp_local = ABTI_xstream_get_local(p_local_xstream);
+            }
+        }
+    }
+
+    /* 3. Block. */
+    ABTD_spinlock_acquire(&p_engine->lock);
+    if (ABTD_atomic_relaxed_load_uint64(&p_engine->tag) == tag) {
+        ABTI_waitlist_wait_and_unlock(pp_local, &p_engine->waitlist,
+                                      &p_engine->lock,
+                                      ABT_SYNC_EVENT_TYPE_BARRIER, p_sync);
+    } else {
+        ABTD_spinlock_release(&p_engine->lock);
+    }
+}
@@ -6,8 +6,6 @@
 #include "abti.h"
 #include <sys/time.h>
 
-static inline double convert_timespec_to_sec(const struct timespec *p_ts);
-
 /** @defgroup COND Condition Variable
  * This group is for Condition Variable.
  */
@@ -263,7 +261,7 @@ int ABT_cond_timedwait(ABT_cond cond, ABT_mutex mutex,
     ABTI_UB_ASSERT(!((p_mutex->attrs & ABTI_MUTEX_ATTR_RECURSIVE) &&
                      p_mutex->nesting_cnt > 1));
 
-    double tar_time = convert_timespec_to_sec(abstime);
+    double tar_time = ABTI_timespec_to_sec(abstime);
 
     ABTI_thread thread;
     thread.type = ABTI_THREAD_TYPE_EXT;
@@ -352,14 +350,3 @@ int ABT_cond_broadcast(ABT_cond cond)
     ABTI_cond_broadcast(p_local, p_cond);
     return ABT_SUCCESS;
 }
-
-/*****************************************************************************/
-/* Internal static functions                                                 */
-/*****************************************************************************/
-
-static inline double convert_timespec_to_sec(const struct timespec *p_ts)
-{
-    double secs;
-    secs = ((double)p_ts->tv_sec) + 1.0e-9 * ((double)p_ts->tv_nsec);
-    return secs;
-}
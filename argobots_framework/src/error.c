@@ -107,7 +107,8 @@ int ABT_error_get_str(int err, char *str, size_t *len)
                                      "ABT_ERR_SYS",
                                      "ABT_ERR_CPUID",
                                      "ABT_ERR_INV_POOL_CONFIG",
-                                     "ABT_ERR_INV_POOL_USER_DEF" };
+                                     "ABT_ERR_INV_POOL_USER_DEF",
+                                     "ABT_ERR_TIMEDOUT" };
 
 #ifndef ABT_CONFIG_ENABLE_VER_20_API
     ABTI_CHECK_TRUE(err >= ABT_SUCCESS &&
@@ -205,6 +205,70 @@ int ABT_eventual_wait(ABT_eventual eventual, void **value)
     return ABT_SUCCESS;
 }
 
+/**
+ * @ingroup EVENTUAL
+ * @brief   Wait on an eventual with a timeout.
+ *
+ * \c ABT_eventual_timedwait() waits on the eventual \c eventual like
+ * \c ABT_eventual_wait().  If \c eventual does not become ready before the
+ * absolute time \c abstime, \c ABT_ERR_TIMEDOUT is returned and \c value is
+ * left unchanged.
+ *
+ * A waiting ULT is suspended and does not occupy its pool.  The timer wheel of
+ * the execution stream on which it started waiting resumes it at \c abstime,
+ * which is checked by \c ABT_xstream_check_events().
+ *
+ * \DOC_DESC_ATOMICITY_EVENTUAL_READINESS
+ *
+ * @contexts
+ * \DOC_CONTEXT_INIT \DOC_CONTEXT_CTXSWITCH_CONDITIONAL{\c eventual is not
+ *                                                     ready}
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_SUCCESS_TIMEDOUT{\c eventual becomes ready}
+ * \DOC_ERROR_INV_EVENTUAL_HANDLE{\c eventual}
+ *
+ * @undefined
+ * \DOC_UNDEFINED_UNINIT
+ * \DOC_UNDEFINED_NULL_PTR{\c abstime}
+ * \DOC_UNDEFINED_EVENTUAL_BUFFER{\c eventual, \c value}
+ *
+ * @param[in]  eventual  eventual handle
+ * @param[out] value     memory buffer of the eventual
+ * @param[in]  abstime   absolute time for timeout
+ * @return Error code
+ */
+int ABT_eventual_timedwait(ABT_eventual eventual, void **value,
+                           const struct timespec *abstime)
+{
+    ABTI_UB_ASSERT(ABTI_initialized());
+    ABTI_UB_ASSERT(abstime);
+
+    ABTI_local *p_local = ABTI_local_get_local();
+    ABTI_eventual *p_eventual = ABTI_eventual_get_ptr(eventual);
+    ABTI_CHECK_NULL_EVENTUAL_PTR(p_eventual);
+
+    ABTD_spinlock_acquire(&p_eventual->lock);
+    if (p_eventual->ready == ABT_FALSE) {
+        ABT_bool is_timedout =
+            ABTI_waitlist_wait_timedout_and_unlock(&p_local,
+                                                   &p_eventual->waitlist,
+                                                   &p_eventual->lock,
+                                                   ABTI_timespec_to_sec(
+                                                       abstime),
+                                                   ABT_SYNC_EVENT_TYPE_EVENTUAL,
+                                                   (void *)p_eventual);
+        if (is_timedout)
+            return ABT_ERR_TIMEDOUT;
+    } else {
+        ABTD_spinlock_release(&p_eventual->lock);
+    }
+    if (value)
+        *value = p_eventual->value;
+    return ABT_SUCCESS;
+}
+
 /**
  * @ingroup EVENTUAL
  * @brief   Check if an eventual is ready.
@@ -72,6 +72,8 @@ int ABT_future_create(uint32_t num_compartments, void (*cb_func)(void **arg),
     ABTI_CHECK_ERROR(abt_errno);
     ABTD_spinlock_clear(&p_future->lock);
     ABTD_atomic_relaxed_store_size(&p_future->counter, 0);
+    ABTD_atomic_relaxed_store_size(&p_future->claimed, 0);
+    ABTD_atomic_relaxed_store_size(&p_future->num_set, 0);
     p_future->num_compartments = arg_num_compartments;
     if (arg_num_compartments > 0) {
         abt_errno = ABTU_malloc(arg_num_compartments * sizeof(void *),
@@ -200,6 +202,65 @@ int ABT_future_wait(ABT_future future)
     return ABT_SUCCESS;
 }
 
+/**
+ * @ingroup FUTURE
+ * @brief   Wait on a future with a timeout.
+ *
+ * \c ABT_future_timedwait() waits on the future \c future like
+ * \c ABT_future_wait().  If \c future does not become ready before the
+ * absolute time \c abstime, \c ABT_ERR_TIMEDOUT is returned.
+ *
+ * A waiting ULT is suspended and does not occupy its pool.  The timer wheel of
+ * the execution stream on which it started waiting resumes it at \c abstime,
+ * which is checked by \c ABT_xstream_check_events().
+ *
+ * \DOC_DESC_ATOMICITY_FUTURE_READINESS
+ *
+ * @contexts
+ * \DOC_CONTEXT_INIT \DOC_CONTEXT_CTXSWITCH_CONDITIONAL{\c future is not
+ *                                                     ready}
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_SUCCESS_TIMEDOUT{\c future becomes ready}
+ * \DOC_ERROR_INV_FUTURE_HANDLE{\c future}
+ *
+ * @undefined
+ * \DOC_UNDEFINED_UNINIT
+ * \DOC_UNDEFINED_NULL_PTR{\c abstime}
+ *
+ * @param[in] future   future handle
+ * @param[in] abstime  absolute time for timeout
+ * @return Error code
+ */
+int ABT_future_timedwait(ABT_future future, const struct timespec *abstime)
+{
+    ABTI_UB_ASSERT(ABTI_initialized());
+    ABTI_UB_ASSERT(abstime);
+
+    ABTI_local *p_local = ABTI_local_get_local();
+    ABTI_future *p_future = ABTI_future_get_ptr(future);
+    ABTI_CHECK_NULL_FUTURE_PTR(p_future);
+
+    ABTD_spinlock_acquire(&p_future->lock);
+    if (ABTD_atomic_relaxed_load_size(&p_future->counter) <
+        p_future->num_compartments) {
+        ABT_bool is_timedout =
+            ABTI_waitlist_wait_timedout_and_unlock(&p_local,
+                                                   &p_future->waitlist,
+                                                   &p_future->lock,
+                                                   ABTI_timespec_to_sec(
+                                                       abstime),
+                                                   ABT_SYNC_EVENT_TYPE_FUTURE,
+                                                   (void *)p_future);
+        if (is_timedout)
+            return ABT_ERR_TIMEDOUT;
+    } else {
+        ABTD_spinlock_release(&p_future->lock);
+    }
+    return ABT_SUCCESS;
+}
+
 /**
  * @ingroup FUTURE
  * @brief   Check if a future is ready.
@@ -275,30 +336,36 @@ int ABT_future_set(ABT_future future, void *value)
     ABTI_future *p_future = ABTI_future_get_ptr(future);
     ABTI_CHECK_NULL_FUTURE_PTR(p_future);
 
-    ABTD_spinlock_acquire(&p_future->lock);
-
-    size_t counter = ABTD_atomic_relaxed_load_size(&p_future->counter);
+    /* Setters do not take the lock: each claims a compartment with one
+     * fetch-add, writes it, and counts it as written with another.  The
+     * fetch-add of the last write acquires all the other writes, so only the
+     * setter that completes the array calls the callback, makes the future
+     * ready, and takes the lock to wake up the waiters. */
     size_t num_compartments = p_future->num_compartments;
+    size_t index = ABTD_atomic_fetch_add_size(&p_future->claimed, 1);
 #ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
     /* If num_compartments is 0, this routine always returns ABT_ERR_FUTURE */
-    if (counter >= num_compartments) {
-        ABTD_spinlock_release(&p_future->lock);
+    if (index >= num_compartments) {
         ABTI_HANDLE_ERROR(ABT_ERR_FUTURE);
     }
 #endif
-    p_future->array[counter] = value;
-    counter++;
-    /* Call a callback function before setting the counter. */
-    if (counter == num_compartments && p_future->p_callback != NULL) {
-        (*p_future->p_callback)(p_future->array);
+    p_future->array[index] = value;
+    if (ABTD_atomic_fetch_add_size(&p_future->num_set, 1) + 1 !=
+        num_compartments) {
+        return ABT_SUCCESS;
     }
 
-    ABTD_atomic_release_store_size(&p_future->counter, counter);
-
-    if (counter == num_compartments) {
-        ABTI_waitlist_broadcast(p_local, &p_future->waitlist);
+    /* Call a callback function before setting the counter. */
+    if (p_future->p_callback != NULL) {
+        (*p_future->p_callback)(p_future->array);
     }
 
+    /* A waiter checks the counter under the lock before it is added to the
+     * waitlist, so it is either woken up by the broadcast below or sees the
+     * future ready. */
+    ABTD_atomic_release_store_size(&p_future->counter, num_compartments);
+    ABTD_spinlock_acquire(&p_future->lock);
+    ABTI_waitlist_broadcast(p_local, &p_future->waitlist);
     ABTD_spinlock_release(&p_future->lock);
     return ABT_SUCCESS;
 }
@@ -343,6 +410,8 @@ int ABT_future_reset(ABT_future future)
 
     ABTD_spinlock_acquire(&p_future->lock);
     ABTI_UB_ASSERT(ABTI_waitlist_is_empty(&p_future->waitlist));
+    ABTD_atomic_relaxed_store_size(&p_future->claimed, 0);
+    ABTD_atomic_relaxed_store_size(&p_future->num_set, 0);
     ABTD_atomic_release_store_size(&p_future->counter, 0);
     ABTD_spinlock_release(&p_future->lock);
     return ABT_SUCCESS;
@@ -207,6 +207,23 @@ ABTU_ret_err static int init_library(void)
     /* Initialize the system environment */
     ABTD_env_init(p_global);
 
+#ifdef ABT_CONFIG_USE_TRACE
+    /* Initialize the event trace */
+    ABTI_trace_init(p_global);
+#endif
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+    /* Initialize hardware counters */
+    ABTI_perf_init(p_global);
+#endif
+#ifdef ABT_CONFIG_USE_STATS
+    /* Map the live statistics page */
+    ABTI_stats_init(p_global);
+#endif
+#ifdef ABT_CONFIG_USE_PREEMPTION
+    /* Install the preemption signal handler */
+    ABTI_preemption_init(p_global);
+#endif
+
     /* Initialize memory pool */
     abt_errno = ABTI_mem_init(p_global);
     if (abt_errno != ABT_SUCCESS)
@@ -277,6 +294,20 @@ FAILED:
                           p_local_xstream, ABT_TRUE);
         ABTI_local_set_xstream(NULL);
     }
+#ifdef ABT_CONFIG_USE_TRACE
+    p_global->trace_enabled = ABT_FALSE;
+    ABTI_trace_finalize(p_global);
+#endif
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+    p_global->perf_enabled = ABT_FALSE;
+    ABTI_perf_finalize(p_global);
+#endif
+#ifdef ABT_CONFIG_USE_STATS
+    ABTI_stats_finalize(p_global);
+#endif
+#ifdef ABT_CONFIG_USE_PREEMPTION
+    ABTI_preemption_finalize(p_global);
+#endif
     if (init_stage >= 1) {
         ABTI_mem_finalize(p_global);
     }
@@ -345,6 +376,23 @@ ABTU_ret_err static int finailze_library(void)
     /* Free the ES array */
     ABTI_ASSERT(p_global->p_xstream_head == NULL);
 
+#ifdef ABT_CONFIG_USE_TRACE
+    /* Write and free the event trace */
+    ABTI_trace_finalize(p_global);
+#endif
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+    /* Print and free hardware counters */
+    ABTI_perf_finalize(p_global);
+#endif
+#ifdef ABT_CONFIG_USE_STATS
+    /* Unmap and remove the live statistics page */
+    ABTI_stats_finalize(p_global);
+#endif
+#ifdef ABT_CONFIG_USE_PREEMPTION
+    /* Restore the signal handler */
+    ABTI_preemption_finalize(p_global);
+#endif
+
     /* Finalize the memory pool */
     ABTI_mem_finalize(p_global);
 
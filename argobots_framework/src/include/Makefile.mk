@@ -3,7 +3,7 @@
 # See COPYRIGHT in top-level directory.
 #
 
-include_HEADERS = include/abt.h
+include_HEADERS = include/abt.h include/abt_stats.h
 
 noinst_HEADERS = \
 	include/abt_config.h \
@@ -29,6 +29,7 @@ noinst_HEADERS = \
 	include/abti_mem_pool.h \
 	include/abti_mutex.h \
 	include/abti_mutex_attr.h \
+	include/abti_perf.h \
 	include/abti_rwlock.h \
 	include/abti_pool.h \
 	include/abti_pool_config.h \
@@ -36,10 +37,13 @@ noinst_HEADERS = \
 	include/abti_sched.h \
 	include/abti_sched_config.h \
 	include/abti_self.h \
+	include/abti_stats.h \
 	include/abti_stream.h \
 	include/abti_stream_barrier.h \
 	include/abti_sync_lifo.h \
 	include/abti_timer.h \
+	include/abti_timer_wheel.h \
+	include/abti_trace.h \
 	include/abti_unit.h \
 	include/abti_thread.h \
 	include/abti_thread_attr.h \
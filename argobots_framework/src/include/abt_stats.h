@@ -0,0 +1,83 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef ABT_STATS_H_INCLUDED
+#define ABT_STATS_H_INCLUDED
+
+/* Layout of the live statistics page.
+ *
+ * If Argobots is configured with --enable-stats and ABT_STATS is set, ABT_init
+ * creates a file (ABT_STATS_FILE, default /dev/shm/abt_stats.<pid>) and maps
+ * it.  The file consists of an ABT_stats_header, ABT_stats_header::max_xstreams
+ * ABT_stats_xstream slots at ABT_stats_header::xstream_offset, and
+ * ABT_stats_header::max_pools ABT_stats_pool slots at
+ * ABT_stats_header::pool_offset.  Another process can map the file read-only
+ * and sample the counters at any time without stopping the program.
+ *
+ * Every field is a naturally aligned 64-bit word (or two 32-bit words in the
+ * header) that Argobots updates with relaxed atomic operations, so a reader
+ * sees each counter without tearing but not a consistent snapshot across
+ * counters.  Counters only increase while a slot is in use.  The file is
+ * removed by ABT_finalize. */
+
+#include <stdint.h>
+
+#define ABT_STATS_MAGIC 0x5354415453544241ULL /* "ABTSTATS" */
+#define ABT_STATS_VERSION 1
+
+/* Counters of an execution stream.  Only the owner execution stream updates
+ * them. */
+enum {
+    ABT_STATS_XSTREAM_PUSHES,          /* Units pushed by this ES */
+    ABT_STATS_XSTREAM_POPS,            /* Units popped by this ES */
+    ABT_STATS_XSTREAM_STEALS,          /* Pops from pools of other ESs */
+    ABT_STATS_XSTREAM_EMPTY_POPS,      /* Pops that found no work (idle) */
+    ABT_STATS_XSTREAM_THREAD_CREATED,  /* ULTs and tasklets created */
+    ABT_STATS_XSTREAM_THREAD_FINISHED, /* ULTs and tasklets terminated */
+    ABT_STATS_XSTREAM_SWITCHES,        /* Context switches to a thread */
+    ABT_STATS_XSTREAM_MEM_POOL_HITS,   /* Allocations from the local pool */
+    ABT_STATS_XSTREAM_MEM_POOL_MISSES, /* Local pool refills */
+    ABT_STATS_XSTREAM_NUM_COUNTERS
+};
+
+/* Counters of a pool.  Any execution stream can update them. */
+enum {
+    ABT_STATS_POOL_PUSHES,     /* Units pushed */
+    ABT_STATS_POOL_POPS,       /* Units popped */
+    ABT_STATS_POOL_STEALS,     /* Units popped by a non-owner scheduler */
+    ABT_STATS_POOL_EMPTY_POPS, /* Pops that found no work */
+    ABT_STATS_POOL_NUM_COUNTERS
+};
+
+typedef struct {
+    uint64_t magic;   /* ABT_STATS_MAGIC once the page is initialized */
+    uint32_t version; /* ABT_STATS_VERSION */
+    uint32_t pid;     /* Process ID of the writer */
+    uint32_t max_xstreams;         /* # of ABT_stats_xstream slots */
+    uint32_t max_pools;            /* # of ABT_stats_pool slots */
+    uint32_t num_xstream_counters; /* ABT_STATS_XSTREAM_NUM_COUNTERS */
+    uint32_t num_pool_counters;    /* ABT_STATS_POOL_NUM_COUNTERS */
+    uint64_t xstream_offset;       /* Byte offset of the first ES slot */
+    uint64_t pool_offset;          /* Byte offset of the first pool slot */
+    uint64_t finalized;            /* Nonzero after ABT_finalize starts */
+} ABT_stats_header;
+
+/* Slot i holds the execution stream whose rank is i. */
+typedef struct {
+    uint64_t in_use; /* Nonzero while an ES of this rank exists */
+    uint64_t counters[ABT_STATS_XSTREAM_NUM_COUNTERS];
+    uint64_t padding[6]; /* Keep each slot in its own cache lines */
+} ABT_stats_xstream;
+
+/* Slot 0 accumulates pools that did not get a slot of their own.  A slot is
+ * reset when a new pool takes it, which a reader can detect by id. */
+typedef struct {
+    uint64_t in_use; /* Nonzero while a pool uses this slot */
+    uint64_t id;     /* Pool ID (ABT_pool_get_id) */
+    uint64_t counters[ABT_STATS_POOL_NUM_COUNTERS];
+    uint64_t padding[2];
+} ABT_stats_pool;
+
+#endif /* ABT_STATS_H_INCLUDED */
@@ -32,6 +32,14 @@ void ABTD_futex_timedwait_and_unlock(ABTD_futex_multiple *p_futex,
  * must be called when a lock (p_lock above) is taken. */
 void ABTD_futex_broadcast(ABTD_futex_multiple *p_futex);
 
+/* This routine unlocks p_lock and wakes up at most max_waiters waiters that are
+ * waiting on p_futex.  The other waiters might wake up spuriously.  This
+ * function must be called when p_lock is taken.  If possible, p_lock is
+ * released before the wake-up system call so that the waiters do not contend
+ * for it with this caller. */
+void ABTD_futex_wake_and_unlock(ABTD_futex_multiple *p_futex,
+                                ABTD_spinlock *p_lock, int max_waiters);
+
 /* ABTD_futex_single supports a suspend-resume pattern.  ABTD_futex_single
  * allows only a single waiter. */
 typedef struct ABTD_futex_single ABTD_futex_single;
@@ -12,10 +12,18 @@
 #include <inttypes.h>
 #include <string.h>
 #include <limits.h>
+#include <float.h>
 
 #include "abt_config.h"
 #include "abt.h"
 
+#ifdef ABT_CONFIG_USE_PREEMPTION
+#include <time.h>
+#endif
+#ifdef ABT_CONFIG_USE_STATS
+#include "abt_stats.h"
+#endif
+
 #ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
 #define ABTI_IS_ERROR_CHECK_ENABLED 1
 #else
@@ -51,6 +59,7 @@
 
 #define ABTI_THREAD_INIT_ID 0xFFFFFFFFFFFFFFFF
 #define ABTI_TASK_INIT_ID 0xFFFFFFFFFFFFFFFF
+#define ABTI_THREAD_NO_DEADLINE DBL_MAX
 
 #define ABTI_INDENT 4
 
@@ -119,11 +128,40 @@ enum ABTI_stack_guard {
      ABTI_THREAD_TYPE_MEM_MEMPOOL_DESC_MEMPOOL_LAZY_STACK |                    \
      ABTI_THREAD_TYPE_MEM_MALLOC_DESC_MEMPOOL_LAZY_STACK)
 
+/* A dummy thread embedded in ABTI_timer_entry.  A ULT that waits on a waitlist
+ * with a timeout is linked to the waitlist through it. */
+#define ABTI_THREAD_TYPE_TIMED_WAITER ((ABTI_thread_type)(0x1 << 13))
+/* A ULT that can be preempted by the per-ES timer signal. */
+#define ABTI_THREAD_TYPE_PREEMPTIBLE ((ABTI_thread_type)(0x1 << 14))
+
 /* ABTI_MUTEX_ATTR_NONE must be 0. See ABT_MUTEX_INITIALIZER. */
 #define ABTI_MUTEX_ATTR_NONE 0
 /* ABTI_MUTEX_ATTR_RECURSIVE must be 1. See ABT_RECURSIVE_MUTEX_INITIALIZER. */
 #define ABTI_MUTEX_ATTR_RECURSIVE 1
 
+/* Timer wheel (see timer_wheel.c).  A tick is 2^14 ns (16.4 us); each of the
+ * five levels has 64 slots, so the wheel covers 2^30 ticks (4.9 hours). */
+#define ABTI_TIMER_WHEEL_TICK_SHIFT 14
+#define ABTI_TIMER_WHEEL_SLOT_BITS 6
+#define ABTI_TIMER_WHEEL_NUM_SLOTS (1 << ABTI_TIMER_WHEEL_SLOT_BITS)
+#define ABTI_TIMER_WHEEL_NUM_LEVELS 5
+
+#define ABTI_TIMER_ENTRY_WAITING 0
+#define ABTI_TIMER_ENTRY_SIGNALED 1
+#define ABTI_TIMER_ENTRY_TIMEDOUT 2
+/* A signaled entry that the wheel has dropped on expiry. */
+#define ABTI_TIMER_ENTRY_DROPPED 3
+/* A signaled entry that the waiter has put in the cancel list of the wheel. */
+#define ABTI_TIMER_ENTRY_CANCELLED 4
+
+/* Hardware counters sampled per ULT/tasklet (see perf.c) */
+#define ABTI_PERF_COUNTER_CYCLES 0
+#define ABTI_PERF_COUNTER_INSTRUCTIONS 1
+#define ABTI_PERF_COUNTER_CACHE_MISSES 2
+#define ABTI_PERF_COUNTER_STALLED_BACKEND 3
+#define ABTI_PERF_NUM_COUNTERS 4
+#define ABTI_PERF_TABLE_SIZE 256
+
 /* Macro functions */
 #define ABTI_UNUSED(a) (void)(a)
 
@@ -157,12 +195,26 @@ typedef struct ABTI_waitlist ABTI_waitlist;
 typedef struct ABTI_mutex_attr ABTI_mutex_attr;
 typedef struct ABTI_mutex ABTI_mutex;
 typedef struct ABTI_cond ABTI_cond;
+typedef struct ABTI_rwlock_reader ABTI_rwlock_reader;
 typedef struct ABTI_rwlock ABTI_rwlock;
 typedef struct ABTI_eventual ABTI_eventual;
 typedef struct ABTI_future ABTI_future;
+typedef struct ABTI_barrier_node ABTI_barrier_node;
+typedef struct ABTI_barrier_engine ABTI_barrier_engine;
 typedef struct ABTI_barrier ABTI_barrier;
 typedef struct ABTI_xstream_barrier ABTI_xstream_barrier;
 typedef struct ABTI_timer ABTI_timer;
+typedef struct ABTI_timer_entry ABTI_timer_entry;
+typedef struct ABTI_timer_wheel ABTI_timer_wheel;
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+typedef struct ABTI_perf_entry ABTI_perf_entry;
+typedef struct ABTI_perf_xstream ABTI_perf_xstream;
+#endif
+#ifdef ABT_CONFIG_USE_TRACE
+typedef enum ABTI_trace_event ABTI_trace_event;
+typedef struct ABTI_trace_record ABTI_trace_record;
+typedef struct ABTI_trace_buffer ABTI_trace_buffer;
+#endif
 #ifndef ABT_CONFIG_DISABLE_TOOL_INTERFACE
 typedef struct ABTI_tool_context ABTI_tool_context;
 #endif
@@ -265,8 +317,42 @@ struct ABTI_global {
 #endif
     ABTI_stack_guard stack_guard_kind; /* Stack guard type. */
 
+    uint32_t barrier_spin_count;  /* # of busy-wait iterations in a barrier */
+    uint32_t barrier_yield_count; /* # of yields in a barrier before blocking */
+
     ABT_bool print_config; /* Whether to print config on ABT_init */
 
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+    ABT_bool perf_enabled;          /* Whether hardware counters are on */
+    ABTD_spinlock perf_lock;        /* Protects p_perf_head */
+    ABTI_perf_xstream *p_perf_head; /* Counter tables of all ESs */
+#endif
+
+#ifdef ABT_CONFIG_USE_TRACE
+    ABT_bool trace_enabled;          /* Whether event tracing is on */
+    uint32_t trace_buffer_size;      /* # of records per ES (power of 2) */
+    char *trace_file;                /* Output file (NULL: default name) */
+    ABTD_spinlock trace_lock;        /* Protects p_trace_head */
+    ABTI_trace_buffer *p_trace_head; /* Trace buffers of all ESs */
+    uint64_t trace_base_timestamp;   /* Trace timestamp at ABT_init */
+    double trace_base_wtime;         /* ABTI_get_wtime() at ABT_init */
+#endif
+
+#ifdef ABT_CONFIG_USE_STATS
+    ABT_bool stats_enabled;       /* Whether the statistics page is on */
+    uint32_t stats_max_xstreams;  /* # of ES slots in the page */
+    uint32_t stats_max_pools;     /* # of pool slots in the page */
+    char *stats_file;             /* Page file (removed at ABT_finalize) */
+    ABTD_spinlock stats_lock;     /* Protects in_use of pool slots */
+    ABT_stats_header *p_stats;    /* Mapped page (NULL if disabled) */
+    size_t stats_size;            /* Size of the mapped page */
+#endif
+
+#ifdef ABT_CONFIG_USE_PREEMPTION
+    uint64_t preemption_interval_usec; /* Quantum (0: preemption is off) */
+    ABT_bool preemption_enabled;       /* Whether the handler is installed */
+#endif
+
 #ifndef ABT_CONFIG_DISABLE_TOOL_INTERFACE
     ABTD_spinlock tool_writer_lock;
 
@@ -309,6 +395,26 @@ struct ABTI_xstream {
 
     ABTU_align_member_var(ABT_CONFIG_STATIC_CACHELINE_SIZE)
         ABTI_thread *p_thread; /* Current running ULT/tasklet */
+#ifdef ABT_CONFIG_USE_TRACE
+    ABTI_trace_buffer *p_trace; /* Event trace buffer (NULL if disabled) */
+#endif
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+    ABTI_perf_xstream *p_perf; /* Hardware counters (NULL if disabled) */
+#endif
+#ifdef ABT_CONFIG_USE_STATS
+    ABT_stats_xstream *p_stats; /* Live counters (NULL if disabled) */
+#endif
+    /* Sleeping and timed-waiting ULTs.  Only this ES accesses it.  NULL until
+     * the first ULT sleeps on this ES. */
+    ABTI_timer_wheel *p_timer_wheel;
+#ifdef ABT_CONFIG_USE_PREEMPTION
+    ABT_bool has_preemption_timer; /* Whether preemption_timer is created */
+    timer_t preemption_timer;      /* Sends the preemption signal to this ES */
+    /* Thread seen by the last timer signal.  Only the signal handler on this
+     * ES accesses it. */
+    ABTI_thread *p_preemption_last;
+    uint64_t num_preemptions; /* # of ULTs preempted on this ES */
+#endif
 
 #ifdef ABT_CONFIG_USE_MEM_POOL
     ABTI_mem_pool_local_pool mem_pool_stack;
@@ -395,6 +501,12 @@ struct ABTI_pool {
     ABTD_atomic_int32 num_blocked; /* Number of blocked ULTs */
     void *data;                    /* Specific data */
     uint64_t id;                   /* ID */
+#ifdef ABT_CONFIG_USE_PREEMPTION
+    ABT_bool is_preemptible; /* Whether ULTs created in it are preemptible */
+#endif
+#ifdef ABT_CONFIG_USE_STATS
+    ABT_stats_pool *p_stats; /* Live counters (NULL if disabled) */
+#endif
 
     ABTI_pool_required_def required_def;
     ABTI_pool_optional_def optional_def;
@@ -434,16 +546,24 @@ struct ABTI_thread {
     ABTI_pool *p_pool;            /* Associated pool */
     ABTD_atomic_ptr p_keytable;   /* Thread-specific data (ABTI_ktable *) */
     ABT_unit_id id;               /* ID */
+    double deadline;              /* Absolute deadline for ABT_POOL_EDF */
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+    uint64_t perf_counts[ABTI_PERF_NUM_COUNTERS]; /* Counts while running */
+#endif
 };
 
 struct ABTI_thread_attr {
     void *p_stack;    /* Stack address */
     size_t stacksize; /* Stack size (in bytes) */
+    double deadline;  /* Absolute deadline (ABTI_THREAD_NO_DEADLINE if none) */
 #ifndef ABT_CONFIG_DISABLE_MIGRATION
     ABT_bool migratable;              /* Migratability */
     void (*f_cb)(ABT_thread, void *); /* Callback function */
     void *p_cb_arg;                   /* Callback function argument */
 #endif
+#ifdef ABT_CONFIG_USE_PREEMPTION
+    ABT_bool preemptible; /* Preemptibility */
+#endif
 };
 
 struct ABTI_thread_mig_data {
@@ -486,11 +606,22 @@ struct ABTI_cond {
     ABTI_waitlist waitlist;
 };
 
+/* Reader indicator of a reader-writer lock.  ESs increment the indicator of
+ * their rank, so readers on different ESs do not share a cache line. */
+struct ABTI_rwlock_reader {
+    ABTD_atomic_int count; /* # of readers that entered through it */
+} ABTU_align_member_var(ABT_CONFIG_STATIC_CACHELINE_SIZE);
+
+/* Reader-biased reader-writer lock.  Readers only touch their indicator while
+ * the lock is read-biased; a writer revokes the bias and waits until the sum
+ * of the indicators drops to zero. */
 struct ABTI_rwlock {
-    ABTI_mutex mutex;
-    ABTI_cond cond;
-    size_t reader_count;
-    int write_flag;
+    ABTD_atomic_int state;          /* ABTI_RWLOCK_STATE_XXX */
+    int num_readers;                /* # of reader indicators */
+    ABTI_rwlock_reader *p_readers;  /* Reader indicators */
+    ABTD_spinlock lock;             /* Protects the waitlists */
+    ABTI_waitlist waitlist;         /* Waiters for the end of a write */
+    ABTI_waitlist drain_waitlist;   /* Writer waiting for readers to leave */
 };
 
 struct ABTI_eventual {
@@ -502,30 +633,116 @@ struct ABTI_eventual {
 };
 
 struct ABTI_future {
-    ABTD_spinlock lock;
-    ABTD_atomic_size counter;
+    ABTD_spinlock lock;       /* Protects waitlist */
+    ABTD_atomic_size counter; /* num_compartments when ready, 0 otherwise */
+    ABTD_atomic_size claimed; /* # of compartments claimed by setters */
+    ABTD_atomic_size num_set; /* # of compartments written */
     size_t num_compartments;
     void **array;
     void (*p_callback)(void **arg);
     ABTI_waitlist waitlist;
 };
 
+/* A node of a combining tree.  Each node sits on its own cache line so that
+ * arrivals on different subtrees do not contend with each other. */
+struct ABTI_barrier_node {
+    ABTD_atomic_uint32 count; /* # of arrivals in the current episode */
+    uint32_t num_arrivals;    /* # of arrivals that complete this node */
+    ABTI_barrier_node *p_parent; /* Parent node (NULL if root) */
+} ABTU_align_member_var(ABT_CONFIG_STATIC_CACHELINE_SIZE);
+
+/* Sense-reversing combining-tree barrier shared by ABT_barrier and
+ * ABT_xstream_barrier. */
+struct ABTI_barrier_engine {
+    uint32_t num_waiters;
+    uint32_t num_leaves;        /* Leaves are nodes[0, num_leaves) */
+    uint32_t num_nodes;         /* Root is nodes[num_nodes - 1] */
+    ABTI_barrier_node *p_nodes; /* Array of tree nodes */
+    void (*f_cb)(void *);       /* Run by the last arriver before release */
+    void *p_cb_arg;
+    ABTU_align_member_var(ABT_CONFIG_STATIC_CACHELINE_SIZE)
+        ABTD_atomic_uint64 tag; /* Episode number (sense) */
+    ABTU_align_member_var(ABT_CONFIG_STATIC_CACHELINE_SIZE)
+        ABTD_spinlock lock;     /* Protects the following */
+    ABTI_waitlist waitlist;     /* Blocked ULTs and external threads */
+#ifndef ABT_CONFIG_ACTIVE_WAIT_POLICY
+    ABTD_futex_multiple futex;     /* Blocked ESs (ABT_xstream_barrier) */
+    uint32_t num_blocked_xstreams; /* # of ESs blocked on futex */
+#endif
+};
+
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+struct ABTI_perf_entry {
+    ABT_bool is_used;         /* Whether this entry is used */
+    void (*f_thread)(void *); /* Thread function (key) */
+    uint32_t thread_type;     /* ABTI_thread_type of the first thread */
+    uint64_t num_runs;        /* # of times threads were scheduled */
+    uint64_t counts[ABTI_PERF_NUM_COUNTERS];
+};
+
+/* Per-ES counter state.  Counters are opened lazily by the owner ES because
+ * perf_event_open() measures the calling OS thread. */
+struct ABTI_perf_xstream {
+    ABTI_perf_xstream *p_next; /* Next table (protected by perf_lock) */
+    int rank;                  /* Rank of the ES that created it */
+    ABT_bool in_use;           /* Whether an ES is attached */
+    ABT_bool is_opened;        /* Whether the owner tried to open counters */
+    int group_fd;              /* Group leader (-1 if unavailable) */
+    int num_fds;               /* # of opened counters */
+    ABTI_thread *p_target;     /* Thread charged with the next delta */
+    /* fds[i] counts kinds[i] (ABTI_PERF_COUNTER_XXX). */
+    int fds[ABTI_PERF_NUM_COUNTERS];
+    int kinds[ABTI_PERF_NUM_COUNTERS];
+    /* Counter values at the last sample, indexed by ABTI_PERF_COUNTER_XXX. */
+    uint64_t last[ABTI_PERF_NUM_COUNTERS];
+    /* Open-addressing table keyed by f_thread.  others is used when it is
+     * full. */
+    ABTI_perf_entry entries[ABTI_PERF_TABLE_SIZE];
+    ABTI_perf_entry others;
+};
+#endif
+
+#ifdef ABT_CONFIG_USE_TRACE
+enum ABTI_trace_event {
+    ABTI_TRACE_EVENT_CREATE,
+    ABTI_TRACE_EVENT_RUN,
+    ABTI_TRACE_EVENT_FINISH,
+    ABTI_TRACE_EVENT_CANCEL,
+    ABTI_TRACE_EVENT_YIELD,
+    ABTI_TRACE_EVENT_SUSPEND,
+    ABTI_TRACE_EVENT_RESUME,
+    ABTI_TRACE_EVENT_POOL_PUSH,
+    ABTI_TRACE_EVENT_POOL_POP,
+};
+
+struct ABTI_trace_record {
+    uint64_t timestamp;   /* See ABTI_trace_get_timestamp() */
+    uint64_t thread_id;   /* ID of the ULT/tasklet */
+    uint64_t pool_id;     /* Pool ID (pool events only) */
+    uint32_t event;       /* ABTI_trace_event */
+    uint32_t thread_type; /* ABTI_thread_type of the ULT/tasklet */
+};
+
+/* Single-writer ring buffer.  Only the owner ES writes records, so recording
+ * needs no atomic read-modify-write; readers use head to detect records that
+ * were overwritten while being copied. */
+struct ABTI_trace_buffer {
+    ABTI_trace_buffer *p_next;    /* Next buffer (protected by trace_lock) */
+    int rank;                     /* Rank of the ES that created it */
+    ABT_bool in_use;              /* Whether an ES is attached */
+    uint64_t mask;                /* # of records - 1 */
+    ABTI_trace_record *p_records; /* Ring of (mask + 1) records */
+    ABTU_align_member_var(ABT_CONFIG_STATIC_CACHELINE_SIZE)
+        ABTD_atomic_uint64 head; /* # of records written so far */
+};
+#endif
+
 struct ABTI_barrier {
-    size_t num_waiters;
-    volatile size_t counter;
-    ABTD_spinlock lock;
-    ABTI_waitlist waitlist;
+    ABTI_barrier_engine engine;
 };
 
 struct ABTI_xstream_barrier {
-    uint32_t num_waiters;
-#ifdef HAVE_PTHREAD_BARRIER_INIT
-    ABTD_xstream_barrier bar;
-#else
-    ABTD_spinlock lock;
-    uint32_t counter;
-    ABTD_atomic_uint64 tag;
-#endif
+    ABTI_barrier_engine engine;
 };
 
 struct ABTI_timer {
@@ -533,6 +750,39 @@ struct ABTI_timer {
     ABTD_time end;
 };
 
+/* A ULT that sleeps or waits with a timeout.  An entry of ABTI_self_sleep() is
+ * on the sleeping ULT's stack.  An entry of a timed wait is allocated and
+ * referenced by both the wheel and the waiting ULT, since a signal may resume
+ * the ULT on another ES before the wheel drops the entry. */
+struct ABTI_timer_entry {
+    ABTI_thread thread; /* Dummy thread linked to p_waitlist */
+    ABTI_timer_entry *p_wheel_prev;
+    ABTI_timer_entry *p_wheel_next;
+    ABTI_timer_entry *p_cancel_next; /* In the cancel list of the wheel */
+    uint64_t expire_tick;       /* Tick at which the entry fires */
+    ABTI_ythread *p_ythread;    /* Sleeping or waiting ULT */
+    ABTI_xstream *p_xstream;    /* ES whose wheel has this entry */
+    ABTI_waitlist *p_waitlist;  /* NULL if sleeping */
+    int level;                  /* Level in the wheel (-1 if not in it) */
+    int slot;                   /* Slot in the level */
+    ABT_bool is_in_waitlist;    /* Protected by the lock of p_waitlist */
+    ABTD_atomic_int state;      /* ABTI_TIMER_ENTRY_XXX */
+    ABTD_atomic_int ref_count;  /* The wheel and the waiting ULT */
+};
+
+struct ABTI_timer_wheel {
+    uint64_t cur_tick;   /* Next tick to process */
+    size_t num_entries;  /* # of entries in slots */
+    /* Entries cancelled by other ESs, linked through p_cancel_next. */
+    ABTD_atomic_ptr p_cancel_list;
+    /* # of cancelled entries that expired before they were in the list */
+    size_t num_cancelled;
+    /* Bit i of bitmaps[l] is set if slots[l][i] is not empty. */
+    uint64_t bitmaps[ABTI_TIMER_WHEEL_NUM_LEVELS];
+    ABTI_timer_entry *slots[ABTI_TIMER_WHEEL_NUM_LEVELS]
+                           [ABTI_TIMER_WHEEL_NUM_SLOTS];
+};
+
 #ifndef ABT_CONFIG_DISABLE_TOOL_INTERFACE
 struct ABTI_tool_context {
     ABTI_thread *p_caller;
@@ -568,11 +818,21 @@ void ABTI_xstream_check_events(ABTI_xstream *p_xstream, ABTI_sched *p_sched);
 void ABTI_xstream_print(ABTI_xstream *p_xstream, FILE *p_os, int indent,
                         ABT_bool print_sub);
 
+/* Barrier */
+ABTU_ret_err int ABTI_barrier_engine_init(ABTI_barrier_engine *p_engine,
+                                          uint32_t num_waiters);
+void ABTI_barrier_engine_destroy(ABTI_barrier_engine *p_engine);
+ABT_bool ABTI_barrier_engine_is_idle(ABTI_barrier_engine *p_engine);
+void ABTI_barrier_engine_wait(ABTI_local **pp_local,
+                              ABTI_barrier_engine *p_engine,
+                              ABT_bool block_xstream, void *p_sync);
+
 /* Scheduler */
 ABT_sched_def *ABTI_sched_get_basic_def(void);
 ABT_sched_def *ABTI_sched_get_basic_wait_def(void);
 ABT_sched_def *ABTI_sched_get_prio_def(void);
 ABT_sched_def *ABTI_sched_get_randws_def(void);
+ABT_sched_def *ABTI_sched_get_edf_def(void);
 void ABTI_sched_finish(ABTI_sched *p_sched);
 void ABTI_sched_exit(ABTI_sched *p_sched);
 ABTU_ret_err int ABTI_sched_create_basic(ABT_sched_predef predef, int num_pools,
@@ -614,6 +874,13 @@ ABTI_pool_get_randws_def(ABT_pool_access access,
                          ABTI_pool_required_def *p_required_def,
                          ABTI_pool_optional_def *p_optional_def,
                          ABTI_pool_deprecated_def *p_deprecated_def);
+ABTU_ret_err int
+ABTI_pool_get_edf_def(ABT_pool_access access,
+                      ABTI_pool_required_def *p_required_def,
+                      ABTI_pool_optional_def *p_optional_def,
+                      ABTI_pool_deprecated_def *p_deprecated_def);
+ABT_bool ABTI_pool_is_edf(ABTI_pool *p_pool);
+double ABTI_pool_edf_get_min_deadline(ABTI_pool *p_pool);
 void ABTI_pool_print(ABTI_pool *p_pool, FILE *p_os, int indent);
 void ABTI_pool_reset_id(void);
 
@@ -692,11 +959,71 @@ void ABTI_ktable_free(ABTI_global *p_global, ABTI_local *p_local,
 void ABTI_info_print_config(ABTI_global *p_global, FILE *fp);
 void ABTI_info_check_print_all_thread_stacks(void);
 
+/* Timer wheel */
+ABTU_ret_err int ABTI_timer_wheel_sleep(ABTI_xstream **pp_local_xstream,
+                                        ABTI_ythread *p_self,
+                                        double target_time);
+ABTU_ret_err int ABTI_timer_wheel_wait_and_unlock(
+    ABTI_xstream **pp_local_xstream, ABTI_ythread *p_self,
+    ABTI_waitlist *p_waitlist, ABTD_spinlock *p_lock, double target_time,
+    ABT_sync_event_type sync_event_type, void *p_sync, ABT_bool *p_is_timedout);
+void ABTI_timer_wheel_process(ABTI_xstream *p_xstream);
+double ABTI_timer_wheel_get_next_time(ABTI_xstream *p_xstream);
+void ABTI_timer_wheel_free(ABTI_local *p_local, ABTI_xstream *p_xstream);
+
+/* Preemption */
+#ifdef ABT_CONFIG_USE_PREEMPTION
+void ABTI_preemption_init(ABTI_global *p_global);
+void ABTI_preemption_finalize(ABTI_global *p_global);
+void ABTI_preemption_start_xstream(ABTI_global *p_global,
+                                   ABTI_xstream *p_xstream);
+void ABTI_preemption_stop_xstream(ABTI_xstream *p_xstream);
+#endif
+
+/* Hardware counters */
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+void ABTI_perf_init(ABTI_global *p_global);
+void ABTI_perf_finalize(ABTI_global *p_global);
+ABTU_ret_err int ABTI_perf_attach_xstream(ABTI_global *p_global,
+                                          ABTI_xstream *p_xstream);
+void ABTI_perf_detach_xstream(ABTI_global *p_global, ABTI_xstream *p_xstream);
+void ABTI_perf_sample(ABTI_perf_xstream *p_perf, ABTI_thread *p_next,
+                      ABT_bool is_run);
+void ABTI_perf_print_report(ABTI_global *p_global, FILE *p_os);
+#endif
+
+/* Event trace */
+#ifdef ABT_CONFIG_USE_TRACE
+void ABTI_trace_init(ABTI_global *p_global);
+void ABTI_trace_finalize(ABTI_global *p_global);
+ABTU_ret_err int ABTI_trace_attach_xstream(ABTI_global *p_global,
+                                           ABTI_xstream *p_xstream);
+void ABTI_trace_detach_xstream(ABTI_global *p_global, ABTI_xstream *p_xstream);
+ABTU_ret_err int ABTI_trace_dump(ABTI_global *p_global, const char *filename);
+void ABTI_trace_pool_push(ABTI_trace_buffer *p_trace, ABTI_pool *p_pool,
+                          ABT_unit unit);
+void ABTI_trace_pool_pop(ABTI_trace_buffer *p_trace, ABTI_pool *p_pool,
+                         ABT_thread thread);
+#endif
+
+/* Live statistics */
+#ifdef ABT_CONFIG_USE_STATS
+void ABTI_stats_init(ABTI_global *p_global);
+void ABTI_stats_finalize(ABTI_global *p_global);
+void ABTI_stats_attach_xstream(ABTI_global *p_global, ABTI_xstream *p_xstream);
+void ABTI_stats_detach_xstream(ABTI_global *p_global, ABTI_xstream *p_xstream);
+void ABTI_stats_attach_pool(ABTI_global *p_global, ABTI_pool *p_pool);
+void ABTI_stats_detach_pool(ABTI_global *p_global, ABTI_pool *p_pool);
+#endif
+
 #include "abti_timer.h"
 #include "abti_log.h"
 #include "abti_local.h"
 #include "abti_global.h"
 #include "abti_self.h"
+#include "abti_trace.h"
+#include "abti_stats.h"
+#include "abti_perf.h"
 #include "abti_pool.h"
 #include "abti_pool_config.h"
 #include "abti_pool_user_def.h"
@@ -709,6 +1036,7 @@ void ABTI_info_check_print_all_thread_stacks(void);
 #include "abti_event.h"
 #include "abti_ythread.h"
 #include "abti_thread_attr.h"
+#include "abti_timer_wheel.h"
 #include "abti_waitlist.h"
 #include "abti_mutex.h"
 #include "abti_mutex_attr.h"
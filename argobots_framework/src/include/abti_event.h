@@ -7,7 +7,8 @@
 #define ABTI_EVENT_H_INCLUDED
 
 #if !defined(ABT_CONFIG_DISABLE_TOOL_INTERFACE) ||                             \
-    defined(ABT_CONFIG_USE_DEBUG_LOG)
+    defined(ABT_CONFIG_USE_DEBUG_LOG) || defined(ABT_CONFIG_USE_TRACE) ||      \
+    defined(ABT_CONFIG_USE_PERF_COUNTERS) || defined(ABT_CONFIG_USE_STATS)
 #define ABTI_ENABLE_EVENT_INTERFACE 1
 #else
 #define ABTI_ENABLE_EVENT_INTERFACE 0
@@ -21,6 +22,14 @@ static inline void ABTI_event_thread_create_impl(ABTI_local *p_local,
 #ifdef ABT_CONFIG_USE_DEBUG_LOG
     ABTI_log_debug_thread("create", p_thread);
 #endif
+#ifdef ABT_CONFIG_USE_TRACE
+    ABTI_trace_thread(ABTI_local_get_xstream_or_null(p_local),
+                      ABTI_TRACE_EVENT_CREATE, p_thread);
+#endif
+#ifdef ABT_CONFIG_USE_STATS
+    ABTI_stats_xstream_add(ABTI_local_get_xstream_or_null(p_local),
+                           ABT_STATS_XSTREAM_THREAD_CREATED, 1);
+#endif
 #ifndef ABT_CONFIG_DISABLE_TOOL_INTERFACE
     ABTI_tool_event_thread(p_local, ABT_TOOL_EVENT_THREAD_CREATE, p_thread,
                            p_caller, p_pool, NULL, ABT_SYNC_EVENT_TYPE_UNKNOWN,
@@ -79,6 +88,15 @@ static inline void ABTI_event_thread_run_impl(ABTI_xstream *p_local_xstream,
 #ifdef ABT_CONFIG_USE_DEBUG_LOG
     ABTI_log_debug_thread("run", p_thread);
 #endif
+#ifdef ABT_CONFIG_USE_TRACE
+    ABTI_trace_thread(p_local_xstream, ABTI_TRACE_EVENT_RUN, p_thread);
+#endif
+#ifdef ABT_CONFIG_USE_STATS
+    ABTI_stats_xstream_add(p_local_xstream, ABT_STATS_XSTREAM_SWITCHES, 1);
+#endif
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+    ABTI_perf_switch(p_local_xstream, p_thread, ABT_TRUE);
+#endif
 #ifndef ABT_CONFIG_DISABLE_TOOL_INTERFACE
     ABTI_tool_event_thread(ABTI_xstream_get_local(p_local_xstream),
                            ABT_TOOL_EVENT_THREAD_RUN, p_thread, p_prev, NULL,
@@ -93,6 +111,16 @@ static inline void ABTI_event_thread_finish_impl(ABTI_xstream *p_local_xstream,
 #ifdef ABT_CONFIG_USE_DEBUG_LOG
     ABTI_log_debug_thread("finish", p_thread);
 #endif
+#ifdef ABT_CONFIG_USE_TRACE
+    ABTI_trace_thread(p_local_xstream, ABTI_TRACE_EVENT_FINISH, p_thread);
+#endif
+#ifdef ABT_CONFIG_USE_STATS
+    ABTI_stats_xstream_add(p_local_xstream, ABT_STATS_XSTREAM_THREAD_FINISHED,
+                           1);
+#endif
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+    ABTI_perf_switch(p_local_xstream, p_parent, ABT_FALSE);
+#endif
 #ifndef ABT_CONFIG_DISABLE_TOOL_INTERFACE
     ABTI_tool_event_thread(ABTI_xstream_get_local(p_local_xstream),
                            ABT_TOOL_EVENT_THREAD_FINISH, p_thread, NULL, NULL,
@@ -106,6 +134,16 @@ static inline void ABTI_event_thread_cancel_impl(ABTI_xstream *p_local_xstream,
 #ifdef ABT_CONFIG_USE_DEBUG_LOG
     ABTI_log_debug_thread("cancel", p_thread);
 #endif
+#ifdef ABT_CONFIG_USE_TRACE
+    ABTI_trace_thread(p_local_xstream, ABTI_TRACE_EVENT_CANCEL, p_thread);
+#endif
+#ifdef ABT_CONFIG_USE_STATS
+    ABTI_stats_xstream_add(p_local_xstream, ABT_STATS_XSTREAM_THREAD_FINISHED,
+                           1);
+#endif
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+    ABTI_perf_switch(p_local_xstream, p_thread->p_parent, ABT_FALSE);
+#endif
 #ifndef ABT_CONFIG_DISABLE_TOOL_INTERFACE
     ABTI_tool_event_thread(ABTI_xstream_get_local(p_local_xstream),
                            ABT_TOOL_EVENT_THREAD_CANCEL, p_thread, NULL, NULL,
@@ -121,6 +159,13 @@ ABTI_event_ythread_yield_impl(ABTI_xstream *p_local_xstream,
 #ifdef ABT_CONFIG_USE_DEBUG_LOG
     ABTI_log_debug_thread("yield", &p_ythread->thread);
 #endif
+#ifdef ABT_CONFIG_USE_TRACE
+    ABTI_trace_thread(p_local_xstream, ABTI_TRACE_EVENT_YIELD,
+                      &p_ythread->thread);
+#endif
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+    ABTI_perf_switch(p_local_xstream, p_parent, ABT_FALSE);
+#endif
 #ifndef ABT_CONFIG_DISABLE_TOOL_INTERFACE
     ABTI_tool_event_thread(ABTI_xstream_get_local(p_local_xstream),
                            ABT_TOOL_EVENT_THREAD_YIELD, &p_ythread->thread,
@@ -136,6 +181,13 @@ static inline void ABTI_event_ythread_suspend_impl(
 #ifdef ABT_CONFIG_USE_DEBUG_LOG
     ABTI_log_debug_thread("suspend", &p_ythread->thread);
 #endif
+#ifdef ABT_CONFIG_USE_TRACE
+    ABTI_trace_thread(p_local_xstream, ABTI_TRACE_EVENT_SUSPEND,
+                      &p_ythread->thread);
+#endif
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+    ABTI_perf_switch(p_local_xstream, p_parent, ABT_FALSE);
+#endif
 #ifndef ABT_CONFIG_DISABLE_TOOL_INTERFACE
     ABTI_tool_event_thread(ABTI_xstream_get_local(p_local_xstream),
                            ABT_TOOL_EVENT_THREAD_SUSPEND, &p_ythread->thread,
@@ -151,6 +203,10 @@ static inline void ABTI_event_ythread_resume_impl(ABTI_local *p_local,
 #ifdef ABT_CONFIG_USE_DEBUG_LOG
     ABTI_log_debug_thread("resume", &p_ythread->thread);
 #endif
+#ifdef ABT_CONFIG_USE_TRACE
+    ABTI_trace_thread(ABTI_local_get_xstream_or_null(p_local),
+                      ABTI_TRACE_EVENT_RESUME, &p_ythread->thread);
+#endif
 #ifndef ABT_CONFIG_DISABLE_TOOL_INTERFACE
     ABTI_tool_event_thread(p_local, ABT_TOOL_EVENT_THREAD_RESUME,
                            &p_ythread->thread, p_caller,
@@ -136,6 +136,7 @@ ABTU_ret_err static inline int ABTI_mem_alloc_nythread(ABTI_local *p_local,
     ABTI_xstream *p_local_xstream = ABTI_local_get_xstream_or_null(p_local);
     if (!ABTI_IS_EXT_THREAD_ENABLED || p_local_xstream) {
         /* It's not called on an external thread.  Use a memory pool. */
+        STATS_MEM_POOL_ALLOC(p_local_xstream, &p_local_xstream->mem_pool_desc);
         int abt_errno = ABTI_mem_pool_alloc(&p_local_xstream->mem_pool_desc,
                                             (void **)&p_thread);
         ABTI_CHECK_ERROR(abt_errno);
@@ -189,6 +190,7 @@ ABTI_mem_alloc_ythread_desc_impl(ABTI_local *p_local, ABT_bool use_lazy_stack,
     ABTI_xstream *p_local_xstream = ABTI_local_get_xstream_or_null(p_local);
     if (!ABTI_IS_EXT_THREAD_ENABLED || p_local_xstream) {
         /* It's not called on an external thread.  Use a memory pool. */
+        STATS_MEM_POOL_ALLOC(p_local_xstream, &p_local_xstream->mem_pool_desc);
         int abt_errno = ABTI_mem_pool_alloc(&p_local_xstream->mem_pool_desc,
                                             (void **)&p_ythread);
         ABTI_CHECK_ERROR(abt_errno);
@@ -296,6 +298,8 @@ ABTI_mem_alloc_ythread_mempool_desc_stack(ABTI_global *p_global,
         /* Allocate a ULT stack and a descriptor together. */
         ABTI_xstream *p_local_xstream = ABTI_local_get_xstream_or_null(p_local);
         if (!ABTI_IS_EXT_THREAD_ENABLED || p_local_xstream) {
+            STATS_MEM_POOL_ALLOC(p_local_xstream,
+                                 &p_local_xstream->mem_pool_stack);
             int abt_errno = ABTI_mem_alloc_ythread_mempool_desc_stack_impl(
                 &p_local_xstream->mem_pool_stack, stacksize, &p_ythread,
                 &p_stacktop);
@@ -466,6 +470,7 @@ ABTI_mem_alloc_ythread_mempool_stack(ABTI_xstream *p_local_xstream,
                    (ABTI_THREAD_TYPE_MEM_MEMPOOL_DESC_MEMPOOL_LAZY_STACK |
                     ABTI_THREAD_TYPE_MEM_MALLOC_DESC_MEMPOOL_LAZY_STACK));
     void *p_stacktop;
+    STATS_MEM_POOL_ALLOC(p_local_xstream, &p_local_xstream->mem_pool_stack);
     int abt_errno =
         ABTI_mem_pool_alloc(&p_local_xstream->mem_pool_stack, &p_stacktop);
     ABTI_CHECK_ERROR(abt_errno);
@@ -517,6 +522,7 @@ ABTU_ret_err static inline int ABTI_mem_alloc_desc(ABTI_local *p_local,
         return ABT_SUCCESS;
     } else {
         /* Find the page that has an empty block */
+        STATS_MEM_POOL_ALLOC(p_local_xstream, &p_local_xstream->mem_pool_desc);
         int abt_errno =
             ABTI_mem_pool_alloc(&p_local_xstream->mem_pool_desc, &p_desc);
         ABTI_CHECK_ERROR(abt_errno);
@@ -114,6 +114,76 @@ static inline void ABTI_mutex_lock(ABTI_local **pp_local, ABTI_mutex *p_mutex)
     }
 }
 
+/* Returns ABT_ERR_TIMEDOUT if the mutex is not taken by target_time. */
+static inline int ABTI_mutex_timedlock_no_recursion(ABTI_local **pp_local,
+                                                    ABTI_mutex *p_mutex,
+                                                    double target_time)
+{
+#ifndef ABT_CONFIG_USE_SIMPLE_MUTEX
+    while (ABTD_spinlock_try_acquire(&p_mutex->lock)) {
+        ABTD_spinlock_acquire(&p_mutex->waiter_lock);
+        /* Maybe the mutex lock has been already released.  Check it. */
+        if (!ABTD_spinlock_try_acquire(&p_mutex->lock)) {
+            ABTD_spinlock_release(&p_mutex->waiter_lock);
+            break;
+        }
+        if (ABTI_waitlist_wait_timedout_and_unlock(pp_local, &p_mutex->waitlist,
+                                                   &p_mutex->waiter_lock,
+                                                   target_time,
+                                                   ABT_SYNC_EVENT_TYPE_MUTEX,
+                                                   (void *)p_mutex)) {
+            /* The last chance. */
+            if (!ABTD_spinlock_try_acquire(&p_mutex->lock))
+                break;
+            return ABT_ERR_TIMEDOUT;
+        }
+    }
+#else
+    ABTI_ythread *p_ythread = NULL;
+    ABTI_xstream *p_local_xstream = ABTI_local_get_xstream_or_null(*pp_local);
+    if (!ABTI_IS_EXT_THREAD_ENABLED || p_local_xstream)
+        p_ythread = ABTI_thread_get_ythread_or_null(p_local_xstream->p_thread);
+
+    while (ABTD_spinlock_try_acquire(&p_mutex->lock)) {
+        if (ABTI_get_wtime() >= target_time)
+            return ABT_ERR_TIMEDOUT;
+        if (p_ythread) {
+            ABTI_ythread_yield(&p_local_xstream, p_ythread,
+                               ABTI_YTHREAD_YIELD_KIND_YIELD_LOOP,
+                               ABT_SYNC_EVENT_TYPE_MUTEX, (void *)p_mutex);
+            *pp_local = ABTI_xstream_get_local(p_local_xstream);
+        }
+    }
+#endif
+    return ABT_SUCCESS;
+}
+
+static inline int ABTI_mutex_timedlock(ABTI_local **pp_local,
+                                       ABTI_mutex *p_mutex, double target_time)
+{
+    if (p_mutex->attrs & ABTI_MUTEX_ATTR_RECURSIVE) {
+        /* Recursive mutex */
+        ABTI_thread_id self_id = ABTI_self_get_thread_id(*pp_local);
+        if (self_id != p_mutex->owner_id) {
+            int abt_errno =
+                ABTI_mutex_timedlock_no_recursion(pp_local, p_mutex,
+                                                  target_time);
+            if (abt_errno == ABT_SUCCESS) {
+                ABTI_ASSERT(p_mutex->nesting_cnt == 0);
+                p_mutex->owner_id = self_id;
+            }
+            return abt_errno;
+        } else {
+            /* Increment a nesting count. */
+            p_mutex->nesting_cnt++;
+            return ABT_SUCCESS;
+        }
+    } else {
+        return ABTI_mutex_timedlock_no_recursion(pp_local, p_mutex,
+                                                 target_time);
+    }
+}
+
 static inline ABT_bool ABTI_mutex_is_locked(ABTI_mutex *p_mutex)
 {
     return ABTD_spinlock_is_locked(&p_mutex->lock);
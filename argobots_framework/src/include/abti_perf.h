@@ -0,0 +1,30 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef ABTI_PERF_H_INCLUDED
+#define ABTI_PERF_H_INCLUDED
+
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+
+static inline void ABTI_perf_reset_thread(ABTI_thread *p_thread)
+{
+    int i;
+    for (i = 0; i < ABTI_PERF_NUM_COUNTERS; i++)
+        p_thread->perf_counts[i] = 0;
+}
+
+/* Charge the counts since the last switch to the currently running thread and
+ * start charging p_next.  This function must be called by p_local_xstream. */
+static inline void ABTI_perf_switch(ABTI_xstream *p_local_xstream,
+                                    ABTI_thread *p_next, ABT_bool is_run)
+{
+    if (p_local_xstream && p_local_xstream->p_perf) {
+        ABTI_perf_sample(p_local_xstream->p_perf, p_next, is_run);
+    }
+}
+
+#endif /* ABT_CONFIG_USE_PERF_COUNTERS */
+
+#endif /* ABTI_PERF_H_INCLUDED */
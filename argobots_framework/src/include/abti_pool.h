@@ -55,6 +55,8 @@ static inline void ABTI_pool_push(ABTI_pool *p_pool, ABT_unit unit,
 {
     /* Push unit into pool */
     LOG_DEBUG_POOL_PUSH(p_pool, unit);
+    TRACE_POOL_PUSH(p_pool, unit);
+    STATS_POOL_PUSH(p_pool, 1);
     p_pool->required_def.p_push(ABTI_pool_get_handle(p_pool), unit, context);
 }
 
@@ -84,6 +86,8 @@ static inline ABT_thread ABTI_pool_pop_wait(ABTI_pool *p_pool, double time_secs,
         p_pool->optional_def.p_pop_wait(ABTI_pool_get_handle(p_pool), time_secs,
                                         context);
     LOG_DEBUG_POOL_POP(p_pool, thread);
+    TRACE_POOL_POP(p_pool, thread);
+    STATS_POOL_POP(p_pool, thread, context);
     return thread;
 }
 
@@ -96,6 +100,8 @@ static inline ABT_thread ABTI_pool_pop(ABTI_pool *p_pool,
     ABT_thread thread =
         p_pool->required_def.p_pop(ABTI_pool_get_handle(p_pool), context);
     LOG_DEBUG_POOL_POP(p_pool, thread);
+    TRACE_POOL_POP(p_pool, thread);
+    STATS_POOL_POP(p_pool, thread, context);
     return thread;
 }
 
@@ -107,12 +113,16 @@ static inline void ABTI_pool_pop_many(ABTI_pool *p_pool, ABT_thread *threads,
     p_pool->optional_def.p_pop_many(ABTI_pool_get_handle(p_pool), threads, len,
                                     num, context);
     LOG_DEBUG_POOL_POP_MANY(p_pool, threads, *num);
+    TRACE_POOL_POP_MANY(p_pool, threads, *num);
+    STATS_POOL_POP_MANY(p_pool, *num, context);
 }
 
 static inline void ABTI_pool_push_many(ABTI_pool *p_pool, const ABT_unit *units,
                                        size_t num, ABT_pool_context context)
 {
     ABTI_UB_ASSERT(p_pool->optional_def.p_push_many);
+    TRACE_POOL_PUSH_MANY(p_pool, units, num);
+    STATS_POOL_PUSH(p_pool, num);
     p_pool->optional_def.p_push_many(ABTI_pool_get_handle(p_pool), units, num,
                                      context);
     LOG_DEBUG_POOL_PUSH_MANY(p_pool, units, num);
@@ -6,8 +6,12 @@
 #ifndef ABTI_RWLOCK_H_INCLUDED
 #define ABTI_RWLOCK_H_INCLUDED
 
-#include "abti_mutex.h"
-#include "abti_cond.h"
+#include "abti_waitlist.h"
+
+/* States of ABTI_rwlock */
+#define ABTI_RWLOCK_STATE_READ_BIAS 0    /* Readers enter through indicators */
+#define ABTI_RWLOCK_STATE_REVOKED 1      /* A writer waits for readers */
+#define ABTI_RWLOCK_STATE_WRITE_LOCKED 2 /* A writer holds the lock */
 
 /* Inlined functions for RWLock */
 
@@ -41,4 +45,13 @@ static inline ABT_rwlock ABTI_rwlock_get_handle(ABTI_rwlock *p_rwlock)
 #endif
 }
 
+static inline ABTI_rwlock_reader *ABTI_rwlock_get_reader(ABTI_local *p_local,
+                                                         ABTI_rwlock *p_rwlock)
+{
+    /* External threads share the first indicator. */
+    ABTI_xstream *p_local_xstream = ABTI_local_get_xstream_or_null(p_local);
+    int rank = p_local_xstream ? p_local_xstream->rank : 0;
+    return &p_rwlock->p_readers[rank % p_rwlock->num_readers];
+}
+
 #endif /* ABTI_RWLOCK_H_INCLUDED */
@@ -0,0 +1,114 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef ABTI_STATS_H_INCLUDED
+#define ABTI_STATS_H_INCLUDED
+
+#ifdef ABT_CONFIG_USE_STATS
+
+/* Counters of an ES have a single writer, so a relaxed load and store are
+ * enough.  The reader only needs each word to be written atomically. */
+static inline void ABTI_stats_xstream_add(ABTI_xstream *p_local_xstream,
+                                          int kind, uint64_t num)
+{
+    if (p_local_xstream && p_local_xstream->p_stats) {
+        ABTD_atomic_uint64 *p_counter =
+            (ABTD_atomic_uint64 *)&p_local_xstream->p_stats->counters[kind];
+        uint64_t val = ABTD_atomic_relaxed_load_uint64(p_counter);
+        ABTD_atomic_relaxed_store_uint64(p_counter, val + num);
+    }
+}
+
+/* Counters of a pool can be updated by multiple ESs. */
+static inline void ABTI_stats_pool_add(ABT_stats_pool *p_stats, int kind,
+                                       uint64_t num)
+{
+    ABTD_atomic_uint64 *p_counter =
+        (ABTD_atomic_uint64 *)&p_stats->counters[kind];
+    ABTD_atomic_fetch_add_uint64(p_counter, num);
+}
+
+static inline void ABTI_stats_pool_push(ABTI_pool *p_pool, size_t num)
+{
+    /* p_stats of every pool is set if the statistics page is enabled. */
+    if (p_pool->p_stats && num > 0) {
+        ABTI_stats_pool_add(p_pool->p_stats, ABT_STATS_POOL_PUSHES, num);
+        ABTI_stats_xstream_add(ABTI_local_get_xstream_or_null(
+                                   ABTI_local_get_local()),
+                               ABT_STATS_XSTREAM_PUSHES, num);
+    }
+}
+
+static inline void ABTI_stats_pool_pop(ABTI_pool *p_pool, size_t num,
+                                       ABT_pool_context context)
+{
+    if (p_pool->p_stats) {
+        ABTI_xstream *p_local_xstream =
+            ABTI_local_get_xstream_or_null(ABTI_local_get_local());
+        if (num == 0) {
+            ABTI_stats_pool_add(p_pool->p_stats, ABT_STATS_POOL_EMPTY_POPS, 1);
+            ABTI_stats_xstream_add(p_local_xstream,
+                                   ABT_STATS_XSTREAM_EMPTY_POPS, 1);
+            return;
+        }
+        ABTI_stats_pool_add(p_pool->p_stats, ABT_STATS_POOL_POPS, num);
+        ABTI_stats_xstream_add(p_local_xstream, ABT_STATS_XSTREAM_POPS, num);
+        if (context & ABT_POOL_CONTEXT_OWNER_SECONDARY) {
+            ABTI_stats_pool_add(p_pool->p_stats, ABT_STATS_POOL_STEALS, num);
+            ABTI_stats_xstream_add(p_local_xstream, ABT_STATS_XSTREAM_STEALS,
+                                   num);
+        }
+    }
+}
+
+#ifdef ABT_CONFIG_USE_MEM_POOL
+/* Called before ABTI_mem_pool_alloc().  The allocation is a miss if it takes
+ * buckets from the global pool. */
+static inline void
+ABTI_stats_mem_pool_alloc(ABTI_xstream *p_local_xstream,
+                          ABTI_mem_pool_local_pool *p_local_pool)
+{
+    if (p_local_xstream->p_stats) {
+        const size_t bucket_index = p_local_pool->bucket_index;
+        const ABT_bool is_miss =
+            (bucket_index == 0 &&
+             p_local_pool->buckets[0]->bucket_info.num_headers == 1)
+                ? ABT_TRUE
+                : ABT_FALSE;
+        ABTI_stats_xstream_add(p_local_xstream,
+                               is_miss ? ABT_STATS_XSTREAM_MEM_POOL_MISSES
+                                       : ABT_STATS_XSTREAM_MEM_POOL_HITS,
+                               1);
+    }
+}
+
+#define STATS_MEM_POOL_ALLOC(p_local_xstream, p_local_pool)                    \
+    ABTI_stats_mem_pool_alloc(p_local_xstream, p_local_pool)
+#endif
+
+#define STATS_POOL_PUSH(p_pool, num) ABTI_stats_pool_push(p_pool, num)
+#define STATS_POOL_POP(p_pool, thread, context)                                \
+    ABTI_stats_pool_pop(p_pool, (thread) == ABT_THREAD_NULL ? 0 : 1, context)
+#define STATS_POOL_POP_MANY(p_pool, num, context)                              \
+    ABTI_stats_pool_pop(p_pool, num, context)
+
+#else /* !ABT_CONFIG_USE_STATS */
+
+#define STATS_POOL_PUSH(p_pool, num)                                           \
+    do {                                                                       \
+    } while (0)
+#define STATS_POOL_POP(p_pool, thread, context)                                \
+    do {                                                                       \
+    } while (0)
+#define STATS_POOL_POP_MANY(p_pool, num, context)                              \
+    do {                                                                       \
+    } while (0)
+#define STATS_MEM_POOL_ALLOC(p_local_xstream, p_local_pool)                    \
+    do {                                                                       \
+    } while (0)
+
+#endif /* ABT_CONFIG_USE_STATS */
+
+#endif /* ABTI_STATS_H_INCLUDED */
@@ -45,6 +45,10 @@ static inline void ABTI_thread_attr_init(ABTI_thread_attr *p_attr,
 {
     p_attr->p_stack = p_stack;
     p_attr->stacksize = stacksize;
+    p_attr->deadline = ABTI_THREAD_NO_DEADLINE;
+#ifdef ABT_CONFIG_USE_PREEMPTION
+    p_attr->preemptible = ABT_FALSE;
+#endif
 #ifndef ABT_CONFIG_DISABLE_MIGRATION
     p_attr->migratable = migratable;
     p_attr->f_cb = NULL;
@@ -15,6 +15,11 @@ static inline double ABTI_get_wtime(void)
     return ABTD_time_read_sec(&t);
 }
 
+static inline double ABTI_timespec_to_sec(const struct timespec *p_ts)
+{
+    return ((double)p_ts->tv_sec) + 1.0e-9 * ((double)p_ts->tv_nsec);
+}
+
 static inline ABTI_timer *ABTI_timer_get_ptr(ABT_timer timer)
 {
 #ifndef ABT_CONFIG_DISABLE_ERROR_CHECK
@@ -0,0 +1,49 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef ABTI_TIMER_WHEEL_H_INCLUDED
+#define ABTI_TIMER_WHEEL_H_INCLUDED
+
+/* Inlined functions for Timer wheel */
+
+static inline ABTI_timer_entry *ABTI_timer_entry_get_ptr(ABTI_thread *p_thread)
+{
+    ABTI_ASSERT(p_thread->type & ABTI_THREAD_TYPE_TIMED_WAITER);
+    return (ABTI_timer_entry *)(((char *)p_thread) -
+                                offsetof(ABTI_timer_entry, thread));
+}
+
+static inline ABT_bool ABTI_timer_wheel_is_empty(ABTI_xstream *p_xstream)
+{
+    ABTI_timer_wheel *p_wheel = p_xstream->p_timer_wheel;
+    return (!p_wheel || p_wheel->num_entries == 0) ? ABT_TRUE : ABT_FALSE;
+}
+
+static inline void ABTI_timer_entry_release(ABTI_timer_entry *p_entry)
+{
+    if (ABTD_atomic_fetch_sub_int(&p_entry->ref_count, 1) == 1) {
+        ABTU_free(p_entry);
+    }
+}
+
+/* Called while holding the lock of p_entry->p_waitlist after p_entry is
+ * removed from the waitlist.  Returns ABT_FALSE if the timeout has already
+ * expired, in which case the wheel has resumed the ULT. */
+static inline ABT_bool ABTI_timer_entry_signal(ABTI_local *p_local,
+                                               ABTI_timer_entry *p_entry)
+{
+    /* p_entry may be freed once state is updated. */
+    ABTI_ythread *p_ythread = p_entry->p_ythread;
+    p_entry->is_in_waitlist = ABT_FALSE;
+    if (ABTD_atomic_bool_cas_strong_int(&p_entry->state,
+                                        ABTI_TIMER_ENTRY_WAITING,
+                                        ABTI_TIMER_ENTRY_SIGNALED)) {
+        ABTI_ythread_resume_and_push(p_local, p_ythread);
+        return ABT_TRUE;
+    }
+    return ABT_FALSE;
+}
+
+#endif /* ABTI_TIMER_WHEEL_H_INCLUDED */
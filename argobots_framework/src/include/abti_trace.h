@@ -0,0 +1,117 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#ifndef ABTI_TRACE_H_INCLUDED
+#define ABTI_TRACE_H_INCLUDED
+
+#ifdef ABT_CONFIG_USE_TRACE
+
+/* Raw timestamp of a trace record.  ABTI_trace_dump() converts it to
+ * microseconds by using the calibration taken at ABT_init. */
+static inline uint64_t ABTI_trace_get_timestamp(void)
+{
+#if defined(__x86_64__)
+    uint32_t hi, lo;
+    __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+    return ((uint64_t)lo) | (((uint64_t)hi) << 32);
+#elif defined(__aarch64__)
+    uint64_t cycle;
+    __asm__ __volatile__("isb; mrs %0, cntvct_el0" : "=r"(cycle));
+    return cycle;
+#else
+    /* Return a nanosecond as the best effort. */
+    return (uint64_t)(ABTI_get_wtime() * 1.0e9);
+#endif
+}
+
+/* Pool hooks do not have the caller's ES, and looking it up is a TLS access,
+ * which can be as costly as a push or a pop of a simple pool.  The global flag
+ * is checked first so that a disabled trace costs a few loads and a branch. */
+static inline ABTI_trace_buffer *ABTI_trace_get_local_buffer(void)
+{
+    ABTI_global *p_global = gp_ABTI_global;
+    if (ABTU_likely(!p_global || p_global->trace_enabled == ABT_FALSE))
+        return NULL;
+    ABTI_xstream *p_local_xstream =
+        ABTI_local_get_xstream_or_null(ABTI_local_get_local());
+    return p_local_xstream ? p_local_xstream->p_trace : NULL;
+}
+
+/* This function must be called by the ES that owns p_trace. */
+static inline void ABTI_trace_record_event(ABTI_trace_buffer *p_trace,
+                                           ABTI_trace_event event,
+                                           ABTI_thread *p_thread,
+                                           uint64_t pool_id)
+{
+    uint64_t head = ABTD_atomic_relaxed_load_uint64(&p_trace->head);
+    ABTI_trace_record *p_record = &p_trace->p_records[head & p_trace->mask];
+    p_record->timestamp = ABTI_trace_get_timestamp();
+    p_record->thread_id = (uint64_t)ABTI_thread_get_id(p_thread);
+    p_record->pool_id = pool_id;
+    p_record->event = (uint32_t)event;
+    p_record->thread_type = (uint32_t)p_thread->type;
+    ABTD_atomic_release_store_uint64(&p_trace->head, head + 1);
+}
+
+static inline void ABTI_trace_thread(ABTI_xstream *p_local_xstream,
+                                     ABTI_trace_event event,
+                                     ABTI_thread *p_thread)
+{
+    if (p_local_xstream && p_local_xstream->p_trace) {
+        ABTI_pool *p_pool = p_thread->p_pool;
+        ABTI_trace_record_event(p_local_xstream->p_trace, event, p_thread,
+                                p_pool ? p_pool->id : 0);
+    }
+}
+
+#define TRACE_POOL_PUSH(p_pool, unit)                                          \
+    do {                                                                       \
+        ABTI_trace_buffer *p_trace_ = ABTI_trace_get_local_buffer();           \
+        if (p_trace_)                                                          \
+            ABTI_trace_pool_push(p_trace_, p_pool, unit);                      \
+    } while (0)
+#define TRACE_POOL_POP(p_pool, thread)                                         \
+    do {                                                                       \
+        ABTI_trace_buffer *p_trace_ = ABTI_trace_get_local_buffer();           \
+        if (p_trace_)                                                          \
+            ABTI_trace_pool_pop(p_trace_, p_pool, thread);                     \
+    } while (0)
+#define TRACE_POOL_POP_MANY(p_pool, threads, num)                              \
+    do {                                                                       \
+        ABTI_trace_buffer *p_trace_ = ABTI_trace_get_local_buffer();           \
+        if (p_trace_) {                                                        \
+            size_t i_;                                                         \
+            for (i_ = 0; i_ < (num); i_++)                                     \
+                ABTI_trace_pool_pop(p_trace_, p_pool, (threads)[i_]);          \
+        }                                                                      \
+    } while (0)
+#define TRACE_POOL_PUSH_MANY(p_pool, units, num)                               \
+    do {                                                                       \
+        ABTI_trace_buffer *p_trace_ = ABTI_trace_get_local_buffer();           \
+        if (p_trace_) {                                                        \
+            size_t i_;                                                         \
+            for (i_ = 0; i_ < (num); i_++)                                     \
+                ABTI_trace_pool_push(p_trace_, p_pool, (units)[i_]);           \
+        }                                                                      \
+    } while (0)
+
+#else /* !ABT_CONFIG_USE_TRACE */
+
+#define TRACE_POOL_PUSH(p_pool, unit)                                          \
+    do {                                                                       \
+    } while (0)
+#define TRACE_POOL_POP(p_pool, thread)                                         \
+    do {                                                                       \
+    } while (0)
+#define TRACE_POOL_POP_MANY(p_pool, threads, num)                              \
+    do {                                                                       \
+    } while (0)
+#define TRACE_POOL_PUSH_MANY(p_pool, units, num)                               \
+    do {                                                                       \
+    } while (0)
+
+#endif /* ABT_CONFIG_USE_TRACE */
+
+#endif /* ABTI_TRACE_H_INCLUDED */
@@ -87,6 +87,57 @@ ABTI_waitlist_wait_and_unlock(ABTI_local **pp_local, ABTI_waitlist *p_waitlist,
     }
 }
 
+/* Adds a dummy thread that may be removed on timeout.  This implementation is
+ * tricky since this updates p_prev as well for removal on timeout while the
+ * other functions (e.g., wait, broadcast, signal) do not update it. */
+static inline void ABTI_waitlist_add_timed(ABTI_waitlist *p_waitlist,
+                                           ABTI_thread *p_thread)
+{
+    p_thread->p_next = NULL;
+    if (p_waitlist->p_head == NULL) {
+        p_waitlist->p_head = p_thread;
+        p_thread->p_prev = NULL;
+    } else {
+        p_waitlist->p_tail->p_next = p_thread;
+        p_thread->p_prev = p_waitlist->p_tail;
+    }
+    p_waitlist->p_tail = p_thread;
+}
+
+/* Removes p_thread that has been added by ABTI_waitlist_add_timed(). */
+static inline void ABTI_waitlist_remove_timed(ABTI_waitlist *p_waitlist,
+                                              ABTI_thread *p_thread)
+{
+    if (p_waitlist->p_head == p_thread) {
+        /* p_thread is a head. */
+        /* Note that p_thread->p_prev cannot be used to check whether p_thread
+         * is a head or not because signal and broadcast do not modify
+         * p_thread->p_prev. */
+        p_waitlist->p_head = p_thread->p_next;
+        if (!p_thread->p_next) {
+            /* This thread is p_tail */
+            ABTI_ASSERT(p_waitlist->p_tail == p_thread);
+            p_waitlist->p_tail = NULL;
+        }
+    } else {
+        /* p_thread is not a head and thus p_prev exists. */
+        ABTI_ASSERT(p_thread->p_prev);
+        p_thread->p_prev->p_next = p_thread->p_next;
+        if (p_thread->p_next) {
+            /* Only a dummy thread added by ABTI_waitlist_add_timed() checks
+             * p_prev.  Note that a real external thread is also dummy, so
+             * updating p_prev is allowed. */
+            p_thread->p_next->p_prev = p_thread->p_prev;
+        } else {
+            /* This thread is p_tail */
+            ABTI_ASSERT(p_waitlist->p_tail == p_thread);
+            p_waitlist->p_tail = p_thread->p_prev;
+        }
+    }
+    /* We do not need to modify p_thread->p_prev and p_next since this dummy
+     * thread is no longer used. */
+}
+
 /* Return ABT_TRUE if timed out. */
 static inline ABT_bool ABTI_waitlist_wait_timedout_and_unlock(
     ABTI_local **pp_local, ABTI_waitlist *p_waitlist, ABTD_spinlock *p_lock,
@@ -98,24 +149,30 @@ static inline ABT_bool ABTI_waitlist_wait_timedout_and_unlock(
     if (!ABTI_IS_EXT_THREAD_ENABLED || p_local_xstream)
         p_ythread = ABTI_thread_get_ythread_or_null(p_local_xstream->p_thread);
 
+    if (p_ythread) {
+        /* Suspend the ULT until it is signaled or the timer wheel of this ES
+         * resumes it. */
+        ABT_bool is_timedout;
+        int abt_errno =
+            ABTI_timer_wheel_wait_and_unlock(&p_local_xstream, p_ythread,
+                                             p_waitlist, p_lock, target_time,
+                                             sync_event_type, p_sync,
+                                             &is_timedout);
+        /* This ULT may have been resumed on another ES. */
+        *pp_local = ABTI_xstream_get_local(p_local_xstream);
+        if (abt_errno == ABT_SUCCESS)
+            return is_timedout;
+        /* Memory allocation failed, so poll the time below. */
+    }
+
     /* Always use a dummy thread. */
     ABTI_thread thread;
     thread.type = ABTI_THREAD_TYPE_EXT;
     /* use state for synchronization */
     ABTD_atomic_relaxed_store_int(&thread.state, ABT_THREAD_STATE_BLOCKED);
 
-    /* Add p_thread to the list.  This implementation is tricky since this
-     * updates p_prev as well for removal on timeout while the other functions
-     * (e.g., wait, broadcast, signal) do not update it. */
-    thread.p_next = NULL;
-    if (p_waitlist->p_head == NULL) {
-        p_waitlist->p_head = &thread;
-        thread.p_prev = NULL;
-    } else {
-        p_waitlist->p_tail->p_next = &thread;
-        thread.p_prev = p_waitlist->p_tail;
-    }
-    p_waitlist->p_tail = &thread;
+    /* Add thread to the list. */
+    ABTI_waitlist_add_timed(p_waitlist, &thread);
 
     /* Waiting here. */
     if (p_ythread) {
@@ -180,34 +237,7 @@ timeout:
             : ABT_FALSE;
     if (is_timedout) {
         /* This thread is still in the list. */
-        if (p_waitlist->p_head == &thread) {
-            /* thread is a head. */
-            /* Note that thread->p_prev cannot be used to check whether
-             * thread is a head or not because signal and broadcast do
-             * not modify thread->p_prev. */
-            p_waitlist->p_head = thread.p_next;
-            if (!thread.p_next) {
-                /* This thread is p_tail */
-                ABTI_ASSERT(p_waitlist->p_tail == &thread);
-                p_waitlist->p_tail = NULL;
-            }
-        } else {
-            /* thread is not a head and thus p_prev exists. */
-            ABTI_ASSERT(thread.p_prev);
-            thread.p_prev->p_next = thread.p_next;
-            if (thread.p_next && thread.type == ABTI_THREAD_TYPE_EXT) {
-                /* Only a dummy external thread created by this function
-                 * checks p_prev.  Note that a real external thread is
-                 * also dummy, so updating p_prev is allowed. */
-                thread.p_next->p_prev = thread.p_prev;
-            } else {
-                /* This thread is p_tail */
-                ABTI_ASSERT(p_waitlist->p_tail == &thread);
-                p_waitlist->p_tail = thread.p_prev;
-            }
-        }
-        /* We do not need to modify thread->p_prev and p_next since this
-         * dummy thread is no longer used. */
+        ABTI_waitlist_remove_timed(p_waitlist, &thread);
     }
     ABTD_spinlock_release(p_lock);
     return is_timedout;
@@ -217,13 +247,19 @@ static inline void ABTI_waitlist_signal(ABTI_local *p_local,
                                         ABTI_waitlist *p_waitlist)
 {
     ABTI_thread *p_thread = p_waitlist->p_head;
-    if (p_thread) {
+    while (p_thread) {
         ABTI_thread *p_next = p_thread->p_next;
         p_thread->p_next = NULL;
 
+        ABT_bool is_woken = ABT_TRUE;
         ABTI_ythread *p_ythread = ABTI_thread_get_ythread_or_null(p_thread);
         if (p_ythread) {
             ABTI_ythread_resume_and_push(p_local, p_ythread);
+        } else if (p_thread->type & ABTI_THREAD_TYPE_TIMED_WAITER) {
+            /* If its timeout has expired, signal the next one. */
+            is_woken =
+                ABTI_timer_entry_signal(p_local,
+                                        ABTI_timer_entry_get_ptr(p_thread));
         } else {
             /* When p_thread is an external thread or a tasklet */
             ABTD_atomic_release_store_int(&p_thread->state,
@@ -240,6 +276,9 @@ static inline void ABTI_waitlist_signal(ABTI_local *p_local,
         p_waitlist->p_head = p_next;
         if (!p_next)
             p_waitlist->p_tail = NULL;
+        if (is_woken)
+            break;
+        p_thread = p_next;
     }
 }
 
@@ -256,6 +295,9 @@ static inline void ABTI_waitlist_broadcast(ABTI_local *p_local,
             ABTI_ythread *p_ythread = ABTI_thread_get_ythread_or_null(p_thread);
             if (p_ythread) {
                 ABTI_ythread_resume_and_push(p_local, p_ythread);
+            } else if (p_thread->type & ABTI_THREAD_TYPE_TIMED_WAITER) {
+                ABTI_timer_entry_signal(p_local,
+                                        ABTI_timer_entry_get_ptr(p_thread));
             } else {
                 /* When p_thread is an external thread or a tasklet */
                 wakeup_nonyieldable = ABT_TRUE;
@@ -192,6 +192,20 @@ static void info_trigger_print_all_thread_stacks(
  *   to \c ABT_TRUE if Argobots is configured to enable lazy allocation for ULT
  *   stacks by default.  Otherwise, \c val is set to \c ABT_FALSE.
  *
+ * - \c ABT_INFO_QUERY_KIND_ENABLED_PREEMPTION
+ *
+ *   \c val must be a pointer to a variable of type \c ABT_bool.  \c val is set
+ *   to \c ABT_TRUE if Argobots is configured to enable the preemption feature
+ *   and \c ABT_PREEMPTION_INTERVAL_USEC enables it at run time.  Otherwise,
+ *   \c val is set to \c ABT_FALSE.
+ *
+ * - \c ABT_INFO_QUERY_KIND_ENABLED_STATS
+ *
+ *   \c val must be a pointer to a variable of type \c ABT_bool.  \c val is set
+ *   to \c ABT_TRUE if Argobots is configured to enable the live statistics
+ *   page and \c ABT_STATS enables it at run time.  Otherwise, \c val is set
+ *   to \c ABT_FALSE.  See abt_stats.h for the layout of the page.
+ *
  * @changev20
  * \DOC_DESC_V1X_RETURN_INFO_IF_POSSIBLE
  * @endchangev20
@@ -435,6 +449,26 @@ int ABT_info_query_config(ABT_info_query_kind query_kind, void *val)
             *((ABT_bool *)val) = ABT_TRUE;
 #endif
             break;
+        case ABT_INFO_QUERY_KIND_ENABLED_PREEMPTION: {
+#ifdef ABT_CONFIG_USE_PREEMPTION
+            ABTI_global *p_global;
+            /* This check needs runtime check in ABT_init(). */
+            ABTI_SETUP_GLOBAL(&p_global);
+            *((ABT_bool *)val) = p_global->preemption_enabled;
+#else
+            *((ABT_bool *)val) = ABT_FALSE;
+#endif
+        } break;
+        case ABT_INFO_QUERY_KIND_ENABLED_STATS: {
+#ifdef ABT_CONFIG_USE_STATS
+            ABTI_global *p_global;
+            /* The page is mapped in ABT_init(). */
+            ABTI_SETUP_GLOBAL(&p_global);
+            *((ABT_bool *)val) = p_global->stats_enabled;
+#else
+            *((ABT_bool *)val) = ABT_FALSE;
+#endif
+        } break;
         default:
             ABTI_HANDLE_ERROR(ABT_ERR_INV_QUERY_KIND);
     }
@@ -1012,6 +1046,57 @@ int ABT_info_trigger_print_all_thread_stacks(FILE *fp, double timeout,
     return ABT_SUCCESS;
 }
 
+/**
+ * @ingroup INFO
+ * @brief   Write the event trace of all execution streams to a file.
+ *
+ * \c ABT_info_dump_trace() writes the events recorded in the per-execution
+ * stream trace buffers to the file \c filename in the Chrome trace event JSON
+ * format, which can be loaded by \c chrome://tracing and Perfetto.  If
+ * \c filename is \c NULL, the file name given by \c ABT_TRACE_FILE or
+ * \c abt_trace.<pid>.json is used.
+ *
+ * Events are recorded only if Argobots is configured with \c --enable-trace
+ * and the environment variable \c ABT_TRACE is set.  Each execution stream
+ * keeps the latest \c ABT_TRACE_BUFFER_SIZE events, and older events are
+ * overwritten.  The trace is also written by \c ABT_finalize().
+ *
+ * @note
+ * Events that are being recorded while this routine runs might be dropped.
+ *
+ * @contexts
+ * \DOC_CONTEXT_INIT \DOC_CONTEXT_NOCTXSWITCH
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_FEATURE_NA{the trace feature}
+ * \DOC_ERROR_RESOURCE
+ *
+ * @undefined
+ * \DOC_UNDEFINED_UNINIT
+ *
+ * @param[in] filename  output file name
+ * @return Error code
+ */
+int ABT_info_dump_trace(const char *filename)
+{
+    ABTI_UB_ASSERT(ABTI_initialized());
+
+#ifndef ABT_CONFIG_USE_TRACE
+    ABTI_UNUSED(filename);
+    ABTI_HANDLE_ERROR(ABT_ERR_FEATURE_NA);
+#else
+    ABTI_global *p_global;
+    ABTI_SETUP_GLOBAL(&p_global);
+
+    if (!filename)
+        filename = p_global->trace_file;
+    int abt_errno = ABTI_trace_dump(p_global, filename);
+    ABTI_CHECK_ERROR(abt_errno);
+    return ABT_SUCCESS;
+#endif
+}
+
 /*****************************************************************************/
 /* Private APIs                                                              */
 /*****************************************************************************/
@@ -1204,6 +1289,40 @@ void ABTI_info_print_config(ABTI_global *p_global, FILE *fp)
                 "\n");
     fprintf(fp, " - default scheduler sleep duration : %" PRIu64 " [ns]\n",
             p_global->sched_sleep_nsec);
+    fprintf(fp, " - barrier spin count: %u\n", p_global->barrier_spin_count);
+    fprintf(fp, " - barrier yield count: %u\n", p_global->barrier_yield_count);
+    fprintf(fp, " - hardware counters: "
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+                "%s\n",
+            p_global->perf_enabled ? "on" : "off");
+#else
+                "not supported\n");
+#endif
+    fprintf(fp, " - preemption: "
+#ifdef ABT_CONFIG_USE_PREEMPTION
+                "%s\n",
+            p_global->preemption_enabled ? "on" : "off");
+    fprintf(fp, " - preemption interval: %" PRIu64 " [us]\n",
+            p_global->preemption_interval_usec);
+#else
+                "not supported\n");
+#endif
+    fprintf(fp, " - event trace: "
+#ifdef ABT_CONFIG_USE_TRACE
+                "%s\n",
+            p_global->trace_enabled ? "on" : "off");
+    fprintf(fp, " - event trace buffer size: %u\n",
+            p_global->trace_buffer_size);
+#else
+                "not supported\n");
+#endif
+    fprintf(fp, " - live statistics: "
+#ifdef ABT_CONFIG_USE_STATS
+                "%s\n",
+            p_global->stats_enabled ? p_global->stats_file : "off");
+#else
+                "not supported\n");
+#endif
 
     fprintf(fp, " - timer function: "
 #if defined(ABT_CONFIG_USE_CLOCK_GETTIME)
@@ -299,6 +299,46 @@ int ABT_mutex_trylock(ABT_mutex mutex)
     return abt_errno;
 }
 
+/**
+ * @ingroup MUTEX
+ * @brief   Lock a mutex with a timeout.
+ *
+ * \c ABT_mutex_timedlock() locks the mutex \c mutex like \c ABT_mutex_lock().
+ * If \c mutex cannot be locked before the absolute time \c abstime,
+ * \c ABT_ERR_TIMEDOUT is returned and the caller does not acquire \c mutex.
+ *
+ * A ULT that waits for \c mutex is suspended and does not occupy its pool.
+ * The timer wheel of the execution stream on which it started waiting resumes
+ * it at \c abstime, which is checked by \c ABT_xstream_check_events().
+ *
+ * @contexts
+ * \DOC_CONTEXT_ANY \DOC_CONTEXT_CTXSWITCH_CONDITIONAL{\c mutex is locked and
+ * therefore the caller fails to take a lock}
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_SUCCESS_TIMEDOUT{\c mutex is locked by the caller}
+ * \DOC_ERROR_INV_MUTEX_HANDLE{\c mutex}
+ *
+ * @undefined
+ * \DOC_UNDEFINED_NULL_PTR{\c abstime}
+ *
+ * @param[in] mutex    mutex handle
+ * @param[in] abstime  absolute time for timeout
+ * @return Error code
+ */
+int ABT_mutex_timedlock(ABT_mutex mutex, const struct timespec *abstime)
+{
+    ABTI_UB_ASSERT(abstime);
+
+    ABTI_local *p_local = ABTI_local_get_local();
+    ABTI_mutex *p_mutex = ABTI_mutex_get_ptr(mutex);
+    ABTI_CHECK_NULL_MUTEX_PTR(p_mutex);
+    /* Timed out is not an error. */
+    return ABTI_mutex_timedlock(&p_local, p_mutex,
+                                ABTI_timespec_to_sec(abstime));
+}
+
 /**
  * @ingroup MUTEX
  * @brief   Lock a mutex in a busy-wait form.
@@ -0,0 +1,339 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#define _GNU_SOURCE
+#include "abti.h"
+
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#ifdef HAVE_DLADDR
+#include <dlfcn.h>
+#endif
+
+static void perf_open_counters(ABTI_perf_xstream *p_perf);
+static void perf_close_counters(ABTI_perf_xstream *p_perf);
+static ABTI_perf_entry *perf_get_entry(ABTI_perf_xstream *p_perf,
+                                       ABTI_thread *p_thread);
+static void perf_print_xstream(ABTI_perf_xstream *p_perf, FILE *p_os);
+static int perf_compare_rank(const void *p_a, const void *p_b);
+static int perf_compare_cycles(const void *p_a, const void *p_b);
+
+/*****************************************************************************/
+/* Private APIs                                                              */
+/*****************************************************************************/
+
+void ABTI_perf_init(ABTI_global *p_global)
+{
+    ABTD_spinlock_clear(&p_global->perf_lock);
+    p_global->p_perf_head = NULL;
+}
+
+void ABTI_perf_finalize(ABTI_global *p_global)
+{
+    if (p_global->perf_enabled == ABT_TRUE && p_global->p_perf_head) {
+        ABTI_perf_print_report(p_global, stdout);
+    }
+    ABTI_perf_xstream *p_perf = p_global->p_perf_head;
+    while (p_perf) {
+        ABTI_perf_xstream *p_next = p_perf->p_next;
+        ABTI_ASSERT(p_perf->in_use == ABT_FALSE);
+        ABTU_free(p_perf);
+        p_perf = p_next;
+    }
+    p_global->p_perf_head = NULL;
+}
+
+ABTU_ret_err int ABTI_perf_attach_xstream(ABTI_global *p_global,
+                                          ABTI_xstream *p_xstream)
+{
+    p_xstream->p_perf = NULL;
+    if (p_global->perf_enabled == ABT_FALSE)
+        return ABT_SUCCESS;
+
+    ABTD_spinlock_acquire(&p_global->perf_lock);
+    /* Keep accumulating counts of a freed ES that had the same rank. */
+    ABTI_perf_xstream *p_perf = p_global->p_perf_head;
+    while (p_perf) {
+        if (p_perf->in_use == ABT_FALSE && p_perf->rank == p_xstream->rank)
+            break;
+        p_perf = p_perf->p_next;
+    }
+    if (!p_perf) {
+        int abt_errno =
+            ABTU_calloc(1, sizeof(ABTI_perf_xstream), (void **)&p_perf);
+        if (abt_errno != ABT_SUCCESS) {
+            ABTD_spinlock_release(&p_global->perf_lock);
+            return abt_errno;
+        }
+        p_perf->rank = p_xstream->rank;
+        p_perf->p_next = p_global->p_perf_head;
+        p_global->p_perf_head = p_perf;
+    }
+    /* Counters are opened by the new owner on its first sample. */
+    p_perf->in_use = ABT_TRUE;
+    p_perf->is_opened = ABT_FALSE;
+    p_perf->group_fd = -1;
+    p_perf->p_target = NULL;
+    ABTD_spinlock_release(&p_global->perf_lock);
+
+    p_xstream->p_perf = p_perf;
+    return ABT_SUCCESS;
+}
+
+void ABTI_perf_detach_xstream(ABTI_global *p_global, ABTI_xstream *p_xstream)
+{
+    ABTI_perf_xstream *p_perf = p_xstream->p_perf;
+    if (!p_perf)
+        return;
+    p_xstream->p_perf = NULL;
+    ABTD_spinlock_acquire(&p_global->perf_lock);
+    perf_close_counters(p_perf);
+    p_perf->p_target = NULL;
+    p_perf->in_use = ABT_FALSE;
+    ABTD_spinlock_release(&p_global->perf_lock);
+}
+
+void ABTI_perf_sample(ABTI_perf_xstream *p_perf, ABTI_thread *p_next,
+                      ABT_bool is_run)
+{
+    if (ABTU_unlikely(p_perf->is_opened == ABT_FALSE))
+        perf_open_counters(p_perf);
+    if (p_perf->group_fd < 0)
+        return;
+
+    struct {
+        uint64_t nr;
+        uint64_t values[ABTI_PERF_NUM_COUNTERS];
+    } buf;
+    ssize_t len = read(p_perf->group_fd, &buf, sizeof(buf));
+    if (len >= (ssize_t)sizeof(uint64_t) &&
+        buf.nr == (uint64_t)p_perf->num_fds) {
+        ABTI_thread *p_target = p_perf->p_target;
+        ABTI_perf_entry *p_entry =
+            p_target ? perf_get_entry(p_perf, p_target) : NULL;
+        int i;
+        for (i = 0; i < p_perf->num_fds; i++) {
+            const int kind = p_perf->kinds[i];
+            const uint64_t delta = buf.values[i] - p_perf->last[kind];
+            p_perf->last[kind] = buf.values[i];
+            if (p_target) {
+                p_target->perf_counts[kind] += delta;
+                p_entry->counts[kind] += delta;
+            }
+        }
+    }
+    if (is_run && p_next)
+        perf_get_entry(p_perf, p_next)->num_runs++;
+    p_perf->p_target = p_next;
+}
+
+void ABTI_perf_print_report(ABTI_global *p_global, FILE *p_os)
+{
+    ABTD_spinlock_acquire(&p_global->perf_lock);
+    size_t num_tables = 0, i;
+    ABTI_perf_xstream *p_perf;
+    for (p_perf = p_global->p_perf_head; p_perf; p_perf = p_perf->p_next)
+        num_tables++;
+    ABTI_perf_xstream **tables;
+    if (ABTU_malloc(sizeof(ABTI_perf_xstream *) * num_tables,
+                    (void **)&tables) != ABT_SUCCESS) {
+        ABTD_spinlock_release(&p_global->perf_lock);
+        return;
+    }
+    num_tables = 0;
+    for (p_perf = p_global->p_perf_head; p_perf; p_perf = p_perf->p_next)
+        tables[num_tables++] = p_perf;
+    qsort(tables, num_tables, sizeof(ABTI_perf_xstream *), perf_compare_rank);
+
+    fprintf(p_os, "Argobots hardware counters (per ES and thread function):\n");
+    for (i = 0; i < num_tables; i++)
+        perf_print_xstream(tables[i], p_os);
+    fflush(p_os);
+    ABTU_free(tables);
+    ABTD_spinlock_release(&p_global->perf_lock);
+}
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+static void perf_open_counters(ABTI_perf_xstream *p_perf)
+{
+    static const uint64_t configs[ABTI_PERF_NUM_COUNTERS] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_STALLED_CYCLES_BACKEND
+    };
+    int kind;
+    p_perf->is_opened = ABT_TRUE;
+    p_perf->group_fd = -1;
+    p_perf->num_fds = 0;
+    for (kind = 0; kind < ABTI_PERF_NUM_COUNTERS; kind++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = configs[kind];
+        attr.disabled = (p_perf->group_fd < 0) ? 1 : 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        /* Measure the calling OS thread (= this ES) on any CPU.  A counter
+         * that is not supported by this CPU is skipped. */
+        int fd = (int)syscall(__NR_perf_event_open, &attr, 0, -1,
+                              p_perf->group_fd, 0);
+        if (fd < 0)
+            continue;
+        if (p_perf->group_fd < 0)
+            p_perf->group_fd = fd;
+        p_perf->fds[p_perf->num_fds] = fd;
+        p_perf->kinds[p_perf->num_fds] = kind;
+        p_perf->num_fds++;
+        p_perf->last[kind] = 0;
+    }
+    if (p_perf->group_fd >= 0) {
+        ioctl(p_perf->group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(p_perf->group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+static void perf_close_counters(ABTI_perf_xstream *p_perf)
+{
+    int i;
+    if (p_perf->group_fd < 0)
+        return;
+    /* Close group members before the leader.  kinds[] is kept for the
+     * report. */
+    for (i = p_perf->num_fds - 1; i >= 0; i--)
+        close(p_perf->fds[i]);
+    p_perf->group_fd = -1;
+}
+
+static ABTI_perf_entry *perf_get_entry(ABTI_perf_xstream *p_perf,
+                                       ABTI_thread *p_thread)
+{
+    void (*f_thread)(void *) = p_thread->f_thread;
+    size_t hash = (size_t)(((uintptr_t)f_thread >> 4) * 0x9E3779B97F4A7C15ull);
+    size_t i;
+    for (i = 0; i < ABTI_PERF_TABLE_SIZE; i++) {
+        ABTI_perf_entry *p_entry =
+            &p_perf->entries[(hash + i) & (ABTI_PERF_TABLE_SIZE - 1)];
+        if (p_entry->is_used == ABT_FALSE) {
+            p_entry->is_used = ABT_TRUE;
+            p_entry->f_thread = f_thread;
+            p_entry->thread_type = (uint32_t)p_thread->type;
+            return p_entry;
+        } else if (p_entry->f_thread == f_thread) {
+            return p_entry;
+        }
+    }
+    return &p_perf->others;
+}
+
+static void perf_print_xstream(ABTI_perf_xstream *p_perf, FILE *p_os)
+{
+    static const char *names[ABTI_PERF_NUM_COUNTERS] = { "cycles",
+                                                          "instructions",
+                                                          "LLC-misses",
+                                                          "backend-stalls" };
+    ABT_bool has_counter[ABTI_PERF_NUM_COUNTERS] = { ABT_FALSE };
+    int i, j;
+    if (p_perf->num_fds == 0) {
+        fprintf(p_os, " - ES %d: hardware counters are unavailable\n",
+                p_perf->rank);
+        return;
+    }
+    for (i = 0; i < p_perf->num_fds; i++)
+        has_counter[p_perf->kinds[i]] = ABT_TRUE;
+
+    ABTI_perf_entry *entries[ABTI_PERF_TABLE_SIZE + 1];
+    int num_entries = 0;
+    for (i = 0; i < ABTI_PERF_TABLE_SIZE; i++) {
+        if (p_perf->entries[i].is_used)
+            entries[num_entries++] = &p_perf->entries[i];
+    }
+    if (p_perf->others.num_runs)
+        entries[num_entries++] = &p_perf->others;
+    qsort(entries, num_entries, sizeof(ABTI_perf_entry *),
+          perf_compare_cycles);
+
+    fprintf(p_os, " - ES %d:\n   %-40s %10s", p_perf->rank, "function",
+            "runs");
+    for (j = 0; j < ABTI_PERF_NUM_COUNTERS; j++)
+        fprintf(p_os, " %15s", names[j]);
+    fprintf(p_os, " %6s %8s\n", "IPC", "LLC-MPKI");
+    for (i = 0; i < num_entries; i++) {
+        const ABTI_perf_entry *p_entry = entries[i];
+        char name[41];
+        const char *sym = NULL;
+#ifdef HAVE_DLADDR
+        Dl_info info;
+        if (p_entry->f_thread &&
+            dladdr((void *)(uintptr_t)p_entry->f_thread, &info) &&
+            info.dli_sname)
+            sym = info.dli_sname;
+#endif
+        if (p_entry == &p_perf->others) {
+            sym = "(others)";
+        } else if (p_entry->thread_type & ABTI_THREAD_TYPE_PRIMARY) {
+            sym = "(primary)";
+        } else if (p_entry->thread_type & ABTI_THREAD_TYPE_ROOT) {
+            sym = "(root)";
+        } else if (p_entry->thread_type & ABTI_THREAD_TYPE_MAIN_SCHED) {
+            sym = "(main scheduler)";
+        }
+        if (sym) {
+            snprintf(name, sizeof(name), "%s", sym);
+        } else {
+            snprintf(name, sizeof(name), "%p",
+                     (void *)(uintptr_t)p_entry->f_thread);
+        }
+        fprintf(p_os, "   %-40s %10" PRIu64, name, p_entry->num_runs);
+        for (j = 0; j < ABTI_PERF_NUM_COUNTERS; j++) {
+            if (has_counter[j]) {
+                fprintf(p_os, " %15" PRIu64, p_entry->counts[j]);
+            } else {
+                fprintf(p_os, " %15s", "n/a");
+            }
+        }
+        const uint64_t cycles = p_entry->counts[ABTI_PERF_COUNTER_CYCLES];
+        const uint64_t insts = p_entry->counts[ABTI_PERF_COUNTER_INSTRUCTIONS];
+        const uint64_t misses = p_entry->counts[ABTI_PERF_COUNTER_CACHE_MISSES];
+        if (cycles && insts) {
+            fprintf(p_os, " %6.2f", (double)insts / (double)cycles);
+        } else {
+            fprintf(p_os, " %6s", "n/a");
+        }
+        if (insts && has_counter[ABTI_PERF_COUNTER_CACHE_MISSES]) {
+            fprintf(p_os, " %8.2f\n", (double)misses * 1000.0 / (double)insts);
+        } else {
+            fprintf(p_os, " %8s\n", "n/a");
+        }
+    }
+}
+
+static int perf_compare_rank(const void *p_a, const void *p_b)
+{
+    const ABTI_perf_xstream *p_perf_a = *(ABTI_perf_xstream *const *)p_a;
+    const ABTI_perf_xstream *p_perf_b = *(ABTI_perf_xstream *const *)p_b;
+    return (p_perf_a->rank > p_perf_b->rank) -
+           (p_perf_a->rank < p_perf_b->rank);
+}
+
+static int perf_compare_cycles(const void *p_a, const void *p_b)
+{
+    const uint64_t cycles_a = (*(ABTI_perf_entry *const *)p_a)
+                                  ->counts[ABTI_PERF_COUNTER_CYCLES];
+    const uint64_t cycles_b = (*(ABTI_perf_entry *const *)p_b)
+                                  ->counts[ABTI_PERF_COUNTER_CYCLES];
+    /* In descending order. */
+    return (cycles_a < cycles_b) - (cycles_a > cycles_b);
+}
+
+#endif /* ABT_CONFIG_USE_PERF_COUNTERS */
@@ -4,6 +4,7 @@
 #
 
 abt_sources += \
+	pool/edf.c \
 	pool/fifo.c \
 	pool/fifo_wait.c \
 	pool/pool.c \
@@ -0,0 +1,456 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+#include "thread_queue.h"
+#include <time.h>
+
+/* EDF pool implementation
+ *
+ * ULTs that have a deadline are kept in a pairing heap ordered by deadline.
+ * A node uses p_prev as its first child and p_next as its next sibling, so the
+ * heap needs no memory besides the ULT descriptors.  Work units without a
+ * deadline are kept in a FIFO queue and popped only when the heap is empty. */
+
+static int pool_init(ABT_pool pool, ABT_pool_config config);
+static void pool_free(ABT_pool pool);
+static ABT_bool pool_is_empty(ABT_pool pool);
+static size_t pool_get_size(ABT_pool pool);
+static void pool_push_shared(ABT_pool pool, ABT_unit unit,
+                             ABT_pool_context context);
+static void pool_push_private(ABT_pool pool, ABT_unit unit,
+                              ABT_pool_context context);
+static ABT_thread pool_pop_shared(ABT_pool pool, ABT_pool_context context);
+static ABT_thread pool_pop_private(ABT_pool pool, ABT_pool_context context);
+static ABT_thread pool_pop_wait(ABT_pool pool, double time_secs,
+                                ABT_pool_context context);
+static void pool_print_all(ABT_pool pool, void *arg,
+                           void (*print_fn)(void *, ABT_thread));
+static ABT_unit pool_create_unit(ABT_pool pool, ABT_thread thread);
+static void pool_free_unit(ABT_pool pool, ABT_unit unit);
+
+/* For backward compatibility */
+static ABT_unit pool_pop_timedwait(ABT_pool pool, double abstime_secs);
+static int pool_remove_shared(ABT_pool pool, ABT_unit unit);
+static int pool_remove_private(ABT_pool pool, ABT_unit unit);
+static ABT_bool pool_unit_is_in_pool(ABT_unit unit);
+
+struct data {
+    ABTD_spinlock mutex;
+    ABTI_thread *p_root;   /* Root of the heap of ULTs with a deadline */
+    thread_queue_t queue;  /* Work units without a deadline */
+    /* Read without the lock by pool_is_empty() and by schedulers that look
+     * for the most urgent ULT among pools. */
+    ABTD_atomic_size num_threads;
+    ABTD_atomic_uint64 min_deadline; /* Bits of the deadline of p_root */
+};
+typedef struct data data_t;
+
+static inline data_t *pool_get_data_ptr(void *p_data)
+{
+    return (data_t *)p_data;
+}
+
+static inline uint64_t deadline_to_bits(double deadline)
+{
+    uint64_t bits;
+    memcpy(&bits, &deadline, sizeof(bits));
+    return bits;
+}
+
+static inline double deadline_from_bits(uint64_t bits)
+{
+    double deadline;
+    memcpy(&deadline, &bits, sizeof(deadline));
+    return deadline;
+}
+
+static inline ABTI_thread *heap_meld(ABTI_thread *p_a, ABTI_thread *p_b)
+{
+    if (!p_a)
+        return p_b;
+    if (!p_b)
+        return p_a;
+    if (p_b->deadline < p_a->deadline) {
+        ABTI_thread *p_tmp = p_a;
+        p_a = p_b;
+        p_b = p_tmp;
+    }
+    /* p_b becomes the first child of p_a. */
+    p_b->p_next = p_a->p_prev;
+    p_a->p_prev = p_b;
+    return p_a;
+}
+
+static inline ABTI_thread *heap_pop(ABTI_thread *p_root)
+{
+    /* Two-pass pairing: meld the children in pairs from left to right, then
+     * meld the pairs from right to left.  The first pass links the pairs in
+     * reverse order through p_next. */
+    ABTI_thread *p_child = p_root->p_prev, *p_pairs = NULL;
+    while (p_child) {
+        ABTI_thread *p_a = p_child, *p_b = p_child->p_next;
+        if (!p_b) {
+            p_a->p_next = p_pairs;
+            p_pairs = p_a;
+            break;
+        }
+        p_child = p_b->p_next;
+        p_a->p_next = NULL;
+        p_b->p_next = NULL;
+        ABTI_thread *p_pair = heap_meld(p_a, p_b);
+        p_pair->p_next = p_pairs;
+        p_pairs = p_pair;
+    }
+    ABTI_thread *p_new_root = NULL;
+    while (p_pairs) {
+        ABTI_thread *p_next = p_pairs->p_next;
+        p_pairs->p_next = NULL;
+        p_new_root = heap_meld(p_new_root, p_pairs);
+        p_pairs = p_next;
+    }
+    return p_new_root;
+}
+
+static inline void data_update_min_deadline(data_t *p_data)
+{
+    double deadline =
+        p_data->p_root ? p_data->p_root->deadline : ABTI_THREAD_NO_DEADLINE;
+    ABTD_atomic_relaxed_store_uint64(&p_data->min_deadline,
+                                     deadline_to_bits(deadline));
+}
+
+static inline void data_push(data_t *p_data, ABTI_thread *p_thread)
+{
+    if (p_thread->deadline == ABTI_THREAD_NO_DEADLINE) {
+        thread_queue_push_tail(&p_data->queue, p_thread);
+    } else {
+        p_thread->p_prev = NULL;
+        p_thread->p_next = NULL;
+        p_data->p_root = heap_meld(p_data->p_root, p_thread);
+        data_update_min_deadline(p_data);
+        ABTD_atomic_release_store_int(&p_thread->is_in_pool, 1);
+    }
+    size_t num_threads =
+        ABTD_atomic_relaxed_load_size(&p_data->num_threads) + 1;
+    ABTD_atomic_release_store_size(&p_data->num_threads, num_threads);
+}
+
+static inline ABTI_thread *data_pop(data_t *p_data)
+{
+    ABTI_thread *p_thread = p_data->p_root;
+    if (p_thread) {
+        p_data->p_root = heap_pop(p_thread);
+        data_update_min_deadline(p_data);
+        p_thread->p_prev = NULL;
+        p_thread->p_next = NULL;
+        ABTD_atomic_release_store_int(&p_thread->is_in_pool, 0);
+    } else {
+        p_thread = thread_queue_pop_head(&p_data->queue);
+        if (!p_thread)
+            return NULL;
+    }
+    size_t num_threads =
+        ABTD_atomic_relaxed_load_size(&p_data->num_threads) - 1;
+    ABTD_atomic_release_store_size(&p_data->num_threads, num_threads);
+    return p_thread;
+}
+
+/* A ULT in the heap is removed by popping the ULTs before it and melding them
+ * back, so removing an urgent ULT is cheap. */
+ABTU_ret_err static inline int data_remove(data_t *p_data,
+                                           ABTI_thread *p_thread)
+{
+    if (p_thread->deadline == ABTI_THREAD_NO_DEADLINE) {
+        int abt_errno = thread_queue_remove(&p_data->queue, p_thread);
+        ABTI_CHECK_ERROR(abt_errno);
+    } else {
+        int is_in_pool = ABTD_atomic_acquire_load_int(&p_thread->is_in_pool);
+        ABTI_CHECK_TRUE(is_in_pool == 1, ABT_ERR_POOL);
+        ABTI_thread *p_cur, *p_popped = NULL;
+        while ((p_cur = p_data->p_root) != NULL && p_cur != p_thread) {
+            p_data->p_root = heap_pop(p_cur);
+            p_cur->p_prev = NULL;
+            p_cur->p_next = p_popped;
+            p_popped = p_cur;
+        }
+        if (p_cur)
+            p_data->p_root = heap_pop(p_cur);
+        while (p_popped) {
+            ABTI_thread *p_next = p_popped->p_next;
+            p_popped->p_next = NULL;
+            p_data->p_root = heap_meld(p_data->p_root, p_popped);
+            p_popped = p_next;
+        }
+        data_update_min_deadline(p_data);
+        /* The ULT is in another pool. */
+        ABTI_CHECK_TRUE(p_cur, ABT_ERR_POOL);
+        p_thread->p_prev = NULL;
+        p_thread->p_next = NULL;
+        ABTD_atomic_release_store_int(&p_thread->is_in_pool, 0);
+    }
+    size_t num_threads =
+        ABTD_atomic_relaxed_load_size(&p_data->num_threads) - 1;
+    ABTD_atomic_release_store_size(&p_data->num_threads, num_threads);
+    return ABT_SUCCESS;
+}
+
+/* Obtain the EDF pool definition according to the access type */
+ABTU_ret_err int
+ABTI_pool_get_edf_def(ABT_pool_access access,
+                      ABTI_pool_required_def *p_required_def,
+                      ABTI_pool_optional_def *p_optional_def,
+                      ABTI_pool_deprecated_def *p_deprecated_def)
+{
+    /* Definitions according to the access type */
+    switch (access) {
+        case ABT_POOL_ACCESS_PRIV:
+            p_required_def->p_push = pool_push_private;
+            p_required_def->p_pop = pool_pop_private;
+            p_deprecated_def->p_remove = pool_remove_private;
+            break;
+
+        case ABT_POOL_ACCESS_SPSC:
+        case ABT_POOL_ACCESS_MPSC:
+        case ABT_POOL_ACCESS_SPMC:
+        case ABT_POOL_ACCESS_MPMC:
+            p_required_def->p_push = pool_push_shared;
+            p_required_def->p_pop = pool_pop_shared;
+            p_deprecated_def->p_remove = pool_remove_shared;
+            break;
+
+        default:
+            ABTI_HANDLE_ERROR(ABT_ERR_INV_POOL_ACCESS);
+    }
+
+    /* Common definitions regardless of the access type */
+    p_optional_def->p_init = pool_init;
+    p_optional_def->p_free = pool_free;
+    p_required_def->p_is_empty = pool_is_empty;
+    p_optional_def->p_get_size = pool_get_size;
+    p_optional_def->p_pop_wait = pool_pop_wait;
+    p_optional_def->p_print_all = pool_print_all;
+    p_required_def->p_create_unit = pool_create_unit;
+    p_required_def->p_free_unit = pool_free_unit;
+
+    p_deprecated_def->p_pop_timedwait = pool_pop_timedwait;
+    p_deprecated_def->u_is_in_pool = pool_unit_is_in_pool;
+    return ABT_SUCCESS;
+}
+
+ABT_bool ABTI_pool_is_edf(ABTI_pool *p_pool)
+{
+    return p_pool->required_def.p_is_empty == pool_is_empty ? ABT_TRUE
+                                                            : ABT_FALSE;
+}
+
+/* Returns the earliest deadline in an EDF pool without taking its lock, or
+ * ABTI_THREAD_NO_DEADLINE if no ULT in the pool has a deadline. */
+double ABTI_pool_edf_get_min_deadline(ABTI_pool *p_pool)
+{
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    return deadline_from_bits(
+        ABTD_atomic_relaxed_load_uint64(&p_data->min_deadline));
+}
+
+/* Pool functions */
+
+static int pool_init(ABT_pool pool, ABT_pool_config config)
+{
+    ABTI_UNUSED(config);
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+
+    data_t *p_data;
+    int abt_errno = ABTU_malloc(sizeof(data_t), (void **)&p_data);
+    ABTI_CHECK_ERROR(abt_errno);
+
+    ABTD_spinlock_clear(&p_data->mutex);
+    p_data->p_root = NULL;
+    thread_queue_init(&p_data->queue);
+    ABTD_atomic_relaxed_store_size(&p_data->num_threads, 0);
+    data_update_min_deadline(p_data);
+
+    p_pool->data = p_data;
+    return ABT_SUCCESS;
+}
+
+static void pool_free(ABT_pool pool)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    thread_queue_free(&p_data->queue);
+    ABTU_free(p_data);
+}
+
+static ABT_bool pool_is_empty(ABT_pool pool)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    return ABTD_atomic_acquire_load_size(&p_data->num_threads) ? ABT_FALSE
+                                                               : ABT_TRUE;
+}
+
+static size_t pool_get_size(ABT_pool pool)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    return ABTD_atomic_acquire_load_size(&p_data->num_threads);
+}
+
+static void pool_push_shared(ABT_pool pool, ABT_unit unit,
+                             ABT_pool_context context)
+{
+    (void)context;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    ABTI_thread *p_thread = ABTI_unit_get_thread_from_builtin_unit(unit);
+    ABTD_spinlock_acquire(&p_data->mutex);
+    data_push(p_data, p_thread);
+    ABTD_spinlock_release(&p_data->mutex);
+}
+
+static void pool_push_private(ABT_pool pool, ABT_unit unit,
+                              ABT_pool_context context)
+{
+    (void)context;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    ABTI_thread *p_thread = ABTI_unit_get_thread_from_builtin_unit(unit);
+    data_push(p_data, p_thread);
+}
+
+static ABT_thread pool_pop_shared(ABT_pool pool, ABT_pool_context context)
+{
+    (void)context;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    if (ABTD_atomic_acquire_load_size(&p_data->num_threads) == 0)
+        return ABT_THREAD_NULL;
+    ABTD_spinlock_acquire(&p_data->mutex);
+    ABTI_thread *p_thread = data_pop(p_data);
+    ABTD_spinlock_release(&p_data->mutex);
+    return ABTI_thread_get_handle(p_thread);
+}
+
+static ABT_thread pool_pop_private(ABT_pool pool, ABT_pool_context context)
+{
+    (void)context;
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    return ABTI_thread_get_handle(data_pop(p_data));
+}
+
+static ABT_thread pool_pop_wait(ABT_pool pool, double time_secs,
+                                ABT_pool_context context)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    double time_start = 0.0;
+    while (1) {
+        ABT_thread thread = p_pool->required_def.p_pop(pool, context);
+        if (thread != ABT_THREAD_NULL)
+            return thread;
+        if (time_start == 0.0) {
+            time_start = ABTI_get_wtime();
+        } else {
+            double elapsed = ABTI_get_wtime() - time_start;
+            if (elapsed > time_secs)
+                return ABT_THREAD_NULL;
+        }
+        /* Sleep. */
+        const int sleep_nsecs = 100;
+        struct timespec ts = { 0, sleep_nsecs };
+        nanosleep(&ts, NULL);
+    }
+}
+
+static ABT_unit pool_pop_timedwait(ABT_pool pool, double abstime_secs)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    while (1) {
+        ABT_thread thread =
+            p_pool->required_def.p_pop(pool, ABT_POOL_CONTEXT_OP_POOL_OTHER);
+        if (thread != ABT_THREAD_NULL) {
+            return ABTI_unit_get_builtin_unit(ABTI_thread_get_ptr(thread));
+        }
+        const int sleep_nsecs = 100;
+        struct timespec ts = { 0, sleep_nsecs };
+        nanosleep(&ts, NULL);
+
+        if (ABTI_get_wtime() > abstime_secs)
+            return ABT_UNIT_NULL;
+    }
+}
+
+static int pool_remove_shared(ABT_pool pool, ABT_unit unit)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    ABTI_thread *p_thread = ABTI_unit_get_thread_from_builtin_unit(unit);
+    ABTD_spinlock_acquire(&p_data->mutex);
+    int abt_errno = data_remove(p_data, p_thread);
+    ABTD_spinlock_release(&p_data->mutex);
+    return abt_errno;
+}
+
+static int pool_remove_private(ABT_pool pool, ABT_unit unit)
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+    ABTI_thread *p_thread = ABTI_unit_get_thread_from_builtin_unit(unit);
+    return data_remove(p_data, p_thread);
+}
+
+static void pool_print_all(ABT_pool pool, void *arg,
+                           void (*print_fn)(void *, ABT_thread))
+{
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    data_t *p_data = pool_get_data_ptr(p_pool->data);
+
+    if (p_pool->access != ABT_POOL_ACCESS_PRIV) {
+        ABTD_spinlock_acquire(&p_data->mutex);
+    }
+    /* Print the ULTs in deadline order by taking them out of the heap. */
+    ABTI_thread *p_sorted = NULL, *p_thread;
+    while ((p_thread = p_data->p_root) != NULL) {
+        p_data->p_root = heap_pop(p_thread);
+        print_fn(arg, ABTI_thread_get_handle(p_thread));
+        p_thread->p_next = p_sorted;
+        p_sorted = p_thread;
+    }
+    while (p_sorted) {
+        p_thread = p_sorted;
+        p_sorted = p_sorted->p_next;
+        p_thread->p_prev = NULL;
+        p_thread->p_next = NULL;
+        p_data->p_root = heap_meld(p_data->p_root, p_thread);
+    }
+    thread_queue_print_all(&p_data->queue, arg, print_fn);
+    if (p_pool->access != ABT_POOL_ACCESS_PRIV) {
+        ABTD_spinlock_release(&p_data->mutex);
+    }
+}
+
+/* Unit functions */
+
+static ABT_bool pool_unit_is_in_pool(ABT_unit unit)
+{
+    ABTI_thread *p_thread = ABTI_unit_get_thread_from_builtin_unit(unit);
+    return ABTD_atomic_acquire_load_int(&p_thread->is_in_pool) ? ABT_TRUE
+                                                               : ABT_FALSE;
+}
+
+static ABT_unit pool_create_unit(ABT_pool pool, ABT_thread thread)
+{
+    /* Call ABTI_unit_init_builtin() instead. */
+    ABTI_ASSERT(0);
+    return ABT_UNIT_NULL;
+}
+
+static void pool_free_unit(ABT_pool pool, ABT_unit unit)
+{
+    /* A built-in unit does not need to be freed.  This function may not be
+     * called. */
+    ABTI_ASSERT(0);
+}
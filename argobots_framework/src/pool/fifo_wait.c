@@ -5,6 +5,7 @@
 
 #include "abti.h"
 #include "thread_queue.h"
+#include <time.h>
 
 /* FIFO_WAIT pool implementation */
 
@@ -31,10 +32,17 @@ static int pool_remove(ABT_pool pool, ABT_unit unit);
 static ABT_unit pool_pop_timedwait(ABT_pool pool, double abstime_secs);
 static ABT_bool pool_unit_is_in_pool(ABT_unit unit);
 
+/* A consumer that finds the pool empty sleeps on futex.  Since num_sleepers is
+ * incremented while mutex is taken, a producer that pushes a thread while
+ * taking mutex always sees the sleeper.  A push issues a wake-up only if
+ * num_sleepers is not zero. */
 struct data {
-    pthread_mutex_t mutex;
-    pthread_cond_t cond;
+    ABTD_spinlock mutex;
     thread_queue_t queue;
+    ABTD_atomic_int num_sleepers;
+#ifndef ABT_CONFIG_ACTIVE_WAIT_POLICY
+    ABTD_futex_multiple futex;
+#endif
 };
 typedef struct data data_t;
 
@@ -68,30 +76,79 @@ ABTI_pool_get_fifo_wait_def(ABT_pool_access access,
     return ABT_SUCCESS;
 }
 
+/* Internal functions */
+
+/* Release mutex and wake up sleepers for num_threads new threads. */
+static inline void pool_unlock_and_wake(data_t *p_data, size_t num_threads)
+{
+#ifndef ABT_CONFIG_ACTIVE_WAIT_POLICY
+    int num_sleepers = ABTD_atomic_relaxed_load_int(&p_data->num_sleepers);
+    if (num_sleepers > 0) {
+        ABTD_futex_wake_and_unlock(&p_data->futex, &p_data->mutex,
+                                   num_threads < (size_t)num_sleepers
+                                       ? (int)num_threads
+                                       : num_sleepers);
+        return;
+    }
+#else
+    ABTI_UNUSED(num_threads);
+#endif
+    ABTD_spinlock_release(&p_data->mutex);
+}
+
+/* Pop a thread.  If the pool is empty, sleep until a thread is pushed or the
+ * time reaches abstime_secs. */
+static ABTI_thread *pool_pop_until(data_t *p_data, double abstime_secs)
+{
+    while (1) {
+        if (thread_queue_acquire_spinlock_if_not_empty(&p_data->queue,
+                                                       &p_data->mutex) == 0) {
+            ABTI_thread *p_thread = thread_queue_pop_head(&p_data->queue);
+            ABTD_spinlock_release(&p_data->mutex);
+            if (p_thread)
+                return p_thread;
+        }
+        double wait_time_sec = abstime_secs - ABTI_get_wtime();
+        if (wait_time_sec <= 0.0)
+            return NULL;
+#ifndef ABT_CONFIG_ACTIVE_WAIT_POLICY
+        ABTD_spinlock_acquire(&p_data->mutex);
+        if (!thread_queue_is_empty(&p_data->queue)) {
+            /* A thread has been pushed.  Pop it. */
+            ABTD_spinlock_release(&p_data->mutex);
+            continue;
+        }
+        ABTD_atomic_fetch_add_int(&p_data->num_sleepers, 1);
+        /* Spurious wakeup is fine since the loop checks the pool again. */
+        ABTD_futex_timedwait_and_unlock(&p_data->futex, &p_data->mutex,
+                                        wait_time_sec);
+        ABTD_atomic_fetch_sub_int(&p_data->num_sleepers, 1);
+#else
+        const int sleep_nsecs = 100;
+        struct timespec ts = { 0, sleep_nsecs };
+        nanosleep(&ts, NULL);
+#endif
+    }
+}
+
 /* Pool functions */
 
 static int pool_init(ABT_pool pool, ABT_pool_config config)
 {
     ABTI_UNUSED(config);
-    int ret, abt_errno = ABT_SUCCESS;
+    int abt_errno = ABT_SUCCESS;
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
 
     data_t *p_data;
     abt_errno = ABTU_malloc(sizeof(data_t), (void **)&p_data);
     ABTI_CHECK_ERROR(abt_errno);
 
-    ret = pthread_mutex_init(&p_data->mutex, NULL);
-    if (ret != 0) {
-        ABTU_free(p_data);
-        return ABT_ERR_SYS;
-    }
-    ret = pthread_cond_init(&p_data->cond, NULL);
-    if (ret != 0) {
-        pthread_mutex_destroy(&p_data->mutex);
-        ABTU_free(p_data);
-        return ABT_ERR_SYS;
-    }
+    ABTD_spinlock_clear(&p_data->mutex);
     thread_queue_init(&p_data->queue);
+    ABTD_atomic_relaxed_store_int(&p_data->num_sleepers, 0);
+#ifndef ABT_CONFIG_ACTIVE_WAIT_POLICY
+    ABTD_futex_multiple_init(&p_data->futex);
+#endif
 
     p_pool->data = p_data;
     return abt_errno;
@@ -102,8 +159,6 @@ static void pool_free(ABT_pool pool)
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
     data_t *p_data = pool_get_data_ptr(p_pool->data);
     thread_queue_free(&p_data->queue);
-    pthread_mutex_destroy(&p_data->mutex);
-    pthread_cond_destroy(&p_data->cond);
     ABTU_free(p_data);
 }
 
@@ -128,10 +183,9 @@ static void pool_push(ABT_pool pool, ABT_unit unit, ABT_pool_context context)
     data_t *p_data = pool_get_data_ptr(p_pool->data);
     ABTI_thread *p_thread = ABTI_unit_get_thread_from_builtin_unit(unit);
 
-    pthread_mutex_lock(&p_data->mutex);
+    ABTD_spinlock_acquire(&p_data->mutex);
     thread_queue_push_tail(&p_data->queue, p_thread);
-    pthread_cond_signal(&p_data->cond);
-    pthread_mutex_unlock(&p_data->mutex);
+    pool_unlock_and_wake(p_data, 1);
 }
 
 static void pool_push_many(ABT_pool pool, const ABT_unit *units,
@@ -142,21 +196,15 @@ static void pool_push_many(ABT_pool pool, const ABT_unit *units,
     data_t *p_data = pool_get_data_ptr(p_pool->data);
 
     if (num_units > 0) {
-        pthread_mutex_lock(&p_data->mutex);
+        ABTD_spinlock_acquire(&p_data->mutex);
         size_t i;
         for (i = 0; i < num_units; i++) {
             ABTI_thread *p_thread =
                 ABTI_unit_get_thread_from_builtin_unit(units[i]);
             thread_queue_push_tail(&p_data->queue, p_thread);
         }
-        if (num_units == 1) {
-            /* Wake up a single waiter. */
-            pthread_cond_signal(&p_data->cond);
-        } else {
-            /* Wake up all the waiters. */
-            pthread_cond_broadcast(&p_data->cond);
-        }
-        pthread_mutex_unlock(&p_data->mutex);
+        /* Wake up as many sleepers as needed at once. */
+        pool_unlock_and_wake(p_data, num_units);
     }
 }
 
@@ -166,57 +214,23 @@ static ABT_thread pool_pop_wait(ABT_pool pool, double time_secs,
     (void)context;
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
     data_t *p_data = pool_get_data_ptr(p_pool->data);
-    pthread_mutex_lock(&p_data->mutex);
-    if (thread_queue_is_empty(&p_data->queue)) {
-#if defined(ABT_CONFIG_USE_CLOCK_GETTIME)
-        struct timespec ts;
-        clock_gettime(CLOCK_REALTIME, &ts);
-        ts.tv_sec += (time_t)time_secs;
-        ts.tv_nsec += (long)((time_secs - (time_t)time_secs) * 1e9);
-        if (ts.tv_nsec > 1e9) {
-            ts.tv_sec += 1;
-            ts.tv_nsec -= 1e9;
-        }
-        pthread_cond_timedwait(&p_data->cond, &p_data->mutex, &ts);
-#else
-        /* We cannot use pthread_cond_timedwait().  Let's use nanosleep()
-         * instead */
-        double start_time = ABTI_get_wtime();
-        while (ABTI_get_wtime() - start_time < time_secs) {
-            pthread_mutex_unlock(&p_data->mutex);
-            const int sleep_nsecs = 100;
-            struct timespec ts = { 0, sleep_nsecs };
-            nanosleep(&ts, NULL);
-            pthread_mutex_lock(&p_data->mutex);
-            if (p_data->num_threads > 0)
-                break;
-        }
-#endif
+    if (thread_queue_acquire_spinlock_if_not_empty(&p_data->queue,
+                                                   &p_data->mutex) == 0) {
+        ABTI_thread *p_thread = thread_queue_pop_head(&p_data->queue);
+        ABTD_spinlock_release(&p_data->mutex);
+        if (p_thread)
+            return ABTI_thread_get_handle(p_thread);
     }
-    ABTI_thread *p_thread = thread_queue_pop_head(&p_data->queue);
-    pthread_mutex_unlock(&p_data->mutex);
+    ABTI_thread *p_thread =
+        pool_pop_until(p_data, ABTI_get_wtime() + time_secs);
     return ABTI_thread_get_handle(p_thread);
 }
 
-static inline void convert_double_sec_to_timespec(struct timespec *ts_out,
-                                                  double seconds)
-{
-    ts_out->tv_sec = (time_t)seconds;
-    ts_out->tv_nsec = (long)((seconds - ts_out->tv_sec) * 1000000000.0);
-}
-
 static ABT_unit pool_pop_timedwait(ABT_pool pool, double abstime_secs)
 {
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
     data_t *p_data = pool_get_data_ptr(p_pool->data);
-    pthread_mutex_lock(&p_data->mutex);
-    if (thread_queue_is_empty(&p_data->queue)) {
-        struct timespec ts;
-        convert_double_sec_to_timespec(&ts, abstime_secs);
-        pthread_cond_timedwait(&p_data->cond, &p_data->mutex, &ts);
-    }
-    ABTI_thread *p_thread = thread_queue_pop_head(&p_data->queue);
-    pthread_mutex_unlock(&p_data->mutex);
+    ABTI_thread *p_thread = pool_pop_until(p_data, abstime_secs);
     if (p_thread) {
         return ABTI_unit_get_builtin_unit(p_thread);
     } else {
@@ -229,10 +243,10 @@ static ABT_thread pool_pop(ABT_pool pool, ABT_pool_context context)
     (void)context;
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
     data_t *p_data = pool_get_data_ptr(p_pool->data);
-    if (!thread_queue_is_empty(&p_data->queue)) {
-        pthread_mutex_lock(&p_data->mutex);
+    if (thread_queue_acquire_spinlock_if_not_empty(&p_data->queue,
+                                                   &p_data->mutex) == 0) {
         ABTI_thread *p_thread = thread_queue_pop_head(&p_data->queue);
-        pthread_mutex_unlock(&p_data->mutex);
+        ABTD_spinlock_release(&p_data->mutex);
         return ABTI_thread_get_handle(p_thread);
     } else {
         return ABT_THREAD_NULL;
@@ -246,8 +260,9 @@ static void pool_pop_many(ABT_pool pool, ABT_thread *threads,
     (void)context;
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
     data_t *p_data = pool_get_data_ptr(p_pool->data);
-    if (max_threads != 0 && !thread_queue_is_empty(&p_data->queue)) {
-        pthread_mutex_lock(&p_data->mutex);
+    if (max_threads != 0 &&
+        thread_queue_acquire_spinlock_if_not_empty(&p_data->queue,
+                                                   &p_data->mutex) == 0) {
         size_t i;
         for (i = 0; i < max_threads; i++) {
             ABTI_thread *p_thread = thread_queue_pop_head(&p_data->queue);
@@ -256,7 +271,7 @@ static void pool_pop_many(ABT_pool pool, ABT_thread *threads,
             threads[i] = ABTI_thread_get_handle(p_thread);
         }
         *num_popped = i;
-        pthread_mutex_unlock(&p_data->mutex);
+        ABTD_spinlock_release(&p_data->mutex);
     } else {
         *num_popped = 0;
     }
@@ -272,9 +287,9 @@ static int pool_remove(ABT_pool pool, ABT_unit unit)
     ABTI_CHECK_TRUE(ABTD_atomic_acquire_load_int(&p_thread->is_in_pool) == 1,
                     ABT_ERR_POOL);
 
-    pthread_mutex_lock(&p_data->mutex);
+    ABTD_spinlock_acquire(&p_data->mutex);
     int abt_errno = thread_queue_remove(&p_data->queue, p_thread);
-    pthread_mutex_unlock(&p_data->mutex);
+    ABTD_spinlock_release(&p_data->mutex);
     return abt_errno;
 }
 
@@ -284,9 +299,9 @@ static void pool_print_all(ABT_pool pool, void *arg,
     ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
     data_t *p_data = pool_get_data_ptr(p_pool->data);
 
-    pthread_mutex_lock(&p_data->mutex);
+    ABTD_spinlock_acquire(&p_data->mutex);
     thread_queue_print_all(&p_data->queue, arg, print_fn);
-    pthread_mutex_unlock(&p_data->mutex);
+    ABTD_spinlock_release(&p_data->mutex);
 }
 
 /* Unit functions */
@@ -1269,6 +1269,91 @@ int ABT_pool_get_data(ABT_pool pool, void **data)
     return ABT_SUCCESS;
 }
 
+/**
+ * @ingroup POOL
+ * @brief   Set the preemptibility of a pool.
+ *
+ * \c ABT_pool_set_preemptible() sets the preemptibility of the pool \c pool.
+ * If \c preemptible is \c ABT_TRUE, ULTs that are created in \c pool
+ * afterward are preemptible (see \c ABT_thread_set_preemptible()).  This
+ * routine does not change the preemptibility of existing ULTs.
+ *
+ * A newly created pool is not preemptible.
+ *
+ * @contexts
+ * \DOC_CONTEXT_INIT \DOC_CONTEXT_NOCTXSWITCH
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_INV_POOL_HANDLE{\c pool}
+ * \DOC_ERROR_FEATURE_NA{the preemption feature}
+ *
+ * @undefined
+ * \DOC_UNDEFINED_UNINIT
+ * \DOC_UNDEFINED_BOOL{\c preemptible}
+ * \DOC_UNDEFINED_THREAD_UNSAFE{\c pool}
+ *
+ * @param[in] pool         pool handle
+ * @param[in] preemptible  preemptibility flag (\c ABT_TRUE: preemptible,
+ *                                              \c ABT_FALSE: not)
+ * @return Error code
+ */
+int ABT_pool_set_preemptible(ABT_pool pool, ABT_bool preemptible)
+{
+    ABTI_UB_ASSERT(ABTI_initialized());
+    ABTI_UB_ASSERT_BOOL(preemptible);
+
+#ifdef ABT_CONFIG_USE_PREEMPTION
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    ABTI_CHECK_NULL_POOL_PTR(p_pool);
+
+    p_pool->is_preemptible = preemptible;
+    return ABT_SUCCESS;
+#else
+    ABTI_HANDLE_ERROR(ABT_ERR_FEATURE_NA);
+#endif
+}
+
+/**
+ * @ingroup POOL
+ * @brief   Get the preemptibility of a pool.
+ *
+ * \c ABT_pool_is_preemptible() returns the preemptibility of the pool \c pool
+ * through \c is_preemptible.
+ *
+ * @contexts
+ * \DOC_CONTEXT_INIT \DOC_CONTEXT_NOCTXSWITCH
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_INV_POOL_HANDLE{\c pool}
+ * \DOC_ERROR_FEATURE_NA{the preemption feature}
+ *
+ * @undefined
+ * \DOC_UNDEFINED_UNINIT
+ * \DOC_UNDEFINED_NULL_PTR{\c is_preemptible}
+ *
+ * @param[in]  pool            pool handle
+ * @param[out] is_preemptible  result (\c ABT_TRUE: preemptible,
+ *                                     \c ABT_FALSE: not)
+ * @return Error code
+ */
+int ABT_pool_is_preemptible(ABT_pool pool, ABT_bool *is_preemptible)
+{
+    ABTI_UB_ASSERT(ABTI_initialized());
+    ABTI_UB_ASSERT(is_preemptible);
+
+#ifdef ABT_CONFIG_USE_PREEMPTION
+    ABTI_pool *p_pool = ABTI_pool_get_ptr(pool);
+    ABTI_CHECK_NULL_POOL_PTR(p_pool);
+
+    *is_preemptible = p_pool->is_preemptible;
+    return ABT_SUCCESS;
+#else
+    ABTI_HANDLE_ERROR(ABT_ERR_FEATURE_NA);
+#endif
+}
+
 /**
  * @ingroup POOL
  * @brief   Create a new work unit associated with a scheduler and push it to a
@@ -1416,6 +1501,10 @@ ABTU_ret_err int ABTI_pool_create_basic(ABT_pool_kind kind,
                 ABTI_pool_get_randws_def(access, &required_def, &optional_def,
                                          &deprecated_def);
             break;
+        case ABT_POOL_EDF:
+            abt_errno = ABTI_pool_get_edf_def(access, &required_def,
+                                              &optional_def, &deprecated_def);
+            break;
         default:
             abt_errno = ABT_ERR_INV_POOL_KIND;
             break;
@@ -1432,6 +1521,9 @@ ABTU_ret_err int ABTI_pool_create_basic(ABT_pool_kind kind,
 void ABTI_pool_free(ABTI_pool *p_pool)
 {
     ABT_pool h_pool = ABTI_pool_get_handle(p_pool);
+#ifdef ABT_CONFIG_USE_STATS
+    ABTI_stats_detach_pool(ABTI_global_get_global(), p_pool);
+#endif
     if (p_pool->optional_def.p_free) {
         p_pool->optional_def.p_free(h_pool);
     }
@@ -1445,12 +1537,15 @@ ABT_thread ABTI_pool_pop_timedwait(ABTI_pool *p_pool, double abstime_secs)
         p_pool->deprecated_def.p_pop_timedwait(ABTI_pool_get_handle(p_pool),
                                                abstime_secs);
     if (unit == ABT_UNIT_NULL) {
+        STATS_POOL_POP(p_pool, ABT_THREAD_NULL, ABT_POOL_CONTEXT_OWNER_PRIMARY);
         return ABT_THREAD_NULL;
     } else {
         ABTI_thread *p_thread =
             ABTI_unit_get_thread(ABTI_global_get_global(), unit);
         ABT_thread thread = ABTI_thread_get_handle(p_thread);
         LOG_DEBUG_POOL_POP(p_pool, thread);
+        TRACE_POOL_POP(p_pool, thread);
+        STATS_POOL_POP(p_pool, thread, ABT_POOL_CONTEXT_OWNER_PRIMARY);
         return thread;
     }
 }
@@ -1711,6 +1806,9 @@ pool_create(ABT_pool_access access,
     ABTD_atomic_release_store_int32(&p_pool->num_scheds, 0);
     ABTD_atomic_release_store_int32(&p_pool->num_blocked, 0);
     p_pool->data = NULL;
+#ifdef ABT_CONFIG_USE_PREEMPTION
+    p_pool->is_preemptible = ABT_FALSE;
+#endif
     memcpy(&p_pool->required_def, p_required_def,
            sizeof(ABTI_pool_required_def));
     if (p_optional_def) {
@@ -1731,6 +1829,9 @@ pool_create(ABT_pool_access access,
         memset(&p_pool->old_def, 0, sizeof(ABTI_pool_old_def));
     }
     p_pool->id = pool_get_new_id();
+#ifdef ABT_CONFIG_USE_STATS
+    ABTI_stats_attach_pool(ABTI_global_get_global(), p_pool);
+#endif
 
     /* Configure the pool */
     if (p_pool->optional_def.p_init) {
@@ -1738,6 +1839,9 @@ pool_create(ABT_pool_access access,
         abt_errno =
             p_pool->optional_def.p_init(ABTI_pool_get_handle(p_pool), config);
         if (abt_errno != ABT_SUCCESS) {
+#ifdef ABT_CONFIG_USE_STATS
+            ABTI_stats_detach_pool(ABTI_global_get_global(), p_pool);
+#endif
             ABTU_free(p_pool);
             return abt_errno;
         }
@@ -0,0 +1,304 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#define _GNU_SOURCE
+#include "abti.h"
+
+#ifdef ABT_CONFIG_USE_PREEMPTION
+
+#include <errno.h>
+#include <signal.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <link.h>
+#include <sys/syscall.h>
+#ifdef HAVE_GETAUXVAL
+#include <sys/auxv.h>
+#endif
+
+/*
+ * Preemption of long-running ULTs.
+ *
+ * Every ES owns a POSIX timer that sends ABTI_PREEMPTION_SIGNAL to the OS
+ * thread of that ES every quantum.  The signal handler runs on the stack of
+ * the interrupted ULT.  If the same preemptible ULT is found running at two
+ * consecutive ticks and the interrupted instruction is at a safe point, the
+ * handler yields the ULT in the same way as ABT_self_yield(): the ULT is pushed
+ * back to its pool and the scheduler resumes.  The handler frame stays on the
+ * stack of the ULT, and the handler returns when the ULT is scheduled again.
+ *
+ * An instruction is at a safe point if it belongs to neither Argobots nor the
+ * C library, the threading library, the memory allocator, or the dynamic
+ * linker.  Yielding in the middle of them could leave a runtime lock or an
+ * allocator lock held by a ULT that is no longer running.
+ */
+
+/* SIGURG is ignored by default, so a signal that is delivered after the timer
+ * is deleted is harmless. */
+#define ABTI_PREEMPTION_SIGNAL SIGURG
+#define PREEMPTION_MAX_RANGES 32
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__) ||        \
+    defined(__powerpc64__)
+#define PREEMPTION_HAVE_PC 1
+#else
+#define PREEMPTION_HAVE_PC 0
+#endif
+
+typedef struct {
+    uintptr_t start; /* Inclusive */
+    uintptr_t end;   /* Exclusive */
+} preemption_range;
+
+typedef struct {
+    uintptr_t probes[4];   /* Functions of the objects to be protected. */
+    uintptr_t ldso_base;   /* Load address of the dynamic linker. */
+    ABT_bool is_abt_in_exe; /* Whether Argobots is in the executable. */
+} preemption_search_arg;
+
+static int g_num_ranges = 0;
+static preemption_range g_ranges[PREEMPTION_MAX_RANGES];
+static struct sigaction g_old_action;
+
+static int preemption_find_ranges(struct dl_phdr_info *p_info, size_t size,
+                                  void *arg);
+static void preemption_signal_handler(int sig, siginfo_t *p_info,
+                                      void *p_ucontext);
+
+/*****************************************************************************/
+/* Private APIs                                                              */
+/*****************************************************************************/
+
+void ABTI_preemption_init(ABTI_global *p_global)
+{
+    p_global->preemption_enabled = ABT_FALSE;
+    if (p_global->preemption_interval_usec == 0)
+        return;
+    if (!PREEMPTION_HAVE_PC) {
+        fprintf(stderr, "ABT_PREEMPTION_INTERVAL_USEC: preemption is not "
+                        "supported on this architecture.\n");
+        return;
+    }
+
+    /* Find the code that must not be interrupted by a context switch.  The
+     * first probe must be a function of Argobots. */
+    preemption_search_arg search_arg;
+    search_arg.probes[0] = (uintptr_t)ABTI_preemption_init;
+    search_arg.probes[1] = (uintptr_t)malloc;
+    search_arg.probes[2] = (uintptr_t)fprintf;
+    search_arg.probes[3] = (uintptr_t)pthread_mutex_lock;
+#ifdef HAVE_GETAUXVAL
+    search_arg.ldso_base = (uintptr_t)getauxval(AT_BASE);
+#else
+    search_arg.ldso_base = 0;
+#endif
+    search_arg.is_abt_in_exe = ABT_FALSE;
+    g_num_ranges = 0;
+    dl_iterate_phdr(preemption_find_ranges, &search_arg);
+    if (search_arg.is_abt_in_exe || g_num_ranges == 0) {
+        /* Argobots cannot be told apart from the application. */
+        fprintf(stderr, "ABT_PREEMPTION_INTERVAL_USEC: preemption requires "
+                        "Argobots to be linked as a shared library.\n");
+        return;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = preemption_signal_handler;
+    sa.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(ABTI_PREEMPTION_SIGNAL, &sa, &g_old_action) != 0)
+        return;
+    p_global->preemption_enabled = ABT_TRUE;
+}
+
+void ABTI_preemption_finalize(ABTI_global *p_global)
+{
+    if (p_global->preemption_enabled) {
+        sigaction(ABTI_PREEMPTION_SIGNAL, &g_old_action, NULL);
+        p_global->preemption_enabled = ABT_FALSE;
+    }
+}
+
+/* This function must be called by the OS thread that runs p_xstream. */
+void ABTI_preemption_start_xstream(ABTI_global *p_global,
+                                   ABTI_xstream *p_xstream)
+{
+    p_xstream->p_preemption_last = NULL;
+    if (!p_global->preemption_enabled || p_xstream->has_preemption_timer)
+        return;
+
+    struct sigevent sev;
+    memset(&sev, 0, sizeof(sev));
+    sev.sigev_notify = SIGEV_THREAD_ID;
+    sev.sigev_signo = ABTI_PREEMPTION_SIGNAL;
+    sev.sigev_notify_thread_id = (pid_t)syscall(SYS_gettid);
+    timer_t timer;
+    if (timer_create(CLOCK_MONOTONIC, &sev, &timer) != 0) {
+        /* ULTs on this ES are not preempted. */
+        return;
+    }
+    uint64_t interval_usec = p_global->preemption_interval_usec;
+    struct itimerspec its;
+    its.it_interval.tv_sec = (time_t)(interval_usec / 1000000);
+    its.it_interval.tv_nsec = (long)(interval_usec % 1000000) * 1000;
+    its.it_value = its.it_interval;
+    if (timer_settime(timer, 0, &its, NULL) != 0) {
+        timer_delete(timer);
+        return;
+    }
+    p_xstream->preemption_timer = timer;
+    p_xstream->has_preemption_timer = ABT_TRUE;
+}
+
+void ABTI_preemption_stop_xstream(ABTI_xstream *p_xstream)
+{
+    if (p_xstream->has_preemption_timer) {
+        timer_delete(p_xstream->preemption_timer);
+        p_xstream->has_preemption_timer = ABT_FALSE;
+    }
+}
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+static inline uintptr_t preemption_get_pc(void *p_ucontext)
+{
+    ucontext_t *p_uc = (ucontext_t *)p_ucontext;
+#if defined(__x86_64__)
+    return (uintptr_t)p_uc->uc_mcontext.gregs[REG_RIP];
+#elif defined(__i386__)
+    return (uintptr_t)p_uc->uc_mcontext.gregs[REG_EIP];
+#elif defined(__aarch64__)
+    return (uintptr_t)p_uc->uc_mcontext.pc;
+#elif defined(__powerpc64__)
+    return (uintptr_t)p_uc->uc_mcontext.gp_regs[32]; /* PT_NIP */
+#else
+    ABTI_UNUSED(p_uc);
+    return 0;
+#endif
+}
+
+static inline ABT_bool preemption_is_safe_pc(uintptr_t pc)
+{
+    int i;
+    for (i = 0; i < g_num_ranges; i++) {
+        if (g_ranges[i].start <= pc && pc < g_ranges[i].end)
+            return ABT_FALSE;
+    }
+    return ABT_TRUE;
+}
+
+static ABT_bool preemption_is_libc_name(const char *name)
+{
+    /* Used when a probe resolves to a PLT entry of the executable. */
+    const char *basename = strrchr(name, '/');
+    basename = basename ? basename + 1 : name;
+    return (strncmp(basename, "libc.so", 7) == 0 ||
+            strncmp(basename, "libc-", 5) == 0 ||
+            strncmp(basename, "libpthread", 10) == 0 ||
+            strncmp(basename, "ld-linux", 8) == 0 ||
+            strncmp(basename, "ld64.so", 7) == 0)
+               ? ABT_TRUE
+               : ABT_FALSE;
+}
+
+static int preemption_find_ranges(struct dl_phdr_info *p_info, size_t size,
+                                  void *arg)
+{
+    ABTI_UNUSED(size);
+    preemption_search_arg *p_arg = (preemption_search_arg *)arg;
+    /* The executable is the object that has no name. */
+    ABT_bool is_exe = (!p_info->dlpi_name || p_info->dlpi_name[0] == '\0')
+                          ? ABT_TRUE
+                          : ABT_FALSE;
+    ABT_bool is_target = (!is_exe && (p_info->dlpi_addr == p_arg->ldso_base ||
+                                      preemption_is_libc_name(
+                                          p_info->dlpi_name)))
+                             ? ABT_TRUE
+                             : ABT_FALSE;
+    int i, j;
+    for (i = 0; i < p_info->dlpi_phnum && !is_target; i++) {
+        const ElfW(Phdr) *p_phdr = &p_info->dlpi_phdr[i];
+        if (p_phdr->p_type != PT_LOAD || !(p_phdr->p_flags & PF_X))
+            continue;
+        uintptr_t start = p_info->dlpi_addr + p_phdr->p_vaddr;
+        uintptr_t end = start + p_phdr->p_memsz;
+        for (j = 0; j < 4; j++) {
+            if (start <= p_arg->probes[j] && p_arg->probes[j] < end) {
+                if (!is_exe) {
+                    is_target = ABT_TRUE;
+                } else if (j == 0) {
+                    /* Argobots is statically linked. */
+                    p_arg->is_abt_in_exe = ABT_TRUE;
+                }
+            }
+        }
+    }
+    if (!is_target)
+        return 0;
+    for (i = 0; i < p_info->dlpi_phnum; i++) {
+        const ElfW(Phdr) *p_phdr = &p_info->dlpi_phdr[i];
+        if (p_phdr->p_type != PT_LOAD || !(p_phdr->p_flags & PF_X))
+            continue;
+        if (g_num_ranges == PREEMPTION_MAX_RANGES)
+            return 1;
+        uintptr_t start = p_info->dlpi_addr + p_phdr->p_vaddr;
+        g_ranges[g_num_ranges].start = start;
+        g_ranges[g_num_ranges].end = start + p_phdr->p_memsz;
+        g_num_ranges++;
+    }
+    return 0;
+}
+
+static void preemption_signal_handler(int sig, siginfo_t *p_info,
+                                      void *p_ucontext)
+{
+    ABTI_UNUSED(sig);
+    ABTI_UNUSED(p_info);
+    int saved_errno = errno;
+    ABTI_xstream *p_local_xstream =
+        ABTI_local_get_xstream_or_null(ABTI_local_get_local());
+    if (!p_local_xstream)
+        goto DONE;
+    ABTI_thread *p_thread = p_local_xstream->p_thread;
+    if (!p_thread || !(p_thread->type & ABTI_THREAD_TYPE_PREEMPTIBLE)) {
+        p_local_xstream->p_preemption_last = NULL;
+        goto DONE;
+    }
+    if (p_local_xstream->p_preemption_last != p_thread) {
+        /* p_thread has not run for a full quantum yet. */
+        p_local_xstream->p_preemption_last = p_thread;
+        goto DONE;
+    }
+    if (!preemption_is_safe_pc(preemption_get_pc(p_ucontext))) {
+        /* Try again at the next tick. */
+        goto DONE;
+    }
+    p_local_xstream->p_preemption_last = NULL;
+    p_local_xstream->num_preemptions++;
+
+    /* The signal is blocked while this handler runs.  Unblock it so that the
+     * scheduler and the next ULTs can be preempted; the original mask is
+     * restored when this ULT returns from the handler. */
+    sigset_t sigset;
+    sigemptyset(&sigset);
+    sigaddset(&sigset, ABTI_PREEMPTION_SIGNAL);
+    pthread_sigmask(SIG_UNBLOCK, &sigset, NULL);
+
+    ABTI_ythread *p_ythread = ABTI_thread_get_ythread(p_thread);
+    ABTI_ythread_yield(&p_local_xstream, p_ythread,
+                       ABTI_YTHREAD_YIELD_KIND_USER, ABT_SYNC_EVENT_TYPE_OTHER,
+                       NULL);
+DONE:
+    errno = saved_errno;
+}
+
+#endif /* ABT_CONFIG_USE_PREEMPTION */
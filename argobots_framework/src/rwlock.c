@@ -5,6 +5,11 @@
 
 #include "abti.h"
 
+static inline void rwlock_leave_reader(ABTI_local *p_local,
+                                       ABTI_rwlock *p_rwlock,
+                                       ABTI_rwlock_reader *p_reader);
+static inline int rwlock_count_readers(ABTI_rwlock *p_rwlock);
+
 /** @defgroup RWLOCK Readers-Writer Lock
  * A Readers writer lock allows concurrent access for readers and exclusionary
  * access for writers.
@@ -51,10 +56,31 @@ int ABT_rwlock_create(ABT_rwlock *newrwlock)
     int abt_errno = ABTU_malloc(sizeof(ABTI_rwlock), (void **)&p_newrwlock);
     ABTI_CHECK_ERROR(abt_errno);
 
-    ABTI_mutex_init(&p_newrwlock->mutex);
-    ABTI_cond_init(&p_newrwlock->cond);
-    p_newrwlock->reader_count = 0;
-    p_newrwlock->write_flag = 0;
+    /* One reader indicator per core or per ES, whichever is larger.  ESs
+     * created later share the indicators by rank. */
+    ABTI_global *p_global = ABTI_global_get_global();
+    int num_readers = ABTU_max_int(p_global->num_cores, p_global->max_xstreams);
+    num_readers = ABTU_max_int(num_readers, 1);
+    ABTI_rwlock_reader *p_readers;
+    abt_errno = ABTU_memalign(ABT_CONFIG_STATIC_CACHELINE_SIZE,
+                              sizeof(ABTI_rwlock_reader) * num_readers,
+                              (void **)&p_readers);
+    if (ABTI_IS_ERROR_CHECK_ENABLED && abt_errno != ABT_SUCCESS) {
+        ABTU_free(p_newrwlock);
+        ABTI_HANDLE_ERROR(abt_errno);
+    }
+    int i;
+    for (i = 0; i < num_readers; i++) {
+        ABTD_atomic_relaxed_store_int(&p_readers[i].count, 0);
+    }
+
+    ABTD_atomic_relaxed_store_int(&p_newrwlock->state,
+                                  ABTI_RWLOCK_STATE_READ_BIAS);
+    p_newrwlock->num_readers = num_readers;
+    p_newrwlock->p_readers = p_readers;
+    ABTD_spinlock_clear(&p_newrwlock->lock);
+    ABTI_waitlist_init(&p_newrwlock->waitlist);
+    ABTI_waitlist_init(&p_newrwlock->drain_waitlist);
 
     /* Return value */
     *newrwlock = ABTI_rwlock_get_handle(p_newrwlock);
@@ -96,7 +122,11 @@ int ABT_rwlock_free(ABT_rwlock *rwlock)
     ABTI_rwlock *p_rwlock = ABTI_rwlock_get_ptr(h_rwlock);
     ABTI_CHECK_NULL_RWLOCK_PTR(p_rwlock);
 
-    ABTI_cond_fini(&p_rwlock->cond);
+    /* The lock must not be held by anyone. */
+    ABTI_UB_ASSERT(ABTD_atomic_relaxed_load_int(&p_rwlock->state) ==
+                   ABTI_RWLOCK_STATE_READ_BIAS);
+    ABTI_UB_ASSERT(ABTI_waitlist_is_empty(&p_rwlock->waitlist));
+    ABTU_free(p_rwlock->p_readers);
     ABTU_free(p_rwlock);
 
     /* Return value */
@@ -159,17 +189,30 @@ int ABT_rwlock_rdlock(ABT_rwlock rwlock)
     }
 #endif
 
-    ABTI_mutex_lock(&p_local, &p_rwlock->mutex);
-    int abt_errno = ABT_SUCCESS;
-    while (p_rwlock->write_flag && abt_errno == ABT_SUCCESS) {
-        abt_errno = ABTI_cond_wait(&p_local, &p_rwlock->cond, &p_rwlock->mutex);
-    }
-    if (abt_errno == ABT_SUCCESS) {
-        p_rwlock->reader_count++;
+    while (1) {
+        /* Announce this reader on the indicator of this ES.  If the lock is
+         * still read-biased, a writer that revokes the bias sees the
+         * indicator and waits for this reader. */
+        ABTI_rwlock_reader *p_reader = ABTI_rwlock_get_reader(p_local, p_rwlock);
+        ABTD_atomic_fetch_add_int(&p_reader->count, 1);
+        ABTD_atomic_full_barrier();
+        if (ABTD_atomic_acquire_load_int(&p_rwlock->state) ==
+            ABTI_RWLOCK_STATE_READ_BIAS)
+            return ABT_SUCCESS;
+
+        /* A writer revoked the bias.  Leave and wait until it unlocks. */
+        rwlock_leave_reader(p_local, p_rwlock, p_reader);
+        ABTD_spinlock_acquire(&p_rwlock->lock);
+        if (ABTD_atomic_relaxed_load_int(&p_rwlock->state) ==
+            ABTI_RWLOCK_STATE_READ_BIAS) {
+            ABTD_spinlock_release(&p_rwlock->lock);
+        } else {
+            ABTI_waitlist_wait_and_unlock(&p_local, &p_rwlock->waitlist,
+                                          &p_rwlock->lock,
+                                          ABT_SYNC_EVENT_TYPE_RWLOCK,
+                                          (void *)p_rwlock);
+        }
     }
-    ABTI_mutex_unlock(p_local, &p_rwlock->mutex);
-    ABTI_CHECK_ERROR(abt_errno);
-    return ABT_SUCCESS;
 }
 
 /**
@@ -222,17 +265,32 @@ int ABT_rwlock_wrlock(ABT_rwlock rwlock)
     }
 #endif
 
-    ABTI_mutex_lock(&p_local, &p_rwlock->mutex);
-    int abt_errno = ABT_SUCCESS;
-    while ((p_rwlock->write_flag || p_rwlock->reader_count) &&
-           abt_errno == ABT_SUCCESS) {
-        abt_errno = ABTI_cond_wait(&p_local, &p_rwlock->cond, &p_rwlock->mutex);
+    ABTD_spinlock_acquire(&p_rwlock->lock);
+    /* Wait for the other writer. */
+    while (ABTD_atomic_relaxed_load_int(&p_rwlock->state) !=
+           ABTI_RWLOCK_STATE_READ_BIAS) {
+        ABTI_waitlist_wait_and_unlock(&p_local, &p_rwlock->waitlist,
+                                      &p_rwlock->lock,
+                                      ABT_SYNC_EVENT_TYPE_RWLOCK,
+                                      (void *)p_rwlock);
+        ABTD_spinlock_acquire(&p_rwlock->lock);
     }
-    if (abt_errno == ABT_SUCCESS) {
-        p_rwlock->write_flag = 1;
+    /* Revoke the bias so that new readers back off, and wait until the
+     * readers that already entered leave.  A reader that leaves while the
+     * bias is revoked takes the lock to wake up this writer, so it cannot
+     * miss the writer that is about to wait. */
+    ABTD_atomic_relaxed_store_int(&p_rwlock->state, ABTI_RWLOCK_STATE_REVOKED);
+    ABTD_atomic_full_barrier();
+    while (rwlock_count_readers(p_rwlock) != 0) {
+        ABTI_waitlist_wait_and_unlock(&p_local, &p_rwlock->drain_waitlist,
+                                      &p_rwlock->lock,
+                                      ABT_SYNC_EVENT_TYPE_RWLOCK,
+                                      (void *)p_rwlock);
+        ABTD_spinlock_acquire(&p_rwlock->lock);
     }
-    ABTI_mutex_unlock(p_local, &p_rwlock->mutex);
-    ABTI_CHECK_ERROR(abt_errno);
+    ABTD_atomic_relaxed_store_int(&p_rwlock->state,
+                                  ABTI_RWLOCK_STATE_WRITE_LOCKED);
+    ABTD_spinlock_release(&p_rwlock->lock);
     return ABT_SUCCESS;
 }
 
@@ -268,14 +326,48 @@ int ABT_rwlock_unlock(ABT_rwlock rwlock)
     ABTI_rwlock *p_rwlock = ABTI_rwlock_get_ptr(rwlock);
     ABTI_CHECK_NULL_RWLOCK_PTR(p_rwlock);
 
-    ABTI_mutex_lock(&p_local, &p_rwlock->mutex);
-    if (p_rwlock->write_flag) {
-        p_rwlock->write_flag = 0;
+    /* No reader can hold the lock while a writer holds it. */
+    if (ABTD_atomic_relaxed_load_int(&p_rwlock->state) ==
+        ABTI_RWLOCK_STATE_WRITE_LOCKED) {
+        /* Restore the bias and wake up the waiting readers and writers. */
+        ABTD_spinlock_acquire(&p_rwlock->lock);
+        ABTD_atomic_release_store_int(&p_rwlock->state,
+                                      ABTI_RWLOCK_STATE_READ_BIAS);
+        ABTI_waitlist_broadcast(p_local, &p_rwlock->waitlist);
+        ABTD_spinlock_release(&p_rwlock->lock);
     } else {
-        ABTI_UB_ASSERT(p_rwlock->reader_count > 0);
-        p_rwlock->reader_count--;
+        /* The reader may have migrated to another ES since it locked the
+         * rwlock, so only the sum of the indicators is meaningful. */
+        rwlock_leave_reader(p_local, p_rwlock,
+                            ABTI_rwlock_get_reader(p_local, p_rwlock));
     }
-    ABTI_cond_broadcast(p_local, &p_rwlock->cond);
-    ABTI_mutex_unlock(p_local, &p_rwlock->mutex);
     return ABT_SUCCESS;
 }
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+static inline void rwlock_leave_reader(ABTI_local *p_local,
+                                       ABTI_rwlock *p_rwlock,
+                                       ABTI_rwlock_reader *p_reader)
+{
+    ABTD_atomic_fetch_sub_int(&p_reader->count, 1);
+    ABTD_atomic_full_barrier();
+    if (ABTD_atomic_relaxed_load_int(&p_rwlock->state) ==
+        ABTI_RWLOCK_STATE_REVOKED) {
+        /* A writer may be waiting for this reader. */
+        ABTD_spinlock_acquire(&p_rwlock->lock);
+        ABTI_waitlist_broadcast(p_local, &p_rwlock->drain_waitlist);
+        ABTD_spinlock_release(&p_rwlock->lock);
+    }
+}
+
+static inline int rwlock_count_readers(ABTI_rwlock *p_rwlock)
+{
+    int i, count = 0;
+    for (i = 0; i < p_rwlock->num_readers; i++) {
+        count += ABTD_atomic_acquire_load_int(&p_rwlock->p_readers[i].count);
+    }
+    return count;
+}
@@ -6,6 +6,7 @@
 abt_sources += \
 	sched/basic.c \
 	sched/basic_wait.c \
+	sched/edf.c \
 	sched/prio.c \
 	sched/randws.c \
 	sched/sched.c \
@@ -129,12 +129,19 @@ static void sched_run(ABT_sched sched)
         if (!run_cnt_nowait) {
             ABTI_pool *p_pool = ABTI_pool_get_ptr(pools[0]);
             ABT_thread thread;
+            /* Wake up in time for the ULTs sleeping on this ES. */
+            double cur_time = ABTI_get_wtime();
+            double wait_time =
+                ABTI_timer_wheel_get_next_time(p_local_xstream) - cur_time;
+            if (wait_time > 0.1)
+                wait_time = 0.1;
+            else if (wait_time < 0.0)
+                wait_time = 0.0;
             if (p_pool->optional_def.p_pop_wait) {
-                thread = ABTI_pool_pop_wait(p_pool, 0.1,
+                thread = ABTI_pool_pop_wait(p_pool, wait_time,
                                             ABT_POOL_CONTEXT_OP_POOL_OTHER);
             } else if (p_pool->deprecated_def.p_pop_timedwait) {
-                thread =
-                    ABTI_pool_pop_timedwait(p_pool, ABTI_get_wtime() + 0.1);
+                thread = ABTI_pool_pop_timedwait(p_pool, cur_time + wait_time);
             } else {
                 /* No "wait" pop, so let's use a normal one. */
                 thread = ABTI_pool_pop(p_pool, ABT_POOL_CONTEXT_OP_POOL_OTHER);
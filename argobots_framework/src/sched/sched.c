@@ -11,6 +11,7 @@ ABTU_ret_err static int sched_create(ABT_sched_def *def, int num_pools,
                                      ABT_bool def_automatic,
                                      ABTI_sched **pp_newsched);
 static inline ABTI_sched_kind sched_get_kind(ABT_sched_def *def);
+static inline ABT_bool sched_has_pending_timer(ABTI_sched *p_sched);
 #ifdef ABT_CONFIG_USE_DEBUG_LOG
 static inline uint64_t sched_get_new_id(void);
 #endif
@@ -733,8 +734,11 @@ ABTU_ret_err int ABTI_sched_create_basic(ABT_sched_predef predef, int num_pools,
                 if (pools[p] == ABT_POOL_NULL) {
                     ABTI_pool *p_newpool;
                     abt_errno =
-                        ABTI_pool_create_basic(ABT_POOL_FIFO, def_access,
-                                               ABT_TRUE, &p_newpool);
+                        ABTI_pool_create_basic(predef == ABT_SCHED_EDF
+                                                   ? ABT_POOL_EDF
+                                                   : ABT_POOL_FIFO,
+                                               def_access, ABT_TRUE,
+                                               &p_newpool);
                     if (ABTI_IS_ERROR_CHECK_ENABLED &&
                         abt_errno != ABT_SUCCESS) {
                         /* Remove pools that are already created. */
@@ -781,6 +785,11 @@ ABTU_ret_err int ABTI_sched_create_basic(ABT_sched_predef predef, int num_pools,
                                          pool_list, p_config, def_automatic,
                                          pp_newsched);
                 break;
+            case ABT_SCHED_EDF:
+                abt_errno = sched_create(ABTI_sched_get_edf_def(), num_pools,
+                                         pool_list, p_config, def_automatic,
+                                         pp_newsched);
+                break;
             default:
                 abt_errno = ABT_ERR_INV_SCHED_PREDEF;
                 break;
@@ -816,6 +825,10 @@ ABTU_ret_err int ABTI_sched_create_basic(ABT_sched_predef predef, int num_pools,
             case ABT_SCHED_RANDWS:
                 num_pools = 1;
                 break;
+            case ABT_SCHED_EDF:
+                kind = ABT_POOL_EDF;
+                num_pools = 1;
+                break;
             default:
                 abt_errno = ABT_ERR_INV_SCHED_PREDEF;
                 ABTI_CHECK_ERROR(abt_errno);
@@ -869,6 +882,11 @@ ABTU_ret_err int ABTI_sched_create_basic(ABT_sched_predef predef, int num_pools,
                                          pool_list, p_config, def_automatic,
                                          pp_newsched);
                 break;
+            case ABT_SCHED_EDF:
+                abt_errno = sched_create(ABTI_sched_get_edf_def(), num_pools,
+                                         pool_list, p_config, def_automatic,
+                                         pp_newsched);
+                break;
             default:
                 abt_errno = ABT_ERR_INV_SCHED_PREDEF;
                 break;
@@ -931,10 +949,13 @@ ABT_bool ABTI_sched_has_to_stop(ABTI_sched *p_sched)
     }
 
     if (!ABTI_sched_has_unit(p_sched)) {
-        if (ABTD_atomic_acquire_load_uint32(&p_sched->request) &
-            (ABTI_SCHED_REQ_FINISH | ABTI_SCHED_REQ_REPLACE)) {
-            /* Check join request */
-            if (!ABTI_sched_has_unit(p_sched))
+        uint32_t request = ABTD_atomic_acquire_load_uint32(&p_sched->request);
+        if (request & (ABTI_SCHED_REQ_FINISH | ABTI_SCHED_REQ_REPLACE)) {
+            /* Check join request.  Replacing the main scheduler keeps the ES
+             * and its timer wheel. */
+            if (!ABTI_sched_has_unit(p_sched) &&
+                ((request & ABTI_SCHED_REQ_REPLACE) ||
+                 !sched_has_pending_timer(p_sched)))
                 return ABT_TRUE;
         } else if (p_sched->used == ABTI_SCHED_IN_POOL) {
             /* Let's finish it anyway.
@@ -1015,6 +1036,8 @@ void ABTI_sched_print(ABTI_sched *p_sched, FILE *p_os, int indent,
             kind_str = "PRIO";
         } else if (kind == sched_get_kind(ABTI_sched_get_randws_def())) {
             kind_str = "RANDWS";
+        } else if (kind == sched_get_kind(ABTI_sched_get_edf_def())) {
+            kind_str = "EDF";
         } else {
             kind_str = "USER";
         }
@@ -1187,6 +1210,20 @@ ABTU_ret_err static int sched_create(ABT_sched_def *def, int num_pools,
     return ABT_SUCCESS;
 }
 
+/* The main scheduler of an ES does not finish while the timer wheel of the ES
+ * has entries since no other ES fires them.  The wheel is processed by
+ * ABTI_xstream_check_events(), which the scheduler calls before this check. */
+static inline ABT_bool sched_has_pending_timer(ABTI_sched *p_sched)
+{
+    if (p_sched->used != ABTI_SCHED_MAIN)
+        return ABT_FALSE;
+    ABTI_xstream *p_local_xstream =
+        ABTI_local_get_xstream_or_null(ABTI_local_get_local());
+    if (!p_local_xstream || p_local_xstream->p_main_sched != p_sched)
+        return ABT_FALSE;
+    return ABTI_timer_wheel_is_empty(p_local_xstream) ? ABT_FALSE : ABT_TRUE;
+}
+
 #ifdef ABT_CONFIG_USE_DEBUG_LOG
 static inline uint64_t sched_get_new_id(void)
 {
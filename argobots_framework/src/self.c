@@ -793,6 +793,60 @@ int ABT_self_suspend(void)
     return ABT_SUCCESS;
 }
 
+/**
+ * @ingroup SELF
+ * @brief   Suspend the calling ULT for a given time.
+ *
+ * \c ABT_self_sleep() suspends the calling ULT for at least \c nsecs
+ * nanoseconds.  The sleeping ULT is not in its associated pool; the timer wheel
+ * of the calling execution stream pushes it back to the pool when its time
+ * comes.  The timer wheel is checked by \c ABT_xstream_check_events(), so the
+ * calling ULT may sleep longer if the scheduler of the calling execution stream
+ * does not call it frequently.  The calling execution stream does not terminate
+ * on join while the calling ULT is sleeping.  If \c nsecs is zero, this routine
+ * yields the calling ULT.
+ *
+ * @contexts
+ * \DOC_CONTEXT_INIT_YIELDABLE \DOC_CONTEXT_CTXSWITCH
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_INV_XSTREAM_EXT
+ * \DOC_ERROR_INV_THREAD_NY
+ * \DOC_ERROR_RESOURCE
+ *
+ * @undefined
+ * \DOC_UNDEFINED_UNINIT
+ * \DOC_UNDEFINED_THREAD_UNSAFE{the caller}
+ *
+ * @param[in] nsecs  sleep time in nanoseconds
+ * @return Error code
+ */
+int ABT_self_sleep(uint64_t nsecs)
+{
+    ABTI_UB_ASSERT(ABTI_initialized());
+
+    ABTI_xstream *p_local_xstream;
+    ABTI_ythread *p_self;
+    ABTI_SETUP_LOCAL_YTHREAD(&p_local_xstream, &p_self);
+
+    if (nsecs == 0) {
+        ABTI_ythread_yield(&p_local_xstream, p_self,
+                           ABTI_YTHREAD_YIELD_KIND_USER,
+                           ABT_SYNC_EVENT_TYPE_USER, NULL);
+        return ABT_SUCCESS;
+    }
+    double target_time = ABTI_get_wtime() + 1.0e-9 * (double)nsecs;
+    do {
+        /* The wheel fires the entry early if its ES is freed, in which case
+         * this ULT sleeps again with the wheel of the ES that runs it. */
+        int abt_errno =
+            ABTI_timer_wheel_sleep(&p_local_xstream, p_self, target_time);
+        ABTI_CHECK_ERROR(abt_errno);
+    } while (ABTI_get_wtime() < target_time);
+    return ABT_SUCCESS;
+}
+
 /**
  * @ingroup SELF
  * @brief   Suspend the calling ULT and jump to another ULT.
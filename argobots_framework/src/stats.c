@@ -0,0 +1,234 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "abti.h"
+
+#ifdef ABT_CONFIG_USE_STATS
+
+static inline ABT_stats_xstream *stats_get_xstream_slot(ABT_stats_header *p_hdr,
+                                                        uint32_t index);
+static inline ABT_stats_pool *stats_get_pool_slot(ABT_stats_header *p_hdr,
+                                                  uint32_t index);
+static inline void stats_store(uint64_t *p_val, uint64_t val);
+static int stats_create_file(const char *filename);
+static void stats_remove_at_exit(void);
+
+static ABT_bool g_stats_atexit_registered = ABT_FALSE;
+
+/*****************************************************************************/
+/* Private APIs                                                              */
+/*****************************************************************************/
+
+void ABTI_stats_init(ABTI_global *p_global)
+{
+    ABTD_spinlock_clear(&p_global->stats_lock);
+    p_global->p_stats = NULL;
+    p_global->stats_size = 0;
+    if (p_global->stats_enabled == ABT_FALSE)
+        return;
+
+    if (!p_global->stats_file) {
+        char default_filename[64];
+        sprintf(default_filename, "/dev/shm/abt_stats.%d", (int)getpid());
+        size_t len = strlen(default_filename);
+        if (ABTU_malloc(len + 1, (void **)&p_global->stats_file) !=
+            ABT_SUCCESS) {
+            p_global->stats_file = NULL;
+            p_global->stats_enabled = ABT_FALSE;
+            return;
+        }
+        memcpy(p_global->stats_file, default_filename, len + 1);
+    }
+
+    const size_t xstream_offset =
+        ABTU_roundup_size(sizeof(ABT_stats_header),
+                          ABT_CONFIG_STATIC_CACHELINE_SIZE);
+    const size_t pool_offset =
+        xstream_offset +
+        sizeof(ABT_stats_xstream) * p_global->stats_max_xstreams;
+    const size_t size =
+        pool_offset + sizeof(ABT_stats_pool) * p_global->stats_max_pools;
+
+    /* The page is zero-filled by ftruncate(). */
+    void *p_page = MAP_FAILED;
+    int fd = stats_create_file(p_global->stats_file);
+    if (fd != -1) {
+        if (ftruncate(fd, (off_t)size) == 0) {
+            p_page =
+                mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+    }
+    if (p_page == MAP_FAILED) {
+        fprintf(stderr, "ABT_STATS: failed to map %s.\n", p_global->stats_file);
+        if (fd != -1)
+            unlink(p_global->stats_file);
+        p_global->stats_enabled = ABT_FALSE;
+        return;
+    }
+
+    ABT_stats_header *p_hdr = (ABT_stats_header *)p_page;
+    p_hdr->version = ABT_STATS_VERSION;
+    p_hdr->pid = (uint32_t)getpid();
+    p_hdr->max_xstreams = p_global->stats_max_xstreams;
+    p_hdr->max_pools = p_global->stats_max_pools;
+    p_hdr->num_xstream_counters = ABT_STATS_XSTREAM_NUM_COUNTERS;
+    p_hdr->num_pool_counters = ABT_STATS_POOL_NUM_COUNTERS;
+    p_hdr->xstream_offset = xstream_offset;
+    p_hdr->pool_offset = pool_offset;
+    /* Slot 0 collects pools that do not get their own slot. */
+    stats_get_pool_slot(p_hdr, 0)->in_use = 1;
+    /* A reader checks magic before the other fields. */
+    ABTD_atomic_release_store_uint64((ABTD_atomic_uint64 *)&p_hdr->magic,
+                                     ABT_STATS_MAGIC);
+
+    p_global->p_stats = p_hdr;
+    p_global->stats_size = size;
+    /* Remove the file even if the program exits without ABT_finalize. */
+    if (g_stats_atexit_registered == ABT_FALSE &&
+        atexit(stats_remove_at_exit) == 0) {
+        g_stats_atexit_registered = ABT_TRUE;
+    }
+}
+
+void ABTI_stats_finalize(ABTI_global *p_global)
+{
+    ABT_stats_header *p_hdr = p_global->p_stats;
+    if (p_hdr) {
+        stats_store(&p_hdr->finalized, 1);
+        munmap((void *)p_hdr, p_global->stats_size);
+        unlink(p_global->stats_file);
+        p_global->p_stats = NULL;
+    }
+    if (p_global->stats_file) {
+        ABTU_free(p_global->stats_file);
+        p_global->stats_file = NULL;
+    }
+}
+
+void ABTI_stats_attach_xstream(ABTI_global *p_global, ABTI_xstream *p_xstream)
+{
+    ABT_stats_header *p_hdr = p_global->p_stats;
+    p_xstream->p_stats = NULL;
+    /* An ES whose rank does not fit in the page is not counted. */
+    if (!p_hdr || p_xstream->rank < 0 ||
+        (uint32_t)p_xstream->rank >= p_hdr->max_xstreams)
+        return;
+    /* Ranks are unique among running ESs, so a slot is not shared.  Counters
+     * of a freed ES are kept and continue with the next ES of the same
+     * rank. */
+    ABT_stats_xstream *p_slot =
+        stats_get_xstream_slot(p_hdr, (uint32_t)p_xstream->rank);
+    stats_store(&p_slot->in_use, 1);
+    p_xstream->p_stats = p_slot;
+}
+
+void ABTI_stats_detach_xstream(ABTI_global *p_global, ABTI_xstream *p_xstream)
+{
+    ABT_stats_xstream *p_slot = p_xstream->p_stats;
+    if (!p_slot)
+        return;
+    p_xstream->p_stats = NULL;
+    stats_store(&p_slot->in_use, 0);
+}
+
+void ABTI_stats_attach_pool(ABTI_global *p_global, ABTI_pool *p_pool)
+{
+    ABT_stats_header *p_hdr = p_global->p_stats;
+    p_pool->p_stats = NULL;
+    if (!p_hdr)
+        return;
+
+    ABT_stats_pool *p_slot = stats_get_pool_slot(p_hdr, 0);
+    uint32_t i;
+    ABTD_spinlock_acquire(&p_global->stats_lock);
+    for (i = 1; i < p_hdr->max_pools; i++) {
+        ABT_stats_pool *p_cur = stats_get_pool_slot(p_hdr, i);
+        if (p_cur->in_use == 0) {
+            int kind;
+            for (kind = 0; kind < ABT_STATS_POOL_NUM_COUNTERS; kind++)
+                stats_store(&p_cur->counters[kind], 0);
+            stats_store(&p_cur->id, p_pool->id);
+            stats_store(&p_cur->in_use, 1);
+            p_slot = p_cur;
+            break;
+        }
+    }
+    ABTD_spinlock_release(&p_global->stats_lock);
+    p_pool->p_stats = p_slot;
+}
+
+void ABTI_stats_detach_pool(ABTI_global *p_global, ABTI_pool *p_pool)
+{
+    ABT_stats_pool *p_slot = p_pool->p_stats;
+    if (!p_slot)
+        return;
+    p_pool->p_stats = NULL;
+    /* Slot 0 is shared.  The page may be unmapped already. */
+    if (!p_global->p_stats ||
+        p_slot == stats_get_pool_slot(p_global->p_stats, 0))
+        return;
+    ABTD_spinlock_acquire(&p_global->stats_lock);
+    stats_store(&p_slot->in_use, 0);
+    ABTD_spinlock_release(&p_global->stats_lock);
+}
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+static inline ABT_stats_xstream *stats_get_xstream_slot(ABT_stats_header *p_hdr,
+                                                        uint32_t index)
+{
+    return &((ABT_stats_xstream *)(((char *)p_hdr) +
+                                   p_hdr->xstream_offset))[index];
+}
+
+static inline ABT_stats_pool *stats_get_pool_slot(ABT_stats_header *p_hdr,
+                                                  uint32_t index)
+{
+    return &((ABT_stats_pool *)(((char *)p_hdr) + p_hdr->pool_offset))[index];
+}
+
+static inline void stats_store(uint64_t *p_val, uint64_t val)
+{
+    ABTD_atomic_relaxed_store_uint64((ABTD_atomic_uint64 *)p_val, val);
+}
+
+/* The file is usually in a world-writable directory such as /dev/shm, so it
+ * is created exclusively and a symbolic link is not followed.  It is readable
+ * only by the owner since the counters show what the program is doing.  A
+ * stale file is removed only if it is a regular file of the same user, e.g.,
+ * one left by a killed process with the same PID. */
+static int stats_create_file(const char *filename)
+{
+    const int flags = O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW;
+    int fd = open(filename, flags, 0600);
+    if (fd == -1 && errno == EEXIST) {
+        struct stat st;
+        if (lstat(filename, &st) == 0 && S_ISREG(st.st_mode) &&
+            st.st_uid == geteuid() && unlink(filename) == 0) {
+            fd = open(filename, flags, 0600);
+        }
+    }
+    return fd;
+}
+
+static void stats_remove_at_exit(void)
+{
+    ABTI_global *p_global = ABTI_global_get_global_or_null();
+    if (p_global && p_global->p_stats) {
+        stats_store(&p_global->p_stats->finalized, 1);
+        unlink(p_global->stats_file);
+    }
+}
+
+#endif /* ABT_CONFIG_USE_STATS */
@@ -464,7 +464,9 @@ int ABT_xstream_free(ABT_xstream *xstream)
  * @brief   Wait for an execution stream to terminate.
  *
  * The caller of \c ABT_thread_join() waits for the execution stream \c xstream
- * until \c xstream terminates.
+ * until \c xstream terminates.  \c xstream does not terminate while a ULT that
+ * started sleeping with \c ABT_self_sleep() or waiting with a timeout on
+ * \c xstream is still suspended.
  *
  * \DOC_DESC_ATOMICITY_XSTREAM_STATE
  *
@@ -1347,6 +1349,54 @@ int ABT_xstream_check_events(ABT_sched sched)
     return ABT_SUCCESS;
 }
 
+/**
+ * @ingroup ES
+ * @brief   Get the time when the next timer of a scheduler's execution stream
+ *          expires
+ *
+ * \c ABT_xstream_get_next_timer_time() returns through \c abstime_secs the
+ * time (in seconds, on the clock of \c ABT_get_wtime()) before which no ULT
+ * sleeping or waiting with a timeout on the execution stream running the
+ * scheduler \c sched needs to be woken up.  If no such ULT exists, \c DBL_MAX
+ * is returned.  The calling work unit must be associated with \c sched.
+ *
+ * The timers are processed by \c ABT_xstream_check_events(), so a scheduler
+ * that blocks its execution stream should wake up and call it by this time.
+ *
+ * @contexts
+ * \DOC_CONTEXT_INIT_SCHED{\c sched} \DOC_CONTEXT_NOCTXSWITCH
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_INV_XSTREAM_EXT
+ * \DOC_ERROR_INV_SCHED_HANDLE{\c sched}
+ * \DOC_ERROR_INV_THREAD_NOT_CALLER{a work unit associated with \c sched}
+ *
+ * @undefined
+ * \DOC_UNDEFINED_UNINIT
+ * \DOC_UNDEFINED_NULL_PTR{\c abstime_secs}
+ *
+ * @param[in]  sched         scheduler handle
+ * @param[out] abstime_secs  expiration time of the next timer
+ * @return Error code
+ */
+int ABT_xstream_get_next_timer_time(ABT_sched sched, double *abstime_secs)
+{
+    ABTI_UB_ASSERT(ABTI_initialized());
+    ABTI_UB_ASSERT(abstime_secs);
+
+    ABTI_xstream *p_local_xstream;
+    ABTI_SETUP_LOCAL_XSTREAM(&p_local_xstream);
+
+    ABTI_sched *p_sched = ABTI_sched_get_ptr(sched);
+    ABTI_CHECK_NULL_SCHED_PTR(p_sched);
+    ABTI_CHECK_TRUE(p_local_xstream->p_thread == &p_sched->p_ythread->thread,
+                    ABT_ERR_INV_THREAD);
+
+    *abstime_secs = ABTI_timer_wheel_get_next_time(p_local_xstream);
+    return ABT_SUCCESS;
+}
+
 /**
  * @ingroup ES
  * @brief   Bind an execution stream to a target CPU.
@@ -1606,6 +1656,10 @@ void ABTI_xstream_start_primary(ABTI_global *p_global,
     if (p_global->set_affinity == ABT_TRUE) {
         ABTD_affinity_cpuset_apply_default(&p_xstream->ctx, p_xstream->rank);
     }
+#ifdef ABT_CONFIG_USE_PREEMPTION
+    /* Start the preemption timer of this ES */
+    ABTI_preemption_start_xstream(p_global, p_xstream);
+#endif
 
     /* Context switch to the root thread. */
     p_xstream->p_root_ythread->thread.p_last_xstream = p_xstream;
@@ -1620,6 +1674,10 @@ void ABTI_xstream_check_events(ABTI_xstream *p_xstream, ABTI_sched *p_sched)
 {
     ABTI_info_check_print_all_thread_stacks();
 
+    /* Resume the sleeping ULTs whose time has come. */
+    if (p_xstream->p_timer_wheel)
+        ABTI_timer_wheel_process(p_xstream);
+
     uint32_t request = ABTD_atomic_acquire_load_uint32(
         &p_xstream->p_main_sched->p_ythread->thread.request);
     if (request & ABTI_THREAD_REQ_JOIN) {
@@ -1634,6 +1692,20 @@ void ABTI_xstream_check_events(ABTI_xstream *p_xstream, ABTI_sched *p_sched)
 void ABTI_xstream_free(ABTI_global *p_global, ABTI_local *p_local,
                        ABTI_xstream *p_xstream, ABT_bool force_free)
 {
+#ifdef ABT_CONFIG_USE_TRACE
+    ABTI_trace_detach_xstream(p_global, p_xstream);
+#endif
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+    ABTI_perf_detach_xstream(p_global, p_xstream);
+#endif
+#ifdef ABT_CONFIG_USE_STATS
+    ABTI_stats_detach_xstream(p_global, p_xstream);
+#endif
+#ifdef ABT_CONFIG_USE_PREEMPTION
+    ABTI_preemption_stop_xstream(p_xstream);
+#endif
+    /* Resume the ULTs left in the timer wheel. */
+    ABTI_timer_wheel_free(p_local, p_xstream);
     /* Clean up memory pool. */
     ABTI_mem_finalize_local(p_xstream);
     /* Return rank for reuse. rank must be returned prior to other free
@@ -1709,6 +1781,10 @@ void ABTI_xstream_print(ABTI_xstream *p_xstream, FILE *p_os, int indent,
                 (void *)p_xstream->p_root_pool, indent, "",
                 (void *)p_xstream->p_thread, indent, "",
                 (void *)p_xstream->p_main_sched);
+#ifdef ABT_CONFIG_USE_PREEMPTION
+        fprintf(p_os, "%*spreemptions : %" PRIu64 "\n", indent, "",
+                p_xstream->num_preemptions);
+#endif
 
         if (print_sub == ABT_TRUE) {
             ABTI_sched_print(p_xstream->p_main_sched, p_os,
@@ -1726,6 +1802,9 @@ static void *xstream_launch_root_ythread(void *p_xstream)
 
     /* Initialization of the local variables */
     ABTI_local_set_xstream(p_local_xstream);
+#ifdef ABT_CONFIG_USE_PREEMPTION
+    ABTI_preemption_start_xstream(ABTI_global_get_global(), p_local_xstream);
+#endif
 
     /* Set the root thread as the current thread */
     ABTI_ythread *p_root_ythread = p_local_xstream->p_root_ythread;
@@ -1736,6 +1815,9 @@ static void *xstream_launch_root_ythread(void *p_xstream)
     p_root_ythread->thread.f_thread(p_root_ythread->thread.p_arg);
     ABTI_thread_terminate(ABTI_global_get_global(), p_local_xstream,
                           &p_root_ythread->thread);
+#ifdef ABT_CONFIG_USE_PREEMPTION
+    ABTI_preemption_stop_xstream(p_local_xstream);
+#endif
 
     /* Reset the current ES and its local info. */
     ABTI_local_set_xstream(NULL);
@@ -1772,10 +1854,29 @@ ABTU_ret_err static int xstream_create(ABTI_global *p_global,
                                   ABT_XSTREAM_STATE_RUNNING);
     p_newxstream->p_main_sched = NULL;
     p_newxstream->p_thread = NULL;
+    p_newxstream->p_timer_wheel = NULL;
+#ifdef ABT_CONFIG_USE_PREEMPTION
+    p_newxstream->has_preemption_timer = ABT_FALSE;
+    p_newxstream->p_preemption_last = NULL;
+    p_newxstream->num_preemptions = 0;
+#endif
     abt_errno = ABTI_mem_init_local(p_global, p_newxstream);
     if (abt_errno != ABT_SUCCESS)
         goto FAILED;
     init_stage = 2;
+#ifdef ABT_CONFIG_USE_TRACE
+    abt_errno = ABTI_trace_attach_xstream(p_global, p_newxstream);
+    if (abt_errno != ABT_SUCCESS)
+        goto FAILED;
+#endif
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+    abt_errno = ABTI_perf_attach_xstream(p_global, p_newxstream);
+    if (abt_errno != ABT_SUCCESS)
+        goto FAILED;
+#endif
+#ifdef ABT_CONFIG_USE_STATS
+    ABTI_stats_attach_xstream(p_global, p_newxstream);
+#endif
 
     /* Set the main scheduler */
     xstream_init_main_sched(p_newxstream, p_sched);
@@ -1843,6 +1944,15 @@ FAILED:
     }
     if (init_stage >= 2) {
         p_sched->used = ABTI_SCHED_NOT_USED;
+#ifdef ABT_CONFIG_USE_TRACE
+        ABTI_trace_detach_xstream(p_global, p_newxstream);
+#endif
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+        ABTI_perf_detach_xstream(p_global, p_newxstream);
+#endif
+#ifdef ABT_CONFIG_USE_STATS
+        ABTI_stats_detach_xstream(p_global, p_newxstream);
+#endif
         ABTI_mem_finalize_local(p_newxstream);
     }
     if (init_stage >= 1) {
@@ -592,6 +592,10 @@ ABTU_ret_err static int task_create(ABTI_global *p_global, ABTI_local *p_local,
     ABTD_atomic_relaxed_store_uint32(&p_newtask->request, 0);
     p_newtask->f_thread = task_func;
     p_newtask->p_arg = arg;
+    p_newtask->deadline = ABTI_THREAD_NO_DEADLINE;
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+    ABTI_perf_reset_thread(p_newtask);
+#endif
     ABTD_atomic_relaxed_store_ptr(&p_newtask->p_keytable, NULL);
     p_newtask->id = ABTI_TASK_INIT_ID;
 
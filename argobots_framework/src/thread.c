@@ -2005,6 +2005,110 @@ int ABT_thread_is_migratable(ABT_thread thread, ABT_bool *is_migratable)
 #endif
 }
 
+/**
+ * @ingroup ULT
+ * @brief   Set the preemptibility of a ULT.
+ *
+ * \c ABT_thread_set_preemptible() sets the preemptibility of the ULT
+ * \c thread.  If \c preemptible is \c ABT_TRUE, \c thread can be pushed back
+ * to its associated pool by the timer signal of its execution stream after it
+ * keeps running for the quantum set by \c ABT_PREEMPTION_INTERVAL_USEC.
+ * Otherwise, \c thread runs until it yields, suspends, or terminates.
+ *
+ * A ULT can disable its own preemption around code that must not be
+ * interrupted by another ULT on the same execution stream, such as code that
+ * holds an OS-level lock.
+ *
+ * @contexts
+ * \DOC_CONTEXT_INIT \DOC_CONTEXT_NOCTXSWITCH
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_INV_THREAD_HANDLE{\c thread}
+ * \DOC_ERROR_INV_THREAD_NY{\c thread}
+ * \DOC_ERROR_INV_THREAD_PRIMARY_ULT{\c thread}
+ * \DOC_ERROR_INV_THREAD_MAIN_SCHED_THREAD{\c thread}
+ * \DOC_ERROR_FEATURE_NA{the preemption feature}
+ *
+ * @undefined
+ * \DOC_UNDEFINED_UNINIT
+ * \DOC_UNDEFINED_BOOL{\c preemptible}
+ * \DOC_UNDEFINED_THREAD_UNSAFE{\c thread}
+ *
+ * @param[in] thread       ULT handle
+ * @param[in] preemptible  preemptibility flag (\c ABT_TRUE: preemptible,
+ *                                              \c ABT_FALSE: not)
+ * @return Error code
+ */
+int ABT_thread_set_preemptible(ABT_thread thread, ABT_bool preemptible)
+{
+    ABTI_UB_ASSERT(ABTI_initialized());
+    ABTI_UB_ASSERT_BOOL(preemptible);
+
+#ifdef ABT_CONFIG_USE_PREEMPTION
+    ABTI_thread *p_thread = ABTI_thread_get_ptr(thread);
+    ABTI_CHECK_NULL_THREAD_PTR(p_thread);
+    ABTI_CHECK_TRUE(p_thread->type & ABTI_THREAD_TYPE_YIELDABLE,
+                    ABT_ERR_INV_THREAD);
+    ABTI_CHECK_TRUE(!(p_thread->type &
+                      (ABTI_THREAD_TYPE_ROOT | ABTI_THREAD_TYPE_PRIMARY |
+                       ABTI_THREAD_TYPE_MAIN_SCHED)),
+                    ABT_ERR_INV_THREAD);
+
+    if (preemptible) {
+        p_thread->type |= ABTI_THREAD_TYPE_PREEMPTIBLE;
+    } else {
+        p_thread->type &= ~ABTI_THREAD_TYPE_PREEMPTIBLE;
+    }
+    return ABT_SUCCESS;
+#else
+    ABTI_HANDLE_ERROR(ABT_ERR_FEATURE_NA);
+#endif
+}
+
+/**
+ * @ingroup ULT
+ * @brief   Get the preemptibility of a work unit.
+ *
+ * \c ABT_thread_is_preemptible() returns the preemptibility of the work unit
+ * \c thread through \c is_preemptible.  If \c thread is preemptible,
+ * \c is_preemptible is set to \c ABT_TRUE.  Otherwise, \c is_preemptible is
+ * set to \c ABT_FALSE.  A tasklet is never preemptible.
+ *
+ * @contexts
+ * \DOC_CONTEXT_INIT \DOC_CONTEXT_NOCTXSWITCH
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_INV_THREAD_HANDLE{\c thread}
+ * \DOC_ERROR_FEATURE_NA{the preemption feature}
+ *
+ * @undefined
+ * \DOC_UNDEFINED_UNINIT
+ * \DOC_UNDEFINED_NULL_PTR{\c is_preemptible}
+ *
+ * @param[in]  thread          work unit handle
+ * @param[out] is_preemptible  result (\c ABT_TRUE: preemptible,
+ *                                     \c ABT_FALSE: not)
+ * @return Error code
+ */
+int ABT_thread_is_preemptible(ABT_thread thread, ABT_bool *is_preemptible)
+{
+    ABTI_UB_ASSERT(ABTI_initialized());
+    ABTI_UB_ASSERT(is_preemptible);
+
+#ifdef ABT_CONFIG_USE_PREEMPTION
+    ABTI_thread *p_thread = ABTI_thread_get_ptr(thread);
+    ABTI_CHECK_NULL_THREAD_PTR(p_thread);
+
+    *is_preemptible =
+        (p_thread->type & ABTI_THREAD_TYPE_PREEMPTIBLE) ? ABT_TRUE : ABT_FALSE;
+    return ABT_SUCCESS;
+#else
+    ABTI_HANDLE_ERROR(ABT_ERR_FEATURE_NA);
+#endif
+}
+
 /**
  * @ingroup ULT
  * @brief   Check if a work unit is the primary ULT.
@@ -2477,6 +2581,11 @@ int ABT_thread_get_attr(ABT_thread thread, ABT_thread_attr *attr)
         thread_attr.p_stack = NULL;
         thread_attr.stacksize = 0;
     }
+    thread_attr.deadline = p_thread->deadline;
+#ifdef ABT_CONFIG_USE_PREEMPTION
+    thread_attr.preemptible =
+        (p_thread->type & ABTI_THREAD_TYPE_PREEMPTIBLE) ? ABT_TRUE : ABT_FALSE;
+#endif
 #ifndef ABT_CONFIG_DISABLE_MIGRATION
     thread_attr.migratable =
         (p_thread->type & ABTI_THREAD_TYPE_MIGRATABLE) ? ABT_TRUE : ABT_FALSE;
@@ -2778,6 +2887,23 @@ void ABTI_thread_print(ABTI_thread *p_thread, FILE *p_os, int indent)
                 p_migration_cb_arg, indent, "",
                 ABTD_atomic_acquire_load_ptr(&p_thread->p_keytable));
 
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+        fprintf(p_os,
+                "%*scycles     : %" PRIu64 "\n"
+                "%*sinsts      : %" PRIu64 "\n"
+                "%*sLLC_misses : %" PRIu64 "\n"
+                "%*sbe_stalls  : %" PRIu64 "\n",
+                indent, "", p_thread->perf_counts[ABTI_PERF_COUNTER_CYCLES],
+                indent, "",
+                p_thread->perf_counts[ABTI_PERF_COUNTER_INSTRUCTIONS], indent,
+                "", p_thread->perf_counts[ABTI_PERF_COUNTER_CACHE_MISSES],
+                indent, "",
+                p_thread->perf_counts[ABTI_PERF_COUNTER_STALLED_BACKEND]);
+#endif
+#ifdef ABT_CONFIG_USE_PREEMPTION
+        fprintf(p_os, "%*spreemptible: %s\n", indent, "",
+                (p_thread->type & ABTI_THREAD_TYPE_PREEMPTIBLE) ? "yes" : "no");
+#endif
         if (p_thread->type & ABTI_THREAD_TYPE_YIELDABLE) {
             ABTI_ythread *p_ythread = ABTI_thread_get_ythread(p_thread);
             fprintf(p_os,
@@ -2904,8 +3030,24 @@ ythread_create(ABTI_global *p_global, ABTI_local *p_local, ABTI_pool *p_pool,
 #endif
     }
 
+#ifdef ABT_CONFIG_USE_PREEMPTION
+    /* Neither schedulers nor the primary ULT are preempted. */
+    if (!p_sched &&
+        !(thread_type & (ABTI_THREAD_TYPE_ROOT | ABTI_THREAD_TYPE_PRIMARY |
+                         ABTI_THREAD_TYPE_MAIN_SCHED)) &&
+        ((p_attr && p_attr->preemptible) ||
+         (p_pool && p_pool->is_preemptible))) {
+        thread_type |= ABTI_THREAD_TYPE_PREEMPTIBLE;
+    }
+#endif
+
     p_newthread->thread.f_thread = thread_func;
     p_newthread->thread.p_arg = arg;
+    p_newthread->thread.deadline =
+        p_attr ? p_attr->deadline : ABTI_THREAD_NO_DEADLINE;
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+    ABTI_perf_reset_thread(&p_newthread->thread);
+#endif
 
     ABTD_atomic_release_store_int(&p_newthread->thread.state,
                                   ABT_THREAD_STATE_READY);
@@ -2981,6 +3123,9 @@ thread_revive(ABTI_global *p_global, ABTI_local *p_local, ABTI_pool *p_pool,
 
     p_thread->f_thread = thread_func;
     p_thread->p_arg = arg;
+#ifdef ABT_CONFIG_USE_PERF_COUNTERS
+    ABTI_perf_reset_thread(p_thread);
+#endif
 
     ABTD_atomic_relaxed_store_int(&p_thread->state, ABT_THREAD_STATE_READY);
     ABTD_atomic_relaxed_store_uint32(&p_thread->request, 0);
@@ -3292,7 +3437,8 @@ static void thread_main_sched_func(void *arg)
          * execution of all work units. */
         if ((ABTD_atomic_relaxed_load_uint32(&p_sched->request) &
              ABTI_SCHED_REQ_FINISH) &&
-            !ABTI_sched_has_unit(p_sched)) {
+            !ABTI_sched_has_unit(p_sched) &&
+            ABTI_timer_wheel_is_empty(p_local_xstream)) {
             break;
         }
     }
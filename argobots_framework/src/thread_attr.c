@@ -382,6 +382,138 @@ int ABT_thread_attr_set_migratable(ABT_thread_attr attr, ABT_bool is_migratable)
 #endif
 }
 
+/**
+ * @ingroup ULT_ATTR
+ * @brief   Set the ULT's preemptibility in a ULT attribute.
+ *
+ * \c ABT_thread_attr_set_preemptible() sets the ULT's preemptibility
+ * \c is_preemptible in the ULT attribute \c attr.  If \c is_preemptible is
+ * \c ABT_TRUE, the ULT created with this attribute is preemptible (see
+ * \c ABT_thread_set_preemptible()).  If \c is_preemptible is \c ABT_FALSE,
+ * the ULT is preemptible only if it is created in a preemptible pool (see
+ * \c ABT_pool_set_preemptible()).
+ *
+ * A ULT attribute is not preemptible by default.
+ *
+ * @contexts
+ * \DOC_CONTEXT_INIT \DOC_CONTEXT_NOCTXSWITCH
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_INV_THREAD_ATTR_HANDLE{\c attr}
+ * \DOC_ERROR_FEATURE_NA{the preemption feature}
+ *
+ * @undefined
+ * \DOC_UNDEFINED_UNINIT
+ * \DOC_UNDEFINED_BOOL{\c is_preemptible}
+ * \DOC_UNDEFINED_THREAD_UNSAFE{\c attr}
+ *
+ * @param[in] attr            ULT attribute handle
+ * @param[in] is_preemptible  flag (\c ABT_TRUE: preemptible, \c ABT_FALSE: not)
+ * @return Error code
+ */
+int ABT_thread_attr_set_preemptible(ABT_thread_attr attr,
+                                    ABT_bool is_preemptible)
+{
+    ABTI_UB_ASSERT(ABTI_initialized());
+    ABTI_UB_ASSERT_BOOL(is_preemptible);
+
+#ifdef ABT_CONFIG_USE_PREEMPTION
+    ABTI_thread_attr *p_attr = ABTI_thread_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_THREAD_ATTR_PTR(p_attr);
+
+    /* Set the value */
+    p_attr->preemptible = is_preemptible;
+    return ABT_SUCCESS;
+#else
+    ABTI_HANDLE_ERROR(ABT_ERR_FEATURE_NA);
+#endif
+}
+
+/**
+ * @ingroup ULT_ATTR
+ * @brief   Set a deadline in a ULT attribute.
+ *
+ * \c ABT_thread_attr_set_deadline() sets the absolute deadline \c deadline
+ * in the ULT attribute \c attr.  \c deadline is a time in seconds on the
+ * clock of \c ABT_get_wtime().  A pool of \c ABT_POOL_EDF returns a ULT that
+ * has an earlier deadline first, and ULTs without a deadline after all the ULTs
+ * that have one.  Other pools ignore the deadline.
+ *
+ * A ULT attribute has no deadline by default.
+ *
+ * @contexts
+ * \DOC_CONTEXT_INIT \DOC_CONTEXT_NOCTXSWITCH
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_INV_THREAD_ATTR_HANDLE{\c attr}
+ *
+ * @undefined
+ * \DOC_UNDEFINED_UNINIT
+ * \DOC_UNDEFINED_THREAD_UNSAFE{\c attr}
+ *
+ * @param[in] attr      ULT attribute handle
+ * @param[in] deadline  absolute deadline in seconds
+ * @return Error code
+ */
+int ABT_thread_attr_set_deadline(ABT_thread_attr attr, double deadline)
+{
+    ABTI_UB_ASSERT(ABTI_initialized());
+
+    ABTI_thread_attr *p_attr = ABTI_thread_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_THREAD_ATTR_PTR(p_attr);
+
+    /* Set the value */
+    p_attr->deadline = deadline;
+    return ABT_SUCCESS;
+}
+
+/**
+ * @ingroup ULT_ATTR
+ * @brief   Get a deadline in a ULT attribute.
+ *
+ * \c ABT_thread_attr_get_deadline() returns the deadline set in the ULT
+ * attribute \c attr through \c deadline and sets \c has_deadline to
+ * \c ABT_TRUE.  If \c attr has no deadline, this routine sets
+ * \c has_deadline to \c ABT_FALSE and does not change \c deadline.
+ *
+ * @contexts
+ * \DOC_CONTEXT_INIT \DOC_CONTEXT_NOCTXSWITCH
+ *
+ * @errors
+ * \DOC_ERROR_SUCCESS
+ * \DOC_ERROR_INV_THREAD_ATTR_HANDLE{\c attr}
+ *
+ * @undefined
+ * \DOC_UNDEFINED_UNINIT
+ * \DOC_UNDEFINED_NULL_PTR{\c deadline}
+ * \DOC_UNDEFINED_NULL_PTR{\c has_deadline}
+ *
+ * @param[in]  attr          ULT attribute handle
+ * @param[out] deadline      absolute deadline in seconds
+ * @param[out] has_deadline  whether \c attr has a deadline
+ * @return Error code
+ */
+int ABT_thread_attr_get_deadline(ABT_thread_attr attr, double *deadline,
+                                 ABT_bool *has_deadline)
+{
+    ABTI_UB_ASSERT(ABTI_initialized());
+    ABTI_UB_ASSERT(deadline);
+    ABTI_UB_ASSERT(has_deadline);
+
+    ABTI_thread_attr *p_attr = ABTI_thread_attr_get_ptr(attr);
+    ABTI_CHECK_NULL_THREAD_ATTR_PTR(p_attr);
+
+    if (p_attr->deadline == ABTI_THREAD_NO_DEADLINE) {
+        *has_deadline = ABT_FALSE;
+    } else {
+        *deadline = p_attr->deadline;
+        *has_deadline = ABT_TRUE;
+    }
+    return ABT_SUCCESS;
+}
+
 /*****************************************************************************/
 /* Private APIs                                                              */
 /*****************************************************************************/
@@ -0,0 +1,414 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include "abti.h"
+
+/* Hierarchical timer wheel.  Every ES has its own wheel that holds the ULTs
+ * sleeping in ABT_self_sleep() and the ULTs waiting with a timeout on that ES.
+ * Only the ES accesses its wheel: a ULT adds its entry before it suspends, and
+ * ABTI_xstream_check_events() fires the expired entries.  A slot of level l
+ * spans 64^l ticks.  When the current tick reaches a slot of level l > 0, its
+ * entries move to lower levels, so adding, cancelling and firing an entry take
+ * O(1) time regardless of the number of sleeping ULTs.
+ *
+ * A signaled timed waiter that resumes on another ES cannot unlink its entry,
+ * so it pushes the entry to the lock-free cancel list of the wheel, which the
+ * owner drains when it processes the wheel.  Cancelled entries therefore do
+ * not stay in the wheel until their timeout.
+ *
+ * The main scheduler of an ES does not finish on join while its wheel has
+ * entries (see ABTI_sched_has_to_stop()), since no other ES fires them. */
+
+#define TIMER_WHEEL_SLOT_MASK ((uint64_t)ABTI_TIMER_WHEEL_NUM_SLOTS - 1)
+#define TIMER_WHEEL_MAX_DELTA                                                  \
+    ((uint64_t)1                                                               \
+     << (ABTI_TIMER_WHEEL_SLOT_BITS * ABTI_TIMER_WHEEL_NUM_LEVELS))
+
+static inline uint64_t timer_wheel_get_cur_tick(void)
+{
+    double cur_time = ABTI_get_wtime();
+    return (uint64_t)(cur_time * 1.0e9) >> ABTI_TIMER_WHEEL_TICK_SHIFT;
+}
+
+static inline uint64_t timer_wheel_time_to_tick(double time)
+{
+    if (time <= 0.0)
+        return 0;
+    /* Round up so that an entry never fires before its time. */
+    return ((uint64_t)(time * 1.0e9) +
+            (((uint64_t)1 << ABTI_TIMER_WHEEL_TICK_SHIFT) - 1)) >>
+           ABTI_TIMER_WHEEL_TICK_SHIFT;
+}
+
+static inline double timer_wheel_tick_to_time(uint64_t tick)
+{
+    return (double)(tick << ABTI_TIMER_WHEEL_TICK_SHIFT) * 1.0e-9;
+}
+
+static void timer_wheel_insert(ABTI_timer_wheel *p_wheel,
+                               ABTI_timer_entry *p_entry);
+static void timer_wheel_unlink(ABTI_timer_wheel *p_wheel,
+                               ABTI_timer_entry *p_entry);
+static void timer_wheel_cascade(ABTI_timer_wheel *p_wheel);
+static void timer_wheel_cancel(ABTI_timer_entry *p_entry);
+static void timer_wheel_drain_cancel_list(ABTI_timer_wheel *p_wheel);
+static void timer_entry_fire(ABTI_local *p_local, ABTI_timer_wheel *p_wheel,
+                             ABTI_timer_entry *p_entry);
+ABTU_ret_err static int timer_wheel_add(ABTI_xstream *p_xstream,
+                                        ABTI_timer_entry *p_entry,
+                                        double target_time);
+
+/*****************************************************************************/
+/* Private APIs                                                              */
+/*****************************************************************************/
+
+ABTU_ret_err int ABTI_timer_wheel_sleep(ABTI_xstream **pp_local_xstream,
+                                        ABTI_ythread *p_self,
+                                        double target_time)
+{
+    /* The entry is fired only by this ES, which does not access it after
+     * resuming p_self, so it can be on the stack. */
+    ABTI_timer_entry entry;
+    entry.thread.type = ABTI_THREAD_TYPE_EXT;
+    entry.p_ythread = p_self;
+    entry.p_waitlist = NULL;
+    entry.is_in_waitlist = ABT_FALSE;
+    ABTD_atomic_relaxed_store_int(&entry.state, ABTI_TIMER_ENTRY_WAITING);
+    int abt_errno = timer_wheel_add(*pp_local_xstream, &entry, target_time);
+    if (abt_errno != ABT_SUCCESS)
+        return abt_errno;
+
+    ABTI_ythread_suspend(pp_local_xstream, p_self, ABT_SYNC_EVENT_TYPE_OTHER,
+                         NULL);
+    return ABT_SUCCESS;
+}
+
+ABTU_ret_err int ABTI_timer_wheel_wait_and_unlock(
+    ABTI_xstream **pp_local_xstream, ABTI_ythread *p_self,
+    ABTI_waitlist *p_waitlist, ABTD_spinlock *p_lock, double target_time,
+    ABT_sync_event_type sync_event_type, void *p_sync, ABT_bool *p_is_timedout)
+{
+    ABTI_ASSERT(ABTD_spinlock_is_locked(p_lock) == ABT_TRUE);
+    ABTI_timer_entry *p_entry;
+    int abt_errno = ABTU_malloc(sizeof(ABTI_timer_entry), (void **)&p_entry);
+    if (abt_errno != ABT_SUCCESS)
+        return abt_errno;
+    p_entry->thread.type = ABTI_THREAD_TYPE_EXT | ABTI_THREAD_TYPE_TIMED_WAITER;
+    p_entry->p_ythread = p_self;
+    p_entry->p_waitlist = p_waitlist;
+    ABTD_atomic_relaxed_store_int(&p_entry->state, ABTI_TIMER_ENTRY_WAITING);
+    /* Released by the wheel and by this ULT. */
+    ABTD_atomic_relaxed_store_int(&p_entry->ref_count, 2);
+    abt_errno = timer_wheel_add(*pp_local_xstream, p_entry, target_time);
+    if (abt_errno != ABT_SUCCESS) {
+        ABTU_free(p_entry);
+        return abt_errno;
+    }
+    ABTI_waitlist_add_timed(p_waitlist, &p_entry->thread);
+    p_entry->is_in_waitlist = ABT_TRUE;
+
+    while (1) {
+        /* p_lock is released after this ULT is suspended, so neither a signal
+         * nor the wheel can resume it earlier. */
+        ABTI_ythread_suspend_unlock(pp_local_xstream, p_self, p_lock,
+                                    sync_event_type, p_sync);
+        /* Resumed by a signal or by the wheel. */
+        if (ABTD_atomic_acquire_load_int(&p_entry->state) !=
+            ABTI_TIMER_ENTRY_TIMEDOUT)
+            break;
+        ABTD_spinlock_acquire(p_lock);
+        ABT_bool is_expired =
+            (ABTI_get_wtime() >= target_time) ? ABT_TRUE : ABT_FALSE;
+        if (is_expired || !p_entry->is_in_waitlist) {
+            /* The entry stays in the waitlist unless a signal has skipped it.
+             * A skipped entry that fired early is a wakeup. */
+            if (p_entry->is_in_waitlist)
+                ABTI_waitlist_remove_timed(p_waitlist, &p_entry->thread);
+            ABTD_spinlock_release(p_lock);
+            *p_is_timedout = is_expired;
+            ABTI_timer_entry_release(p_entry);
+            return ABT_SUCCESS;
+        }
+        /* The ES that owned the wheel has been freed, which fired the entry
+         * early.  Wait again with the wheel of the current ES. */
+        ABTD_atomic_relaxed_store_int(&p_entry->state,
+                                      ABTI_TIMER_ENTRY_WAITING);
+        ABTD_atomic_relaxed_store_int(&p_entry->ref_count, 2);
+        abt_errno = timer_wheel_add(*pp_local_xstream, p_entry, target_time);
+        if (abt_errno != ABT_SUCCESS) {
+            /* The caller polls the time while holding p_lock. */
+            ABTI_waitlist_remove_timed(p_waitlist, &p_entry->thread);
+            ABTU_free(p_entry);
+            return abt_errno;
+        }
+    }
+
+    /* Signaled.  Cancel the entry unless the wheel has dropped it. */
+    *p_is_timedout = ABT_FALSE;
+    ABTI_xstream *p_local_xstream = *pp_local_xstream;
+    if (p_local_xstream == p_entry->p_xstream) {
+        if (p_entry->level >= 0) {
+            timer_wheel_unlink(p_local_xstream->p_timer_wheel, p_entry);
+            ABTI_timer_entry_release(p_entry);
+        }
+    } else if (ABTD_atomic_bool_cas_strong_int(&p_entry->state,
+                                               ABTI_TIMER_ENTRY_SIGNALED,
+                                               ABTI_TIMER_ENTRY_CANCELLED)) {
+        /* The wheel has not dropped the entry yet.  The reference of this ULT
+         * goes to the cancel list. */
+        timer_wheel_cancel(p_entry);
+        return ABT_SUCCESS;
+    }
+    ABTI_timer_entry_release(p_entry);
+    return ABT_SUCCESS;
+}
+
+void ABTI_timer_wheel_process(ABTI_xstream *p_xstream)
+{
+    ABTI_timer_wheel *p_wheel = p_xstream->p_timer_wheel;
+    ABTI_local *p_local = ABTI_xstream_get_local(p_xstream);
+    uint64_t now_tick = timer_wheel_get_cur_tick();
+    timer_wheel_drain_cancel_list(p_wheel);
+
+    while (p_wheel->cur_tick <= now_tick) {
+        if (p_wheel->num_entries == 0) {
+            p_wheel->cur_tick = now_tick + 1;
+            break;
+        }
+        uint64_t cur_tick = p_wheel->cur_tick;
+        int slot = (int)(cur_tick & TIMER_WHEEL_SLOT_MASK);
+        if (slot == 0)
+            timer_wheel_cascade(p_wheel);
+
+        /* Fire the entries of this tick. */
+        ABTI_timer_entry *p_entry = p_wheel->slots[0][slot];
+        if (p_entry) {
+            p_wheel->slots[0][slot] = NULL;
+            p_wheel->bitmaps[0] &= ~((uint64_t)1 << slot);
+            while (p_entry) {
+                ABTI_timer_entry *p_next = p_entry->p_wheel_next;
+                p_entry->level = -1;
+                p_wheel->num_entries--;
+                timer_entry_fire(p_local, p_wheel, p_entry);
+                p_entry = p_next;
+            }
+        }
+
+        /* Skip empty slots, but do not skip the next cascade. */
+        uint64_t next_tick = (cur_tick | TIMER_WHEEL_SLOT_MASK) + 1;
+        uint64_t bits = (slot == ABTI_TIMER_WHEEL_NUM_SLOTS - 1)
+                            ? 0
+                            : (p_wheel->bitmaps[0] >> (slot + 1));
+        if (bits)
+            next_tick = cur_tick + 1 + (uint64_t)__builtin_ctzll(bits);
+        p_wheel->cur_tick = (next_tick <= now_tick) ? next_tick : now_tick + 1;
+    }
+}
+
+/* Returns a time before which no entry fires (DBL_MAX if it is empty). */
+double ABTI_timer_wheel_get_next_time(ABTI_xstream *p_xstream)
+{
+    ABTI_timer_wheel *p_wheel = p_xstream->p_timer_wheel;
+    if (!p_wheel || p_wheel->num_entries == 0)
+        return DBL_MAX;
+    uint64_t cur_tick = p_wheel->cur_tick;
+    /* Entries in upper levels do not fire before the next cascade. */
+    uint64_t next_tick = (cur_tick | TIMER_WHEEL_SLOT_MASK) + 1;
+    int slot = (int)(cur_tick & TIMER_WHEEL_SLOT_MASK);
+    uint64_t bits = p_wheel->bitmaps[0] >> slot;
+    if (bits)
+        next_tick = cur_tick + (uint64_t)__builtin_ctzll(bits);
+    return timer_wheel_tick_to_time(next_tick);
+}
+
+void ABTI_timer_wheel_free(ABTI_local *p_local, ABTI_xstream *p_xstream)
+{
+    ABTI_timer_wheel *p_wheel = p_xstream->p_timer_wheel;
+    if (!p_wheel)
+        return;
+    /* The main scheduler does not finish on join while the wheel has entries,
+     * so usually only the entries of signaled ULTs remain.  If the ES has been
+     * cancelled, the others fire now; the resumed ULT finds that its time has
+     * not come and waits again with the wheel of the ES that runs it. */
+    timer_wheel_drain_cancel_list(p_wheel);
+    int level, slot;
+    for (level = 0; level < ABTI_TIMER_WHEEL_NUM_LEVELS; level++) {
+        for (slot = 0; slot < ABTI_TIMER_WHEEL_NUM_SLOTS; slot++) {
+            ABTI_timer_entry *p_entry = p_wheel->slots[level][slot];
+            while (p_entry) {
+                ABTI_timer_entry *p_next = p_entry->p_wheel_next;
+                p_entry->level = -1;
+                timer_entry_fire(p_local, p_wheel, p_entry);
+                p_entry = p_next;
+            }
+        }
+    }
+    /* A waiter that has cancelled its entry is about to push it. */
+    while (p_wheel->num_cancelled > 0) {
+        ABTD_atomic_pause();
+        timer_wheel_drain_cancel_list(p_wheel);
+    }
+    ABTU_free(p_wheel);
+    p_xstream->p_timer_wheel = NULL;
+}
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+ABTU_ret_err static int timer_wheel_add(ABTI_xstream *p_xstream,
+                                        ABTI_timer_entry *p_entry,
+                                        double target_time)
+{
+    ABTI_timer_wheel *p_wheel = p_xstream->p_timer_wheel;
+    if (!p_wheel) {
+        int abt_errno = ABTU_calloc(1, sizeof(ABTI_timer_wheel),
+                                    (void **)&p_wheel);
+        if (abt_errno != ABT_SUCCESS)
+            return abt_errno;
+        p_wheel->cur_tick = timer_wheel_get_cur_tick();
+        p_xstream->p_timer_wheel = p_wheel;
+    }
+    p_entry->p_xstream = p_xstream;
+    p_entry->expire_tick = timer_wheel_time_to_tick(target_time);
+    timer_wheel_insert(p_wheel, p_entry);
+    return ABT_SUCCESS;
+}
+
+static void timer_wheel_insert(ABTI_timer_wheel *p_wheel,
+                               ABTI_timer_entry *p_entry)
+{
+    uint64_t tick = p_entry->expire_tick;
+    if (tick < p_wheel->cur_tick)
+        tick = p_wheel->cur_tick;
+    uint64_t delta = tick - p_wheel->cur_tick;
+    if (delta >= TIMER_WHEEL_MAX_DELTA) {
+        /* Put it in the last slot.  It is inserted again on cascade. */
+        delta = TIMER_WHEEL_MAX_DELTA - 1;
+        tick = p_wheel->cur_tick + delta;
+    }
+    int level = 0;
+    while (delta >> (ABTI_TIMER_WHEEL_SLOT_BITS * (level + 1)))
+        level++;
+    int slot = (int)((tick >> (ABTI_TIMER_WHEEL_SLOT_BITS * level)) &
+                     TIMER_WHEEL_SLOT_MASK);
+
+    ABTI_timer_entry *p_head = p_wheel->slots[level][slot];
+    p_entry->p_wheel_prev = NULL;
+    p_entry->p_wheel_next = p_head;
+    if (p_head)
+        p_head->p_wheel_prev = p_entry;
+    p_wheel->slots[level][slot] = p_entry;
+    p_wheel->bitmaps[level] |= (uint64_t)1 << slot;
+    p_entry->level = level;
+    p_entry->slot = slot;
+    p_wheel->num_entries++;
+}
+
+static void timer_wheel_unlink(ABTI_timer_wheel *p_wheel,
+                               ABTI_timer_entry *p_entry)
+{
+    int level = p_entry->level, slot = p_entry->slot;
+    if (p_entry->p_wheel_prev) {
+        p_entry->p_wheel_prev->p_wheel_next = p_entry->p_wheel_next;
+    } else {
+        p_wheel->slots[level][slot] = p_entry->p_wheel_next;
+        if (!p_entry->p_wheel_next)
+            p_wheel->bitmaps[level] &= ~((uint64_t)1 << slot);
+    }
+    if (p_entry->p_wheel_next)
+        p_entry->p_wheel_next->p_wheel_prev = p_entry->p_wheel_prev;
+    p_entry->level = -1;
+    p_wheel->num_entries--;
+}
+
+/* Called when cur_tick is a multiple of 64.  Level l is cascaded if cur_tick
+ * is a multiple of 64^l.  Higher levels go first since their entries may move
+ * to a slot of a lower level that is cascaded at the same tick. */
+static void timer_wheel_cascade(ABTI_timer_wheel *p_wheel)
+{
+    uint64_t cur_tick = p_wheel->cur_tick;
+    int top_level = 1;
+    while (top_level < ABTI_TIMER_WHEEL_NUM_LEVELS - 1 &&
+           ((cur_tick >> (ABTI_TIMER_WHEEL_SLOT_BITS * top_level)) &
+            TIMER_WHEEL_SLOT_MASK) == 0)
+        top_level++;
+
+    int level;
+    for (level = top_level; level >= 1; level--) {
+        int slot = (int)((cur_tick >> (ABTI_TIMER_WHEEL_SLOT_BITS * level)) &
+                         TIMER_WHEEL_SLOT_MASK);
+        ABTI_timer_entry *p_entry = p_wheel->slots[level][slot];
+        p_wheel->slots[level][slot] = NULL;
+        p_wheel->bitmaps[level] &= ~((uint64_t)1 << slot);
+        while (p_entry) {
+            ABTI_timer_entry *p_next = p_entry->p_wheel_next;
+            p_wheel->num_entries--;
+            timer_wheel_insert(p_wheel, p_entry);
+            p_entry = p_next;
+        }
+    }
+}
+
+/* Called by a signaled waiter on another ES than the owner of the wheel. */
+static void timer_wheel_cancel(ABTI_timer_entry *p_entry)
+{
+    /* The owner does not free the wheel while this entry is cancelled but not
+     * in the list. */
+    ABTI_timer_wheel *p_wheel = p_entry->p_xstream->p_timer_wheel;
+    ABTI_timer_entry *p_head;
+    do {
+        p_head = (ABTI_timer_entry *)ABTD_atomic_relaxed_load_ptr(
+            &p_wheel->p_cancel_list);
+        p_entry->p_cancel_next = p_head;
+    } while (!ABTD_atomic_bool_cas_weak_ptr(&p_wheel->p_cancel_list, p_head,
+                                            p_entry));
+}
+
+static void timer_wheel_drain_cancel_list(ABTI_timer_wheel *p_wheel)
+{
+    ABTI_timer_entry *p_entry =
+        (ABTI_timer_entry *)ABTD_atomic_exchange_ptr(&p_wheel->p_cancel_list,
+                                                     NULL);
+    while (p_entry) {
+        ABTI_timer_entry *p_next = p_entry->p_cancel_next;
+        if (p_entry->level >= 0) {
+            timer_wheel_unlink(p_wheel, p_entry);
+        } else {
+            /* It has expired.  See timer_entry_fire(). */
+            p_wheel->num_cancelled--;
+        }
+        /* Drop the references of the wheel and the waiter. */
+        ABTI_timer_entry_release(p_entry);
+        ABTI_timer_entry_release(p_entry);
+        p_entry = p_next;
+    }
+}
+
+static void timer_entry_fire(ABTI_local *p_local, ABTI_timer_wheel *p_wheel,
+                             ABTI_timer_entry *p_entry)
+{
+    ABTI_ythread *p_ythread = p_entry->p_ythread;
+    if (!p_entry->p_waitlist) {
+        /* A sleeping ULT.  Do not touch p_entry after resuming it. */
+        ABTD_atomic_relaxed_store_int(&p_entry->state,
+                                      ABTI_TIMER_ENTRY_TIMEDOUT);
+        ABTI_ythread_resume_and_push(p_local, p_ythread);
+    } else if (ABTD_atomic_bool_cas_strong_int(&p_entry->state,
+                                               ABTI_TIMER_ENTRY_WAITING,
+                                               ABTI_TIMER_ENTRY_TIMEDOUT)) {
+        ABTI_ythread_resume_and_push(p_local, p_ythread);
+        ABTI_timer_entry_release(p_entry);
+    } else if (ABTD_atomic_bool_cas_strong_int(&p_entry->state,
+                                               ABTI_TIMER_ENTRY_SIGNALED,
+                                               ABTI_TIMER_ENTRY_DROPPED)) {
+        /* A signal has resumed the ULT, which has not cancelled the entry. */
+        ABTI_timer_entry_release(p_entry);
+    } else {
+        /* The waiter has cancelled it, so the entry is released when the
+         * cancel list is drained. */
+        p_wheel->num_cancelled++;
+    }
+}
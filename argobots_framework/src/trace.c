@@ -0,0 +1,296 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include "abti.h"
+
+#ifdef ABT_CONFIG_USE_TRACE
+
+/* Maximum nesting of ULTs and tasklets on a single ES that the JSON writer
+ * tracks to pair "B" and "E" events. */
+#define ABTI_TRACE_MAX_DEPTH 64
+
+static void trace_write_buffer(FILE *fp, ABTI_trace_buffer *p_trace,
+                               ABTI_trace_record *p_tmp, int pid,
+                               uint64_t base_timestamp, double ticks_per_usec,
+                               ABT_bool *p_is_first);
+static const char *trace_get_thread_name(uint32_t thread_type);
+
+/*****************************************************************************/
+/* Private APIs                                                              */
+/*****************************************************************************/
+
+void ABTI_trace_init(ABTI_global *p_global)
+{
+    ABTD_spinlock_clear(&p_global->trace_lock);
+    p_global->p_trace_head = NULL;
+    p_global->trace_base_wtime = ABTI_get_wtime();
+    p_global->trace_base_timestamp = ABTI_trace_get_timestamp();
+}
+
+void ABTI_trace_finalize(ABTI_global *p_global)
+{
+    if (p_global->trace_enabled == ABT_TRUE) {
+        int abt_errno = ABTI_trace_dump(p_global, p_global->trace_file);
+        if (abt_errno != ABT_SUCCESS) {
+            fprintf(stderr, "ABT_TRACE: failed to write a trace file.\n");
+        }
+    }
+    ABTI_trace_buffer *p_trace = p_global->p_trace_head;
+    while (p_trace) {
+        ABTI_trace_buffer *p_next = p_trace->p_next;
+        ABTI_ASSERT(p_trace->in_use == ABT_FALSE);
+        ABTU_free(p_trace->p_records);
+        ABTU_free(p_trace);
+        p_trace = p_next;
+    }
+    p_global->p_trace_head = NULL;
+    if (p_global->trace_file) {
+        ABTU_free(p_global->trace_file);
+        p_global->trace_file = NULL;
+    }
+}
+
+ABTU_ret_err int ABTI_trace_attach_xstream(ABTI_global *p_global,
+                                           ABTI_xstream *p_xstream)
+{
+    int abt_errno;
+    p_xstream->p_trace = NULL;
+    if (p_global->trace_enabled == ABT_FALSE)
+        return ABT_SUCCESS;
+
+    ABTD_spinlock_acquire(&p_global->trace_lock);
+    /* Reuse a buffer of a freed ES that had the same rank so that the number
+     * of buffers is bounded by the number of ranks ever used. */
+    ABTI_trace_buffer *p_trace = p_global->p_trace_head;
+    while (p_trace) {
+        if (p_trace->in_use == ABT_FALSE && p_trace->rank == p_xstream->rank)
+            break;
+        p_trace = p_trace->p_next;
+    }
+    if (!p_trace) {
+        const size_t num_records = p_global->trace_buffer_size;
+        abt_errno = ABTU_malloc(sizeof(ABTI_trace_buffer), (void **)&p_trace);
+        if (abt_errno != ABT_SUCCESS) {
+            ABTD_spinlock_release(&p_global->trace_lock);
+            return abt_errno;
+        }
+        abt_errno = ABTU_malloc(sizeof(ABTI_trace_record) * num_records,
+                                (void **)&p_trace->p_records);
+        if (abt_errno != ABT_SUCCESS) {
+            ABTU_free(p_trace);
+            ABTD_spinlock_release(&p_global->trace_lock);
+            return abt_errno;
+        }
+        p_trace->rank = p_xstream->rank;
+        p_trace->mask = num_records - 1;
+        ABTD_atomic_relaxed_store_uint64(&p_trace->head, 0);
+        p_trace->p_next = p_global->p_trace_head;
+        p_global->p_trace_head = p_trace;
+    }
+    p_trace->in_use = ABT_TRUE;
+    ABTD_spinlock_release(&p_global->trace_lock);
+
+    p_xstream->p_trace = p_trace;
+    return ABT_SUCCESS;
+}
+
+void ABTI_trace_detach_xstream(ABTI_global *p_global, ABTI_xstream *p_xstream)
+{
+    ABTI_trace_buffer *p_trace = p_xstream->p_trace;
+    if (!p_trace)
+        return;
+    /* Records are kept until ABT_finalize. */
+    p_xstream->p_trace = NULL;
+    ABTD_spinlock_acquire(&p_global->trace_lock);
+    p_trace->in_use = ABT_FALSE;
+    ABTD_spinlock_release(&p_global->trace_lock);
+}
+
+ABTU_ret_err int ABTI_trace_dump(ABTI_global *p_global, const char *filename)
+{
+    int abt_errno;
+    char default_filename[64];
+    const int pid = (int)getpid();
+    if (!filename) {
+        sprintf(default_filename, "abt_trace.%d.json", pid);
+        filename = default_filename;
+    }
+
+    /* Calibrate timestamps against ABTI_get_wtime(). */
+    const double wtime = ABTI_get_wtime();
+    const uint64_t timestamp = ABTI_trace_get_timestamp();
+    const uint64_t base_timestamp = p_global->trace_base_timestamp;
+    double ticks_per_usec = 1.0e3; /* Nanosecond timestamps */
+    if (wtime > p_global->trace_base_wtime && timestamp > base_timestamp) {
+        ticks_per_usec = (double)(timestamp - base_timestamp) /
+                         ((wtime - p_global->trace_base_wtime) * 1.0e6);
+    }
+
+    ABTI_trace_record *p_tmp;
+    abt_errno =
+        ABTU_malloc(sizeof(ABTI_trace_record) * p_global->trace_buffer_size,
+                    (void **)&p_tmp);
+    ABTI_CHECK_ERROR(abt_errno);
+    FILE *fp = fopen(filename, "w");
+    if (!fp) {
+        ABTU_free(p_tmp);
+        ABTI_HANDLE_ERROR(ABT_ERR_SYS);
+    }
+
+    ABT_bool is_first = ABT_TRUE;
+    fprintf(fp, "{\"traceEvents\":[\n");
+    ABTD_spinlock_acquire(&p_global->trace_lock);
+    ABTI_trace_buffer *p_trace = p_global->p_trace_head;
+    while (p_trace) {
+        trace_write_buffer(fp, p_trace, p_tmp, pid, base_timestamp,
+                           ticks_per_usec, &is_first);
+        p_trace = p_trace->p_next;
+    }
+    ABTD_spinlock_release(&p_global->trace_lock);
+    fprintf(fp, "\n],\"displayTimeUnit\":\"ns\"}\n");
+
+    ABTU_free(p_tmp);
+    if (fclose(fp) != 0) {
+        ABTI_HANDLE_ERROR(ABT_ERR_SYS);
+    }
+    return ABT_SUCCESS;
+}
+
+void ABTI_trace_pool_push(ABTI_trace_buffer *p_trace, ABTI_pool *p_pool,
+                          ABT_unit unit)
+{
+    if (unit == ABT_UNIT_NULL)
+        return;
+    ABTI_thread *p_thread =
+        ABTI_unit_get_thread(ABTI_global_get_global(), unit);
+    ABTI_trace_record_event(p_trace, ABTI_TRACE_EVENT_POOL_PUSH, p_thread,
+                            p_pool->id);
+}
+
+void ABTI_trace_pool_pop(ABTI_trace_buffer *p_trace, ABTI_pool *p_pool,
+                         ABT_thread thread)
+{
+    if (thread == ABT_THREAD_NULL)
+        return;
+    ABTI_thread *p_thread = ABTI_thread_get_ptr(thread);
+    ABTI_trace_record_event(p_trace, ABTI_TRACE_EVENT_POOL_POP, p_thread,
+                            p_pool->id);
+}
+
+/*****************************************************************************/
+/* Internal static functions                                                 */
+/*****************************************************************************/
+
+static void trace_write_buffer(FILE *fp, ABTI_trace_buffer *p_trace,
+                               ABTI_trace_record *p_tmp, int pid,
+                               uint64_t base_timestamp, double ticks_per_usec,
+                               ABT_bool *p_is_first)
+{
+    const uint64_t num_records = p_trace->mask + 1;
+    /* The owner ES may keep writing records.  Copy the ring first and then
+     * drop the records that might have been overwritten during the copy. */
+    uint64_t head1 = ABTD_atomic_acquire_load_uint64(&p_trace->head);
+    uint64_t start = head1 > num_records ? head1 - num_records : 0;
+    uint64_t i;
+    for (i = start; i < head1; i++) {
+        p_tmp[i & p_trace->mask] = p_trace->p_records[i & p_trace->mask];
+    }
+    ABTD_atomic_mem_barrier();
+    uint64_t head2 = ABTD_atomic_acquire_load_uint64(&p_trace->head);
+    if (head2 >= num_records && head2 - num_records + 1 > start)
+        start = head2 - num_records + 1;
+
+    fprintf(fp,
+            "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,"
+            "\"args\":{\"name\":\"ES %d\"}}",
+            *p_is_first ? "" : ",\n", pid, p_trace->rank, p_trace->rank);
+    *p_is_first = ABT_FALSE;
+
+    uint64_t stack[ABTI_TRACE_MAX_DEPTH];
+    int depth = 0;
+    double ts = 0.0;
+    for (i = start; i < head1; i++) {
+        const ABTI_trace_record *p_record = &p_tmp[i & p_trace->mask];
+        const uint64_t id = p_record->thread_id;
+        const char *name = trace_get_thread_name(p_record->thread_type);
+        ts = (double)(p_record->timestamp - base_timestamp) / ticks_per_usec;
+        switch (p_record->event) {
+            case ABTI_TRACE_EVENT_RUN:
+                if (depth < ABTI_TRACE_MAX_DEPTH) {
+                    stack[depth++] = id;
+                    fprintf(fp,
+                            ",\n{\"name\":\"%s\",\"cat\":\"thread\","
+                            "\"ph\":\"B\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d,"
+                            "\"args\":{\"id\":%" PRIu64 ",\"pool\":%" PRIu64
+                            "}}",
+                            name, ts, pid, p_trace->rank, id,
+                            p_record->pool_id);
+                }
+                break;
+            case ABTI_TRACE_EVENT_FINISH:
+            case ABTI_TRACE_EVENT_CANCEL:
+            case ABTI_TRACE_EVENT_YIELD:
+            case ABTI_TRACE_EVENT_SUSPEND: {
+                /* Ignore an end event whose begin event was not recorded
+                 * (e.g., overwritten or the primary ULT). */
+                int d = depth;
+                while (d > 0 && stack[d - 1] != id)
+                    d--;
+                if (d == 0)
+                    break;
+                while (depth >= d) {
+                    fprintf(fp,
+                            ",\n{\"ph\":\"E\",\"ts\":%.3f,\"pid\":%d,"
+                            "\"tid\":%d}",
+                            ts, pid, p_trace->rank);
+                    depth--;
+                }
+                break;
+            }
+            default: {
+                const char *event_name =
+                    (p_record->event == ABTI_TRACE_EVENT_CREATE)
+                        ? "create"
+                        : (p_record->event == ABTI_TRACE_EVENT_RESUME)
+                              ? "resume"
+                              : (p_record->event == ABTI_TRACE_EVENT_POOL_PUSH)
+                                    ? "push"
+                                    : "pop";
+                fprintf(fp,
+                        ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"i\","
+                        "\"s\":\"t\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d,"
+                        "\"args\":{\"id\":%" PRIu64 ",\"pool\":%" PRIu64 "}}",
+                        event_name, name, ts, pid, p_trace->rank, id,
+                        p_record->pool_id);
+                break;
+            }
+        }
+    }
+    /* Close threads that are still running. */
+    while (depth > 0) {
+        fprintf(fp, ",\n{\"ph\":\"E\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d}", ts,
+                pid, p_trace->rank);
+        depth--;
+    }
+}
+
+static const char *trace_get_thread_name(uint32_t thread_type)
+{
+    if (thread_type & ABTI_THREAD_TYPE_MAIN_SCHED) {
+        return "sched";
+    } else if (thread_type & ABTI_THREAD_TYPE_ROOT) {
+        return "root";
+    } else if (thread_type & ABTI_THREAD_TYPE_PRIMARY) {
+        return "primary";
+    } else if (thread_type & ABTI_THREAD_TYPE_YIELDABLE) {
+        return "ULT";
+    } else {
+        return "tasklet";
+    }
+}
+
+#endif /* ABT_CONFIG_USE_TRACE */
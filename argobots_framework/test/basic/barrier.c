@@ -13,6 +13,13 @@ int *values;
 ABT_barrier *row_barrier;
 ABT_barrier *col_barrier;
 ABT_barrier global_barrier;
+int num_global_releases;
+
+void global_release_cb(void *arg)
+{
+    /* Called by exactly one waiter per episode of global_barrier. */
+    (*(int *)arg)++;
+}
 
 void run(void *args)
 {
@@ -83,6 +90,10 @@ int main(int argc, char *argv[])
     }
     ret = ABT_barrier_create((size_t)N * N, &global_barrier);
     ATS_ERROR(ret, "ABT_barrier_create");
+    num_global_releases = 0;
+    ret = ABT_barrier_set_callback(global_barrier, global_release_cb,
+                                   (void *)&num_global_releases);
+    ATS_ERROR(ret, "ABT_barrier_set_callback");
 
     args = (int *)malloc(2 * N * N * sizeof(int));
 
@@ -140,6 +151,9 @@ int main(int argc, char *argv[])
         }
     }
 
+    /* global_barrier is passed twice per iteration. */
+    assert(num_global_releases == 2 * iter);
+
     /* Free the barriers */
     for (i = 0; i < N; i++) {
         ret = ABT_barrier_free(&row_barrier[i]);
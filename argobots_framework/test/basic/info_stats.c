@@ -0,0 +1,184 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "abt.h"
+#include "abt_stats.h"
+#include "abttest.h"
+
+/* Check if the live statistics page counts work units while the program is
+ * running.  This test is skipped if Argobots is not configured with
+ * --enable-stats. */
+
+#define DEFAULT_NUM_XSTREAMS 2
+#define DEFAULT_NUM_THREADS 4
+
+void thread_func(void *arg)
+{
+    ABT_thread_yield();
+}
+
+void task_func(void *arg)
+{
+    /* Do nothing. */
+}
+
+uint64_t sum_xstream_counter(const ABT_stats_header *p_hdr, int kind)
+{
+    const ABT_stats_xstream *p_slots =
+        (const ABT_stats_xstream *)(((const char *)p_hdr) +
+                                    p_hdr->xstream_offset);
+    uint64_t sum = 0;
+    uint32_t i;
+    for (i = 0; i < p_hdr->max_xstreams; i++)
+        sum += p_slots[i].counters[kind];
+    return sum;
+}
+
+const ABT_stats_pool *find_pool_slot(const ABT_stats_header *p_hdr,
+                                     ABT_pool pool)
+{
+    const ABT_stats_pool *p_slots =
+        (const ABT_stats_pool *)(((const char *)p_hdr) + p_hdr->pool_offset);
+    int id, ret;
+    uint32_t i;
+    ret = ABT_pool_get_id(pool, &id);
+    ATS_ERROR(ret, "ABT_pool_get_id");
+    for (i = 1; i < p_hdr->max_pools; i++) {
+        if (p_slots[i].in_use && p_slots[i].id == (uint64_t)id)
+            return &p_slots[i];
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    int i, j, ret;
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    char filename[64];
+
+    sprintf(filename, "abt_stats_test.%d", (int)getpid());
+    setenv("ABT_STATS", "1", 1);
+    setenv("ABT_STATS_FILE", filename, 1);
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc >= 2) {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads = ATS_get_arg_val(ATS_ARG_N_ULT);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    ABT_bool stats_enabled;
+    ret = ABT_info_query_config(ABT_INFO_QUERY_KIND_ENABLED_STATS,
+                                (void *)&stats_enabled);
+    ATS_ERROR(ret, "ABT_info_query_config");
+    if (!stats_enabled) {
+        ATS_ERROR(ABT_ERR_FEATURE_NA, "ABT_info_query_config");
+    }
+
+    /* Map the page as another process would. */
+    int fd = open(filename, O_RDONLY);
+    assert(fd != -1);
+    struct stat st;
+    ret = fstat(fd, &st);
+    assert(ret == 0);
+    const size_t size = (size_t)st.st_size;
+    const ABT_stats_header *p_hdr =
+        (const ABT_stats_header *)mmap(NULL, size, PROT_READ, MAP_SHARED, fd,
+                                       0);
+    assert(p_hdr != MAP_FAILED);
+    close(fd);
+    assert(p_hdr->magic == ABT_STATS_MAGIC);
+    assert(p_hdr->version == ABT_STATS_VERSION);
+    assert(p_hdr->pid == (uint32_t)getpid());
+    assert(p_hdr->num_xstream_counters == ABT_STATS_XSTREAM_NUM_COUNTERS);
+    assert(p_hdr->num_pool_counters == ABT_STATS_POOL_NUM_COUNTERS);
+    assert(p_hdr->pool_offset + sizeof(ABT_stats_pool) * p_hdr->max_pools <=
+           size);
+
+    ABT_xstream *xstreams =
+        (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    ABT_pool *pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+    const ABT_stats_pool *p_pool_stats = find_pool_slot(p_hdr, pools[0]);
+    assert(p_pool_stats);
+    const uint64_t pool_pushes =
+        p_pool_stats->counters[ABT_STATS_POOL_PUSHES];
+    const uint64_t created =
+        sum_xstream_counter(p_hdr, ABT_STATS_XSTREAM_THREAD_CREATED);
+    const uint64_t finished =
+        sum_xstream_counter(p_hdr, ABT_STATS_XSTREAM_THREAD_FINISHED);
+
+    /* Create ULTs and tasklets. */
+    ABT_thread *threads =
+        (ABT_thread *)malloc(sizeof(ABT_thread) * num_xstreams * num_threads);
+    for (i = 0; i < num_xstreams; i++) {
+        for (j = 0; j < num_threads; j++) {
+            ret = ABT_thread_create(pools[i], thread_func, NULL,
+                                    ABT_THREAD_ATTR_NULL,
+                                    &threads[i * num_threads + j]);
+            ATS_ERROR(ret, "ABT_thread_create");
+            ret = ABT_task_create(pools[i], task_func, NULL, NULL);
+            ATS_ERROR(ret, "ABT_task_create");
+        }
+    }
+    for (i = 0; i < num_xstreams * num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+
+    /* Counters are visible while Argobots is running.  Each ULT is pushed at
+     * least twice since it yields. */
+    const uint64_t num_units = (uint64_t)(num_xstreams * num_threads * 2);
+    assert(p_pool_stats->counters[ABT_STATS_POOL_PUSHES] - pool_pushes >=
+           (uint64_t)num_threads * 3);
+    assert(sum_xstream_counter(p_hdr, ABT_STATS_XSTREAM_THREAD_CREATED) -
+               created >=
+           num_units);
+    assert(sum_xstream_counter(p_hdr, ABT_STATS_XSTREAM_POPS) >= num_units);
+    assert(sum_xstream_counter(p_hdr, ABT_STATS_XSTREAM_SWITCHES) >=
+           num_units);
+    assert(p_hdr->finalized == 0);
+
+    /* Join and free execution streams. */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+    /* Tasklets on the other execution streams have finished. */
+    ret = ABT_thread_yield();
+    ATS_ERROR(ret, "ABT_thread_yield");
+    assert(sum_xstream_counter(p_hdr, ABT_STATS_XSTREAM_THREAD_FINISHED) -
+               finished >=
+           num_units);
+
+    /* Finalize, which removes the file. */
+    ret = ATS_finalize(0);
+    assert(p_hdr->finalized != 0);
+    assert(access(filename, F_OK) == -1);
+    munmap((void *)p_hdr, size);
+
+    free(threads);
+    free(pools);
+    free(xstreams);
+
+    return ret;
+}
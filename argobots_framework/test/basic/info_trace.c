@@ -0,0 +1,120 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "abt.h"
+#include "abttest.h"
+
+/* Check if ABT_info_dump_trace() writes events in the Chrome trace format.
+ * This test is skipped if Argobots is not configured with --enable-trace. */
+
+#define DEFAULT_NUM_XSTREAMS 2
+#define DEFAULT_NUM_THREADS 4
+
+void thread_func(void *arg)
+{
+    ABT_thread_yield();
+}
+
+void task_func(void *arg)
+{
+    /* Do nothing. */
+}
+
+void check_trace_file(const char *filename)
+{
+    FILE *fp = fopen(filename, "r");
+    assert(fp);
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *buffer = (char *)malloc(size + 1);
+    size_t len = fread(buffer, 1, size, fp);
+    buffer[len] = '\0';
+    fclose(fp);
+
+    assert(strncmp(buffer, "{\"traceEvents\":[", 16) == 0);
+    assert(strstr(buffer, "\"name\":\"ULT\""));
+    assert(strstr(buffer, "\"name\":\"tasklet\""));
+    assert(strstr(buffer, "\"ph\":\"B\""));
+    assert(strstr(buffer, "\"ph\":\"E\""));
+    assert(strstr(buffer, "\"name\":\"push\""));
+    assert(strstr(buffer, "\"name\":\"pop\""));
+    free(buffer);
+}
+
+int main(int argc, char *argv[])
+{
+    int i, j, ret;
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    int num_threads = DEFAULT_NUM_THREADS;
+    char dump_filename[64], final_filename[64];
+
+    sprintf(dump_filename, "abt_trace_dump.%d.json", (int)getpid());
+    sprintf(final_filename, "abt_trace_final.%d.json", (int)getpid());
+    setenv("ABT_TRACE", "1", 1);
+    setenv("ABT_TRACE_FILE", final_filename, 1);
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc >= 2) {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads = ATS_get_arg_val(ATS_ARG_N_ULT);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    ABT_xstream *xstreams =
+        (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    ABT_pool *pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* Create ULTs and tasklets. */
+    for (i = 0; i < num_xstreams; i++) {
+        for (j = 0; j < num_threads; j++) {
+            ret = ABT_thread_create(pools[i], thread_func, NULL,
+                                    ABT_THREAD_ATTR_NULL, NULL);
+            ATS_ERROR(ret, "ABT_thread_create");
+            ret = ABT_task_create(pools[i], task_func, NULL, NULL);
+            ATS_ERROR(ret, "ABT_task_create");
+        }
+    }
+
+    /* Join and free execution streams. */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+    /* Run the rest of the work units on the primary execution stream. */
+    ret = ABT_thread_yield();
+    ATS_ERROR(ret, "ABT_thread_yield");
+
+    /* Write the trace on demand. */
+    ret = ABT_info_dump_trace(dump_filename);
+    ATS_ERROR(ret, "ABT_info_dump_trace");
+    check_trace_file(dump_filename);
+    remove(dump_filename);
+
+    /* Finalize, which writes the trace to final_filename. */
+    ret = ATS_finalize(0);
+    check_trace_file(final_filename);
+    remove(final_filename);
+
+    free(pools);
+    free(xstreams);
+
+    return ret;
+}
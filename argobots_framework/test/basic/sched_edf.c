@@ -0,0 +1,340 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS 4
+#define DEFAULT_NUM_THREADS 4
+#define NUM_ORDERED_THREADS 16
+
+static int num_threads = DEFAULT_NUM_THREADS;
+
+static int g_counter = 0;
+static ABT_mutex g_mutex = ABT_MUTEX_NULL;
+
+static int g_order[NUM_ORDERED_THREADS];
+static int g_num_ordered = 0;
+
+static void ordered_func(void *arg)
+{
+    g_order[g_num_ordered++] = (int)(intptr_t)arg;
+}
+
+/* ULTs pushed before the scheduler starts must run in deadline order, and the
+ * ones without a deadline after them in FIFO order. */
+static void test_order(void)
+{
+    int i, ret;
+    ABT_pool pool;
+    ABT_sched sched;
+    ABT_xstream xstream;
+    ABT_thread_attr attr;
+    ABT_thread threads[NUM_ORDERED_THREADS];
+    const int num_deadlines = NUM_ORDERED_THREADS / 2;
+
+    ret = ABT_pool_create_basic(ABT_POOL_EDF, ABT_POOL_ACCESS_MPMC, ABT_TRUE,
+                                &pool);
+    ATS_ERROR(ret, "ABT_pool_create_basic");
+    ret = ABT_thread_attr_create(&attr);
+    ATS_ERROR(ret, "ABT_thread_attr_create");
+
+    for (i = 0; i < NUM_ORDERED_THREADS; i++) {
+        ABT_thread_attr attr_i = ABT_THREAD_ATTR_NULL;
+        if (i < num_deadlines) {
+            /* Deadlines in the order 7, 0, 1, ..., 6: the last created ULT
+             * with a deadline has to run first. */
+            int rank = (i == num_deadlines - 1) ? -1 : i;
+            ret = ABT_thread_attr_set_deadline(attr, 100.0 + rank);
+            ATS_ERROR(ret, "ABT_thread_attr_set_deadline");
+            attr_i = attr;
+        }
+        ret = ABT_thread_create(pool, ordered_func, (void *)(intptr_t)i, attr_i,
+                                &threads[i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+
+    ret = ABT_sched_create_basic(ABT_SCHED_EDF, 1, &pool, ABT_SCHED_CONFIG_NULL,
+                                 &sched);
+    ATS_ERROR(ret, "ABT_sched_create_basic");
+    ret = ABT_xstream_create(sched, &xstream);
+    ATS_ERROR(ret, "ABT_xstream_create");
+    for (i = 0; i < NUM_ORDERED_THREADS; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+    ret = ABT_xstream_free(&xstream);
+    ATS_ERROR(ret, "ABT_xstream_free");
+    ret = ABT_thread_attr_free(&attr);
+    ATS_ERROR(ret, "ABT_thread_attr_free");
+
+    assert(g_num_ordered == NUM_ORDERED_THREADS);
+    assert(g_order[0] == num_deadlines - 1);
+    for (i = 1; i < NUM_ORDERED_THREADS; i++) {
+        int expected = (i < num_deadlines) ? i - 1 : i;
+        if (g_order[i] != expected) {
+            fprintf(stderr, "g_order[%d]=%d vs. expected=%d\n", i, g_order[i],
+                    expected);
+        }
+        assert(g_order[i] == expected);
+    }
+}
+
+#define NUM_YIELD_TO_THREADS 4
+
+static void yield_to_func(void *arg)
+{
+    ATS_UNUSED(arg);
+    int i, ret;
+    ABT_pool pool;
+    ABT_thread_attr attr;
+    ABT_thread threads[NUM_YIELD_TO_THREADS];
+
+    ret = ABT_self_get_last_pool(&pool);
+    ATS_ERROR(ret, "ABT_self_get_last_pool");
+    ret = ABT_thread_attr_create(&attr);
+    ATS_ERROR(ret, "ABT_thread_attr_create");
+    for (i = 0; i < NUM_YIELD_TO_THREADS; i++) {
+        ret = ABT_thread_attr_set_deadline(attr, 100.0 + i);
+        ATS_ERROR(ret, "ABT_thread_attr_set_deadline");
+        ret = ABT_thread_create(pool, ordered_func, (void *)(intptr_t)i, attr,
+                                &threads[i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+    ret = ABT_thread_attr_free(&attr);
+    ATS_ERROR(ret, "ABT_thread_attr_free");
+
+    /* A queued ULT with a deadline is in the pool, so it can be removed from
+     * the heap and run directly.  The caller has no deadline and resumes after
+     * the others. */
+    ret = ABT_thread_yield_to(threads[2]);
+    ATS_ERROR(ret, "ABT_thread_yield_to");
+    assert(g_num_ordered == NUM_YIELD_TO_THREADS);
+    assert(g_order[0] == 2 && g_order[1] == 0 && g_order[2] == 1 &&
+           g_order[3] == 3);
+
+    for (i = 0; i < NUM_YIELD_TO_THREADS; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+}
+
+static void test_yield_to(void)
+{
+    int ret;
+    ABT_pool pool;
+    ABT_sched sched;
+    ABT_xstream xstream;
+    ABT_thread thread;
+
+    g_num_ordered = 0;
+    ret = ABT_pool_create_basic(ABT_POOL_EDF, ABT_POOL_ACCESS_MPMC, ABT_TRUE,
+                                &pool);
+    ATS_ERROR(ret, "ABT_pool_create_basic");
+    ret = ABT_sched_create_basic(ABT_SCHED_EDF, 1, &pool, ABT_SCHED_CONFIG_NULL,
+                                 &sched);
+    ATS_ERROR(ret, "ABT_sched_create_basic");
+    ret = ABT_xstream_create(sched, &xstream);
+    ATS_ERROR(ret, "ABT_xstream_create");
+    ret = ABT_thread_create(pool, yield_to_func, NULL, ABT_THREAD_ATTR_NULL,
+                            &thread);
+    ATS_ERROR(ret, "ABT_thread_create");
+    ret = ABT_thread_free(&thread);
+    ATS_ERROR(ret, "ABT_thread_free");
+    ret = ABT_xstream_free(&xstream);
+    ATS_ERROR(ret, "ABT_xstream_free");
+}
+
+static void test_attr(void)
+{
+    int ret;
+    double deadline = -1.0;
+    ABT_bool has_deadline;
+    ABT_thread_attr attr;
+
+    ret = ABT_thread_attr_create(&attr);
+    ATS_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_attr_get_deadline(attr, &deadline, &has_deadline);
+    ATS_ERROR(ret, "ABT_thread_attr_get_deadline");
+    assert(has_deadline == ABT_FALSE && deadline == -1.0);
+    ret = ABT_thread_attr_set_deadline(attr, 2.5);
+    ATS_ERROR(ret, "ABT_thread_attr_set_deadline");
+    ret = ABT_thread_attr_get_deadline(attr, &deadline, &has_deadline);
+    ATS_ERROR(ret, "ABT_thread_attr_get_deadline");
+    assert(has_deadline == ABT_TRUE && deadline == 2.5);
+    ret = ABT_thread_attr_free(&attr);
+    ATS_ERROR(ret, "ABT_thread_attr_free");
+}
+
+static void thread_func(void *arg)
+{
+    ATS_UNUSED(arg);
+    int old_rank, cur_rank;
+    ABT_thread self;
+    ABT_unit_id id;
+    char *msg;
+
+    ABT_xstream_self_rank(&cur_rank);
+    ABT_thread_self(&self);
+    ABT_thread_get_id(self, &id);
+
+    ATS_printf(1, "[U%lu:E%d] Hello, world!\n", id, cur_rank);
+
+    ABT_thread_yield();
+
+    old_rank = cur_rank;
+    ABT_xstream_self_rank(&cur_rank);
+    msg = (cur_rank == old_rank) ? "" : " (stolen)";
+    ATS_printf(1, "[U%lu:E%d] Goodbye, world!%s\n", id, cur_rank, msg);
+
+    ABT_mutex_lock(g_mutex);
+    g_counter++;
+    ABT_mutex_unlock(g_mutex);
+}
+
+static void create_threads(void *arg)
+{
+    ATS_UNUSED(arg);
+    int i, ret;
+    ABT_xstream xstream;
+    ABT_pool pool;
+    ABT_thread_attr attr;
+    ABT_thread *threads;
+
+    ret = ABT_xstream_self(&xstream);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_get_main_pools(xstream, 1, &pool);
+    ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    ret = ABT_thread_attr_create(&attr);
+    ATS_ERROR(ret, "ABT_thread_attr_create");
+
+    /* Half of the ULTs have a deadline. */
+    threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_attr_set_deadline(attr, ABT_get_wtime() + 1.0e-3 * i);
+        ATS_ERROR(ret, "ABT_thread_attr_set_deadline");
+        ret = ABT_thread_create(pool, thread_func, NULL,
+                                (i % 2) ? attr : ABT_THREAD_ATTR_NULL,
+                                &threads[i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+    free(threads);
+    ret = ABT_thread_attr_free(&attr);
+    ATS_ERROR(ret, "ABT_thread_attr_free");
+}
+
+int main(int argc, char *argv[])
+{
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+    ABT_xstream *xstreams;
+    ABT_sched *scheds;
+    ABT_pool *pools, *my_pools;
+    ABT_thread *main_threads;
+    int i, k, ret;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc > 1) {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads = ATS_get_arg_val(ATS_ARG_N_ULT);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    ATS_printf(1,
+               "# of ESs    : %d\n"
+               "# of ULTs/ES: %d\n",
+               num_xstreams, num_threads);
+
+    test_attr();
+    test_order();
+    test_yield_to();
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    scheds = (ABT_sched *)malloc(num_xstreams * sizeof(ABT_sched));
+    pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    main_threads = (ABT_thread *)malloc(num_xstreams * sizeof(ABT_thread));
+
+    /* Create a mutex */
+    ret = ABT_mutex_create(&g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_create");
+
+    /* Create pools */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_pool_create_basic(ABT_POOL_EDF, ABT_POOL_ACCESS_MPMC,
+                                    ABT_TRUE, &pools[i]);
+        ATS_ERROR(ret, "ABT_pool_create_basic");
+    }
+
+    /* Create schedulers that steal from the other pools */
+    my_pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+    for (i = 0; i < num_xstreams; i++) {
+        for (k = 0; k < num_xstreams; k++) {
+            my_pools[k] = pools[(i + k) % num_xstreams];
+        }
+
+        ret = ABT_sched_create_basic(ABT_SCHED_EDF, num_xstreams, my_pools,
+                                     ABT_SCHED_CONFIG_NULL, &scheds[i]);
+        ATS_ERROR(ret, "ABT_sched_create_basic");
+    }
+    free(my_pools);
+
+    /* Create Execution Streams */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    ret = ABT_xstream_set_main_sched(xstreams[0], scheds[0]);
+    ATS_ERROR(ret, "ABT_xstream_set_main_sched");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(scheds[i], &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+
+    /* Create main ULTs */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_thread_create(pools[i], create_threads, NULL,
+                                ABT_THREAD_ATTR_NULL, &main_threads[i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+
+    /* Join and free main ULTs */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_thread_free(&main_threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+
+    /* Join and free Execution Streams */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    /* Free the mutex */
+    ret = ABT_mutex_free(&g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_free");
+
+    /* Validation */
+    int expected = num_xstreams * num_threads;
+    if (g_counter != expected) {
+        fprintf(stderr, "expected=%d vs. g_counter=%d\n", expected, g_counter);
+    }
+    assert(g_counter == expected);
+
+    /* Finalize */
+    ret = ATS_finalize(0);
+
+    free(xstreams);
+    free(scheds);
+    free(pools);
+    free(main_threads);
+
+    return ret;
+}
@@ -0,0 +1,348 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/time.h>
+#include "abt.h"
+#include "abttest.h"
+
+#define DEFAULT_NUM_XSTREAMS 4
+#define DEFAULT_NUM_THREADS 4
+#define NUM_SLEEPS 3
+#define SLEEP_NSECS 5000000  /* 5 ms */
+#define SHORT_TIMEOUT 0.01   /* [s] */
+#define LONG_TIMEOUT 10.0    /* [s] */
+#define SHARED_TIMEOUT 0.05  /* [s] */
+
+static ABT_mutex g_mutex = ABT_MUTEX_NULL;
+static ABT_eventual g_eventual = ABT_EVENTUAL_NULL;
+static ABT_future g_future = ABT_FUTURE_NULL;
+static int g_counter = 0;
+static volatile int g_waiting_rank = -1;
+
+static void get_abstime(double timeout, struct timespec *p_ts)
+{
+    struct timeval tv;
+    int ret = gettimeofday(&tv, NULL);
+    assert(!ret);
+    double abstime = tv.tv_sec + tv.tv_usec * 1.0e-6 + timeout;
+    p_ts->tv_sec = (time_t)abstime;
+    p_ts->tv_nsec = (long)((abstime - (double)p_ts->tv_sec) * 1.0e9);
+}
+
+static void sleep_func(void *arg)
+{
+    int i, ret;
+    for (i = 0; i < NUM_SLEEPS; i++) {
+        double start_time = ABT_get_wtime();
+        ret = ABT_self_sleep(SLEEP_NSECS);
+        ATS_ERROR(ret, "ABT_self_sleep");
+        double elapsed = ABT_get_wtime() - start_time;
+        /* A ULT must never wake up early. */
+        assert(elapsed >= SLEEP_NSECS * 1.0e-9);
+    }
+    ret = ABT_mutex_lock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_lock");
+    g_counter++;
+    ret = ABT_mutex_unlock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_unlock");
+}
+
+static void timeout_func(void *arg)
+{
+    int ret;
+    struct timespec ts;
+    double start_time = ABT_get_wtime();
+
+    /* The primary ULT holds g_mutex, and nobody sets g_eventual and
+     * g_future. */
+    get_abstime(SHORT_TIMEOUT, &ts);
+    ret = ABT_mutex_timedlock(g_mutex, &ts);
+    assert(ret == ABT_ERR_TIMEDOUT);
+    get_abstime(SHORT_TIMEOUT, &ts);
+    ret = ABT_eventual_timedwait(g_eventual, NULL, &ts);
+    assert(ret == ABT_ERR_TIMEDOUT);
+    get_abstime(SHORT_TIMEOUT, &ts);
+    ret = ABT_future_timedwait(g_future, &ts);
+    assert(ret == ABT_ERR_TIMEDOUT);
+    assert(ABT_get_wtime() - start_time >= 3 * SHORT_TIMEOUT);
+}
+
+static void signaled_func(void *arg)
+{
+    int ret;
+    struct timespec ts;
+
+    get_abstime(LONG_TIMEOUT, &ts);
+    ret = ABT_eventual_timedwait(g_eventual, NULL, &ts);
+    ATS_ERROR(ret, "ABT_eventual_timedwait");
+    ret = ABT_future_timedwait(g_future, &ts);
+    ATS_ERROR(ret, "ABT_future_timedwait");
+    ret = ABT_mutex_timedlock(g_mutex, &ts);
+    ATS_ERROR(ret, "ABT_mutex_timedlock");
+    g_counter++;
+    ret = ABT_mutex_unlock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_unlock");
+}
+
+static void migrated_func(void *arg)
+{
+    int ret;
+    struct timespec ts;
+
+    /* A signal pushes this ULT to the pool of another ES, which cancels the
+     * timer of this ES. */
+    ret = ABT_self_set_associated_pool((ABT_pool)arg);
+    ATS_ERROR(ret, "ABT_self_set_associated_pool");
+    get_abstime(LONG_TIMEOUT, &ts);
+    ret = ABT_eventual_timedwait(g_eventual, NULL, &ts);
+    ATS_ERROR(ret, "ABT_eventual_timedwait");
+    ret = ABT_mutex_lock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_lock");
+    g_counter++;
+    ret = ABT_mutex_unlock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_unlock");
+}
+
+static void shared_sleep_func(void *arg)
+{
+    int ret, rank;
+    ret = ABT_self_get_xstream_rank(&rank);
+    ATS_ERROR(ret, "ABT_self_get_xstream_rank");
+    double start_time = ABT_get_wtime();
+    ATS_atomic_store(&g_waiting_rank, rank);
+    ret = ABT_self_sleep((uint64_t)(SHARED_TIMEOUT * 1.0e9));
+    ATS_ERROR(ret, "ABT_self_sleep");
+    /* Neither join nor free of the ES shortens the sleep. */
+    assert(ABT_get_wtime() - start_time >= SHARED_TIMEOUT);
+}
+
+static void shared_timeout_func(void *arg)
+{
+    int ret, rank;
+    struct timespec ts;
+    ret = ABT_self_get_xstream_rank(&rank);
+    ATS_ERROR(ret, "ABT_self_get_xstream_rank");
+    double start_time = ABT_get_wtime();
+    get_abstime(SHARED_TIMEOUT, &ts);
+    ATS_atomic_store(&g_waiting_rank, rank);
+    ret = ABT_eventual_timedwait(g_eventual, NULL, &ts);
+    assert(ret == ABT_ERR_TIMEDOUT);
+    assert(ABT_get_wtime() - start_time >= SHARED_TIMEOUT);
+}
+
+/* Two ESs share a pool, and the ES on which a ULT started to wait is joined or
+ * cancelled and then freed while the ULT is waiting.  The other ES runs the
+ * ULT after that. */
+static void run_shared_pool(void (*func)(void *), ABT_bool is_cancel)
+{
+    int i, ret, rank;
+    ABT_pool pool;
+    ABT_sched scheds[2];
+    ABT_xstream xstreams[2];
+    ABT_thread thread;
+
+    ret = ABT_pool_create_basic(ABT_POOL_FIFO, ABT_POOL_ACCESS_MPMC, ABT_TRUE,
+                                &pool);
+    ATS_ERROR(ret, "ABT_pool_create_basic");
+    for (i = 0; i < 2; i++) {
+        ret = ABT_sched_create_basic(ABT_SCHED_BASIC, 1, &pool,
+                                     ABT_SCHED_CONFIG_NULL, &scheds[i]);
+        ATS_ERROR(ret, "ABT_sched_create_basic");
+        ret = ABT_xstream_create(scheds[i], &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    ATS_atomic_store(&g_waiting_rank, -1);
+    ret = ABT_thread_create(pool, func, NULL, ABT_THREAD_ATTR_NULL, &thread);
+    ATS_ERROR(ret, "ABT_thread_create");
+    while (ATS_atomic_load(&g_waiting_rank) == -1) {
+        ret = ABT_thread_yield();
+        ATS_ERROR(ret, "ABT_thread_yield");
+    }
+    ret = ABT_xstream_get_rank(xstreams[0], &rank);
+    ATS_ERROR(ret, "ABT_xstream_get_rank");
+    i = (rank == ATS_atomic_load(&g_waiting_rank)) ? 0 : 1;
+
+    if (is_cancel) {
+        ret = ABT_xstream_cancel(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_cancel");
+    } else {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+    }
+    ret = ABT_xstream_free(&xstreams[i]);
+    ATS_ERROR(ret, "ABT_xstream_free");
+    ret = ABT_thread_free(&thread);
+    ATS_ERROR(ret, "ABT_thread_free");
+    ret = ABT_xstream_free(&xstreams[1 - i]);
+    ATS_ERROR(ret, "ABT_xstream_free");
+}
+
+static void run_threads(void (*func)(void *), ABT_pool *pools, int num_pools,
+                        int num_threads)
+{
+    int i, ret;
+    ABT_thread *threads = (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[i % num_pools], func, NULL,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+    free(threads);
+}
+
+int main(int argc, char *argv[])
+{
+    ABT_xstream *xstreams;
+    ABT_pool *pools;
+    ABT_thread thread;
+    int num_xstreams;
+    int num_threads;
+    int ret, i;
+    size_t size, total_size;
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc < 2) {
+        num_xstreams = DEFAULT_NUM_XSTREAMS;
+        num_threads = DEFAULT_NUM_THREADS;
+    } else {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+        num_threads = ATS_get_arg_val(ATS_ARG_N_ULT);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    xstreams = (ABT_xstream *)malloc(num_xstreams * sizeof(ABT_xstream));
+    pools = (ABT_pool *)malloc(num_xstreams * sizeof(ABT_pool));
+
+    ret = ABT_mutex_create(&g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_create");
+    ret = ABT_eventual_create(0, &g_eventual);
+    ATS_ERROR(ret, "ABT_eventual_create");
+    ret = ABT_future_create(1, NULL, &g_future);
+    ATS_ERROR(ret, "ABT_future_create");
+
+    /* Create ESs */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+    }
+
+    /* A sleeping ULT is blocked, so it does not occupy its pool. */
+    ret = ABT_thread_create(pools[0], sleep_func, NULL, ABT_THREAD_ATTR_NULL,
+                            &thread);
+    ATS_ERROR(ret, "ABT_thread_create");
+    ret = ABT_thread_yield();
+    ATS_ERROR(ret, "ABT_thread_yield");
+    ret = ABT_pool_get_size(pools[0], &size);
+    ATS_ERROR(ret, "ABT_pool_get_size");
+    ret = ABT_pool_get_total_size(pools[0], &total_size);
+    ATS_ERROR(ret, "ABT_pool_get_total_size");
+    assert(size == 0 && total_size == 1);
+    ret = ABT_thread_free(&thread);
+    ATS_ERROR(ret, "ABT_thread_free");
+
+    /* Sleep on all the ESs. */
+    run_threads(sleep_func, pools, num_xstreams, num_threads);
+
+    /* Timeouts */
+    ret = ABT_mutex_lock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_lock");
+    run_threads(timeout_func, pools, num_xstreams, num_threads);
+    ret = ABT_mutex_unlock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_unlock");
+
+    /* Signals before timeouts.  Set the eventual and the future after the ULTs
+     * start to wait. */
+    ABT_thread *threads =
+        (ABT_thread *)malloc(num_threads * sizeof(ABT_thread));
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[i % num_xstreams], signaled_func, NULL,
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+    ret = ABT_self_sleep(SLEEP_NSECS);
+    ATS_ERROR(ret, "ABT_self_sleep");
+    ret = ABT_eventual_set(g_eventual, NULL, 0);
+    ATS_ERROR(ret, "ABT_eventual_set");
+    ret = ABT_future_set(g_future, NULL);
+    ATS_ERROR(ret, "ABT_future_set");
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+
+    /* Signals of ULTs that resume on another ES. */
+    ret = ABT_eventual_reset(g_eventual);
+    ATS_ERROR(ret, "ABT_eventual_reset");
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_create(pools[i % num_xstreams], migrated_func,
+                                (void *)pools[(i + 1) % num_xstreams],
+                                ABT_THREAD_ATTR_NULL, &threads[i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+    ret = ABT_self_sleep(SLEEP_NSECS);
+    ATS_ERROR(ret, "ABT_self_sleep");
+    ret = ABT_eventual_set(g_eventual, NULL, 0);
+    ATS_ERROR(ret, "ABT_eventual_set");
+    for (i = 0; i < num_threads; i++) {
+        ret = ABT_thread_free(&threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+    /* Let the ESs drain their cancel lists before they are freed. */
+    ret = ABT_self_sleep(SLEEP_NSECS);
+    ATS_ERROR(ret, "ABT_self_sleep");
+    free(threads);
+
+    /* Join or free the ES on which a ULT is waiting. */
+    ret = ABT_eventual_reset(g_eventual);
+    ATS_ERROR(ret, "ABT_eventual_reset");
+    for (i = 0; i < 2; i++) {
+        ABT_bool is_cancel = (i == 0) ? ABT_FALSE : ABT_TRUE;
+        run_shared_pool(shared_sleep_func, is_cancel);
+        run_shared_pool(shared_timeout_func, is_cancel);
+    }
+
+    /* Join and free ESs */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+
+    ret = ABT_future_free(&g_future);
+    ATS_ERROR(ret, "ABT_future_free");
+    ret = ABT_eventual_free(&g_eventual);
+    ATS_ERROR(ret, "ABT_eventual_free");
+    ret = ABT_mutex_free(&g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_free");
+
+    /* Validation */
+    int expected = 1 + num_threads * 3;
+    if (g_counter != expected) {
+        printf("g_counter = %d (expected: %d)\n", g_counter, expected);
+    }
+
+    /* Finalize */
+    ret = ATS_finalize(g_counter != expected);
+
+    free(pools);
+    free(xstreams);
+
+    return ret;
+}
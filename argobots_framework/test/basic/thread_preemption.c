@@ -0,0 +1,201 @@
+/* -*- Mode: C; c-basic-offset:4 ; indent-tabs-mode:nil ; -*- */
+/*
+ * See COPYRIGHT in top-level directory.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "abt.h"
+#include "abttest.h"
+
+/* Each ES runs a preemptible ULT that never yields and a short ULT pushed after
+ * it.  The short ULTs can run only if the spinning ULTs are preempted. */
+
+#define DEFAULT_NUM_XSTREAMS 2
+#define SPIN_TIMEOUT 10.0 /* [s] */
+
+static volatile int g_done = 0;
+static int g_num_short = 0;
+static int g_num_timeouts = 0;
+static ABT_mutex g_mutex = ABT_MUTEX_NULL;
+
+static void spin_func(void *arg)
+{
+    int ret;
+    ABT_thread self;
+    ABT_bool is_preemptible;
+    ret = ABT_self_get_thread(&self);
+    ATS_ERROR(ret, "ABT_self_get_thread");
+    ret = ABT_thread_is_preemptible(self, &is_preemptible);
+    ATS_ERROR(ret, "ABT_thread_is_preemptible");
+    assert(is_preemptible == ABT_TRUE);
+
+    double start_time = ABT_get_wtime();
+    volatile unsigned long count = 0;
+    while (!g_done) {
+        /* Spin without calling Argobots. */
+        count++;
+        if ((count & 0xfffff) == 0 &&
+            ABT_get_wtime() - start_time > SPIN_TIMEOUT) {
+            ret = ABT_mutex_lock(g_mutex);
+            ATS_ERROR(ret, "ABT_mutex_lock");
+            g_num_timeouts++;
+            ret = ABT_mutex_unlock(g_mutex);
+            ATS_ERROR(ret, "ABT_mutex_unlock");
+            break;
+        }
+    }
+}
+
+static void short_func(void *arg)
+{
+    int ret;
+    ABT_thread self;
+    ABT_bool is_preemptible;
+    ret = ABT_self_get_thread(&self);
+    ATS_ERROR(ret, "ABT_self_get_thread");
+    ret = ABT_thread_is_preemptible(self, &is_preemptible);
+    ATS_ERROR(ret, "ABT_thread_is_preemptible");
+    assert(is_preemptible == ABT_FALSE);
+
+    /* A ULT can disable and enable its own preemption. */
+    ret = ABT_thread_set_preemptible(self, ABT_TRUE);
+    ATS_ERROR(ret, "ABT_thread_set_preemptible");
+    ret = ABT_thread_set_preemptible(self, ABT_FALSE);
+    ATS_ERROR(ret, "ABT_thread_set_preemptible");
+
+    ret = ABT_mutex_lock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_lock");
+    g_num_short++;
+    ret = ABT_mutex_unlock(g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_unlock");
+}
+
+/* If use_pool is ABT_TRUE, spinning ULTs are preemptible because of their
+ * pools.  Otherwise, because of their attribute. */
+static void run_spin_and_short(ABT_pool *pools, int num_xstreams,
+                               ABT_bool use_pool)
+{
+    int i, ret;
+    ABT_thread *spin_threads =
+        (ABT_thread *)malloc(sizeof(ABT_thread) * num_xstreams);
+    ABT_thread *short_threads =
+        (ABT_thread *)malloc(sizeof(ABT_thread) * num_xstreams);
+    ABT_thread_attr attr;
+    ret = ABT_thread_attr_create(&attr);
+    ATS_ERROR(ret, "ABT_thread_attr_create");
+    ret = ABT_thread_attr_set_preemptible(attr, ABT_TRUE);
+    ATS_ERROR(ret, "ABT_thread_attr_set_preemptible");
+
+    g_done = 0;
+    g_num_short = 0;
+    for (i = 0; i < num_xstreams; i++) {
+        if (use_pool) {
+            ret = ABT_pool_set_preemptible(pools[i], ABT_TRUE);
+            ATS_ERROR(ret, "ABT_pool_set_preemptible");
+            ret = ABT_thread_create(pools[i], spin_func, NULL,
+                                    ABT_THREAD_ATTR_NULL, &spin_threads[i]);
+            ATS_ERROR(ret, "ABT_thread_create");
+            ret = ABT_pool_set_preemptible(pools[i], ABT_FALSE);
+            ATS_ERROR(ret, "ABT_pool_set_preemptible");
+        } else {
+            ret = ABT_thread_create(pools[i], spin_func, NULL, attr,
+                                    &spin_threads[i]);
+            ATS_ERROR(ret, "ABT_thread_create");
+        }
+        ret = ABT_thread_create(pools[i], short_func, NULL,
+                                ABT_THREAD_ATTR_NULL, &short_threads[i]);
+        ATS_ERROR(ret, "ABT_thread_create");
+    }
+
+    /* The primary ULT is not preemptible, but the spinning ULT on the primary
+     * ES is preempted while the primary ULT waits. */
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_thread_free(&short_threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+    g_done = 1;
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_thread_free(&spin_threads[i]);
+        ATS_ERROR(ret, "ABT_thread_free");
+    }
+    assert(g_num_short == num_xstreams);
+
+    ret = ABT_thread_attr_free(&attr);
+    ATS_ERROR(ret, "ABT_thread_attr_free");
+    free(spin_threads);
+    free(short_threads);
+}
+
+int main(int argc, char *argv[])
+{
+    int i, ret;
+    int num_xstreams = DEFAULT_NUM_XSTREAMS;
+
+    /* Use a short quantum unless the user specifies one. */
+    setenv("ABT_PREEMPTION_INTERVAL_USEC", "1000", 0);
+
+    /* Initialize */
+    ATS_read_args(argc, argv);
+    if (argc >= 2) {
+        num_xstreams = ATS_get_arg_val(ATS_ARG_N_ES);
+    }
+    ATS_init(argc, argv, num_xstreams);
+
+    ABT_bool preemption_enabled;
+    ret = ABT_info_query_config(ABT_INFO_QUERY_KIND_ENABLED_PREEMPTION,
+                                (void *)&preemption_enabled);
+    ATS_ERROR(ret, "ABT_info_query_config");
+    if (!preemption_enabled) {
+        ATS_ERROR(ABT_ERR_FEATURE_NA, "ABT_info_query_config");
+    }
+
+    ABT_xstream *xstreams =
+        (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
+    ABT_pool *pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_xstreams);
+
+    ret = ABT_mutex_create(&g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_create");
+
+    /* Create ESs */
+    ret = ABT_xstream_self(&xstreams[0]);
+    ATS_ERROR(ret, "ABT_xstream_self");
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_create");
+    }
+    for (i = 0; i < num_xstreams; i++) {
+        ret = ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        ATS_ERROR(ret, "ABT_xstream_get_main_pools");
+        ABT_bool is_preemptible;
+        ret = ABT_pool_is_preemptible(pools[i], &is_preemptible);
+        ATS_ERROR(ret, "ABT_pool_is_preemptible");
+        assert(is_preemptible == ABT_FALSE);
+    }
+
+    run_spin_and_short(pools, num_xstreams, ABT_FALSE);
+    run_spin_and_short(pools, num_xstreams, ABT_TRUE);
+
+    /* Join and free ESs */
+    for (i = 1; i < num_xstreams; i++) {
+        ret = ABT_xstream_join(xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_join");
+        ret = ABT_xstream_free(&xstreams[i]);
+        ATS_ERROR(ret, "ABT_xstream_free");
+    }
+    ret = ABT_mutex_free(&g_mutex);
+    ATS_ERROR(ret, "ABT_mutex_free");
+
+    /* Validation */
+    if (g_num_timeouts) {
+        printf("%d ULTs were not preempted\n", g_num_timeouts);
+    }
+
+    /* Finalize */
+    ret = ATS_finalize(g_num_timeouts != 0);
+
+    free(pools);
+    free(xstreams);
+
+    return ret;
+}
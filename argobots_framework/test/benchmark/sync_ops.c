@@ -17,6 +17,10 @@ enum {
     T_MUTEX_CREATE_FREE,
     T_MUTEX_LOCK_UNLOCK,
     T_MUTEX_LOCK_UNLOCK_ALL,
+    T_RWLOCK_RDLOCK_UNLOCK,
+    T_BARRIER_WAIT,
+    T_XSTREAM_BARRIER_WAIT,
+    T_FUTURE_SET,
     T_LAST
 };
 static char *t_names[] = {
@@ -28,6 +32,10 @@ static char *t_names[] = {
     "mutex: create/free",
     "mutex: lock/unlock",
     "mutex: lock/unlock (all)",
+    "rwlock: rdlock/unlock",
+    "barrier: wait",
+    "xstream_barrier: wait",
+    "future: set (all)",
 };
 
 typedef struct {
@@ -46,6 +54,9 @@ static int num_threads;
 
 static ABT_barrier g_barrier = ABT_BARRIER_NULL;
 static ABT_mutex g_mutex = ABT_MUTEX_NULL;
+static ABT_rwlock g_rwlock = ABT_RWLOCK_NULL;
+static ABT_xstream_barrier g_xstream_barrier = ABT_XSTREAM_BARRIER_NULL;
+static ABT_future *g_futures = NULL;
 
 static double t_overhead = 0.0;
 static double t_timers[T_LAST];
@@ -88,6 +99,145 @@ void mutex_lock_unlock(void *arg)
     }
 }
 
+void rwlock_rdlock_unlock(void *arg)
+{
+    arg_t *my_arg = (arg_t *)arg;
+    int eid = my_arg->eid;
+    int tid = my_arg->tid;
+
+    ABT_timer timer;
+    double t_time;
+    int i;
+
+    if (eid == 0 && tid == 0) {
+        ABT_timer_create(&timer);
+    }
+
+    /* barrier */
+    ABT_barrier_wait(g_barrier);
+
+    /* start timer */
+    if (eid == 0 && tid == 0)
+        ABT_timer_start(timer);
+
+    /* all the ULTs read-lock the same rwlock */
+    for (i = 0; i < iter; i++) {
+        ABT_rwlock_rdlock(g_rwlock);
+        ABT_rwlock_unlock(g_rwlock);
+    }
+
+    /* barrier */
+    ABT_barrier_wait(g_barrier);
+
+    /* stop timer */
+    if (eid == 0 && tid == 0) {
+        ABT_timer_stop_and_read(timer, &t_time);
+        t_timers[T_RWLOCK_RDLOCK_UNLOCK] = (t_time - t_overhead) / iter;
+        ABT_timer_free(&timer);
+    }
+}
+
+void barrier_wait(void *arg)
+{
+    arg_t *my_arg = (arg_t *)arg;
+    int eid = my_arg->eid;
+    int tid = my_arg->tid;
+
+    ABT_timer timer;
+    double t_time;
+    int i;
+
+    if (eid == 0 && tid == 0) {
+        ABT_timer_create(&timer);
+    }
+
+    /* barrier */
+    ABT_barrier_wait(g_barrier);
+
+    /* start timer */
+    if (eid == 0 && tid == 0)
+        ABT_timer_start(timer);
+
+    /* measure barrier wait time */
+    for (i = 0; i < iter; i++) {
+        ABT_barrier_wait(g_barrier);
+    }
+
+    /* stop timer */
+    if (eid == 0 && tid == 0) {
+        ABT_timer_stop_and_read(timer, &t_time);
+        t_timers[T_BARRIER_WAIT] = (t_time - t_overhead) / iter;
+        ABT_timer_free(&timer);
+    }
+}
+
+void future_set(void *arg)
+{
+    arg_t *my_arg = (arg_t *)arg;
+    int eid = my_arg->eid;
+    int tid = my_arg->tid;
+
+    ABT_timer timer;
+    double t_time;
+    int i;
+
+    if (eid == 0 && tid == 0) {
+        ABT_timer_create(&timer);
+    }
+
+    /* barrier */
+    ABT_barrier_wait(g_barrier);
+
+    /* start timer */
+    if (eid == 0 && tid == 0)
+        ABT_timer_start(timer);
+
+    /* every ULT sets one compartment of each future */
+    for (i = 0; i < iter; i++) {
+        ABT_future_set(g_futures[i], NULL);
+    }
+
+    /* stop timer when all the futures are ready */
+    if (eid == 0 && tid == 0) {
+        for (i = 0; i < iter; i++) {
+            ABT_future_wait(g_futures[i]);
+        }
+        ABT_timer_stop_and_read(timer, &t_time);
+        t_timers[T_FUTURE_SET] = (t_time - t_overhead) / iter;
+        ABT_timer_free(&timer);
+    }
+}
+
+void xstream_barrier_wait(int eid)
+{
+    ABT_timer timer;
+    double t_time;
+    int i;
+
+    if (eid == 0) {
+        ABT_timer_create(&timer);
+    }
+
+    /* barrier */
+    ABT_xstream_barrier_wait(g_xstream_barrier);
+
+    /* start timer */
+    if (eid == 0)
+        ABT_timer_start(timer);
+
+    /* measure execution stream barrier wait time */
+    for (i = 0; i < iter; i++) {
+        ABT_xstream_barrier_wait(g_xstream_barrier);
+    }
+
+    /* stop timer */
+    if (eid == 0) {
+        ABT_timer_stop_and_read(timer, &t_time);
+        t_timers[T_XSTREAM_BARRIER_WAIT] = (t_time - t_overhead) / iter;
+        ABT_timer_free(&timer);
+    }
+}
+
 void launch_test(void *arg)
 {
     launch_t *my_arg = (launch_t *)arg;
@@ -106,6 +256,19 @@ void launch_test(void *arg)
         case T_MUTEX_LOCK_UNLOCK:
             test_fn = mutex_lock_unlock;
             break;
+        case T_RWLOCK_RDLOCK_UNLOCK:
+            test_fn = rwlock_rdlock_unlock;
+            break;
+        case T_BARRIER_WAIT:
+            test_fn = barrier_wait;
+            break;
+        case T_FUTURE_SET:
+            test_fn = future_set;
+            break;
+        case T_XSTREAM_BARRIER_WAIT:
+            /* Only one waiter per ES: run it on the main ULT. */
+            xstream_barrier_wait(eid);
+            return;
         default:
             fprintf(stderr, "Unknown test kind!\n");
             exit(EXIT_FAILURE);
@@ -132,6 +295,36 @@ void launch_test(void *arg)
     free(args);
 }
 
+static void run_test(ABT_xstream *xstreams, ABT_pool *pools, int test_kind)
+{
+    launch_t *largs;
+    int i;
+
+    largs = (launch_t *)malloc(num_xstreams * sizeof(launch_t));
+
+    ABT_xstream_self(&xstreams[0]);
+    for (i = 1; i < num_xstreams; i++) {
+        ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
+    }
+    for (i = 1; i < num_xstreams; i++) {
+        ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
+        largs[i].eid = i;
+        largs[i].test_kind = test_kind;
+        ABT_thread_create(pools[i], launch_test, (void *)&largs[i],
+                          ABT_THREAD_ATTR_NULL, NULL);
+    }
+
+    largs[0].eid = 0;
+    largs[0].test_kind = test_kind;
+    launch_test((void *)&largs[0]);
+
+    for (i = 1; i < num_xstreams; i++) {
+        ABT_xstream_join(xstreams[i]);
+        ABT_xstream_free(&xstreams[i]);
+    }
+    free(largs);
+}
+
 int main(int argc, char *argv[])
 {
     ABT_xstream *xstreams;
@@ -139,7 +332,6 @@ int main(int argc, char *argv[])
     ABT_thread *threads;
     ABT_mutex *mutexes;
     ABT_timer timer;
-    launch_t *largs;
     double t_time;
     int i;
 
@@ -208,36 +400,38 @@ int main(int argc, char *argv[])
     /* mutex lock/unlock time */
     ABT_timer_start(timer);
 
-    largs = (launch_t *)malloc(num_xstreams * sizeof(launch_t));
     ABT_barrier_create(num_xstreams * num_threads, &g_barrier);
     ABT_mutex_create(&g_mutex);
+    run_test(xstreams, pools, T_MUTEX_LOCK_UNLOCK);
+    ABT_mutex_free(&g_mutex);
 
-    ABT_xstream_self(&xstreams[0]);
-    for (i = 1; i < num_xstreams; i++) {
-        ABT_xstream_create(ABT_SCHED_NULL, &xstreams[i]);
-    }
-    for (i = 1; i < num_xstreams; i++) {
-        ABT_xstream_get_main_pools(xstreams[i], 1, &pools[i]);
-        largs[i].eid = i;
-        largs[i].test_kind = T_MUTEX_LOCK_UNLOCK;
-        ABT_thread_create(pools[i], launch_test, (void *)&largs[i],
-                          ABT_THREAD_ATTR_NULL, NULL);
-    }
+    ABT_timer_stop_and_read(timer, &t_time);
+    t_timers[T_MUTEX_LOCK_UNLOCK_ALL] = (t_time - t_overhead) / iter;
 
-    largs[0].eid = 0;
-    largs[0].test_kind = T_MUTEX_LOCK_UNLOCK;
-    launch_test((void *)&largs[0]);
+    /* rwlock rdlock/unlock time */
+    ABT_rwlock_create(&g_rwlock);
+    run_test(xstreams, pools, T_RWLOCK_RDLOCK_UNLOCK);
+    ABT_rwlock_free(&g_rwlock);
 
-    for (i = 1; i < num_xstreams; i++) {
-        ABT_xstream_join(xstreams[i]);
-        ABT_xstream_free(&xstreams[i]);
+    /* barrier wait time */
+    run_test(xstreams, pools, T_BARRIER_WAIT);
+
+    /* future set time: all the ULTs set each future */
+    g_futures = (ABT_future *)malloc(iter * sizeof(ABT_future));
+    for (i = 0; i < iter; i++) {
+        ABT_future_create(num_xstreams * num_threads, NULL, &g_futures[i]);
+    }
+    run_test(xstreams, pools, T_FUTURE_SET);
+    for (i = 0; i < iter; i++) {
+        ABT_future_free(&g_futures[i]);
     }
+    free(g_futures);
     ABT_barrier_free(&g_barrier);
-    ABT_mutex_free(&g_mutex);
-    free(largs);
 
-    ABT_timer_stop_and_read(timer, &t_time);
-    t_timers[T_MUTEX_LOCK_UNLOCK_ALL] = (t_time - t_overhead) / iter;
+    /* execution stream barrier wait time */
+    ABT_xstream_barrier_create(num_xstreams, &g_xstream_barrier);
+    run_test(xstreams, pools, T_XSTREAM_BARRIER_WAIT);
+    ABT_xstream_barrier_free(&g_xstream_barrier);
 
     /* finalize */
     ABT_timer_free(&timer);
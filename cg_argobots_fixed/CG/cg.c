@@ -47,32 +47,63 @@
 #include "timers.h"
 #include "print_results.h"
 #include "abt_reduction.h"
+#include "spmv.h"
 #include "../../argobots_framework/examples/workstealing_scheduler/abt_workstealing_scheduler.h"
 #include "../../argobots_framework/examples/workstealing_scheduler/abt_workstealing_scheduler_cost_aware.h"
+#include "../../argobots_framework/examples/workstealing_scheduler/abt_elastic_scheduler.h"
+#include "../../argobots_framework/examples/benchmark/abt_bench.h"
 
 //---------------------------------------------------------------------
+// The arrays are allocated by allocate_arrays() and left untouched, so each
+// page is first touched (and placed) by the thread that works on it:
+// a/colidx by the nnz-balanced blocks of sparse(), the vectors by
+// init_random_number_generator_thread().
 /* common / main_int_mem / */
-static int colidx[NZ];
-static int rowstr[NA+1];
-static int iv[NZ+1+NA];
-static int arow[NA+1];
-static int acol[NAZ];
+static int *colidx;   /* [NZ] */
+static int *rowstr;   /* [NA+1] */
+static int *iv;       /* [NZ+1+NA] */
+static int *arow;     /* [NA+1] */
+static int *acol;     /* [NAZ] */
 
 /* common / main_flt_mem / */
-static double v[NZ];
-static double aelt[NAZ];
-static double a[NZ];
-static double x[NA+2];
-static double z[NA+2];
-static double p[NA+2];
-static double q[NA+2];
-static double r[NA+2];
+static double *v;     /* [NZ] */
+static double *aelt;  /* [NAZ] */
+static double *a;     /* [NZ] */
+static double *x;     /* [NA+2] */
+static double *z;     /* [NA+2] */
+static double *p;     /* [NA+2] */
+static double *q;     /* [NA+2] */
+static double *r;     /* [NA+2] */
+
+/* Vectors of the pipelined CG. */
+static double *w;     /* [NA+2] A.r */
+static double *ap;    /* [NA+2] A.p */
+static double *aap;   /* [NA+2] A.A.p */
+
+/* Vectors of the inner iterations of the mixed-precision CG. */
+static float *pf;     /* [NA+2] */
+static float *qf;     /* [NA+2] */
+static float *rf;     /* [NA+2] */
+static float *df;     /* [NA+2] */
 
 /* common /tinof/ */
 
 #define max_threads 1024
 static int last_n[max_threads+1];
 
+//---------------------------------------------------------------------
+// Scratch of the parallel makea() and sparse(), allocated by
+// init_random_number_generator() for its number of blocks.
+//
+// rng_row_pair[t] is the first random pair drawn for block t's rows.
+// dest_count[t][b] counts the [col, row, element] triples that block t
+// generated for the rows of block b; triples holds them grouped by b.
+//---------------------------------------------------------------------
+static long rng_row_pair[max_threads];
+static int *dest_count;       /* [num_threads][num_threads] */
+static int *triples;          /* [NA*(NONZER+1)] */
+static double *row_scale;     /* [NA] */
+
 /* common / partit_size / */
 static int naa;
 static int nzz;
@@ -92,9 +123,65 @@ static logical timeron;
 #define DEFAULT_THREADS 4
 static reduction_context_t reduction_context;
 static ABT_barrier barrier;
+static spmv_matrix_t spmv;
 static ABT_sched *g_scheds = NULL;
 static int g_use_ws_scheduler = 0;
 static int g_use_cost_aware_scheduler = 0;
+static int g_use_elastic_scheduler = 0;
+static elastic_t *g_elastic = NULL;
+static int g_steal_threshold = 0;
+static bench_t bench;
+static int g_autotune = 0;
+static reduction_tuner_t tuner;
+
+//---------------------------------------------------------------------
+// ABT_CG_PRECISION=mixed solves A.z = x by iterative refinement: the
+// correction of each step comes from CG iterations in single precision
+// (a float copy of a, see spmv_enable_float()), and the residual
+// x - A.z is recomputed in double precision after each step.
+//---------------------------------------------------------------------
+typedef enum {
+  CG_PRECISION_DOUBLE = 0,
+  CG_PRECISION_MIXED,
+} cg_precision_t;
+
+#define CG_MIXED_MAX_STEPS 10
+#define CG_MIXED_INNER_MAX 25
+#define CG_MIXED_INNER_TOL 1.0e-5   /* reduction of the inner residual */
+#define CG_MIXED_TOL 1.0e-14        /* ||x - A.z|| / ||x|| */
+static cg_precision_t g_precision = CG_PRECISION_DOUBLE;
+static long g_mixed_steps = 0;
+static long g_mixed_inner_iters = 0;
+static long g_mixed_solves = 0;
+
+//---------------------------------------------------------------------
+// ABT_CG_ALGORITHM=pipelined runs the double-precision CG iterations as
+// the pipelined CG of Ghysels and Vanroose: both dot products of an
+// iteration are taken in the wave that computes the next A.w, and are
+// combined by a single reduction.
+//---------------------------------------------------------------------
+typedef enum {
+  CG_ALGORITHM_CLASSIC = 0,
+  CG_ALGORITHM_PIPELINED,
+} cg_algorithm_t;
+
+static cg_algorithm_t g_algorithm = CG_ALGORITHM_CLASSIC;
+
+static cg_algorithm_t cg_algorithm_from_env(void) {
+  const char *algorithm = getenv("ABT_CG_ALGORITHM");
+  if (algorithm && strcmp(algorithm, "pipelined") == 0) {
+    return CG_ALGORITHM_PIPELINED;
+  }
+  return CG_ALGORITHM_CLASSIC;
+}
+
+static cg_precision_t cg_precision_from_env(void) {
+  const char *precision = getenv("ABT_CG_PRECISION");
+  if (precision && strcmp(precision, "mixed") == 0) {
+    return CG_PRECISION_MIXED;
+  }
+  return CG_PRECISION_DOUBLE;
+}
 
 static inline void register_task_estimate_if_needed(int pool_id, double estimate) {
     if (g_use_cost_aware_scheduler) {
@@ -115,17 +202,41 @@ static inline void create_thread_with_estimate(int pool_id,
                       thread);
 }
 
+/* Leaves never block, so they run as tasklets in tasklet mode. */
+static inline void create_leaf_with_estimate(int pool_id,
+                                             void (*leaf_func)(void *),
+                                             void *arg,
+                                             ABT_thread *leaf,
+                                             double estimate) {
+    register_task_estimate_if_needed(pool_id, estimate);
+    reduction_create_leaf(&reduction_context, pool_id, leaf_func, arg, leaf);
+}
+
 
 static void configure_scheduler_mode(void) {
     const char *scheduler_mode = getenv("ABT_WS_SCHEDULER");
     if (!scheduler_mode || scheduler_mode[0] == '\0' || strcmp(scheduler_mode, "default") == 0) {
         g_use_ws_scheduler = 0;
         g_use_cost_aware_scheduler = 0;
+        g_use_elastic_scheduler = 0;
         return;
     }
 
     g_use_ws_scheduler = 1;
     g_use_cost_aware_scheduler = (strcmp(scheduler_mode, "new") == 0 || strcmp(scheduler_mode, "cost-aware") == 0);
+    // The elastic schedulers park idle xstreams and always steal; they are
+    // configured by the ABT_ELASTIC_* variables (see abt_elastic_scheduler.h).
+    g_use_elastic_scheduler = (strcmp(scheduler_mode, "elastic") == 0);
+
+    // With affinity placement, an idle xstream only steals from a pool that
+    // holds more than one waiting block by default.
+    const char *steal_threshold = getenv("ABT_WS_STEAL_THRESHOLD");
+    if (steal_threshold && steal_threshold[0] != '\0') {
+        g_steal_threshold = atoi(steal_threshold);
+    } else {
+        g_steal_threshold =
+            (reduction_placement_from_env() == REDUCTION_PLACEMENT_AFFINITY) ? 1 : 0;
+    }
 }
 
 //---------------------------------------------------------------------
@@ -141,6 +252,8 @@ static void conj_grad(int colidx[],
                       double q[],
                       double r[],
                       double *rnorm);
+static void conj_grad_mixed(double *rnorm);
+static void conj_grad_pipelined(double *rnorm);
 static void makea(int thread_id,
                   double *tran_ptr,
                   int n,
@@ -177,9 +290,31 @@ static void sparse(int thread_id,
                    int nzloc[],
                    double rcond,
                    double shift);
-static void sprnvc(double *tran_ptr, int n, int nz, int nn1, double v[], int iv[]);
+static int sprnvc(double *tran_ptr, int n, int nz, int nn1, double v[], int iv[]);
+static void rng_skip(double *tran_ptr, long pairs);
 static int icnvrt(double x, int ipwr2);
 static void vecset(int n, double v[], int iv[], int *nzv, int i, double val);
+// Applies the setting the auto-tuner asks for to the next iteration.
+static void apply_tuning(void) {
+    const reduction_tuning_t *tuning = reduction_tuner_current(&tuner);
+    if (tuning->num_threads != spmv.num_blocks) {
+        spmv_set_blocks(&spmv, tuning->num_threads);
+    }
+    reduction_apply_tuning(&reduction_context, tuning);
+    if (g_use_ws_scheduler && !g_use_elastic_scheduler &&
+        tuning->steal_threshold != g_steal_threshold) {
+        for (int i = 0; i < reduction_context.num_xstreams; i++) {
+            if (g_use_cost_aware_scheduler) {
+                ABT_ws_sched_cost_aware_set_steal_threshold(g_scheds[i],
+                                                            tuning->steal_threshold);
+            } else {
+                ABT_ws_sched_set_steal_threshold(g_scheds[i], tuning->steal_threshold);
+            }
+        }
+    }
+    g_steal_threshold = tuning->steal_threshold;
+}
+
 //---------------------------------------------------------------------
 
 
@@ -190,6 +325,21 @@ void initialize_argobots(int num_xstreams, int num_threads) {
     ABT_init(0, NULL);
     configure_scheduler_mode();
 
+    /* With ABT_AUTOTUNE, the number of leaves may grow while the benchmark
+     * tunes itself, so the handles are allocated for the largest option. */
+    int max_leaves = num_threads;
+    g_autotune = reduction_tuner_from_env();
+    if (g_autotune) {
+        reduction_tuning_t initial = {
+            .num_threads = num_threads,
+            .steal_threshold = g_steal_threshold,
+            .placement = reduction_placement_from_env(),
+        };
+        reduction_tuner_init(&tuner, g_autotune, &initial, num_xstreams, max_threads,
+                             g_use_ws_scheduler && !g_use_elastic_scheduler);
+        max_leaves = reduction_tuner_max_threads(&tuner);
+    }
+
     reduction_context.num_xstreams = num_xstreams;
     reduction_context.xstreams = (ABT_xstream *)calloc(num_xstreams, sizeof(ABT_xstream));
 
@@ -198,7 +348,8 @@ void initialize_argobots(int num_xstreams, int num_threads) {
     reduction_context.pools = (ABT_pool *)calloc(num_pools, sizeof(ABT_pool));
 
     reduction_context.num_threads = num_threads;
-    reduction_context.threads = (ABT_thread *)calloc(num_threads, sizeof(ABT_thread));
+    reduction_context.threads = (ABT_thread *)calloc(max_leaves, sizeof(ABT_thread));
+    reduction_context.mode = reduction_mode_from_env();
     
     /* Get a primary execution stream. */
     ABT_xstream_self(&(reduction_context.xstreams[0]));
@@ -209,10 +360,17 @@ if (g_use_ws_scheduler) {
                                   &(reduction_context.pools[i]));
         }
 
-        if (g_use_cost_aware_scheduler) {
-            ABT_create_ws_scheds_cost_aware(num_xstreams, reduction_context.pools, g_scheds);
+        if (g_use_elastic_scheduler) {
+            elastic_config_t config;
+            ABT_elastic_config_from_env(&config, num_xstreams);
+            g_elastic = ABT_create_elastic_scheds(num_xstreams, reduction_context.pools,
+                                                  g_scheds, &config);
+        } else if (g_use_cost_aware_scheduler) {
+            ABT_create_ws_scheds_cost_aware_threshold(num_xstreams, reduction_context.pools,
+                                                      g_scheds, g_steal_threshold);
         } else {
-            ABT_create_ws_scheds(num_xstreams, reduction_context.pools, g_scheds);
+            ABT_create_ws_scheds_threshold(num_xstreams, reduction_context.pools, g_scheds,
+                                           g_steal_threshold);
         }
 
         ABT_xstream_self(&(reduction_context.xstreams[0]));
@@ -235,6 +393,9 @@ if (g_use_ws_scheduler) {
                                        &(reduction_context.pools[i]));
         }
       }
+    reduction_placement_init(&reduction_context, reduction_placement_from_env(),
+                             num_threads);
+
     /* Create a barrier for the threads. */
     ABT_barrier_create(num_threads, &barrier);
 }
@@ -245,6 +406,16 @@ void finalize_argobots() {
         ABT_thread_free(&reduction_context.threads[i]);
     }    
     
+    /* A parked xstream does not see the join request. */
+    if (g_elastic) {
+        elastic_stats_t stats;
+        ABT_elastic_stop(g_elastic, &stats);
+        g_elastic = NULL;
+        printf(" Elastic xstreams: %.2f on average, %lu parks, %lu revives\n",
+               stats.avg_xstreams, (unsigned long)stats.num_parks,
+               (unsigned long)stats.num_revives);
+    }
+
     /* Join and free secondary execution streams. */
     for (int i = 1; i < reduction_context.num_xstreams; i++) {
         ABT_xstream_join(reduction_context.xstreams[i]);
@@ -263,6 +434,7 @@ void finalize_argobots() {
     ABT_finalize();
 
      /* Free allocated memory. */
+    reduction_placement_free(&reduction_context);
     free(reduction_context.xstreams);
     free(reduction_context.pools);
     free(reduction_context.threads);
@@ -337,11 +509,69 @@ void init_random_number_generator_thread(void *args) {
   }
 }
 
+typedef struct {
+  void **ptr;
+  size_t size;
+  reduction_alloc_type_t type;
+} cg_array_t;
+
+static cg_array_t cg_arrays[] = {
+  { (void **)&colidx, sizeof(int) * NZ },
+  { (void **)&rowstr, sizeof(int) * (NA+1) },
+  { (void **)&iv, sizeof(int) * (NZ+1+NA) },
+  { (void **)&arow, sizeof(int) * (NA+1) },
+  { (void **)&acol, sizeof(int) * NAZ },
+  { (void **)&v, sizeof(double) * NZ },
+  { (void **)&aelt, sizeof(double) * NAZ },
+  { (void **)&a, sizeof(double) * NZ },
+  { (void **)&x, sizeof(double) * (NA+2) },
+  { (void **)&z, sizeof(double) * (NA+2) },
+  { (void **)&p, sizeof(double) * (NA+2) },
+  { (void **)&q, sizeof(double) * (NA+2) },
+  { (void **)&r, sizeof(double) * (NA+2) },
+  { (void **)&w, sizeof(double) * (NA+2) },
+  { (void **)&ap, sizeof(double) * (NA+2) },
+  { (void **)&aap, sizeof(double) * (NA+2) },
+  { (void **)&pf, sizeof(float) * (NA+2) },
+  { (void **)&qf, sizeof(float) * (NA+2) },
+  { (void **)&rf, sizeof(float) * (NA+2) },
+  { (void **)&df, sizeof(float) * (NA+2) },
+};
+#define NUM_CG_ARRAYS ((int)(sizeof(cg_arrays) / sizeof(cg_arrays[0])))
+
+void allocate_arrays() {
+  for (int i = 0; i < NUM_CG_ARRAYS; i++) {
+    *cg_arrays[i].ptr = reduction_alloc_array(cg_arrays[i].size,
+                                              &cg_arrays[i].type);
+    if (*cg_arrays[i].ptr == NULL) {
+      printf(" Failed to allocate %zu bytes\n", cg_arrays[i].size);
+      exit(EXIT_FAILURE);
+    }
+  }
+}
+
+void free_arrays() {
+  for (int i = 0; i < NUM_CG_ARRAYS; i++) {
+    reduction_free_array(*cg_arrays[i].ptr, cg_arrays[i].size,
+                         cg_arrays[i].type);
+    *cg_arrays[i].ptr = NULL;
+  }
+}
+
 void init_random_number_generator() {
+  int num_threads = reduction_context.num_threads;
+  dest_count = (int *)malloc(sizeof(int) * num_threads * num_threads);
+  triples = (int *)malloc(sizeof(int) * NA * (NONZER+1));
+  row_scale = (double *)malloc(sizeof(double) * NA);
+  if (!dest_count || !triples || !row_scale) {
+    printf(" Failed to allocate the makea workspace\n");
+    exit(EXIT_FAILURE);
+  }
+
   init_random_number_generator_thread_args_t* args = (init_random_number_generator_thread_args_t*)malloc(sizeof(init_random_number_generator_thread_args_t) * reduction_context.num_threads);
   for (int i = 0; i < reduction_context.num_threads; i++) {
     args[i].thread_id = i;
-    int pool_id = i % reduction_context.num_pools;
+    int pool_id = reduction_block_pool(&reduction_context, i);
     create_thread_with_estimate(pool_id,
                                 init_random_number_generator_thread,
                                 &args[i],
@@ -351,9 +581,13 @@ void init_random_number_generator() {
 
   for (int i = 0; i < reduction_context.num_threads; i++) {
     ABT_thread_join(reduction_context.threads[i]);
+    reduction_block_done(&reduction_context, i, reduction_context.threads[i]);
     ABT_thread_free(&reduction_context.threads[i]);
   }
   free(args);
+  free(dest_count);
+  free(triples);
+  free(row_scale);
 }
 
 
@@ -378,46 +612,63 @@ void set_starting_vector_to_ones() {
   set_starting_vector_to_ones_thread_args_t* args = (set_starting_vector_to_ones_thread_args_t*)malloc(sizeof(set_starting_vector_to_ones_thread_args_t) * reduction_context.num_threads);
   for (int i = 0; i < reduction_context.num_threads; i++) {
     args[i].thread_id = i;
-    int pool_id = i % reduction_context.num_pools;
-    create_thread_with_estimate(pool_id,
-                                set_starting_vector_to_ones_thread,
-                                &args[i],
-                                &reduction_context.threads[i],
-                                (double)(NA + 1) / reduction_context.num_threads);
+    int pool_id = reduction_block_pool(&reduction_context, i);
+    create_leaf_with_estimate(pool_id,
+                              set_starting_vector_to_ones_thread,
+                              &args[i],
+                              &reduction_context.threads[i],
+                              (double)(NA + 1) / reduction_context.num_threads);
   }
 
   for (int i = 0; i < reduction_context.num_threads; i++) {
     ABT_thread_join(reduction_context.threads[i]);
+    reduction_block_done(&reduction_context, i, reduction_context.threads[i]);
     ABT_thread_free(&reduction_context.threads[i]);
   }
   free(args);
 }
 
 
+// Sums the pairs of two-value reductions, e.g. (x.z, z.z).
+static void reduce_sum_pair_func(void *a, void *b) {
+    ((double *)a)[0] += ((double *)b)[0];
+    ((double *)a)[1] += ((double *)b)[1];
+}
+
+// Independent partial sums per dot product in calculate_norm_temps_thread(),
+// so that the additions of consecutive elements do not wait for each other.
+#define NORM_LANES 4
+
 typedef struct {
     int thread_id;
-    double* norm_temp1_local;
-    double* norm_temp2_local;
+    double* norm_temps_local;   /* (x.z, z.z) of the block */
 } calculate_norm_temps_thread_args_t;
 
 void calculate_norm_temps_thread(void *args) {
     calculate_norm_temps_thread_args_t *args_ptr = (calculate_norm_temps_thread_args_t *)args;
 
     int thread_id = args_ptr->thread_id;
-    double norm_temp1 = 0.0;
-    double norm_temp2 = 0.0;
+    double norm_temp1[NORM_LANES] = { 0.0 };
+    double norm_temp2[NORM_LANES] = { 0.0 };
 
     int j_stop_original = lastcol - firstcol + 1;
     int ncols_per_thread = j_stop_original / reduction_context.num_threads;
     int j_start = thread_id * ncols_per_thread;
     int j_stop = (thread_id == reduction_context.num_threads - 1) ? j_stop_original : j_start + ncols_per_thread;
-    for (int j = j_start; j < j_stop; j++) {
-        norm_temp1 += x[j] * z[j];
-        norm_temp2 += z[j] * z[j];
+    int j = j_start;
+    for (; j + NORM_LANES <= j_stop; j += NORM_LANES) {
+        for (int l = 0; l < NORM_LANES; l++) {
+            norm_temp1[l] += x[j+l] * z[j+l];
+            norm_temp2[l] += z[j+l] * z[j+l];
+        }
+    }
+    for (; j < j_stop; j++) {
+        norm_temp1[0] += x[j] * z[j];
+        norm_temp2[0] += z[j] * z[j];
     }
 
-    *(args_ptr->norm_temp1_local) = norm_temp1;
-    *(args_ptr->norm_temp2_local) = norm_temp2;
+    args_ptr->norm_temps_local[0] = (norm_temp1[0] + norm_temp1[1]) + (norm_temp1[2] + norm_temp1[3]);
+    args_ptr->norm_temps_local[1] = (norm_temp2[0] + norm_temp2[1]) + (norm_temp2[2] + norm_temp2[3]);
 }
 
 typedef struct {
@@ -425,38 +676,40 @@ typedef struct {
   double norm_temp2;
 } norm_temps_result;
 
+//---------------------------------------------------------------------
+// One wave computes both partial norms of each block, and one reduction
+// of (x.z, z.z) pairs combines them.
+//---------------------------------------------------------------------
 norm_temps_result calculate_norm_temps() {
-    double* norm_temp1_values = (double*)malloc(sizeof(double) * reduction_context.num_threads);
-    double* norm_temp2_values = (double*)malloc(sizeof(double) * reduction_context.num_threads);
+    double (*norm_temps_values)[2] = (double (*)[2])malloc(sizeof(double[2]) * reduction_context.num_threads);
     calculate_norm_temps_thread_args_t* args = (calculate_norm_temps_thread_args_t*)malloc(sizeof(calculate_norm_temps_thread_args_t) * reduction_context.num_threads);
     for (int i = 0; i < reduction_context.num_threads; i++) {
         args[i].thread_id = i;
-        args[i].norm_temp1_local = &norm_temp1_values[i];
-        args[i].norm_temp2_local = &norm_temp2_values[i];
-        int pool_id = i % reduction_context.num_pools;
-        create_thread_with_estimate(pool_id,
-                                    calculate_norm_temps_thread,
-                                    &args[i],
-                                    &reduction_context.threads[i],
-                                    (double)(lastcol - firstcol + 1) / reduction_context.num_threads);
+        args[i].norm_temps_local = norm_temps_values[i];
+        int pool_id = reduction_block_pool(&reduction_context, i);
+        create_leaf_with_estimate(pool_id,
+                                  calculate_norm_temps_thread,
+                                  &args[i],
+                                  &reduction_context.threads[i],
+                                  (double)(lastcol - firstcol + 1) / reduction_context.num_threads);
     }
 
     for (int i = 0; i < reduction_context.num_threads; i++) {
         ABT_thread_join(reduction_context.threads[i]);
+        reduction_block_done(&reduction_context, i, reduction_context.threads[i]);
         ABT_thread_free(&reduction_context.threads[i]);
     }
 
-    double norm_temp1 = 0.0;
-    double norm_temp2 = 0.0;
-    reduce_sum_double(&reduction_context, norm_temp1_values, reduction_context.num_threads, &norm_temp1);
-    reduce_sum_double(&reduction_context, norm_temp2_values, reduction_context.num_threads, &norm_temp2);
+    const double zero[2] = { 0.0, 0.0 };
+    double norm_temps[2];
+    reduce_common(&reduction_context, norm_temps_values, reduction_context.num_threads,
+                  sizeof(double[2]), (void *)zero, reduce_sum_pair_func, norm_temps);
 
     norm_temps_result result;
-    result.norm_temp1 = norm_temp1;
-    result.norm_temp2 = norm_temp2;
+    result.norm_temp1 = norm_temps[0];
+    result.norm_temp2 = norm_temps[1];
 
-    free(norm_temp1_values);
-    free(norm_temp2_values);
+    free(norm_temps_values);
     free(args);
     return result;
 }
@@ -482,21 +735,27 @@ void normalize_z_thread(void *args) {
     }
 }
 
+//---------------------------------------------------------------------
+// The blocks and their pools are those of calculate_norm_temps(), so in
+// the affinity placement each block of z is scaled by the xstream whose
+// caches it was just summed in.
+//---------------------------------------------------------------------
 void normalize_z(double norm_temp2) {
     normalize_z_thread_args_t* args = (normalize_z_thread_args_t*)malloc(sizeof(normalize_z_thread_args_t) * reduction_context.num_threads);
     for (int i = 0; i < reduction_context.num_threads; i++) {
         args[i].thread_id = i;
         args[i].norm_temp2 = norm_temp2;
-        int pool_id = i % reduction_context.num_pools;
-        create_thread_with_estimate(pool_id,
-                                    normalize_z_thread,
-                                    &args[i],
-                                    &reduction_context.threads[i],
-                                    (double)(lastcol - firstcol + 1) / reduction_context.num_threads);
+        int pool_id = reduction_block_pool(&reduction_context, i);
+        create_leaf_with_estimate(pool_id,
+                                  normalize_z_thread,
+                                  &args[i],
+                                  &reduction_context.threads[i],
+                                  (double)(lastcol - firstcol + 1) / reduction_context.num_threads);
     }
 
     for (int i = 0; i < reduction_context.num_threads; i++) {
         ABT_thread_join(reduction_context.threads[i]);
+        reduction_block_done(&reduction_context, i, reduction_context.threads[i]);
         ABT_thread_free(&reduction_context.threads[i]);
     }
 
@@ -525,7 +784,7 @@ int main(int argc, char *argv[])
   }
   initialize_argobots(num_xstreams, num_threads);
 
-  int i, it;
+  int i, it, run;
 
   double zeta;
   double rnorm;
@@ -593,11 +852,35 @@ int main(int argc, char *argv[])
   naa = NA;
   nzz = NZ;
 
+  allocate_arrays();
+  printf(" Array allocation: %s\n", reduction_alloc_type_name(cg_arrays[0].type));
+
   //---------------------------------------------------------------------
   // Inialize random number generator
   //---------------------------------------------------------------------
   init_random_number_generator();
 
+  //---------------------------------------------------------------------
+  // Split the rows into nnz-balanced blocks for q = A.p, one per thread,
+  // and build the SELL-C-sigma copy if it is selected.
+  //---------------------------------------------------------------------
+  spmv_init(&spmv, spmv_format_from_env(), lastrow - firstrow + 1,
+            rowstr, colidx, a, reduction_context.num_threads);
+  printf(" SpMV format: %s\n", spmv_format_name(spmv.format));
+  g_precision = cg_precision_from_env();
+  if (g_precision == CG_PRECISION_MIXED) {
+    spmv_enable_float(&spmv);
+    printf(" CG precision: mixed (single precision inner iterations)\n");
+  } else {
+    g_algorithm = cg_algorithm_from_env();
+    if (g_algorithm == CG_ALGORITHM_PIPELINED) {
+      printf(" CG algorithm: pipelined (one reduction per iteration)\n");
+    }
+  }
+  printf(" Placement: %s (steal threshold %d)\n\n",
+         reduction_context.placement == REDUCTION_PLACEMENT_AFFINITY ? "affinity" : "static",
+         g_steal_threshold);
+
   //---------------------------------------------------------------------
   //---->
   // Do one iteration untimed to init all code and data page tables
@@ -636,6 +919,43 @@ int main(int argc, char *argv[])
 
   printf(" Initialization time = %15.3f seconds\n", timer_read(T_init));
 
+  //---------------------------------------------------------------------
+  // The timed section is repeated as the benchmark runner asks (see
+  // abt_bench.h); t and the iteration lines are those of the last run.
+  //---------------------------------------------------------------------
+  const char *scheduler_mode = getenv("ABT_WS_SCHEDULER");
+  bench_init(&bench, "cg");
+  bench_config(&bench, "class", "%c", Class);
+  bench_config(&bench, "binary", "cg.%c.x", Class);
+  bench_config(&bench, "xstreams", "%d", num_xstreams);
+  bench_config(&bench, "threads", "%d", num_threads);
+  bench_config(&bench, "scheduler", "%s",
+               (scheduler_mode && scheduler_mode[0]) ? scheduler_mode : "default");
+  bench_config(&bench, "mode", "%s",
+               reduction_context.mode == REDUCTION_MODE_TASKLET ? "tasklet" : "ult");
+  bench_config(&bench, "placement", "%s",
+               reduction_context.placement == REDUCTION_PLACEMENT_AFFINITY ? "affinity" : "static");
+  bench_config(&bench, "spmv", "%s", spmv.format == SPMV_FORMAT_SELL ? "sell" : "csr");
+  bench_config(&bench, "precision", "%s",
+               g_precision == CG_PRECISION_MIXED ? "mixed" : "double");
+  bench_config(&bench, "algorithm", "%s",
+               g_algorithm == CG_ALGORITHM_PIPELINED ? "pipelined" : "classic");
+  if (g_autotune) {
+    bench_config(&bench, "autotune", "%d", g_autotune);
+  }
+
+  epsilon = 1.0e-10;
+  double processor_time = 0.0;
+  for (run = 0; run < bench_num_runs(&bench); run++) {
+  int last_run = (run == bench_num_runs(&bench) - 1);
+  if (run > 0) {
+    set_starting_vector_to_ones();
+    zeta = 0.0;
+    timer_clear(T_bench);
+    timer_clear(T_conj_grad);
+  }
+
+  bench_run_begin(&bench);
   timer_start(T_bench);
   clock_t start = clock();
 
@@ -648,8 +968,11 @@ int main(int argc, char *argv[])
     //---------------------------------------------------------------------
     // The call to the conjugate gradient routine:
     //---------------------------------------------------------------------
+    double it_start = ABT_get_wtime();
     if (timeron) timer_start(T_conj_grad);
+    bench_phase_begin(&bench, "conj_grad");
     conj_grad(colidx, rowstr, x, z, a, p, q, r, &rnorm);
+    bench_phase_end(&bench, "conj_grad");
     if (timeron) timer_stop(T_conj_grad);
 
     //---------------------------------------------------------------------
@@ -658,23 +981,37 @@ int main(int argc, char *argv[])
     // Also, find norm of z
     // So, first: (z.z)
     //---------------------------------------------------------------------
+    bench_phase_begin(&bench, "norm");
     norm_temps_result norm_temps = calculate_norm_temps();
     norm_temp2 = 1.0 / sqrt(norm_temps.norm_temp2);
 
     zeta = SHIFT + 1.0 / norm_temps.norm_temp1;
-    if (it == 1) 
-      printf("\n   iteration           ||r||                 zeta\n");
-    printf("    %5d       %20.14E%20.13f\n", it, rnorm, zeta);
+    if (last_run) {
+      if (it == 1) 
+        printf("\n   iteration           ||r||                 zeta\n");
+      printf("    %5d       %20.14E%20.13f\n", it, rnorm, zeta);
+    }
 
     //---------------------------------------------------------------------
     // Normalize z to obtain x
     //---------------------------------------------------------------------
     normalize_z(norm_temp2);
+    bench_phase_end(&bench, "norm");
+
+    //---------------------------------------------------------------------
+    // The first iterations try the settings of the auto-tuner
+    //---------------------------------------------------------------------
+    if (g_autotune && reduction_tuner_record(&tuner, ABT_get_wtime() - it_start)) {
+      apply_tuning();
+    }
   } // end of main iter inv pow meth
 
   timer_stop(T_bench);
   clock_t end = clock();
-  double processor_time = ((double)(end - start)) / CLOCKS_PER_SEC;
+  processor_time = ((double)(end - start)) / CLOCKS_PER_SEC;
+  bench_run_end(&bench, Class == 'U' ||
+                fabs(zeta - zeta_verify_value) / zeta_verify_value <= epsilon);
+  } // end of benchmark runs
 
   //---------------------------------------------------------------------
   // End of timed section
@@ -683,9 +1020,20 @@ int main(int argc, char *argv[])
   t = timer_read(T_bench);
 
   printf(" Benchmark completed\n");
+  printf(" Block moves: %ld of %ld block runs\n",
+         reduction_context.num_block_moves, reduction_context.num_block_runs);
+  if (g_autotune) {
+    reduction_tuner_print(&tuner, num_xstreams);
+  }
+  if (g_precision == CG_PRECISION_MIXED && g_mixed_solves > 0) {
+    printf(" Mixed precision: %.1f refinement steps and %.1f inner iterations per solve\n",
+           (double)g_mixed_steps / g_mixed_solves,
+           (double)g_mixed_inner_iters / g_mixed_solves);
+  }
+  spmv_free(&spmv);
   finalize_argobots();
+  free_arrays();
 
-  epsilon = 1.0e-10;
   if (Class != 'U') {
     err = fabs(zeta - zeta_verify_value) / zeta_verify_value;
     if (err <= epsilon) {
@@ -719,6 +1067,7 @@ int main(int argc, char *argv[])
                 mflops, "          floating point", 
                 verified, NPBVERSION, COMPILETIME,
                 CS1, CS2, CS3, CS4, CS5, CS6, CS7);
+  int regressed = bench_finish(&bench);
 
   //---------------------------------------------------------------------
   // More timers
@@ -741,7 +1090,7 @@ int main(int argc, char *argv[])
     }
   }
 
-  return 0;
+  return regressed;
 }
 
 
@@ -796,18 +1145,8 @@ void conj_grad_q_thread(void *args) {
     conj_grad_thread_args_t *args_ptr = (conj_grad_thread_args_t *)args;
     int thread_id = args_ptr->thread_id;
     
-    int j_stop_original = lastrow - firstrow + 1;
-    int nrows_per_thread = j_stop_original / reduction_context.num_threads;
-    int j_start = thread_id * nrows_per_thread;
-    int j_stop = (thread_id == reduction_context.num_threads - 1) ? j_stop_original : j_start + nrows_per_thread;
-    
-    for (int j = j_start; j < j_stop; j++) {
-        double suml = 0.0;
-        for (int k = rowstr[j]; k < rowstr[j+1]; k++) {
-            suml += a[k] * p[colidx[k]];
-        }
-        q[j] = suml;
-    }
+    // Rows are split by nonzeros, not evenly, see spmv_init().
+    spmv_block(&spmv, thread_id, p, q);
 }
 
 void conj_grad_d_thread(void *args) {
@@ -900,6 +1239,15 @@ static void conj_grad(int colidx[],
 {
     int cgit, cgitmax = 25;
     double d, sum, rho, rho0, alpha, beta;
+
+    if (g_precision == CG_PRECISION_MIXED) {
+        conj_grad_mixed(rnorm);
+        return;
+    }
+    if (g_algorithm == CG_ALGORITHM_PIPELINED) {
+        conj_grad_pipelined(rnorm);
+        return;
+    }
     
     conj_grad_thread_args_t* args = (conj_grad_thread_args_t*)malloc(
         reduction_context.num_threads * sizeof(conj_grad_thread_args_t));
@@ -918,12 +1266,17 @@ static void conj_grad(int colidx[],
     // Initialize the CG algorithm:
     //---------------------------------------------------------------------
     for (int i = 0; i < reduction_context.num_threads; i++) {
-        int pool_id = i % reduction_context.num_pools;
-        create_thread_with_estimate(pool_id,
-                                    conj_grad_init_thread,
-                                    &args[i],
-                                    &reduction_context.threads[i],
-                                    (double)(lastcol - firstcol + 1) / reduction_context.num_threads);
+        int pool_id = reduction_block_pool(&reduction_context, i);
+        create_leaf_with_estimate(pool_id,
+                                  conj_grad_init_thread,
+                                  &args[i],
+                                  &reduction_context.threads[i],
+                                  (double)(lastcol - firstcol + 1) / reduction_context.num_threads);
+    }
+    for (int i = 0; i < reduction_context.num_threads; i++) {
+        ABT_thread_join(reduction_context.threads[i]);
+        reduction_block_done(&reduction_context, i, reduction_context.threads[i]);
+        ABT_thread_free(&reduction_context.threads[i]);
     }
     
     //---------------------------------------------------------------------
@@ -931,15 +1284,16 @@ static void conj_grad(int colidx[],
     // Now, obtain the norm of r: First, sum squares of r elements locally...
     //---------------------------------------------------------------------
     for (int i = 0; i < reduction_context.num_threads; i++) {
-        int pool_id = i % reduction_context.num_pools;
-        create_thread_with_estimate(pool_id,
-                                    conj_grad_rho_thread,
-                                    &args[i],
-                                    &reduction_context.threads[i],
-                                    (double)(lastcol - firstcol + 1) / reduction_context.num_threads);
+        int pool_id = reduction_block_pool(&reduction_context, i);
+        create_leaf_with_estimate(pool_id,
+                                  conj_grad_rho_thread,
+                                  &args[i],
+                                  &reduction_context.threads[i],
+                                  (double)(lastcol - firstcol + 1) / reduction_context.num_threads);
     }
     for (int i = 0; i < reduction_context.num_threads; i++) {
         ABT_thread_join(reduction_context.threads[i]);
+        reduction_block_done(&reduction_context, i, reduction_context.threads[i]);
         ABT_thread_free(&reduction_context.threads[i]);
     }
     rho = 0.0;
@@ -961,32 +1315,36 @@ static void conj_grad(int colidx[],
         //---------------------------------------------------------------------
         // q = A.p
         //---------------------------------------------------------------------
+        bench_phase_begin(&bench, "spmv");
         for (int i = 0; i < reduction_context.num_threads; i++) {
-            int pool_id = i % reduction_context.num_pools;
-            create_thread_with_estimate(pool_id,
-                                        conj_grad_q_thread,
-                                        &args[i],
-                                        &reduction_context.threads[i],
-                                        (double)(lastrow - firstrow + 1) * NONZER / reduction_context.num_threads);
+            int pool_id = reduction_block_pool(&reduction_context, i);
+            create_leaf_with_estimate(pool_id,
+                                      conj_grad_q_thread,
+                                      &args[i],
+                                      &reduction_context.threads[i],
+                                      (double)spmv.block_nnz[i]);
         }
         for (int i = 0; i < reduction_context.num_threads; i++) {
             ABT_thread_join(reduction_context.threads[i]);
+            reduction_block_done(&reduction_context, i, reduction_context.threads[i]);
             ABT_thread_free(&reduction_context.threads[i]);
         }
+        bench_phase_end(&bench, "spmv");
         
         //---------------------------------------------------------------------
         // Obtain p.q
         //---------------------------------------------------------------------
         for (int i = 0; i < reduction_context.num_threads; i++) {
-            int pool_id = i % reduction_context.num_pools;
-            create_thread_with_estimate(pool_id,
-                                        conj_grad_d_thread,
-                                        &args[i],
-                                        &reduction_context.threads[i],
-                                        (double)(lastcol - firstcol + 1) / reduction_context.num_threads);
+            int pool_id = reduction_block_pool(&reduction_context, i);
+            create_leaf_with_estimate(pool_id,
+                                      conj_grad_d_thread,
+                                      &args[i],
+                                      &reduction_context.threads[i],
+                                      (double)(lastcol - firstcol + 1) / reduction_context.num_threads);
         }
         for (int i = 0; i < reduction_context.num_threads; i++) {
             ABT_thread_join(reduction_context.threads[i]);
+            reduction_block_done(&reduction_context, i, reduction_context.threads[i]);
             ABT_thread_free(&reduction_context.threads[i]);
         }
         reduce_sum_double(&reduction_context, d_values, reduction_context.num_threads, &d);
@@ -1002,15 +1360,16 @@ static void conj_grad(int colidx[],
         //---------------------------------------------------------------------
         for (int i = 0; i < reduction_context.num_threads; i++) {
             args[i].alpha = alpha;
-            int pool_id = i % reduction_context.num_pools;
-            create_thread_with_estimate(pool_id,
-                                        conj_grad_update_thread,
-                                        &args[i],
-                                        &reduction_context.threads[i],
-                                        (double)(lastcol - firstcol + 1) / reduction_context.num_threads);
+            int pool_id = reduction_block_pool(&reduction_context, i);
+            create_leaf_with_estimate(pool_id,
+                                      conj_grad_update_thread,
+                                      &args[i],
+                                      &reduction_context.threads[i],
+                                      (double)(lastcol - firstcol + 1) / reduction_context.num_threads);
         }
         for (int i = 0; i < reduction_context.num_threads; i++) {
             ABT_thread_join(reduction_context.threads[i]);
+            reduction_block_done(&reduction_context, i, reduction_context.threads[i]);
             ABT_thread_free(&reduction_context.threads[i]);
         }
         reduce_sum_double(&reduction_context, rho_values, reduction_context.num_threads, &rho);
@@ -1025,30 +1384,32 @@ static void conj_grad(int colidx[],
         //---------------------------------------------------------------------
         for (int i = 0; i < reduction_context.num_threads; i++) {
             args[i].beta = beta;
-            int pool_id = i % reduction_context.num_pools;
-            create_thread_with_estimate(pool_id,
-                                        conj_grad_p_thread,
-                                        &args[i],
-                                        &reduction_context.threads[i],
-                                        (double)(lastcol - firstcol + 1) / reduction_context.num_threads);
+            int pool_id = reduction_block_pool(&reduction_context, i);
+            create_leaf_with_estimate(pool_id,
+                                      conj_grad_p_thread,
+                                      &args[i],
+                                      &reduction_context.threads[i],
+                                      (double)(lastcol - firstcol + 1) / reduction_context.num_threads);
         }
         for (int i = 0; i < reduction_context.num_threads; i++) {
             ABT_thread_join(reduction_context.threads[i]);
+            reduction_block_done(&reduction_context, i, reduction_context.threads[i]);
             ABT_thread_free(&reduction_context.threads[i]);
         }
     } // end of do cgit=1,cgitmax
     
     // Calculate final residual norm
     for (int i = 0; i < reduction_context.num_threads; i++) {
-        int pool_id = i % reduction_context.num_pools;
-        create_thread_with_estimate(pool_id,
-                                    conj_grad_final_thread,
-                                    &args[i],
-                                    &reduction_context.threads[i],
-                                    (double)(lastcol - firstcol + 1) / reduction_context.num_threads);
+        int pool_id = reduction_block_pool(&reduction_context, i);
+        create_leaf_with_estimate(pool_id,
+                                  conj_grad_final_thread,
+                                  &args[i],
+                                  &reduction_context.threads[i],
+                                  (double)(lastcol - firstcol + 1) / reduction_context.num_threads);
     }
     for (int i = 0; i < reduction_context.num_threads; i++) {
         ABT_thread_join(reduction_context.threads[i]);
+        reduction_block_done(&reduction_context, i, reduction_context.threads[i]);
         ABT_thread_free(&reduction_context.threads[i]);
     }
     sum = 0.0;
@@ -1063,6 +1424,465 @@ static void conj_grad(int colidx[],
 }
 
 
+//---------------------------------------------------------------------
+// Mixed-precision CG.  The leaves split the columns like those of
+// conj_grad(); the dot products of float vectors are summed in double.
+//---------------------------------------------------------------------
+static inline void column_block(int thread_id, int *j_start, int *j_stop) {
+    int j_stop_original = lastcol - firstcol + 1;
+    int ncols_per_thread = j_stop_original / reduction_context.num_threads;
+    *j_start = thread_id * ncols_per_thread;
+    *j_stop = (thread_id == reduction_context.num_threads - 1) ? j_stop_original : *j_start + ncols_per_thread;
+}
+
+// z = 0, r = x, sum = r.r
+void conj_grad_mixed_init_thread(void *args) {
+    conj_grad_thread_args_t *args_ptr = (conj_grad_thread_args_t *)args;
+    double sum_local = 0.0;
+    int j_start, j_stop;
+    column_block(args_ptr->thread_id, &j_start, &j_stop);
+
+    for (int j = j_start; j < j_stop; j++) {
+        z[j] = 0.0;
+        r[j] = x[j];
+        sum_local += r[j] * r[j];
+    }
+
+    *(args_ptr->sum_local) = sum_local;
+}
+
+// Inner CG on A.d = r from d = 0: rf = pf = r, rho = rf.rf
+void conj_grad_mixed_inner_init_thread(void *args) {
+    conj_grad_thread_args_t *args_ptr = (conj_grad_thread_args_t *)args;
+    double rho_local = 0.0;
+    int j_start, j_stop;
+    column_block(args_ptr->thread_id, &j_start, &j_stop);
+
+    for (int j = j_start; j < j_stop; j++) {
+        rf[j] = (float)r[j];
+        pf[j] = rf[j];
+        df[j] = 0.0f;
+        rho_local += (double)rf[j] * rf[j];
+    }
+
+    *(args_ptr->rho_local) = rho_local;
+}
+
+void conj_grad_mixed_q_thread(void *args) {
+    conj_grad_thread_args_t *args_ptr = (conj_grad_thread_args_t *)args;
+    spmv_block_float(&spmv, args_ptr->thread_id, pf, qf);
+}
+
+void conj_grad_mixed_d_thread(void *args) {
+    conj_grad_thread_args_t *args_ptr = (conj_grad_thread_args_t *)args;
+    double d_local = 0.0;
+    int j_start, j_stop;
+    column_block(args_ptr->thread_id, &j_start, &j_stop);
+
+    for (int j = j_start; j < j_stop; j++) {
+        d_local += (double)pf[j] * qf[j];
+    }
+
+    *(args_ptr->d_local) = d_local;
+}
+
+void conj_grad_mixed_update_thread(void *args) {
+    conj_grad_thread_args_t *args_ptr = (conj_grad_thread_args_t *)args;
+    float alpha = (float)args_ptr->alpha;
+    double rho_local = 0.0;
+    int j_start, j_stop;
+    column_block(args_ptr->thread_id, &j_start, &j_stop);
+
+    for (int j = j_start; j < j_stop; j++) {
+        df[j] += alpha * pf[j];
+        rf[j] -= alpha * qf[j];
+        rho_local += (double)rf[j] * rf[j];
+    }
+
+    *(args_ptr->rho_local) = rho_local;
+}
+
+void conj_grad_mixed_p_thread(void *args) {
+    conj_grad_thread_args_t *args_ptr = (conj_grad_thread_args_t *)args;
+    float beta = (float)args_ptr->beta;
+    int j_start, j_stop;
+    column_block(args_ptr->thread_id, &j_start, &j_stop);
+
+    for (int j = j_start; j < j_stop; j++) {
+        pf[j] = rf[j] + beta * pf[j];
+    }
+}
+
+// z = z + d
+void conj_grad_mixed_correct_thread(void *args) {
+    conj_grad_thread_args_t *args_ptr = (conj_grad_thread_args_t *)args;
+    int j_start, j_stop;
+    column_block(args_ptr->thread_id, &j_start, &j_stop);
+
+    for (int j = j_start; j < j_stop; j++) {
+        z[j] += (double)df[j];
+    }
+}
+
+// q = A.z in double precision
+void conj_grad_mixed_az_thread(void *args) {
+    conj_grad_thread_args_t *args_ptr = (conj_grad_thread_args_t *)args;
+    spmv_block(&spmv, args_ptr->thread_id, z, q);
+}
+
+// r = x - A.z, sum = r.r
+void conj_grad_mixed_residual_thread(void *args) {
+    conj_grad_thread_args_t *args_ptr = (conj_grad_thread_args_t *)args;
+    double sum_local = 0.0;
+    int j_start, j_stop;
+    column_block(args_ptr->thread_id, &j_start, &j_stop);
+
+    for (int j = j_start; j < j_stop; j++) {
+        r[j] = x[j] - q[j];
+        sum_local += r[j] * r[j];
+    }
+
+    *(args_ptr->sum_local) = sum_local;
+}
+
+// One fork-join wave of the leaf over all blocks.
+static void conj_grad_phase(void (*leaf)(void *),
+                            conj_grad_thread_args_t *args,
+                            int spmv_phase)
+{
+    for (int i = 0; i < reduction_context.num_threads; i++) {
+        int pool_id = reduction_block_pool(&reduction_context, i);
+        create_leaf_with_estimate(pool_id,
+                                  leaf,
+                                  &args[i],
+                                  &reduction_context.threads[i],
+                                  spmv_phase ? (double)spmv.block_nnz[i]
+                                             : (double)(lastcol - firstcol + 1) / reduction_context.num_threads);
+    }
+    for (int i = 0; i < reduction_context.num_threads; i++) {
+        ABT_thread_join(reduction_context.threads[i]);
+        reduction_block_done(&reduction_context, i, reduction_context.threads[i]);
+        ABT_thread_free(&reduction_context.threads[i]);
+    }
+}
+
+//---------------------------------------------------------------------
+// Iterative refinement: z = z + d, where A.d = r is solved by at most
+// CG_MIXED_INNER_MAX float CG iterations, until ||x - A.z|| is below
+// CG_MIXED_TOL * ||x||.  rnorm is ||x - A.z|| computed in double.
+//---------------------------------------------------------------------
+static void conj_grad_mixed(double *rnorm)
+{
+    double d, sum, sum_x, rho, rho0, rho_start, alpha, beta;
+    int nthreads = reduction_context.num_threads;
+
+    conj_grad_thread_args_t* args = (conj_grad_thread_args_t*)malloc(
+        nthreads * sizeof(conj_grad_thread_args_t));
+    double* rho_values = (double*)malloc(nthreads * sizeof(double));
+    double* d_values = (double*)malloc(nthreads * sizeof(double));
+    double* sum_values = (double*)malloc(nthreads * sizeof(double));
+
+    for (int i = 0; i < nthreads; i++) {
+        args[i].thread_id = i;
+        args[i].rho_local = &rho_values[i];
+        args[i].d_local = &d_values[i];
+        args[i].sum_local = &sum_values[i];
+    }
+
+    conj_grad_phase(conj_grad_mixed_init_thread, args, 0);
+    sum_x = 0.0;
+    reduce_sum_double(&reduction_context, sum_values, nthreads, &sum_x);
+    sum = sum_x;
+
+    g_mixed_solves++;
+    for (int step = 0; step < CG_MIXED_MAX_STEPS; step++) {
+        if (sum <= CG_MIXED_TOL * CG_MIXED_TOL * sum_x) break;
+        g_mixed_steps++;
+
+        //---------------------------------------------------------------------
+        // Solve A.d = r in single precision
+        //---------------------------------------------------------------------
+        conj_grad_phase(conj_grad_mixed_inner_init_thread, args, 0);
+        rho = 0.0;
+        reduce_sum_double(&reduction_context, rho_values, nthreads, &rho);
+        rho_start = rho;
+
+        for (int cgit = 1; cgit <= CG_MIXED_INNER_MAX; cgit++) {
+            g_mixed_inner_iters++;
+            rho0 = rho;
+
+            bench_phase_begin(&bench, "spmv");
+            conj_grad_phase(conj_grad_mixed_q_thread, args, 1);
+            bench_phase_end(&bench, "spmv");
+
+            conj_grad_phase(conj_grad_mixed_d_thread, args, 0);
+            d = 0.0;
+            reduce_sum_double(&reduction_context, d_values, nthreads, &d);
+            alpha = rho0 / d;
+
+            for (int i = 0; i < nthreads; i++) {
+                args[i].alpha = alpha;
+            }
+            conj_grad_phase(conj_grad_mixed_update_thread, args, 0);
+            rho = 0.0;
+            reduce_sum_double(&reduction_context, rho_values, nthreads, &rho);
+            if (rho <= CG_MIXED_INNER_TOL * CG_MIXED_INNER_TOL * rho_start) break;
+
+            beta = rho / rho0;
+            for (int i = 0; i < nthreads; i++) {
+                args[i].beta = beta;
+            }
+            conj_grad_phase(conj_grad_mixed_p_thread, args, 0);
+        }
+
+        //---------------------------------------------------------------------
+        // z = z + d, r = x - A.z in double precision
+        //---------------------------------------------------------------------
+        conj_grad_phase(conj_grad_mixed_correct_thread, args, 0);
+        bench_phase_begin(&bench, "spmv");
+        conj_grad_phase(conj_grad_mixed_az_thread, args, 1);
+        bench_phase_end(&bench, "spmv");
+        conj_grad_phase(conj_grad_mixed_residual_thread, args, 0);
+        sum = 0.0;
+        reduce_sum_double(&reduction_context, sum_values, nthreads, &sum);
+    }
+
+    *rnorm = sqrt(sum);
+
+    free(args);
+    free(rho_values);
+    free(d_values);
+    free(sum_values);
+}
+
+
+//---------------------------------------------------------------------
+// Pipelined CG (Ghysels and Vanroose, 2014) for A.z = x from z = 0,
+// with w = A.r, ap = A.p and aap = A.ap kept by recurrences:
+//
+//   gamma = r.r, delta = w.r, q = A.w                  (one wave)
+//   beta  = gamma / gamma_old
+//   alpha = gamma / (delta - beta * gamma / alpha_old)
+//   aap = q + beta*aap, ap = w + beta*ap, p = r + beta*p
+//   z = z + alpha*p, r = r - alpha*ap, w = w - alpha*aap (one wave)
+//
+// The two dot products and A.w only read r and w, so they share a wave
+// and their partial sums go through one reduction of (gamma, delta)
+// pairs, instead of the two waves and two reductions of conj_grad().
+// One more SpMV computes w = A.r before the first iteration.
+//---------------------------------------------------------------------
+
+// z = 0, r = x, p = ap = aap = 0
+void conj_grad_pipelined_init_thread(void *args) {
+    conj_grad_thread_args_t *args_ptr = (conj_grad_thread_args_t *)args;
+    int j_start, j_stop;
+    column_block(args_ptr->thread_id, &j_start, &j_stop);
+
+    for (int j = j_start; j < j_stop; j++) {
+        z[j] = 0.0;
+        r[j] = x[j];
+        p[j] = 0.0;
+        ap[j] = 0.0;
+        aap[j] = 0.0;
+    }
+}
+
+// w = A.r
+void conj_grad_pipelined_w_thread(void *args) {
+    conj_grad_thread_args_t *args_ptr = (conj_grad_thread_args_t *)args;
+    spmv_block(&spmv, args_ptr->thread_id, r, w);
+}
+
+// gamma = r.r and delta = w.r of the block's columns, then q = A.w for
+// the block's rows
+void conj_grad_pipelined_dots_q_thread(void *args) {
+    conj_grad_thread_args_t *args_ptr = (conj_grad_thread_args_t *)args;
+    double gamma_local = 0.0;
+    double delta_local = 0.0;
+    int j_start, j_stop;
+    column_block(args_ptr->thread_id, &j_start, &j_stop);
+
+    for (int j = j_start; j < j_stop; j++) {
+        gamma_local += r[j] * r[j];
+        delta_local += w[j] * r[j];
+    }
+    *(args_ptr->rho_local) = gamma_local;
+    *(args_ptr->d_local) = delta_local;
+
+    spmv_block(&spmv, args_ptr->thread_id, w, q);
+}
+
+void conj_grad_pipelined_update_thread(void *args) {
+    conj_grad_thread_args_t *args_ptr = (conj_grad_thread_args_t *)args;
+    double alpha = args_ptr->alpha;
+    double beta = args_ptr->beta;
+    int j_start, j_stop;
+    column_block(args_ptr->thread_id, &j_start, &j_stop);
+
+    for (int j = j_start; j < j_stop; j++) {
+        aap[j] = q[j] + beta * aap[j];
+        ap[j] = w[j] + beta * ap[j];
+        p[j] = r[j] + beta * p[j];
+        z[j] += alpha * p[j];
+        r[j] -= alpha * ap[j];
+        w[j] -= alpha * aap[j];
+    }
+}
+
+static void conj_grad_pipelined(double *rnorm)
+{
+    int cgit, cgitmax = 25;
+    double sum, gamma, gamma_old = 0.0, delta, alpha = 0.0, beta;
+    int nthreads = reduction_context.num_threads;
+
+    conj_grad_thread_args_t* args = (conj_grad_thread_args_t*)malloc(
+        nthreads * sizeof(conj_grad_thread_args_t));
+    double (*dots)[2] = (double (*)[2])malloc(nthreads * sizeof(double[2]));
+    double* sum_values = (double*)malloc(nthreads * sizeof(double));
+    const double zero[2] = { 0.0, 0.0 };
+    double result[2];
+
+    for (int i = 0; i < nthreads; i++) {
+        args[i].thread_id = i;
+        args[i].rho_local = &dots[i][0];
+        args[i].d_local = &dots[i][1];
+        args[i].sum_local = &sum_values[i];
+    }
+
+    conj_grad_phase(conj_grad_pipelined_init_thread, args, 0);
+    bench_phase_begin(&bench, "spmv");
+    conj_grad_phase(conj_grad_pipelined_w_thread, args, 1);
+    bench_phase_end(&bench, "spmv");
+
+    for (cgit = 1; cgit <= cgitmax; cgit++) {
+        bench_phase_begin(&bench, "spmv");
+        conj_grad_phase(conj_grad_pipelined_dots_q_thread, args, 1);
+        bench_phase_end(&bench, "spmv");
+        reduce_common(&reduction_context, dots, nthreads, sizeof(double[2]),
+                      (void *)zero, reduce_sum_pair_func, result);
+        gamma = result[0];
+        delta = result[1];
+
+        if (cgit == 1) {
+            beta = 0.0;
+            alpha = gamma / delta;
+        } else {
+            beta = gamma / gamma_old;
+            alpha = gamma / (delta - beta * gamma / alpha);
+        }
+        gamma_old = gamma;
+
+        for (int i = 0; i < nthreads; i++) {
+            args[i].alpha = alpha;
+            args[i].beta = beta;
+        }
+        conj_grad_phase(conj_grad_pipelined_update_thread, args, 0);
+    }
+
+    conj_grad_phase(conj_grad_final_thread, args, 0);
+    sum = 0.0;
+    reduce_sum_double(&reduction_context, sum_values, nthreads, &sum);
+
+    *rnorm = sqrt(sum);
+
+    free(args);
+    free(dots);
+    free(sum_values);
+}
+
+
+//---------------------------------------------------------------------
+// The number of random pairs a row of makea draws depends on the pairs:
+// sprnvc() skips the positions above n and the positions already in the
+// row.  The pairs are therefore drawn in parallel in equal ranges
+// (rng_skip() jumps to a range), only their positions are kept, and the
+// rows are then walked over the positions to find where each block's
+// rows start.
+//
+// rng_num_pairs() is a generous bound on the pairs drawn before the last
+// block: each of the NONZER elements of a row draws nn1/n pairs on
+// average.
+//---------------------------------------------------------------------
+static long rng_num_pairs(int nrows, int n, int nn1, int nz)
+{
+  long guess = (long)((double)nrows * NONZER * nn1 / n);
+  guess = guess + guess / 16 + 64 * NONZER;
+  return (guess < nz) ? guess : nz;
+}
+
+
+//---------------------------------------------------------------------
+// store in loc[] the position drawn by the pairs of range t of the
+// num_pairs pairs, or 0 if sprnvc() would skip it for being above n
+//---------------------------------------------------------------------
+static void rng_draw_locations(int t, double tran0, int n, int nn1,
+                               long num_pairs, int loc[])
+{
+  int num_threads = reduction_context.num_threads;
+  long chunk = (num_pairs + num_threads - 1) / num_threads;
+  long pfirst = chunk * t;
+  long plast = (pfirst + chunk < num_pairs) ? pfirst + chunk : num_pairs;
+  long pp;
+  int i;
+  double tran = tran0;
+
+  rng_skip(&tran, pfirst);
+  for (pp = pfirst; pp < plast; pp++) {
+    randlc(&tran, amult);
+    i = icnvrt(randlc(&tran, amult), nn1) + 1;
+    loc[pp] = (i > n) ? 0 : i;
+  }
+}
+
+
+//---------------------------------------------------------------------
+// walk the rows of makea over the positions of rng_draw_locations() with
+// the acceptance rule of sprnvc(), and store the first pair of each
+// block in rng_row_pair.  Rows beyond the drawn pairs are drawn again.
+//---------------------------------------------------------------------
+static void rng_find_block_starts(double tran0, int n, int nn1, int work,
+                                  long num_pairs, const int loc[])
+{
+  int ivc[NONZER+1];
+  double vc[NONZER+1];
+  int num_threads = reduction_context.num_threads;
+  int row, t, nzv, ii, i, drawing = 0;
+  long pp = 0, start;
+  double tran = tran0;
+
+  rng_row_pair[0] = 0;
+  row = 0;
+  t = 1;
+  while (t < num_threads && work * t < n) {
+    start = pp;
+    nzv = 0;
+    while (nzv < NONZER && pp < num_pairs) {
+      i = loc[pp];
+      pp = pp + 1;
+      if (i == 0) continue;
+      for (ii = 0; ii < nzv; ii++) {
+        if (ivc[ii] == i) break;
+      }
+      if (ii < nzv) continue;
+      ivc[nzv] = i;
+      nzv = nzv + 1;
+    }
+    if (nzv < NONZER) {
+      if (!drawing) {
+        rng_skip(&tran, start);
+        drawing = 1;
+      }
+      pp = start + sprnvc(&tran, n, NONZER, nn1, vc, ivc);
+    }
+    row = row + 1;
+    if (row == work * t) {
+      rng_row_pair[t] = pp;
+      t = t + 1;
+    }
+  }
+}
+
+
 //---------------------------------------------------------------------
 // generate the test problem for benchmark 6
 // makea generates a sparse matrix with a
@@ -1138,17 +1958,34 @@ static void makea(int thread_id,
   int ilow  = work * thread_id;
   int ihigh = ilow + work;
   if (ihigh > n) ihigh = n;
-  
-  for (iouter = 0; iouter < ihigh; iouter++) {
+
+  //---------------------------------------------------------------------
+  // find the first random pair of each block's rows (iv is used as
+  // workspace), then each block skips ahead to its first pair and
+  // generates its rows exactly as the serial loop
+  //---------------------------------------------------------------------
+  double tran0 = *tran_ptr;
+  if (num_threads > 1) {
+    long num_pairs = rng_num_pairs(work * (num_threads-1), n, nn1, nz);
+    rng_draw_locations(thread_id, tran0, n, nn1, num_pairs, iv);
+    ABT_barrier_wait(barrier);
+    if (thread_id == 0) {
+      rng_find_block_starts(tran0, n, nn1, work, num_pairs, iv);
+    }
+    ABT_barrier_wait(barrier);
+  } else {
+    rng_row_pair[0] = 0;
+  }
+  rng_skip(tran_ptr, rng_row_pair[thread_id]);
+
+  for (iouter = ilow; iouter < ihigh; iouter++) {
     nzv = NONZER;
     sprnvc(tran_ptr, n, nzv, nn1, vc, ivc);
-    if (iouter >= ilow) {
-      vecset(n, vc, ivc, &nzv, iouter+1, 0.5);
-      arow[iouter] = nzv;
-      for (ivelt = 0; ivelt < nzv; ivelt++) {
-        acol[iouter][ivelt] = ivc[ivelt] - 1;
-        aelt[iouter][ivelt] = vc[ivelt];
-      }
+    vecset(n, vc, ivc, &nzv, iouter+1, 0.5);
+    arow[iouter] = nzv;
+    for (ivelt = 0; ivelt < nzv; ivelt++) {
+      acol[iouter][ivelt] = ivc[ivelt] - 1;
+      aelt[iouter][ivelt] = vc[ivelt];
     }
   }
 
@@ -1164,6 +2001,32 @@ static void makea(int thread_id,
 }
 
 
+//---------------------------------------------------------------------
+// First row of block b when the compacted rows are split into
+// num_threads blocks of about the same number of nonzeros.  Row j starts
+// at rowstr[j] - nzloc[j-1] after compaction.
+//---------------------------------------------------------------------
+static int final_row_split(const int rowstr[], const int nzloc[], int nrows,
+                           int b)
+{
+  int num_blocks = reduction_context.num_threads;
+  if (b >= num_blocks) return nrows;
+  long total = rowstr[nrows] - nzloc[nrows-1];
+  long target = total * b / num_blocks;
+  int lo = 0, hi = nrows;
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    long start = (mid > 0) ? rowstr[mid] - nzloc[mid-1] : 0;
+    if (start < target) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+
 //---------------------------------------------------------------------
 // rows range from firstrow to lastrow
 // the rowstr pointers are defined for nrows = lastrow-firstrow+1 values
@@ -1206,6 +2069,64 @@ static void sparse(int thread_id,
   j1 = ilow + 1;
   j2 = ihigh + 1;
 
+  //---------------------------------------------------------------------
+  // ...group the triples generated by this block by the block of their
+  //    row: count them, turn the counts into offsets (each block scans its
+  //    column of dest_count, then its row), and scatter them.  The triples
+  //    of a row block stay in the order of the source rows, which is the
+  //    order in which the serial loop sums the duplicates.
+  //---------------------------------------------------------------------
+  int num_threads = reduction_context.num_threads;
+  int work = (n + num_threads - 1) / num_threads;
+  int b, seg_begin, seg_end;
+  int *count = &dest_count[thread_id * num_threads];
+
+  for (b = 0; b < num_threads; b++) {
+    count[b] = 0;
+  }
+  for (i = ilow; i < ihigh; i++) {
+    for (nza = 0; nza < arow[i]; nza++) {
+      count[acol[i][nza] / work]++;
+    }
+  }
+
+  ratio = pow(rcond, (1.0 / (double)(n)));
+  if (thread_id == 0) {
+    size = 1.0;
+    for (i = 0; i < n; i++) {
+      row_scale[i] = size;
+      size = size * ratio;
+    }
+  }
+  ABT_barrier_wait(barrier);
+
+  kk = 0;
+  for (b = 0; b < num_threads; b++) {
+    k = dest_count[b * num_threads + thread_id];
+    dest_count[b * num_threads + thread_id] = kk;
+    kk = kk + k;
+  }
+  last_n[thread_id] = kk;
+  ABT_barrier_wait(barrier);
+
+  kk = 0;
+  for (b = 0; b < num_threads; b++) {
+    count[b] = count[b] + kk;
+    kk = kk + last_n[b];
+  }
+  for (i = ilow; i < ihigh; i++) {
+    for (nza = 0; nza < arow[i]; nza++) {
+      b = acol[i][nza] / work;
+      triples[count[b]] = i * (NONZER+1) + nza;
+      count[b] = count[b] + 1;
+    }
+  }
+  ABT_barrier_wait(barrier);
+
+  count = &dest_count[(num_threads-1) * num_threads];
+  seg_begin = (thread_id > 0) ? count[thread_id-1] : 0;
+  seg_end = count[thread_id];
+
   //---------------------------------------------------------------------
   // ...count the number of triples in each row
   //---------------------------------------------------------------------
@@ -1213,14 +2134,10 @@ static void sparse(int thread_id,
     rowstr[j] = 0;
   }
 
-  for (i = 0; i < n; i++) {
-    for (nza = 0; nza < arow[i]; nza++) {
-      j = acol[i][nza];
-      if (j >= ilow && j < ihigh) {
-        j = j + 1;
-        rowstr[j] = rowstr[j] + arow[i];
-      }
-    }
+  for (k = seg_begin; k < seg_end; k++) {
+    i = triples[k] / (NONZER+1);
+    j = acol[i][triples[k] % (NONZER+1)] + 1;
+    rowstr[j] = rowstr[j] + arow[i];
   }
 
   if (thread_id == 0) {
@@ -1273,66 +2190,61 @@ static void sparse(int thread_id,
 
   //---------------------------------------------------------------------
   // ... generate actual values by summing duplicates
+  //     (row_scale[i] is the size of the serial loop at row i)
   //---------------------------------------------------------------------
-  size = 1.0;
-  ratio = pow(rcond, (1.0 / (double)(n)));
-
-  for (i = 0; i < n; i++) {
-    for (nza = 0; nza < arow[i]; nza++) {
-      j = acol[i][nza];
-
-      if (j < ilow || j >= ihigh) continue;
-
-      scale = size * aelt[i][nza];
-      for (nzrow = 0; nzrow < arow[i]; nzrow++) {
-        jcol = acol[i][nzrow];
-        va = aelt[i][nzrow] * scale;
-
-        //--------------------------------------------------------------------
-        // ... add the identity * rcond to the generated matrix to bound
-        //     the smallest eigenvalue from below by rcond
-        //--------------------------------------------------------------------
-        if (jcol == j && j == i) {
-          va = va + rcond - shift;
-        }
+  for (int e = seg_begin; e < seg_end; e++) {
+    i = triples[e] / (NONZER+1);
+    nza = triples[e] % (NONZER+1);
+    j = acol[i][nza];
+
+    scale = row_scale[i] * aelt[i][nza];
+    for (nzrow = 0; nzrow < arow[i]; nzrow++) {
+      jcol = acol[i][nzrow];
+      va = aelt[i][nzrow] * scale;
+
+      //--------------------------------------------------------------------
+      // ... add the identity * rcond to the generated matrix to bound
+      //     the smallest eigenvalue from below by rcond
+      //--------------------------------------------------------------------
+      if (jcol == j && j == i) {
+        va = va + rcond - shift;
+      }
 
-        cont40 = false;
-        for (k = rowstr[j]; k < rowstr[j+1]; k++) {
-          if (iv[k] > jcol) {
-            //----------------------------------------------------------------
-            // ... insert colidx here orderly
-            //----------------------------------------------------------------
-            for (kk = rowstr[j+1]-2; kk >= k; kk--) {
-              if (iv[kk] > -1) {
-                v[kk+1]  = v[kk];
-                iv[kk+1] = iv[kk];
-              }
+      cont40 = false;
+      for (k = rowstr[j]; k < rowstr[j+1]; k++) {
+        if (iv[k] > jcol) {
+          //----------------------------------------------------------------
+          // ... insert colidx here orderly
+          //----------------------------------------------------------------
+          for (kk = rowstr[j+1]-2; kk >= k; kk--) {
+            if (iv[kk] > -1) {
+              v[kk+1]  = v[kk];
+              iv[kk+1] = iv[kk];
             }
-            iv[k] = jcol;
-            v[k]  = 0.0;
-            cont40 = true;
-            break;
-          } else if (iv[k] == -1) {
-            iv[k] = jcol;
-            cont40 = true;
-            break;
-          } else if (iv[k] == jcol) {
-            //--------------------------------------------------------------
-            // ... mark the duplicated entry
-            //--------------------------------------------------------------
-            nzloc[j] = nzloc[j] + 1;
-            cont40 = true;
-            break;
           }
+          iv[k] = jcol;
+          v[k]  = 0.0;
+          cont40 = true;
+          break;
+        } else if (iv[k] == -1) {
+          iv[k] = jcol;
+          cont40 = true;
+          break;
+        } else if (iv[k] == jcol) {
+          //--------------------------------------------------------------
+          // ... mark the duplicated entry
+          //--------------------------------------------------------------
+          nzloc[j] = nzloc[j] + 1;
+          cont40 = true;
+          break;
         }
-        if (cont40 == false) {
-          printf("internal error in sparse: i=%d\n", i);
-          exit(EXIT_FAILURE);
-        }
-        v[k] = v[k] + va;
       }
+      if (cont40 == false) {
+        printf("internal error in sparse: i=%d\n", i);
+        exit(EXIT_FAILURE);
+      }
+      v[k] = v[k] + va;
     }
-    size = size * ratio;
   }
   ABT_barrier_wait(barrier);
 
@@ -1359,9 +2271,13 @@ static void sparse(int thread_id,
   }
   ABT_barrier_wait(barrier);
 
-  int nrows_per_thread = nrows / reduction_context.num_threads;
-  int j_start = thread_id * nrows_per_thread;
-  int j_stop = (thread_id == reduction_context.num_threads - 1) ? nrows : j_start + nrows_per_thread;
+  //---------------------------------------------------------------------
+  // ... compact the rows in nnz-balanced blocks: the same split that
+  //     spmv_init() computes from the final rowstr, so that the pages of a
+  //     and colidx are first touched by the thread that multiplies them
+  //---------------------------------------------------------------------
+  int j_start = final_row_split(rowstr, nzloc, nrows, thread_id);
+  int j_stop = final_row_split(rowstr, nzloc, nrows, thread_id + 1);
   for (j = j_start; j < j_stop; j++) {
     if (j > 0) {
       j1 = rowstr[j] - nzloc[j-1];
@@ -1377,6 +2293,10 @@ static void sparse(int thread_id,
     }
   }
 
+  // rowstr must not be updated until all threads have compacted a and colidx
+  ABT_barrier_wait(barrier);
+
+  int nrows_per_thread = nrows / reduction_context.num_threads;
   int j_start_original = 1;
   int j_stop_original = nrows + 1;
   j_start = j_start_original + thread_id * nrows_per_thread;
@@ -1390,21 +2310,23 @@ static void sparse(int thread_id,
 
 //---------------------------------------------------------------------
 // generate a sparse n-vector (v, iv)
-// having nzv nonzeros
+// having nzv nonzeros; returns the number of random pairs drawn
 //
 // mark(i) is set to 1 if position i is nonzero.
 // mark is all zero on entry and is reset to all zero before exit
 // this corrects a performance bug found by John G. Lewis, caused by
 // reinitialization of mark on every one of the n calls to sprnvc
 //---------------------------------------------------------------------
-static void sprnvc(double *tran_ptr, int n, int nz, int nn1, double v[], int iv[])
+static int sprnvc(double *tran_ptr, int n, int nz, int nn1, double v[], int iv[])
 {
-  int nzv, ii, i;
+  int nzv, ii, i, npairs;
   double vecelt, vecloc;
 
   nzv = 0;
+  npairs = 0;
 
   while (nzv < nz) {
+    npairs = npairs + 1;
     vecelt = randlc(tran_ptr, amult);
 
     //---------------------------------------------------------------------
@@ -1429,6 +2351,33 @@ static void sprnvc(double *tran_ptr, int n, int nz, int nn1, double v[], int iv[
     iv[nzv] = i;
     nzv = nzv + 1;
   }
+  return npairs;
+}
+
+
+//---------------------------------------------------------------------
+// advance the generator by the given number of (vecelt, vecloc) pairs.
+// Every randlc(x, amult) multiplies x by amult mod 2^46, so the pairs
+// are skipped with one multiplication by amult^(2*pairs), computed by
+// squaring as in ipow46 of EP
+//---------------------------------------------------------------------
+static void rng_skip(double *tran_ptr, long pairs)
+{
+  double q = amult, r = 1.0;
+  long e = 2 * pairs;
+
+  if (pairs == 0) return;
+  while (e > 1) {
+    if (e % 2 == 0) {
+      randlc(&q, q);
+      e = e / 2;
+    } else {
+      randlc(&r, q);
+      e = e - 1;
+    }
+  }
+  randlc(&r, q);
+  randlc(tran_ptr, r);
 }
 
 
@@ -1463,4 +2412,3 @@ static void vecset(int n, double v[], int iv[], int *nzv, int i, double val)
     *nzv     = *nzv + 1;
   }
 }
-
@@ -0,0 +1,368 @@
+#include "spmv.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// The AVX2 kernel handles a chunk as two vectors of four rows.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && \
+    SPMV_SELL_C == 8
+#include <immintrin.h>
+#define SPMV_HAVE_AVX2_KERNEL 1
+#else
+#define SPMV_HAVE_AVX2_KERNEL 0
+#endif
+
+spmv_format_t spmv_format_from_env(void) {
+    const char *format = getenv("ABT_CG_SPMV");
+    if (format && strcmp(format, "sell") == 0) {
+        return SPMV_FORMAT_SELL;
+    }
+    return SPMV_FORMAT_CSR;
+}
+
+const char *spmv_format_name(spmv_format_t format) {
+    return format == SPMV_FORMAT_SELL ? "SELL-C-sigma" : "CSR";
+}
+
+// block_start[b] is the first index whose prefix reaches b/num_blocks of the
+// total, so every block gets about the same share of prefix[n].
+static void balance_blocks(const long *prefix, int n, int num_blocks,
+                           int *block_start) {
+    long total = prefix[n] - prefix[0];
+    block_start[0] = 0;
+    for (int b = 1; b < num_blocks; ++b) {
+        long target = prefix[0] + total * b / num_blocks;
+        int lo = block_start[b - 1], hi = n;
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            if (prefix[mid] < target) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        block_start[b] = lo;
+    }
+    block_start[num_blocks] = n;
+}
+
+typedef struct {
+    int len;
+    int row;
+} row_len_t;
+
+static int compare_row_len(const void *lhs, const void *rhs) {
+    const row_len_t *l = (const row_len_t *)lhs;
+    const row_len_t *r = (const row_len_t *)rhs;
+    // Longer rows first; ties keep the original order.
+    if (l->len != r->len) {
+        return r->len - l->len;
+    }
+    return l->row - r->row;
+}
+
+static void build_sell(spmv_matrix_t *matrix, const int rowstr[],
+                       const int colidx[], const double a[]) {
+    int nrows = matrix->nrows;
+    int num_chunks = (nrows + SPMV_SELL_C - 1) / SPMV_SELL_C;
+    int num_slots = num_chunks * SPMV_SELL_C;
+
+    // Sort the rows by length within each sigma window.
+    row_len_t *rows = (row_len_t *)malloc(sizeof(row_len_t) * nrows);
+    for (int j = 0; j < nrows; ++j) {
+        rows[j].len = rowstr[j + 1] - rowstr[j];
+        rows[j].row = j;
+    }
+    for (int w = 0; w < nrows; w += SPMV_SELL_SIGMA) {
+        int n = (nrows - w < SPMV_SELL_SIGMA) ? (nrows - w) : SPMV_SELL_SIGMA;
+        qsort(&rows[w], n, sizeof(row_len_t), compare_row_len);
+    }
+
+    matrix->num_chunks = num_chunks;
+    matrix->chunk_start = (long *)malloc(sizeof(long) * (num_chunks + 1));
+    matrix->chunk_len = (int *)malloc(sizeof(int) * num_chunks);
+    matrix->sell_row = (int *)malloc(sizeof(int) * num_slots);
+    matrix->chunk_start[0] = 0;
+    for (int c = 0; c < num_chunks; ++c) {
+        int len = 0;
+        for (int s = 0; s < SPMV_SELL_C; ++s) {
+            int slot = c * SPMV_SELL_C + s;
+            if (slot < nrows) {
+                matrix->sell_row[slot] = rows[slot].row;
+                if (rows[slot].len > len) {
+                    len = rows[slot].len;
+                }
+            } else {
+                matrix->sell_row[slot] = -1;
+            }
+        }
+        matrix->chunk_len[c] = len;
+        matrix->chunk_start[c + 1] =
+            matrix->chunk_start[c] + (long)len * SPMV_SELL_C;
+    }
+    free(rows);
+
+    // Store each chunk column by column.  Padding is a zero that multiplies
+    // p[0], which leaves the row sum unchanged.
+    long size = matrix->chunk_start[num_chunks];
+    matrix->sell_colidx = (int *)malloc(sizeof(int) * (size > 0 ? size : 1));
+    matrix->sell_a = (double *)malloc(sizeof(double) * (size > 0 ? size : 1));
+    for (int c = 0; c < num_chunks; ++c) {
+        for (int s = 0; s < SPMV_SELL_C; ++s) {
+            int row = matrix->sell_row[c * SPMV_SELL_C + s];
+            int len = (row >= 0) ? rowstr[row + 1] - rowstr[row] : 0;
+            for (int k = 0; k < matrix->chunk_len[c]; ++k) {
+                long pos = matrix->chunk_start[c] + (long)k * SPMV_SELL_C + s;
+                if (k < len) {
+                    matrix->sell_colidx[pos] = colidx[rowstr[row] + k];
+                    matrix->sell_a[pos] = a[rowstr[row] + k];
+                } else {
+                    matrix->sell_colidx[pos] = 0;
+                    matrix->sell_a[pos] = 0.0;
+                }
+            }
+        }
+    }
+}
+
+void spmv_init(spmv_matrix_t *matrix, spmv_format_t format, int nrows,
+               const int rowstr[], const int colidx[], const double a[],
+               int num_blocks) {
+    memset(matrix, 0, sizeof(spmv_matrix_t));
+    matrix->format = format;
+    matrix->nrows = nrows;
+    matrix->rowstr = rowstr;
+    matrix->colidx = colidx;
+    matrix->a = a;
+
+    if (format == SPMV_FORMAT_SELL) {
+        build_sell(matrix, rowstr, colidx, a);
+#if SPMV_HAVE_AVX2_KERNEL
+        __builtin_cpu_init();
+        matrix->use_avx2 = __builtin_cpu_supports("avx2");
+#endif
+    }
+    spmv_set_blocks(matrix, num_blocks);
+}
+
+void spmv_set_blocks(spmv_matrix_t *matrix, int num_blocks) {
+    free(matrix->block_start);
+    free(matrix->block_nnz);
+    matrix->num_blocks = num_blocks;
+    matrix->block_start = (int *)malloc(sizeof(int) * (num_blocks + 1));
+    matrix->block_nnz = (long *)malloc(sizeof(long) * num_blocks);
+
+    if (matrix->format == SPMV_FORMAT_SELL) {
+        balance_blocks(matrix->chunk_start, matrix->num_chunks, num_blocks,
+                       matrix->block_start);
+        for (int b = 0; b < num_blocks; ++b) {
+            matrix->block_nnz[b] =
+                matrix->chunk_start[matrix->block_start[b + 1]] -
+                matrix->chunk_start[matrix->block_start[b]];
+        }
+    } else {
+        const int *rowstr = matrix->rowstr;
+        int nrows = matrix->nrows;
+        long *prefix = (long *)malloc(sizeof(long) * (nrows + 1));
+        for (int j = 0; j <= nrows; ++j) {
+            prefix[j] = rowstr[j];
+        }
+        balance_blocks(prefix, nrows, num_blocks, matrix->block_start);
+        free(prefix);
+        for (int b = 0; b < num_blocks; ++b) {
+            matrix->block_nnz[b] = rowstr[matrix->block_start[b + 1]] -
+                                   rowstr[matrix->block_start[b]];
+        }
+    }
+}
+
+void spmv_free(spmv_matrix_t *matrix) {
+    free(matrix->block_start);
+    free(matrix->block_nnz);
+    free(matrix->chunk_start);
+    free(matrix->chunk_len);
+    free(matrix->sell_row);
+    free(matrix->sell_colidx);
+    free(matrix->sell_a);
+    free(matrix->a_float);
+    memset(matrix, 0, sizeof(spmv_matrix_t));
+}
+
+static void spmv_csr(const spmv_matrix_t *matrix, int row_from, int row_to,
+                     const double p[], double q[]) {
+    const int *rowstr = matrix->rowstr;
+    const int *colidx = matrix->colidx;
+    const double *a = matrix->a;
+    for (int j = row_from; j < row_to; j++) {
+        double suml = 0.0;
+        for (int k = rowstr[j]; k < rowstr[j + 1]; k++) {
+            suml += a[k] * p[colidx[k]];
+        }
+        q[j] = suml;
+    }
+}
+
+static void spmv_sell_scalar(const spmv_matrix_t *matrix, int chunk_from,
+                             int chunk_to, const double p[], double q[]) {
+    for (int c = chunk_from; c < chunk_to; ++c) {
+        const int *colidx = matrix->sell_colidx + matrix->chunk_start[c];
+        const double *a = matrix->sell_a + matrix->chunk_start[c];
+        double sum[SPMV_SELL_C] = { 0.0 };
+        for (int k = 0; k < matrix->chunk_len[c]; ++k) {
+            for (int s = 0; s < SPMV_SELL_C; ++s) {
+                sum[s] += a[k * SPMV_SELL_C + s] * p[colidx[k * SPMV_SELL_C + s]];
+            }
+        }
+        const int *rows = matrix->sell_row + c * SPMV_SELL_C;
+        for (int s = 0; s < SPMV_SELL_C; ++s) {
+            if (rows[s] >= 0) {
+                q[rows[s]] = sum[s];
+            }
+        }
+    }
+}
+
+#if SPMV_HAVE_AVX2_KERNEL
+// Multiply and add are kept separate (no FMA) to round like the CSR loop.
+__attribute__((target("avx2")))
+static void spmv_sell_avx2(const spmv_matrix_t *matrix, int chunk_from,
+                           int chunk_to, const double p[], double q[]) {
+    for (int c = chunk_from; c < chunk_to; ++c) {
+        const int *colidx = matrix->sell_colidx + matrix->chunk_start[c];
+        const double *a = matrix->sell_a + matrix->chunk_start[c];
+        __m256d sum_lo = _mm256_setzero_pd();
+        __m256d sum_hi = _mm256_setzero_pd();
+        for (int k = 0; k < matrix->chunk_len[c]; ++k) {
+            const int *col = colidx + k * SPMV_SELL_C;
+            const double *val = a + k * SPMV_SELL_C;
+            __m128i idx_lo = _mm_loadu_si128((const __m128i *)col);
+            __m128i idx_hi = _mm_loadu_si128((const __m128i *)(col + 4));
+            __m256d p_lo = _mm256_i32gather_pd(p, idx_lo, 8);
+            __m256d p_hi = _mm256_i32gather_pd(p, idx_hi, 8);
+            sum_lo = _mm256_add_pd(sum_lo,
+                                   _mm256_mul_pd(_mm256_loadu_pd(val), p_lo));
+            sum_hi = _mm256_add_pd(sum_hi, _mm256_mul_pd(
+                                               _mm256_loadu_pd(val + 4), p_hi));
+        }
+        double sum[SPMV_SELL_C];
+        _mm256_storeu_pd(sum, sum_lo);
+        _mm256_storeu_pd(sum + 4, sum_hi);
+        const int *rows = matrix->sell_row + c * SPMV_SELL_C;
+        for (int s = 0; s < SPMV_SELL_C; ++s) {
+            if (rows[s] >= 0) {
+                q[rows[s]] = sum[s];
+            }
+        }
+    }
+}
+#endif
+
+void spmv_enable_float(spmv_matrix_t *matrix) {
+    const double *a = (matrix->format == SPMV_FORMAT_SELL) ? matrix->sell_a
+                                                           : matrix->a;
+    long size = (matrix->format == SPMV_FORMAT_SELL)
+                    ? matrix->chunk_start[matrix->num_chunks]
+                    : matrix->rowstr[matrix->nrows];
+    free(matrix->a_float);
+    matrix->a_float = (float *)malloc(sizeof(float) * (size > 0 ? size : 1));
+    for (long k = 0; k < size; ++k) {
+        matrix->a_float[k] = (float)a[k];
+    }
+}
+
+static void spmv_csr_float(const spmv_matrix_t *matrix, int row_from,
+                           int row_to, const float p[], float q[]) {
+    const int *rowstr = matrix->rowstr;
+    const int *colidx = matrix->colidx;
+    const float *a = matrix->a_float;
+    for (int j = row_from; j < row_to; j++) {
+        float suml = 0.0f;
+        for (int k = rowstr[j]; k < rowstr[j + 1]; k++) {
+            suml += a[k] * p[colidx[k]];
+        }
+        q[j] = suml;
+    }
+}
+
+static void spmv_sell_float_scalar(const spmv_matrix_t *matrix,
+                                   int chunk_from, int chunk_to,
+                                   const float p[], float q[]) {
+    for (int c = chunk_from; c < chunk_to; ++c) {
+        const int *colidx = matrix->sell_colidx + matrix->chunk_start[c];
+        const float *a = matrix->a_float + matrix->chunk_start[c];
+        float sum[SPMV_SELL_C] = { 0.0f };
+        for (int k = 0; k < matrix->chunk_len[c]; ++k) {
+            for (int s = 0; s < SPMV_SELL_C; ++s) {
+                sum[s] += a[k * SPMV_SELL_C + s] * p[colidx[k * SPMV_SELL_C + s]];
+            }
+        }
+        const int *rows = matrix->sell_row + c * SPMV_SELL_C;
+        for (int s = 0; s < SPMV_SELL_C; ++s) {
+            if (rows[s] >= 0) {
+                q[rows[s]] = sum[s];
+            }
+        }
+    }
+}
+
+#if SPMV_HAVE_AVX2_KERNEL
+// A chunk is one vector of eight rows in single precision.
+__attribute__((target("avx2")))
+static void spmv_sell_float_avx2(const spmv_matrix_t *matrix, int chunk_from,
+                                 int chunk_to, const float p[], float q[]) {
+    for (int c = chunk_from; c < chunk_to; ++c) {
+        const int *colidx = matrix->sell_colidx + matrix->chunk_start[c];
+        const float *a = matrix->a_float + matrix->chunk_start[c];
+        __m256 sum_v = _mm256_setzero_ps();
+        for (int k = 0; k < matrix->chunk_len[c]; ++k) {
+            __m256i idx = _mm256_loadu_si256(
+                (const __m256i *)(colidx + k * SPMV_SELL_C));
+            __m256 p_v = _mm256_i32gather_ps(p, idx, 4);
+            sum_v = _mm256_add_ps(sum_v, _mm256_mul_ps(
+                                             _mm256_loadu_ps(a + k * SPMV_SELL_C), p_v));
+        }
+        float sum[SPMV_SELL_C];
+        _mm256_storeu_ps(sum, sum_v);
+        const int *rows = matrix->sell_row + c * SPMV_SELL_C;
+        for (int s = 0; s < SPMV_SELL_C; ++s) {
+            if (rows[s] >= 0) {
+                q[rows[s]] = sum[s];
+            }
+        }
+    }
+}
+#endif
+
+void spmv_block_float(const spmv_matrix_t *matrix, int block_id,
+                      const float p[], float q[]) {
+    int from = matrix->block_start[block_id];
+    int to = matrix->block_start[block_id + 1];
+    if (matrix->format == SPMV_FORMAT_CSR) {
+        spmv_csr_float(matrix, from, to, p, q);
+        return;
+    }
+#if SPMV_HAVE_AVX2_KERNEL
+    if (matrix->use_avx2) {
+        spmv_sell_float_avx2(matrix, from, to, p, q);
+        return;
+    }
+#endif
+    spmv_sell_float_scalar(matrix, from, to, p, q);
+}
+
+void spmv_block(const spmv_matrix_t *matrix, int block_id, const double p[],
+                double q[]) {
+    int from = matrix->block_start[block_id];
+    int to = matrix->block_start[block_id + 1];
+    if (matrix->format == SPMV_FORMAT_CSR) {
+        spmv_csr(matrix, from, to, p, q);
+        return;
+    }
+#if SPMV_HAVE_AVX2_KERNEL
+    if (matrix->use_avx2) {
+        spmv_sell_avx2(matrix, from, to, p, q);
+        return;
+    }
+#endif
+    spmv_sell_scalar(matrix, from, to, p, q);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+/* Sparse matrix-vector product q = A.p for the CG driver.
+ *
+ * The rows are split into num_blocks blocks after the matrix is built,
+ * so that every block has about the same number of nonzeros (makea() produces
+ * rows of very different lengths).  Block i is computed by spmv_block(i).
+ *
+ * Two storage formats are supported, chosen at startup by spmv_format_from_env():
+ *  - CSR: the rowstr/colidx/a arrays of the benchmark, used in place.
+ *  - SELL-C-sigma: a sliced ELLPACK copy.  Rows are sorted by length within
+ *    windows of SPMV_SELL_SIGMA rows and grouped into chunks of SPMV_SELL_C
+ *    rows stored column by column, padded to the longest row of the chunk.
+ *    The chunk is processed with AVX2 gathers when the CPU supports them.
+ * Both formats add the products of a row in the order of CSR and do not fuse
+ * multiply and add, so q is bitwise identical and NPB verification holds.
+ *
+ * spmv_enable_float() adds a single-precision copy of the values in the same
+ * format for spmv_block_float(), which streams half the bytes of a.  It is
+ * used by the inner iterations of the mixed-precision CG. */
+
+#define SPMV_SELL_C 8
+#define SPMV_SELL_SIGMA 256
+
+typedef enum {
+    SPMV_FORMAT_CSR = 0,
+    SPMV_FORMAT_SELL,
+} spmv_format_t;
+
+typedef struct {
+    spmv_format_t format;
+    int nrows;
+    int num_blocks;
+    int *block_start;        /* rows (CSR) or chunks (SELL) of each block */
+    long *block_nnz;         /* stored entries of each block, incl. padding */
+
+    /* CSR */
+    const int *rowstr;
+    const int *colidx;
+    const double *a;
+
+    /* SELL-C-sigma */
+    int num_chunks;
+    long *chunk_start;       /* offset of each chunk in sell_a/sell_colidx */
+    int *chunk_len;          /* length of the longest row of each chunk */
+    int *sell_row;           /* row of each chunk slot, -1 for padding rows */
+    int *sell_colidx;
+    double *sell_a;
+    int use_avx2;
+
+    /* Single precision copy of a or sell_a, NULL until spmv_enable_float(). */
+    float *a_float;
+} spmv_matrix_t;
+
+/* Returns SPMV_FORMAT_SELL if ABT_CG_SPMV=sell is set. */
+spmv_format_t spmv_format_from_env(void);
+
+/* rowstr/colidx/a must stay valid until spmv_free() in the CSR format. */
+void spmv_init(spmv_matrix_t *matrix, spmv_format_t format, int nrows,
+               const int rowstr[], const int colidx[], const double a[],
+               int num_blocks);
+
+/* Splits the rows into num_blocks blocks again, e.g. when the number of
+ * leaves is tuned at run time.  The SELL-C-sigma copy is kept. */
+void spmv_set_blocks(spmv_matrix_t *matrix, int num_blocks);
+
+void spmv_free(spmv_matrix_t *matrix);
+
+/* Builds the single precision copy of the values. */
+void spmv_enable_float(spmv_matrix_t *matrix);
+
+/* Computes q[j] for the rows j of block block_id. */
+void spmv_block(const spmv_matrix_t *matrix, int block_id, const double p[],
+                double q[]);
+
+/* Computes q[j] for the rows j of block block_id in single precision. */
+void spmv_block_float(const spmv_matrix_t *matrix, int block_id,
+                      const float p[], float q[]);
+
+const char *spmv_format_name(spmv_format_t format);
@@ -6,22 +6,36 @@
 #include "abt_reduction.h"
 #include "../argobots_framework/examples/workstealing_scheduler/abt_workstealing_scheduler.h"
 #include "../argobots_framework/examples/workstealing_scheduler/abt_workstealing_scheduler_cost_aware.h"
+#include "../argobots_framework/examples/benchmark/abt_bench.h"
+#include "jac3d_kernel.h"
 
 #define Max(a, b) ((a) > (b) ? (a) : (b))
-#define L 384
 #define ITMAX 100
 
 #define DEFAULT_XSTREAMS 4
 #define DEFAULT_THREADS 4
+/* The grid size of the verification value. */
+#define DEFAULT_SIZE 384
 
-float A[L][L][L];
-float B[L][L][L];
+/* The n x n x n grids, stored plane by plane.  A holds the previous iterate
+ * and B the current one; a sweep writes the next iterate over A and the two
+ * pointers are swapped.  Heap-allocated so that every plane is first touched
+ * by the ULT that updates it (see init_thread). */
+static int n = DEFAULT_SIZE;
+static float *A;
+static float *B;
+static jac3d_kernel_t kernel;
 float MAXEPS = 0.5f;
 
+#define IDX(i, j, k) (((size_t)(i) * n + (j)) * n + (k))
+
 
 static ABT_sched *g_scheds = NULL;
 static int g_use_ws_scheduler = 0;
 static int g_use_cost_aware_scheduler = 0;
+static int g_steal_threshold = 0;
+static int g_autotune = 0;
+static reduction_tuner_t tuner;
 
 static void configure_scheduler_mode(void) {
     const char *scheduler_mode = getenv("ABT_WS_SCHEDULER");
@@ -32,6 +46,15 @@ static void configure_scheduler_mode(void) {
     }
     g_use_ws_scheduler = 1;
     g_use_cost_aware_scheduler = (strcmp(scheduler_mode, "new") == 0 || strcmp(scheduler_mode, "cost-aware") == 0);
+
+    /* With affinity placement, an idle xstream only steals from a pool that
+     * holds more than one waiting block by default. */
+    const char *steal_threshold = getenv("ABT_WS_STEAL_THRESHOLD");
+    if (steal_threshold && steal_threshold[0] != '\0') {
+        g_steal_threshold = atoi(steal_threshold);
+    } else {
+        g_steal_threshold = (reduction_placement_from_env() == REDUCTION_PLACEMENT_AFFINITY) ? 1 : 0;
+    }
 }
 
 static inline void register_task_estimate_if_needed(int pool_id, double estimate) {
@@ -46,35 +69,66 @@ typedef struct {
     float *eps_local;
 } jacobi_args_t;
 
-void update_A_thread(void *arg) {
-    jacobi_args_t *jacobi_args = (jacobi_args_t *)arg;
-    float local_eps = 0.0f;
-    
-    for (int i = jacobi_args->start_i; i < jacobi_args->end_i; i++) {
-        for (int j = 1; j < L-1; j++) {
-            for (int k = 1; k < L-1; k++) {
-                float tmp = fabs(B[i][j][k] - A[i][j][k]);
-                local_eps = Max(tmp, local_eps);
-                A[i][j][k] = B[i][j][k];
+/* Splits the inner planes into num_threads slabs. */
+static void split_rows(jacobi_args_t *thread_args, float *eps_values, int num_threads) {
+    int rows_per_thread = (n - 2) / num_threads;
+    for (int t = 0; t < num_threads; t++) {
+        thread_args[t].start_i = 1 + t * rows_per_thread;
+        thread_args[t].end_i = (t == num_threads - 1) ? n - 1 : thread_args[t].start_i + rows_per_thread;
+        thread_args[t].eps_local = &eps_values[t];
+    }
+}
+
+/* Applies the setting the auto-tuner asks for to the next iteration. */
+static void apply_tuning(reduction_context_t *reduction_context) {
+    const reduction_tuning_t *tuning = reduction_tuner_current(&tuner);
+    reduction_apply_tuning(reduction_context, tuning);
+    if (g_use_ws_scheduler && tuning->steal_threshold != g_steal_threshold) {
+        for (int i = 0; i < reduction_context->num_xstreams; i++) {
+            if (g_use_cost_aware_scheduler) {
+                ABT_ws_sched_cost_aware_set_steal_threshold(g_scheds[i], tuning->steal_threshold);
+            } else {
+                ABT_ws_sched_set_steal_threshold(g_scheds[i], tuning->steal_threshold);
             }
         }
     }
-    
-    *(jacobi_args->eps_local) = local_eps;
+    g_steal_threshold = tuning->steal_threshold;
 }
 
-void update_B_thread(void *arg) {
+// First touch: each leaf initializes the planes it updates in the compute
+// phases.  The boundary planes 0 and n-1 go to the first and last leaves.
+// A is the zero start and B the first iterate, so the leaf also returns the
+// first |B - A| of its planes.
+void init_thread(void *arg) {
     jacobi_args_t *jacobi_args = (jacobi_args_t *)arg;
-    
-    for (int i = jacobi_args->start_i; i < jacobi_args->end_i; i++) {
-        for (int j = 1; j < L-1; j++) {
-            for (int k = 1; k < L-1; k++) {
-                B[i][j][k] = (A[i-1][j][k] + A[i][j-1][k] + 
-                             A[i][j][k-1] + A[i][j][k+1] + 
-                             A[i][j+1][k] + A[i+1][j][k]) / 6.0f;
+    int from = (jacobi_args->start_i == 1) ? 0 : jacobi_args->start_i;
+    int to = (jacobi_args->end_i == n - 1) ? n : jacobi_args->end_i;
+    float local_eps = 0.0f;
+
+    for (int i = from; i < to; i++) {
+        for (int j = 0; j < n; j++) {
+            for (int k = 0; k < n; k++) {
+                A[IDX(i, j, k)] = 0;
+                if (i == 0 ||  j == 0 ||  k == 0 ||  i == n-1 ||  j == n-1 || k == n-1) {
+                    B[IDX(i, j, k)] = 0;
+                } else {
+                    B[IDX(i, j, k)] = 4 + i + j + k;
+                    float tmp = fabs(B[IDX(i, j, k)] - A[IDX(i, j, k)]);
+                    local_eps = Max(tmp, local_eps);
+                }
             }
         }
     }
+
+    *(jacobi_args->eps_local) = local_eps;
+}
+
+// One iteration on the planes of the leaf: the next iterate goes to A, and
+// its largest change from B is the eps of the following iteration.
+void sweep_thread(void *arg) {
+    jacobi_args_t *jacobi_args = (jacobi_args_t *)arg;
+    *(jacobi_args->eps_local) = jac3d_sweep(kernel, n, B, A, jacobi_args->start_i,
+                                            jacobi_args->end_i);
 }
 
 void initialize_argobots(reduction_context_t *reduction_context, int num_xstreams, int num_threads) {
@@ -82,6 +136,21 @@ void initialize_argobots(reduction_context_t *reduction_context, int num_xstream
     ABT_init(0, NULL);
     configure_scheduler_mode();
 
+    /* With ABT_AUTOTUNE, the number of leaves may grow while the benchmark
+     * tunes itself, so the handles are allocated for the largest option. */
+    int max_leaves = num_threads;
+    g_autotune = reduction_tuner_from_env();
+    if (g_autotune) {
+        reduction_tuning_t initial = {
+            .num_threads = num_threads,
+            .steal_threshold = g_steal_threshold,
+            .placement = reduction_placement_from_env(),
+        };
+        reduction_tuner_init(&tuner, g_autotune, &initial, num_xstreams, n - 2,
+                             g_use_ws_scheduler);
+        max_leaves = reduction_tuner_max_threads(&tuner);
+    }
+
     reduction_context->num_xstreams = num_xstreams;
     reduction_context->xstreams = (ABT_xstream *)malloc(sizeof(ABT_xstream) * num_xstreams);
 
@@ -90,7 +159,8 @@ void initialize_argobots(reduction_context_t *reduction_context, int num_xstream
     reduction_context->pools = (ABT_pool *)malloc(sizeof(ABT_pool) * num_pools);
 
     reduction_context->num_threads = num_threads;
-    reduction_context->threads = (ABT_thread *)malloc(sizeof(ABT_thread) * num_threads);
+    reduction_context->threads = (ABT_thread *)malloc(sizeof(ABT_thread) * max_leaves);
+    reduction_context->mode = reduction_mode_from_env();
 
     if (g_use_ws_scheduler) {
         g_scheds = (ABT_sched *)calloc(num_xstreams, sizeof(ABT_sched));
@@ -100,9 +170,11 @@ void initialize_argobots(reduction_context_t *reduction_context, int num_xstream
         }
 
         if (g_use_cost_aware_scheduler) {
-            ABT_create_ws_scheds_cost_aware(num_xstreams, reduction_context->pools, g_scheds);
+            ABT_create_ws_scheds_cost_aware_threshold(num_xstreams, reduction_context->pools,
+                                                      g_scheds, g_steal_threshold);
         } else {
-            ABT_create_ws_scheds(num_xstreams, reduction_context->pools, g_scheds);
+            ABT_create_ws_scheds_threshold(num_xstreams, reduction_context->pools, g_scheds,
+                                           g_steal_threshold);
         }
 
         ABT_xstream_self(&(reduction_context->xstreams[0]));
@@ -125,6 +197,8 @@ void initialize_argobots(reduction_context_t *reduction_context, int num_xstream
                                        &(reduction_context->pools[i]));
         }
     }
+
+    reduction_placement_init(reduction_context, reduction_placement_from_env(), num_threads);
 }
 
 void finalize_argobots(reduction_context_t *reduction_context) {
@@ -148,6 +222,7 @@ void finalize_argobots(reduction_context_t *reduction_context) {
     ABT_finalize();
 
      /* Free allocated memory. */
+    reduction_placement_free(reduction_context);
     free(reduction_context->xstreams);
     free(reduction_context->pools);
     free(reduction_context->threads);
@@ -156,10 +231,10 @@ void finalize_argobots(reduction_context_t *reduction_context) {
 int main(int argc, char **argv) {
     int num_xstreams = DEFAULT_XSTREAMS;
     int num_threads = DEFAULT_THREADS;
-    float eps;
+    float eps = 0.0f;
     clock_t start, end;
     struct timespec start_real_time, end_real_time;
-    double cpu_time_used;
+    double cpu_time_used = 0.0;
     
     /* Parse command line arguments if provided */
     if (argc > 1) {
@@ -169,93 +244,163 @@ int main(int argc, char **argv) {
             num_threads = atoi(argv[2]);
             if (num_threads <= 0) num_threads = DEFAULT_THREADS;
         }
+        if (argc > 3) {
+            n = atoi(argv[3]);
+            if (n < 3) n = DEFAULT_SIZE;
+        }
     }
+    if (num_threads > n - 2) num_threads = n - 2;
+    kernel = jac3d_kernel_from_env();
     
-    printf("Running Jacobi-3D with xstreams=%d and threads=%d\n", num_xstreams, num_threads);
+    printf("Running Jacobi-3D with xstreams=%d and threads=%d (%s mode)\n", num_xstreams, num_threads,
+           reduction_mode_from_env() == REDUCTION_MODE_TASKLET ? "tasklet" : "ULT");
     
     /* Initialize Argobots */
     reduction_context_t reduction_context;
     initialize_argobots(&reduction_context, num_xstreams, num_threads);
     
-    for (int i = 0; i < L; i++) {
-        for (int j = 0; j < L; j++) {
-            for (int k = 0; k < L; k++) {
-                A[i][j][k] = 0;
-                if (i == 0 ||  j == 0 ||  k == 0 ||  i == L-1 ||  j == L-1 || k == L-1)
-                    B[i][j][k] = 0;
-                else
-                    B[i][j][k] = 4 + i + j + k;
-            }
-        }
+    size_t array_size = sizeof(float) * n * n * n;
+    reduction_alloc_type_t alloc_type_A, alloc_type_B;
+    float *grid_A = (float *)reduction_alloc_array(array_size, &alloc_type_A);
+    float *grid_B = (float *)reduction_alloc_array(array_size, &alloc_type_B);
+    if (!grid_A || !grid_B) {
+        fprintf(stderr, "Failed to allocate the %d^3 arrays\n", n);
+        return 1;
     }
+    printf("Array allocation: %s\n", reduction_alloc_type_name(alloc_type_A));
+    printf("Kernel: %s\n", jac3d_kernel_name(kernel));
+    printf("Placement: %s (steal threshold %d)\n",
+           reduction_context.placement == REDUCTION_PLACEMENT_AFFINITY ? "affinity" : "static",
+           g_steal_threshold);
+    
+    int max_leaves = g_autotune ? reduction_tuner_max_threads(&tuner) : num_threads;
+    jacobi_args_t *thread_args = (jacobi_args_t *)malloc(sizeof(jacobi_args_t) * max_leaves);
+    float *eps_values = (float *)malloc(sizeof(float) * max_leaves);
+    int rows_per_thread = (n - 2) / num_threads;
+    split_rows(thread_args, eps_values, num_threads);
     
-    start = clock();
-    clock_gettime(CLOCK_REALTIME, &start_real_time);
+    /* The arrays are reinitialized and the iterations timed once per run of
+     * the benchmark runner (see abt_bench.h); the report is the last run. */
+    const char *scheduler_mode = getenv("ABT_WS_SCHEDULER");
+    bench_t bench;
+    bench_init(&bench, "jac3d");
+    bench_config(&bench, "size", "%d", n);
+    bench_config(&bench, "xstreams", "%d", num_xstreams);
+    bench_config(&bench, "threads", "%d", num_threads);
+    bench_config(&bench, "scheduler", "%s",
+                 (scheduler_mode && scheduler_mode[0]) ? scheduler_mode : "default");
+    bench_config(&bench, "mode", "%s",
+                 reduction_context.mode == REDUCTION_MODE_TASKLET ? "tasklet" : "ult");
+    bench_config(&bench, "placement", "%s",
+                 reduction_context.placement == REDUCTION_PLACEMENT_AFFINITY ? "affinity" : "static");
+    bench_config(&bench, "kernel", "%s", jac3d_kernel_name(kernel));
+    if (g_autotune) {
+        bench_config(&bench, "autotune", "%d", g_autotune);
+    }
     
-    jacobi_args_t *thread_args = (jacobi_args_t *)malloc(sizeof(jacobi_args_t) * num_threads);
-    float *eps_values = (float *)malloc(sizeof(float) * num_threads);
-    int rows_per_thread = (L - 2) / num_threads;
-    for (int it = 1; it <= ITMAX; it++) {
+    long long real_time_nanoseconds = 0;
+    for (int run = 0; run < bench_num_runs(&bench); run++) {
+        /* Initialize the arrays in parallel with the compute-phase partition */
+        A = grid_A;
+        B = grid_B;
         for (int t = 0; t < num_threads; t++) {
-            thread_args[t].start_i = 1 + t * rows_per_thread;
-            thread_args[t].end_i = (t == num_threads - 1) ? L - 1 : thread_args[t].start_i + rows_per_thread;
-            thread_args[t].eps_local = &eps_values[t];
-            
-            register_task_estimate_if_needed(t % reduction_context.num_pools, (double)(rows_per_thread * L * L));
-            ABT_thread_create(
-                reduction_context.pools[t % reduction_context.num_pools],
-                update_A_thread,
+            int pool_id = reduction_block_pool(&reduction_context, t);
+            register_task_estimate_if_needed(pool_id, (double)rows_per_thread * n * n);
+            reduction_create_leaf(
+                &reduction_context,
+                pool_id,
+                init_thread,
                 &thread_args[t],
-                ABT_THREAD_ATTR_NULL,
                 &reduction_context.threads[t]
             );
         }
         for (int t = 0; t < num_threads; t++) {
             ABT_thread_join(reduction_context.threads[t]);
+            reduction_block_done(&reduction_context, t, reduction_context.threads[t]);
             ABT_thread_free(&reduction_context.threads[t]);
         }
+        float next_eps;
+        reduce_max_float(&reduction_context, eps_values, num_threads, &next_eps);
+    
+        bench_run_begin(&bench);
+        start = clock();
+        clock_gettime(CLOCK_REALTIME, &start_real_time);
+    
+        for (int it = 1; it <= ITMAX; it++) {
+            double it_start = ABT_get_wtime();
+            /* eps = max |B - A|, found by the previous sweep */
+            eps = next_eps;
         
-        /* Use Argobots reduction to find maximum epsilon */
-        reduce_max_float(&reduction_context, eps_values, num_threads, &eps);
+            bench_phase_begin(&bench, "sweep");
+            for (int t = 0; t < num_threads; t++) {
+                int pool_id = reduction_block_pool(&reduction_context, t);
+                register_task_estimate_if_needed(pool_id, (double)rows_per_thread * n * n);
+                reduction_create_leaf(
+                    &reduction_context,
+                    pool_id,
+                    sweep_thread,
+                    &thread_args[t],
+                    &reduction_context.threads[t]
+                );
+            }
+            for (int t = 0; t < num_threads; t++) {
+                ABT_thread_join(reduction_context.threads[t]);
+                reduction_block_done(&reduction_context, t, reduction_context.threads[t]);
+                ABT_thread_free(&reduction_context.threads[t]);
+            }
+            bench_phase_end(&bench, "sweep");
         
-        for (int t = 0; t < num_threads; t++) {
-            register_task_estimate_if_needed(t % reduction_context.num_pools, (double)(rows_per_thread * L * L));
-            ABT_thread_create(
-                reduction_context.pools[t % reduction_context.num_pools],
-                update_B_thread,
-                &thread_args[t],
-                ABT_THREAD_ATTR_NULL,
-                &reduction_context.threads[t]
-            );
-        }
-        for (int t = 0; t < num_threads; t++) {
-            ABT_thread_join(reduction_context.threads[t]);
-            ABT_thread_free(&reduction_context.threads[t]);
-        }
+            /* Use Argobots reduction to find maximum epsilon */
+            bench_phase_begin(&bench, "reduce");
+            reduce_max_float(&reduction_context, eps_values, num_threads, &next_eps);
+            bench_phase_end(&bench, "reduce");
         
-        // printf(" IT = %4i   EPS = %14.7E\n", it, eps);
-        if (eps < MAXEPS)
-            break;
-    }
+            float *tmp = A;
+            A = B;
+            B = tmp;
+        
+            /* The first iterations try the settings of the auto-tuner */
+            if (g_autotune && reduction_tuner_record(&tuner, ABT_get_wtime() - it_start)) {
+                apply_tuning(&reduction_context);
+                num_threads = reduction_context.num_threads;
+                rows_per_thread = (n - 2) / num_threads;
+                split_rows(thread_args, eps_values, num_threads);
+            }
+        
+            // printf(" IT = %4i   EPS = %14.7E\n", it, eps);
+            if (eps < MAXEPS)
+                break;
+        }
     
-    end = clock();
-    clock_gettime(CLOCK_REALTIME, &end_real_time);
-    cpu_time_used = ((double) (end - start)) / CLOCKS_PER_SEC;
-    long long real_time_nanoseconds = (end_real_time.tv_sec - start_real_time.tv_sec) * 1000000000 + (end_real_time.tv_nsec - start_real_time.tv_nsec);
+        end = clock();
+        clock_gettime(CLOCK_REALTIME, &end_real_time);
+        cpu_time_used = ((double) (end - start)) / CLOCKS_PER_SEC;
+        real_time_nanoseconds = (end_real_time.tv_sec - start_real_time.tv_sec) * 1000000000 + (end_real_time.tv_nsec - start_real_time.tv_nsec);
+        bench_run_end(&bench, n != DEFAULT_SIZE || fabs(eps - 5.058044) < 1e-4);
+    }
+    long num_block_moves = reduction_context.num_block_moves;
+    long num_block_runs = reduction_context.num_block_runs;
+    if (g_autotune) {
+        reduction_tuner_print(&tuner, num_xstreams);
+    }
     
     free(thread_args);
     free(eps_values);
     finalize_argobots(&reduction_context);
+    reduction_free_array(grid_A, array_size, alloc_type_A);
+    reduction_free_array(grid_B, array_size, alloc_type_B);
     
     printf(" Jacobi3D Benchmark Completed.\n");
-    printf(" Size              = %4d x %4d x %4d\n", L, L, L);
+    printf(" Size              = %4d x %4d x %4d\n", n, n, n);
     printf(" Iterations        =       %12d\n", ITMAX);
     printf(" Time in seconds   =       %12.2lf\n", cpu_time_used);
     printf(" Real time (nanos) =       %12lld\n", real_time_nanoseconds);
     printf(" Operation type    =     floating point\n");
+    printf(" Block moves       = %8ld of %8ld\n", num_block_moves, num_block_runs);
     printf(" Verification      =       %12s\n", 
+           n != DEFAULT_SIZE ? "NOT_PERFORMED" :
            (fabs(eps - 5.058044) < 1e-4 ? "SUCCESSFUL" : "UNSUCCESSFUL"));
     printf(" END OF Jacobi3D Benchmark\n");
     
-    return 0;
+    return bench_finish(&bench);
 }
\ No newline at end of file
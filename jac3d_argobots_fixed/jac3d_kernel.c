@@ -0,0 +1,198 @@
+#include "jac3d_kernel.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define JAC3D_HAVE_X86_KERNELS 1
+#else
+#define JAC3D_HAVE_X86_KERNELS 0
+#endif
+
+static int cpu_supports(jac3d_kernel_t kernel) {
+#if JAC3D_HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    switch (kernel) {
+        case JAC3D_KERNEL_AVX512:
+            return __builtin_cpu_supports("avx512f");
+        case JAC3D_KERNEL_AVX2:
+            return __builtin_cpu_supports("avx2");
+        default:
+            return 1;
+    }
+#else
+    return kernel == JAC3D_KERNEL_SCALAR;
+#endif
+}
+
+jac3d_kernel_t jac3d_kernel_from_env(void) {
+    jac3d_kernel_t kernel = JAC3D_KERNEL_AVX512;
+    const char *name = getenv("ABT_JAC3D_KERNEL");
+    if (name && strcmp(name, "scalar") == 0) {
+        kernel = JAC3D_KERNEL_SCALAR;
+    } else if (name && strcmp(name, "avx2") == 0) {
+        kernel = JAC3D_KERNEL_AVX2;
+    }
+    while (kernel != JAC3D_KERNEL_SCALAR && !cpu_supports(kernel)) {
+        kernel = (jac3d_kernel_t)(kernel - 1);
+    }
+    return kernel;
+}
+
+const char *jac3d_kernel_name(jac3d_kernel_t kernel) {
+    switch (kernel) {
+        case JAC3D_KERNEL_AVX512:
+            return "AVX-512";
+        case JAC3D_KERNEL_AVX2:
+            return "AVX2";
+        default:
+            return "scalar";
+    }
+}
+
+// Points [k_from, k_to) of one row.  c points to the row of src, out to the
+// row of dst; the neighbours are one row (n) and one plane (plane) away.
+static inline float sweep_points(const float *c, float *out, size_t n,
+                                 size_t plane, int k_from, int k_to,
+                                 float eps) {
+    for (int k = k_from; k < k_to; k++) {
+        float v = (c[k - plane] + c[k - n] + c[k - 1] + c[k + 1] + c[k + n] +
+                   c[k + plane]) / 6.0f;
+        float diff = fabsf(v - c[k]);
+        eps = (diff > eps) ? diff : eps;
+        out[k] = v;
+    }
+    return eps;
+}
+
+// First k >= k_from at which out + k is aligned to align bytes.
+static inline int first_aligned(const float *out, int k_from, int k_to,
+                                size_t align) {
+    int k = k_from;
+    while (k < k_to && ((uintptr_t)(out + k) & (align - 1)) != 0) {
+        k++;
+    }
+    return k;
+}
+
+static float sweep_scalar(int n, const float *src, float *dst, int plane_from,
+                          int plane_to) {
+    size_t row = (size_t)n, plane = (size_t)n * n;
+    float eps = 0.0f;
+    for (int i = plane_from; i < plane_to; i++) {
+        for (int j = 1; j < n - 1; j++) {
+            size_t offset = i * plane + j * row;
+            eps = sweep_points(src + offset, dst + offset, row, plane, 1, n - 1,
+                               eps);
+        }
+    }
+    return eps;
+}
+
+#if JAC3D_HAVE_X86_KERNELS
+
+__attribute__((target("avx2")))
+static float sweep_avx2(int n, const float *src, float *dst, int plane_from,
+                        int plane_to, int stream) {
+    size_t row = (size_t)n, plane = (size_t)n * n;
+    const __m256 six = _mm256_set1_ps(6.0f);
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    __m256 veps = _mm256_setzero_ps();
+    float eps = 0.0f;
+    for (int i = plane_from; i < plane_to; i++) {
+        for (int j = 1; j < n - 1; j++) {
+            size_t offset = i * plane + j * row;
+            const float *c = src + offset;
+            float *out = dst + offset;
+            int k = stream ? first_aligned(out, 1, n - 1, 32) : 1;
+            eps = sweep_points(c, out, row, plane, 1, k, eps);
+            for (; k + 8 <= n - 1; k += 8) {
+                __m256 center = _mm256_loadu_ps(c + k);
+                __m256 sum = _mm256_add_ps(_mm256_loadu_ps(c + k - plane),
+                                           _mm256_loadu_ps(c + k - row));
+                sum = _mm256_add_ps(sum, _mm256_loadu_ps(c + k - 1));
+                sum = _mm256_add_ps(sum, _mm256_loadu_ps(c + k + 1));
+                sum = _mm256_add_ps(sum, _mm256_loadu_ps(c + k + row));
+                sum = _mm256_add_ps(sum, _mm256_loadu_ps(c + k + plane));
+                __m256 v = _mm256_div_ps(sum, six);
+                veps = _mm256_max_ps(veps, _mm256_andnot_ps(sign, _mm256_sub_ps(v, center)));
+                if (stream) {
+                    _mm256_stream_ps(out + k, v);
+                } else {
+                    _mm256_storeu_ps(out + k, v);
+                }
+            }
+            eps = sweep_points(c, out, row, plane, k, n - 1, eps);
+        }
+    }
+    if (stream) {
+        _mm_sfence();
+    }
+    float lanes[8];
+    _mm256_storeu_ps(lanes, veps);
+    for (int l = 0; l < 8; l++) {
+        eps = (lanes[l] > eps) ? lanes[l] : eps;
+    }
+    return eps;
+}
+
+__attribute__((target("avx512f")))
+static float sweep_avx512(int n, const float *src, float *dst, int plane_from,
+                          int plane_to, int stream) {
+    size_t row = (size_t)n, plane = (size_t)n * n;
+    const __m512 six = _mm512_set1_ps(6.0f);
+    __m512 veps = _mm512_setzero_ps();
+    float eps = 0.0f;
+    for (int i = plane_from; i < plane_to; i++) {
+        for (int j = 1; j < n - 1; j++) {
+            size_t offset = i * plane + j * row;
+            const float *c = src + offset;
+            float *out = dst + offset;
+            int k = stream ? first_aligned(out, 1, n - 1, 64) : 1;
+            eps = sweep_points(c, out, row, plane, 1, k, eps);
+            for (; k + 16 <= n - 1; k += 16) {
+                __m512 center = _mm512_loadu_ps(c + k);
+                __m512 sum = _mm512_add_ps(_mm512_loadu_ps(c + k - plane),
+                                           _mm512_loadu_ps(c + k - row));
+                sum = _mm512_add_ps(sum, _mm512_loadu_ps(c + k - 1));
+                sum = _mm512_add_ps(sum, _mm512_loadu_ps(c + k + 1));
+                sum = _mm512_add_ps(sum, _mm512_loadu_ps(c + k + row));
+                sum = _mm512_add_ps(sum, _mm512_loadu_ps(c + k + plane));
+                __m512 v = _mm512_div_ps(sum, six);
+                veps = _mm512_max_ps(veps, _mm512_abs_ps(_mm512_sub_ps(v, center)));
+                if (stream) {
+                    _mm512_stream_ps(out + k, v);
+                } else {
+                    _mm512_storeu_ps(out + k, v);
+                }
+            }
+            eps = sweep_points(c, out, row, plane, k, n - 1, eps);
+        }
+    }
+    if (stream) {
+        _mm_sfence();
+    }
+    float vmax = _mm512_reduce_max_ps(veps);
+    return (vmax > eps) ? vmax : eps;
+}
+
+#endif
+
+float jac3d_sweep(jac3d_kernel_t kernel, int n, const float *src, float *dst,
+                  int plane_from, int plane_to) {
+#if JAC3D_HAVE_X86_KERNELS
+    // Streaming only pays off when dst would not stay in the caches anyway.
+    int stream = (size_t)n * n * n * sizeof(float) >= JAC3D_STREAM_MIN_BYTES;
+    if (kernel == JAC3D_KERNEL_AVX512) {
+        return sweep_avx512(n, src, dst, plane_from, plane_to, stream);
+    }
+    if (kernel == JAC3D_KERNEL_AVX2) {
+        return sweep_avx2(n, src, dst, plane_from, plane_to, stream);
+    }
+#endif
+    (void)kernel;
+    return sweep_scalar(n, src, dst, plane_from, plane_to);
+}
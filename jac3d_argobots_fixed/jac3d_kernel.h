@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stddef.h>
+
+/* One Jacobi-3D sweep on an n x n x n grid stored plane by plane.
+ *
+ * jac3d_sweep() writes the 7-point average of src into dst for the inner
+ * points of planes [plane_from, plane_to) and returns the largest
+ * |dst - src| over them, so the convergence test needs no second pass and
+ * the driver swaps src and dst instead of copying.  The boundary of dst is
+ * never written and must be zero in both buffers.
+ *
+ * The kernel is chosen at startup by jac3d_kernel_from_env():
+ *  - scalar: plain loops.
+ *  - avx2, avx512: 8 or 16 points per instruction.
+ * The vector kernels add the six neighbours in the order of the scalar loop
+ * and divide by 6, so every kernel produces the same bits.  On grids larger
+ * than JAC3D_STREAM_MIN_BYTES the output is written with non-temporal
+ * stores, which do not read dst into the caches first. */
+
+#define JAC3D_STREAM_MIN_BYTES (32UL * 1024 * 1024)
+
+typedef enum {
+    JAC3D_KERNEL_SCALAR = 0,
+    JAC3D_KERNEL_AVX2,
+    JAC3D_KERNEL_AVX512,
+} jac3d_kernel_t;
+
+/* Returns the kernel named by ABT_JAC3D_KERNEL=scalar|avx2|avx512, or the
+ * widest one the CPU supports.  A kernel the CPU lacks falls back to the
+ * next narrower one. */
+jac3d_kernel_t jac3d_kernel_from_env(void);
+
+const char *jac3d_kernel_name(jac3d_kernel_t kernel);
+
+float jac3d_sweep(jac3d_kernel_t kernel, int n, const float *src, float *dst,
+                  int plane_from, int plane_to);
@@ -165,9 +165,10 @@ build_jac3d_argobots_fixed() {
     cd jac3d_argobots_fixed
     gcc $JAC3D_BUILD_CFLAGS $ABT_CFLAGS \
       -o jac3d \
-      jac3d.c abt_reduction.c \
+      jac3d.c jac3d_kernel.c abt_reduction.c \
       ../argobots_framework/examples/workstealing_scheduler/abt_workstealing_scheduler.c \
       ../argobots_framework/examples/workstealing_scheduler/abt_workstealing_scheduler_cost_aware.c \
+      ../argobots_framework/examples/benchmark/abt_bench.c \
       $ABT_LIBS -lm
   )
 }